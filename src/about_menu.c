@@ -33,6 +33,7 @@
 #include "new_menu.h"
 #include "about_menu.h"
 #include "discovered.h"
+#include "iqreplay.h"
 #include "radio.h"
 #include "version.h"
 #include "hpsdr_logo.h"
@@ -177,6 +178,11 @@ void about_menu(GtkWidget *parent) {
     g_strlcat(text, line, 1024);
     break;
 #endif
+
+  case REPLAY_PROTOCOL:
+    snprintf(line, 512, "Device: %s (%s)", radio->name, iqreplay_description());
+    g_strlcat(text, line, 1024);
+    break;
   }
 
   label = gtk_label_new(text);
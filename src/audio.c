@@ -22,18 +22,18 @@
 //
 // Some important parameters
 // Note that we keep the playback buffers at half-filling so
-// we can use a larger latency there.
+// we can use a larger latency there. The target latency (the
+// half-filling) can be chosen for each receiver, the ALSA buffer
+// is twice as large.
 //
 //
 // while it is kept above out_low_water
 //
 static const int inp_latency = 125000;
-static const int out_latency = 200000;
 
 static const int mic_buffer_size = 256;
 static const int out_buffer_size = 256;
 
-static const int out_buflen = 48 * (out_latency / 1000); // Length of ALSA buffer
 static const int out_cw_border = 1536;                // separates CW-TX from other buffer fillings
 
 static const int cw_mid_water  = 1024;                // target buffer filling for CW
@@ -58,6 +58,7 @@ static const int cw_high_water = 1152;                // high water mark for CW
 #include "receiver.h"
 #include "transmitter.h"
 #include "audio.h"
+#include "audiofifo.h"
 #include "mode.h"
 #include "vfo.h"
 #include "message.h"
@@ -104,12 +105,21 @@ float  *mic_ring_buffer = NULL;
 volatile int mic_ring_read_pt = 0;
 volatile int mic_ring_write_pt = 0;
 
+static gpointer audio_out_thread(gpointer data);
+
 int audio_open_output(RECEIVER *rx) {
   int err;
   unsigned int rate = 48000;
   unsigned int channels = 2;
   int soft_resample = 1;
-  t_print("%s: rx=%d %s buffer_size=%d\n", __FUNCTION__, rx->id, rx->audio_name, out_buffer_size);
+
+  if (rx->audio_target_latency < AUDIO_MIN_LATENCY) { rx->audio_target_latency = AUDIO_MIN_LATENCY; }
+
+  if (rx->audio_target_latency > AUDIO_MAX_LATENCY) { rx->audio_target_latency = AUDIO_MAX_LATENCY; }
+
+  unsigned int out_latency = 2000 * rx->audio_target_latency;  // ALSA buffer length in usec
+  t_print("%s: rx=%d %s buffer_size=%d latency=%d\n", __FUNCTION__, rx->id, rx->audio_name, out_buffer_size,
+          rx->audio_target_latency);
   int i;
   char hw[128];
   i = 0;
@@ -184,6 +194,13 @@ int audio_open_output(RECEIVER *rx) {
   t_print("%s: rx=%d audio_device=%d handle=%p buffer=%p size=%d\n", __FUNCTION__, rx->id, rx->audio_device,
           rx->playback_handle, rx->local_audio_buffer, out_buffer_size);
   g_mutex_unlock(&rx->local_audio_mutex);
+
+  if (audio_fifo_start(rx, audio_out_thread) < 0) {
+    t_print("%s: cannot start output thread\n", __FUNCTION__);
+    audio_close_output(rx);
+    return -1;
+  }
+
   return 0;
 }
 
@@ -303,6 +320,7 @@ int audio_open_input() {
 
 void audio_close_output(RECEIVER *rx) {
   t_print("%s: rx=%d handle=%p buffer=%p\n", __FUNCTION__, rx->id, rx->playback_handle, rx->local_audio_buffer);
+  audio_fifo_stop(rx);
   g_mutex_lock(&rx->local_audio_mutex);
 
   if (rx->playback_handle != NULL) {
@@ -495,9 +513,11 @@ int cw_audio_write(RECEIVER *rx, float sample) {
 // if rx == active_receiver and while transmitting, DO NOTHING
 // since cw_audio_write may be active
 //
+// audio_write is called from the DSP thread and only stores the samples
+// in the audio FIFO, the ALSA device is served by audio_out_thread.
+//
 
 int audio_write(RECEIVER *rx, float left_sample, float right_sample) {
-  snd_pcm_sframes_t delay;
   int txmode = vfo_get_tx_mode();
 
   //
@@ -512,41 +532,70 @@ int audio_write(RECEIVER *rx, float left_sample, float right_sample) {
     return 0;
   }
 
-  // lock AFTER checking the "quick return" condition but BEFORE checking the pointers
-  g_mutex_lock(&rx->local_audio_mutex);
+  if (rx->audio_running) {
+    audio_fifo_put(rx, left_sample, right_sample);
+  }
 
-  if (rx->playback_handle != NULL && rx->local_audio_buffer != NULL) {
-    switch (rx->local_audio_format) {
-    case SND_PCM_FORMAT_S16_LE: {
-      int16_t *short_buffer = (int16_t *)rx->local_audio_buffer;
-      short_buffer[rx->local_audio_buffer_offset * 2] = (int16_t)(left_sample * 32767.0F);
-      short_buffer[(rx->local_audio_buffer_offset * 2) + 1] = (int16_t)(right_sample * 32767.0F);
-    }
-    break;
+  return 0;
+}
 
-    case SND_PCM_FORMAT_S32_LE: {
-      int32_t *long_buffer = (int32_t *)rx->local_audio_buffer;
-      long_buffer[rx->local_audio_buffer_offset * 2] = (int32_t)(left_sample * 2147483647.0F);
-      long_buffer[(rx->local_audio_buffer_offset * 2) + 1] = (int32_t)(right_sample * 2147483647.0F);
-    }
-    break;
+//
+// Output thread: take blocks from the audio FIFO, convert them
+// to the ALSA format, and write them to the device. The mutex
+// is only held while accessing the device, and since the device
+// has been opened non-blocking, this is never for long.
+//
+static gpointer audio_out_thread(gpointer data) {
+  RECEIVER *rx = (RECEIVER *)data;
+  int out_buflen = 96 * rx->audio_target_latency;     // Length of ALSA buffer
+  int32_t conv[2 * AUDIO_FIFO_BLKSIZE];               // large enough for all formats
+  void *silence = g_new0(int32_t, 2 * out_buflen);    // dito
+  const float *block;
+  snd_pcm_sframes_t delay;
+  long rc;
+  t_print("%s: RX%d: buffer length=%d\n", __FUNCTION__, rx->id, out_buflen);
 
-    case SND_PCM_FORMAT_FLOAT_LE: {
-      float *float_buffer = (float *)rx->local_audio_buffer;
-      float_buffer[rx->local_audio_buffer_offset * 2] = left_sample;
-      float_buffer[(rx->local_audio_buffer_offset * 2) + 1] = right_sample;
-    }
-    break;
+  while (rx->audio_running) {
+    if ((block = audio_fifo_get(rx, 100)) == NULL) { continue; }
 
-    default:
-      t_print("%s: CATASTROPHIC ERROR: unknown sound format\n", __FUNCTION__);
+    g_mutex_lock(&rx->local_audio_mutex);
+
+    if (rx->playback_handle != NULL) {
+      switch (rx->local_audio_format) {
+      case SND_PCM_FORMAT_S16_LE: {
+        int16_t *short_buffer = (int16_t *)conv;
+
+        for (int i = 0; i < 2 * AUDIO_FIFO_BLKSIZE; i++) {
+          short_buffer[i] = (int16_t)(block[i] * 32767.0F);
+        }
+      }
       break;
-    }
 
-    rx->local_audio_buffer_offset++;
+      case SND_PCM_FORMAT_S32_LE:
+        for (int i = 0; i < 2 * AUDIO_FIFO_BLKSIZE; i++) {
+          conv[i] = (int32_t)(block[i] * 2147483647.0F);
+        }
+
+        break;
+
+      case SND_PCM_FORMAT_FLOAT_LE:
+        memcpy(conv, block, 2 * AUDIO_FIFO_BLKSIZE * sizeof(float));
+        break;
+
+      default:
+        t_print("%s: CATASTROPHIC ERROR: unknown sound format\n", __FUNCTION__);
+        memset(conv, 0, sizeof(conv));
+        break;
+      }
 
-    if (rx->local_audio_buffer_offset >= out_buffer_size) {
       if (snd_pcm_delay(rx->playback_handle, &delay) == 0) {
+        //
+        // After an under-run, the delay reported may be negative
+        //
+        if (delay < 0) { delay = 0; }
+
+        if (delay > out_buflen) { delay = out_buflen; }
+
         if (delay < out_cw_border) {
           //
           // upon first occurence, or after a TX/RX transition, the buffer
@@ -556,53 +605,19 @@ int audio_write(RECEIVER *rx, float left_sample, float right_sample) {
           //         rewind until half-filling. Just filling by half does nothing,
           //         ALSA just does not start playing until the buffer is nearly full.
           //
-          void *silence = NULL;
-          size_t len;
-          int num = (out_buflen - delay);
-
-          switch (rx->local_audio_format) {
-          case SND_PCM_FORMAT_S16_LE:
-            silence = g_new(int16_t, 2 * num);
-            len = 2 * num * sizeof(int16_t);
-            break;
-
-          case SND_PCM_FORMAT_S32_LE:
-            silence = g_new(int32_t, 2 * num);
-            len = 2 * num * sizeof(int32_t);
-            break;
-
-          case SND_PCM_FORMAT_FLOAT_LE:
-            silence = g_new(float, 2 * num);
-            len = 2 * num * sizeof(float);
-            break;
-
-          default:
-            t_print("%s: CATASTROPHIC ERROR: unknown sound format\n", __FUNCTION__);
-            silence = NULL;
-            len = 0;
-            break;
-          }
-
-          if (silence) {
-            memset(silence, 0, len);
-            snd_pcm_writei (rx->playback_handle, silence, num);
-            snd_pcm_rewind (rx->playback_handle, out_buflen / 2);
-            g_free(silence);
-          }
+          snd_pcm_writei (rx->playback_handle, silence, out_buflen - delay);
+          snd_pcm_rewind (rx->playback_handle, out_buflen / 2);
         }
       }
 
-      long rc;
-
-      if ((rc = snd_pcm_writei (rx->playback_handle, rx->local_audio_buffer, out_buffer_size)) != out_buffer_size) {
+      if ((rc = snd_pcm_writei (rx->playback_handle, conv, AUDIO_FIFO_BLKSIZE)) != AUDIO_FIFO_BLKSIZE) {
         if (rc < 0) {
           switch (rc) {
           case -EPIPE:
+            rx->audio_xruns++;
+
             if ((rc = snd_pcm_prepare (rx->playback_handle)) < 0) {
               t_print("%s: cannot prepare audio interface for use %ld (%s)\n", __FUNCTION__, rc, snd_strerror (rc));
-              rx->local_audio_buffer_offset = 0;
-              g_mutex_unlock(&rx->local_audio_mutex);
-              return rc;
             }
 
             break;
@@ -612,16 +627,21 @@ int audio_write(RECEIVER *rx, float left_sample, float right_sample) {
             break;
           }
         } else {
-          t_print("%s: short write lost=%d\n", __FUNCTION__, out_buffer_size - (int) rc);
+          t_print("%s: short write lost=%d\n", __FUNCTION__, AUDIO_FIFO_BLKSIZE - (int) rc);
         }
       }
 
-      rx->local_audio_buffer_offset = 0;
+      if (snd_pcm_delay(rx->playback_handle, &delay) == 0 && delay >= 0) {
+        rx->audio_latency = delay / 48 + audio_fifo_latency(rx);
+      }
     }
+
+    g_mutex_unlock(&rx->local_audio_mutex);
+    audio_fifo_release(rx);
   }
 
-  g_mutex_unlock(&rx->local_audio_mutex);
-  return 0;
+  g_free(silence);
+  return NULL;
 }
 
 static void *mic_read_thread(gpointer arg) {
@@ -0,0 +1,120 @@
+/* Copyright (C)
+*
+* 2024,2025 - Heiko Amft, DL1BZ (Project deskHPSDR)
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+
+//
+// Audio output FIFO, see audiofifo.h
+//
+
+#include <gtk/gtk.h>
+#include <stdlib.h>
+
+#include "audiofifo.h"
+#include "message.h"
+
+//
+// Discard blocks left over from a previous run. This only moves the
+// tail, that is, it is done from the consumer side: the DSP thread may
+// still be in audio_fifo_put (it may have checked audio_running just
+// before the output was stopped), so the FIFO must not be reset here.
+//
+static void audio_fifo_drain(RECEIVER *rx) {
+  int n;
+
+  do {
+    n = AUDIO_FIFO_BLOCKS;
+
+    if (ringbuf_peek(rx->audio_fifo, &n) != NULL) {
+      ringbuf_release(rx->audio_fifo, n);
+    }
+  } while (n > 0);
+}
+
+//
+// Allocate the FIFO (this is done only once for each receiver, since
+// audio_write may still store samples into the head slot while the
+// output is being closed) and start the output thread. The output
+// thread of a previous run has been joined, so we may act as the
+// consumer here.
+//
+int audio_fifo_start(RECEIVER *rx, GThreadFunc thread) {
+  char name[16];
+
+  if (rx->audio_fifo == NULL) {
+    if (posix_memalign((void **)&rx->audio_fifo, RINGBUF_CACHELINE, sizeof(RINGBUF)) != 0) {
+      rx->audio_fifo = NULL;
+      return -1;
+    }
+
+    if (ringbuf_init(rx->audio_fifo, AUDIO_FIFO_BLOCKS, 2 * AUDIO_FIFO_BLKSIZE * sizeof(float)) < 0) {
+      free(rx->audio_fifo);
+      rx->audio_fifo = NULL;
+      return -1;
+    }
+  }
+
+  audio_fifo_drain(rx);
+  rx->audio_latency = 0;
+  rx->audio_xruns = 0;
+  rx->audio_drops = 0;
+  rx->audio_running = 1;
+  snprintf(name, sizeof(name), "RX%d AUDIO", rx->id);
+  rx->audio_thread_id = g_thread_new(name, thread, rx);
+  return 0;
+}
+
+//
+// Stop the output thread. After this, audio_write does no longer
+// commit blocks to the FIFO.
+//
+void audio_fifo_stop(RECEIVER *rx) {
+  if (!rx->audio_running) { return; }
+
+  rx->audio_running = 0;
+  ringbuf_wakeup(rx->audio_fifo);
+  g_thread_join(rx->audio_thread_id);
+  rx->audio_thread_id = NULL;
+  t_print("%s: RX%d: blocks=%lu dropped=%lu xruns=%lu latency=%d msec\n", __FUNCTION__, rx->id,
+          rx->audio_fifo->commits, rx->audio_drops, rx->audio_xruns, rx->audio_latency);
+}
+
+//
+// Called from the output thread: return the next block, or NULL if
+// there is none within the time-out, or if the thread should stop.
+//
+float *audio_fifo_get(RECEIVER *rx, int timeout_ms) {
+  int n = 1;
+
+  if (!rx->audio_running) { return NULL; }
+
+  if (ringbuf_wait(rx->audio_fifo, timeout_ms) == 0) { return NULL; }
+
+  return (float *) ringbuf_peek(rx->audio_fifo, &n);
+}
+
+void audio_fifo_release(RECEIVER *rx) {
+  ringbuf_release(rx->audio_fifo, 1);
+}
+
+//
+// Latency (in msec) of the data waiting in the FIFO
+//
+int audio_fifo_latency(RECEIVER *rx) {
+  return (ringbuf_count(rx->audio_fifo) * AUDIO_FIFO_BLKSIZE + rx->audio_fifo_offset) / 48;
+}
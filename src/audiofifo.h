@@ -0,0 +1,68 @@
+/* Copyright (C)
+*
+* 2024,2025 - Heiko Amft, DL1BZ (Project deskHPSDR)
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+
+#ifndef _AUDIOFIFO_H
+#define _AUDIOFIFO_H
+
+#include "receiver.h"
+#include "ringbuf.h"
+
+//
+// FIFO between the DSP thread of a receiver and the local audio output.
+//
+// audio_write() (called from the DSP thread for each sample) only stores
+// the samples into the head slot of the FIFO, a block of AUDIO_FIFO_BLKSIZE
+// stereo float samples, and commits full blocks. No lock is taken, and
+// no system call is made there. A dedicated output thread per receiver
+// (see audio.c and pulseaudio.c) takes the blocks from the FIFO, converts
+// them to the format of the audio device and writes them. Latency and
+// under-run management of the device buffer is done in that thread.
+//
+// If the output thread falls behind, the newest block is dropped.
+//
+
+#define AUDIO_FIFO_BLOCKS  32
+#define AUDIO_FIFO_BLKSIZE 256
+
+//
+// Range for the target latency (msec) of the audio device
+//
+#define AUDIO_MIN_LATENCY  40
+#define AUDIO_MAX_LATENCY  500
+
+extern int    audio_fifo_start(RECEIVER *rx, GThreadFunc thread);
+extern void   audio_fifo_stop(RECEIVER *rx);
+extern float *audio_fifo_get(RECEIVER *rx, int timeout_ms);
+extern void   audio_fifo_release(RECEIVER *rx);
+extern int    audio_fifo_latency(RECEIVER *rx);
+
+static inline void audio_fifo_put(RECEIVER *rx, float left_sample, float right_sample) {
+  float *block = (float *) ringbuf_head(rx->audio_fifo);
+  block[rx->audio_fifo_offset * 2] = left_sample;
+  block[(rx->audio_fifo_offset * 2) + 1] = right_sample;
+
+  if (++rx->audio_fifo_offset >= AUDIO_FIFO_BLKSIZE) {
+    if (ringbuf_commit(rx->audio_fifo, 1) < 0) { rx->audio_drops++; }
+
+    rx->audio_fifo_offset = 0;
+  }
+}
+
+#endif
@@ -0,0 +1,228 @@
+/* Copyright (C)
+*
+* 2024,2025 - Heiko Amft, DL1BZ (Project deskHPSDR)
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+//
+// Lock-free pool of network buffers, see bufpool.h
+//
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "bufpool.h"
+#include "new_protocol.h"
+#include "message.h"
+
+#define HUGEPAGE_SIZE (2 * 1024 * 1024)
+
+//
+// Allocate memory for n buffers. If huge pages are requested, first try
+// explicit huge pages (hugetlbfs, needs pages reserved by the admin),
+// then transparent huge pages, then fall back to normal memory.
+// *hugepage is set to what we actually got.
+//
+static mybuffer *bufpool_alloc(int n, int *hugepage) {
+  size_t size = (size_t)n * sizeof(mybuffer);
+  void *mem = NULL;
+#ifdef __linux__
+
+  if (*hugepage) {
+    size_t hsize = (size + HUGEPAGE_SIZE - 1) & ~((size_t)HUGEPAGE_SIZE - 1);
+    mem = mmap(NULL, hsize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+
+    if (mem != MAP_FAILED) {
+      *hugepage = 2;
+      return mem;
+    }
+
+    if (posix_memalign(&mem, HUGEPAGE_SIZE, hsize) == 0) {
+      madvise(mem, hsize, MADV_HUGEPAGE);
+      *hugepage = 1;
+      return mem;
+    }
+  }
+
+#endif
+  *hugepage = 0;
+
+  if (posix_memalign(&mem, 64, size) != 0) {
+    return NULL;
+  }
+
+  return mem;
+}
+
+static inline void bufpool_push(BUFPOOL *pool, mybuffer *buf) {
+  unsigned long long old = atomic_load_explicit(&pool->top, memory_order_relaxed);
+  unsigned long long new;
+
+  do {
+    __atomic_store_n(&buf->next, (int)(old & 0xFFFFFFFF), __ATOMIC_RELAXED);
+    new = (((old >> 32) + 1) << 32) | (unsigned long long)(buf->index + 1);
+  } while (!atomic_compare_exchange_weak_explicit(&pool->top, &old, new,
+           memory_order_release, memory_order_relaxed));
+}
+
+static inline mybuffer *bufpool_pop(BUFPOOL *pool) {
+  unsigned long long old = atomic_load_explicit(&pool->top, memory_order_acquire);
+  unsigned long long new;
+  mybuffer *buf;
+
+  do {
+    unsigned int idx = old & 0xFFFFFFFF;
+
+    if (idx == 0) { return NULL; }
+
+    buf = pool->table[idx - 1];
+    new = (((old >> 32) + 1) << 32) | (unsigned int)__atomic_load_n(&buf->next, __ATOMIC_RELAXED);
+  } while (!atomic_compare_exchange_weak_explicit(&pool->top, &old, new,
+           memory_order_acquire, memory_order_acquire));
+
+  return buf;
+}
+
+//
+// Add n buffers to the pool, must be called with the mutex locked
+//
+static int bufpool_add(BUFPOOL *pool, int n, int *hugepage) {
+  int nbuf = atomic_load(&pool->nbuf);
+
+  if (n > pool->maxbuf - nbuf) { n = pool->maxbuf - nbuf; }
+
+  if (n <= 0) { return 0; }
+
+  mybuffer *slab = bufpool_alloc(n, hugepage);
+
+  if (slab == NULL) {
+    t_print("%s: pool %s: cannot allocate %d buffers\n", __FUNCTION__, pool->name, n);
+    return 0;
+  }
+
+  for (int i = 0; i < n; i++) {
+    mybuffer *buf = &slab[i];
+    buf->pool = pool;
+    buf->index = nbuf + i;
+    buf->free = 1;
+    pool->table[nbuf + i] = buf;
+  }
+
+  atomic_store(&pool->nbuf, nbuf + n);
+
+  for (int i = n - 1; i >= 0; i--) {
+    bufpool_push(pool, &slab[i]);
+  }
+
+  return n;
+}
+
+int bufpool_init(BUFPOOL *pool, const char *name, int nbuf, int grow, int maxbuf, int hugepage) {
+  memset(pool, 0, sizeof(BUFPOOL));
+  pool->name = name;
+  pool->grow = grow;
+  pool->maxbuf = maxbuf;
+  pthread_mutex_init(&pool->mutex, NULL);
+  pool->table = calloc(maxbuf, sizeof(mybuffer *));
+
+  if (pool->table == NULL) {
+    t_print("%s: pool %s: cannot allocate table\n", __FUNCTION__, name);
+    return -1;
+  }
+
+  //
+  // Only the initial arena may use huge pages
+  //
+  pool->hugepage = hugepage;
+  pthread_mutex_lock(&pool->mutex);
+  int n = bufpool_add(pool, nbuf, &pool->hugepage);
+  pthread_mutex_unlock(&pool->mutex);
+  bufpool_stats(pool);
+  return (n == nbuf) ? 0 : -1;
+}
+
+//
+// Obtain a free buffer
+//
+mybuffer *bufpool_get(BUFPOOL *pool) {
+  mybuffer *buf;
+
+  while ((buf = bufpool_pop(pool)) == NULL) {
+    //
+    // Pool is empty: grow (only one thread does so at a time),
+    // or wait for a buffer to be returned if the pool is at its
+    // maximum size.
+    //
+    pthread_mutex_lock(&pool->mutex);
+
+    if ((buf = bufpool_pop(pool)) == NULL) {
+      int hugepage = 0;
+
+      if (bufpool_add(pool, pool->grow, &hugepage) > 0) {
+        atomic_fetch_add(&pool->grows, 1);
+        t_print("%s: pool %s: number of buffers increased to %d\n", __FUNCTION__, pool->name,
+                atomic_load(&pool->nbuf));
+      } else {
+        if (atomic_fetch_add(&pool->waits, 1) == 0) {
+          t_print("%s: pool %s: exhausted (%d buffers)\n", __FUNCTION__, pool->name, atomic_load(&pool->nbuf));
+        }
+
+        pthread_mutex_unlock(&pool->mutex);
+        usleep(1000);
+        continue;
+      }
+    }
+
+    pthread_mutex_unlock(&pool->mutex);
+
+    if (buf != NULL) { break; }
+  }
+
+  buf->free = 0;
+  int inuse = atomic_fetch_add_explicit(&pool->inuse, 1, memory_order_relaxed) + 1;
+  int hw = atomic_load_explicit(&pool->highwater, memory_order_relaxed);
+
+  while (inuse > hw && !atomic_compare_exchange_weak_explicit(&pool->highwater, &hw, inuse,
+         memory_order_relaxed, memory_order_relaxed));
+
+  return buf;
+}
+
+//
+// Return a buffer to its pool
+//
+void bufpool_put(mybuffer *buf) {
+  BUFPOOL *pool = buf->pool;
+
+  if (buf->free) {
+    t_print("%s: pool %s: buffer %d returned twice\n", __FUNCTION__, pool->name, buf->index);
+    return;
+  }
+
+  buf->free = 1;
+  atomic_fetch_sub_explicit(&pool->inuse, 1, memory_order_relaxed);
+  bufpool_push(pool, buf);
+}
+
+void bufpool_stats(BUFPOOL *pool) {
+  static const char *hp[3] = { "normal pages", "transparent huge pages", "huge pages" };
+  t_print("%s: pool %s: buffers=%d in use=%d high water=%d grows=%u waits=%u (%s)\n",
+          __FUNCTION__, pool->name, atomic_load(&pool->nbuf), atomic_load(&pool->inuse),
+          atomic_load(&pool->highwater), atomic_load(&pool->grows), atomic_load(&pool->waits),
+          hp[pool->hugepage]);
+}
@@ -0,0 +1,73 @@
+/* Copyright (C)
+*
+* 2024,2025 - Heiko Amft, DL1BZ (Project deskHPSDR)
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+#ifndef _BUFPOOL_H
+#define _BUFPOOL_H
+
+#include <stdatomic.h>
+#include <pthread.h>
+
+//
+// Pool of network buffers (struct mybuffer_, see new_protocol.h).
+//
+// The buffers are pre-allocated in one arena and kept in a lock-free
+// LIFO free list, so obtaining and returning a buffer is O(1) and may
+// be done from any thread. The free list head contains a tag that is
+// incremented with each operation, to be safe against the ABA problem.
+//
+// If the pool runs empty, it grows by further slabs of buffers until
+// "maxbuf" is reached, after which bufpool_get() waits until a buffer
+// is returned. Buffers are never released to the operating system.
+//
+// The pool keeps track of how many buffers are in use, and of the
+// high-water mark of this number.
+//
+
+struct mybuffer_;
+
+typedef struct _bufpool {
+  //
+  // free list head: (tag << 32) | (index + 1), index 0 means empty
+  //
+  _Alignas(64) _Atomic unsigned long long top;
+  //
+  // statistics
+  //
+  _Alignas(64) atomic_int inuse;
+  atomic_int highwater;
+  atomic_uint grows;
+  atomic_uint waits;
+  //
+  // constant, or only changed with the mutex locked
+  //
+  _Alignas(64) const char *name;
+  struct mybuffer_ **table;
+  atomic_int nbuf;
+  int maxbuf;
+  int grow;
+  int hugepage;                    // 0: malloc, 1: transparent huge pages, 2: hugetlb
+  pthread_mutex_t mutex;
+} BUFPOOL;
+
+extern int  bufpool_init(BUFPOOL *pool, const char *name, int nbuf, int grow, int maxbuf, int hugepage);
+extern struct mybuffer_ *bufpool_get(BUFPOOL *pool);
+extern void bufpool_put(struct mybuffer_ *buf);
+extern void bufpool_stats(BUFPOOL *pool);
+
+#endif
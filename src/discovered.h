@@ -63,6 +63,8 @@
 
 #define SOAPYSDR_USB_DEVICE     2000
 
+#define REPLAY_DEVICE           3000
+
 #define STATE_AVAILABLE 2
 #define STATE_SENDING 3
 #define STATE_INCOMPATIBLE 4
@@ -71,6 +73,7 @@
 #define NEW_PROTOCOL      1
 #define SOAPYSDR_PROTOCOL 2
 #define STEMLAB_PROTOCOL  5
+#define REPLAY_PROTOCOL   6   // IQ file replay, see iqreplay.h
 
 // A STEMlab discovered via Avahi will have this protocol until the SDR
 // application itself is started, at which point it will be changed to the old
@@ -46,6 +46,7 @@
   #include "stemlab_discovery.h"
 #endif
 #include "ext.h"
+#include "iqreplay.h"
 #include "gpio.h"
 #ifdef GPIO
   #include "actions.h"
@@ -220,6 +221,15 @@ void discovery() {
     }
   }
 
+  //
+  // When replaying an IQ file, the replay is the only "radio", do not
+  // look for real ones
+  //
+  if (iqreplay_discovery()) {
+    status_text("IQ replay ... file opened");
+    goto done;
+  }
+
 #ifdef USBOZY
 
   if (enable_usbozy && !discover_only_stemlab) {
@@ -297,6 +307,7 @@ void discovery() {
   }
 
 #endif
+done:
   status_text("Discovery completed.");
   // subsequent discoveries check all protocols enabled.
   discover_only_stemlab = 0;
@@ -377,6 +388,11 @@ void discovery() {
       case STEMLAB_PROTOCOL:
         snprintf(text, sizeof(text), "Choose SDR App from %s: ",
                  inet_ntoa(d->info.network.address.sin_addr));
+        break;
+
+      case REPLAY_PROTOCOL:
+        snprintf(text, sizeof(text), "%s (%s)", d->name, iqreplay_description());
+        break;
       }
 
       GtkWidget *label = gtk_label_new(text);
@@ -556,7 +572,7 @@ void discovery() {
   //
   t_print("%s: devices=%d autostart=%d\n", __FUNCTION__, devices, autostart);
 
-  if (devices == 1 && autostart) {
+  if (devices == 1 && (autostart || iqreplay_configured())) {
     d = &discovered[0];
 
     if (d->status == STATE_AVAILABLE) {
@@ -25,6 +25,7 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include <wdsp.h>             // only needed for GetDisplayStats
 
 #include "main.h"
 #include "new_menu.h"
@@ -51,8 +52,23 @@ static GtkWidget *panadapter_low_r = NULL;
 static GtkWidget *general_container;
 static GtkWidget *peaks_container;
 static GtkWidget *b_display_solardata;
+#ifndef EXTNR
+static GtkWidget *spectrum_stats_label = NULL;
+static guint spectrum_stats_timer = 0;
+static long spectrum_stats_ffts = -1;
+#endif
 
 static void cleanup() {
+#ifndef EXTNR
+
+  if (spectrum_stats_timer != 0) {
+    g_source_remove(spectrum_stats_timer);
+    spectrum_stats_timer = 0;
+  }
+
+  spectrum_stats_label = NULL;
+#endif
+
   if (dialog != NULL) {
     GtkWidget *tmp = dialog;
     dialog = NULL;
@@ -63,6 +79,35 @@ static void cleanup() {
   }
 }
 
+#ifndef EXTNR
+//
+// Show the FFT rate, the number of FFTs queued in the WDSP worker pool,
+// and the number of dropped frames of the active receiver's spectrum.
+// Called once per second.
+//
+static gboolean spectrum_stats_update(gpointer data) {
+  char text[64];
+  long ffts, dropped;
+  int depth;
+
+  if (spectrum_stats_label == NULL) { return FALSE; }
+
+  GetDisplayStats(active_receiver->id, &ffts, &depth, &dropped);
+
+  if (spectrum_stats_ffts >= 0 && ffts >= spectrum_stats_ffts) {
+    snprintf(text, sizeof(text), "Spectrum: %ld FFT/s, queue %d, %ld dropped",
+             ffts - spectrum_stats_ffts, depth, dropped);
+  } else {
+    snprintf(text, sizeof(text), "Spectrum: -- FFT/s, queue %d, %ld dropped", depth, dropped);
+  }
+
+  spectrum_stats_ffts = ffts;
+  gtk_label_set_text(GTK_LABEL(spectrum_stats_label), text);
+  return TRUE;
+}
+
+#endif
+
 static gboolean close_cb () {
   cleanup();
   return TRUE;
@@ -596,6 +641,14 @@ void display_menu(GtkWidget *parent) {
   gtk_widget_show(b_display_waterfall);
   gtk_grid_attach(GTK_GRID(general_grid), b_display_waterfall, col, ++row, 1, 1);
   g_signal_connect(b_display_waterfall, "toggled", G_CALLBACK(display_waterfall_cb), NULL);
+#ifndef EXTNR
+  spectrum_stats_label = gtk_label_new(NULL);
+  gtk_widget_set_halign(spectrum_stats_label, GTK_ALIGN_START);
+  gtk_grid_attach(GTK_GRID(general_grid), spectrum_stats_label, col, row + 1, 1, 1);
+  spectrum_stats_ffts = -1;
+  spectrum_stats_update(NULL);
+  spectrum_stats_timer = g_timeout_add(1000, spectrum_stats_update, NULL);
+#endif
   //
   // Peaks container and controls therein
   //
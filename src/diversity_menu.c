@@ -36,15 +36,18 @@
 
 #include <math.h>
 
+#ifndef HEADLESS
 static GtkWidget *dialog = NULL;
 static GtkWidget *gain_coarse_scale = NULL;
 static GtkWidget *gain_fine_scale = NULL;
 static GtkWidget *phase_fine_scale = NULL;
 static GtkWidget *phase_coarse_scale = NULL;
+#endif
 
 static double gain_coarse, gain_fine;
 static double phase_coarse, phase_fine;
 
+#ifndef HEADLESS
 static void cleanup() {
   if (dialog != NULL) {
     GtkWidget *tmp = dialog;
@@ -69,6 +72,7 @@ static void diversity_cb(GtkWidget *widget, gpointer data) {
   int state = gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(widget));
   set_diversity(state);
 }
+#endif
 
 //
 // the magic constant 0.017... is Pi/180
@@ -83,6 +87,7 @@ static void set_gain_phase() {
   div_sin = amplitude * sin(arg);
 }
 
+#ifndef HEADLESS
 static void gain_coarse_changed_cb(GtkWidget *widget, gpointer data) {
   gain_coarse = gtk_range_get_value(GTK_RANGE(widget));
   div_gain = gain_coarse + gain_fine;
@@ -106,6 +111,7 @@ static void phase_fine_changed_cb(GtkWidget *widget, gpointer data) {
   div_phase = phase_coarse + phase_fine;
   set_gain_phase();
 }
+#endif
 
 void set_diversity_gain(double val) {
   if (val < -27.0) { val = -27.0; }
@@ -125,6 +131,7 @@ void set_diversity_gain(double val) {
   if (div_gain < -25.0) { gain_coarse = -25.0; }
 
   gain_fine = div_gain - gain_coarse;
+#ifndef HEADLESS
 
   if (gain_coarse_scale != NULL && gain_fine_scale != NULL) {
     gtk_range_set_value(GTK_RANGE(gain_coarse_scale), gain_coarse);
@@ -133,6 +140,8 @@ void set_diversity_gain(double val) {
     show_diversity_gain();
   }
 
+#endif
+
   set_gain_phase();
 }
 
@@ -147,6 +156,7 @@ void set_diversity_phase(double value) {
   //
   phase_coarse = 4.0 * round(div_phase * 0.25);
   phase_fine = div_phase - phase_coarse;
+#ifndef HEADLESS
 
   if (phase_coarse_scale != NULL && phase_fine_scale != NULL) {
     gtk_range_set_value(GTK_RANGE(phase_coarse_scale), phase_coarse);
@@ -155,6 +165,8 @@ void set_diversity_phase(double value) {
     show_diversity_phase();
   }
 
+#endif
+
   set_gain_phase();
 }
 
@@ -179,6 +191,7 @@ void set_diversity(int state) {
   g_idle_add(ext_vfo_update, NULL);
 }
 
+#ifndef HEADLESS
 void diversity_menu(GtkWidget *parent) {
   dialog = gtk_dialog_new();
   gtk_window_set_transient_for(GTK_WINDOW(dialog), GTK_WINDOW(parent));
@@ -281,3 +294,4 @@ void diversity_menu(GtkWidget *parent) {
   sub_menu = dialog;
   gtk_widget_show_all(dialog);
 }
+#endif
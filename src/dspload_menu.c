@@ -0,0 +1,291 @@
+/* Copyright (C)
+*
+* 2024,2025 - Heiko Amft, DL1BZ (Project deskHPSDR)
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+//
+// DSP load menu: shows how much of the real-time budget the WDSP
+// channels (and the code that feeds them) use, per receiver and for
+// the transmitter, and which RXA/TXA stages take the time.
+//
+
+#include <gtk/gtk.h>
+#include <semaphore.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wdsp.h>
+
+#include "new_menu.h"
+#include "dspload_menu.h"
+#include "radio.h"
+#include "receiver.h"
+#include "transmitter.h"
+#include "message.h"
+
+#define MAX_UNITS 8     // receivers plus the transmitter
+#define STAGE_UNITS 3   // stage lists side by side, each spans two columns
+
+enum _dspload_column {
+  COL_DSP = 0,
+  COL_BUDGET,
+  COL_FEXCHANGE,
+  COL_SPECTRUM,
+  COL_BUFFER,
+  COL_PSCALC,
+  NUM_COLUMNS
+};
+
+static const char *column_title[NUM_COLUMNS] = {
+  "DSP (us)",
+  "Budget (%)",
+  "fexchange (us)",
+  "Spectrum (us)",
+  "Buffer (us)",
+  "PS calc (us)"
+};
+
+static GtkWidget *dialog = NULL;
+static guint refresh_timer = 0;
+
+static int units = 0;
+static RECEIVER *unit_rx[MAX_UNITS];         // NULL for the transmitter
+static GtkWidget *value_label[MAX_UNITS][NUM_COLUMNS];
+static GtkWidget *stage_label[MAX_UNITS];
+
+static void cleanup() {
+  if (refresh_timer != 0) {
+    g_source_remove(refresh_timer);
+    refresh_timer = 0;
+  }
+
+  if (dialog != NULL) {
+    GtkWidget *tmp = dialog;
+    dialog = NULL;
+    gtk_widget_destroy(tmp);
+    sub_menu = NULL;
+    active_menu  = NO_MENU;
+    radio_save_state();
+  }
+}
+
+static gboolean close_cb () {
+  cleanup();
+  return TRUE;
+}
+
+static void unit_name(int u, char *text, size_t len) {
+  if (unit_rx[u]) {
+    snprintf(text, len, "RX%d", unit_rx[u]->id + 1);
+  } else {
+    snprintf(text, len, "TX");
+  }
+}
+
+static void set_value(GtkWidget *label, double avg, double peak, long count) {
+  char text[64];
+
+  if (count > 0) {
+    snprintf(text, sizeof(text), "%.0f / %.0f", avg, peak);
+  } else {
+    snprintf(text, sizeof(text), "-");
+  }
+
+  gtk_label_set_text(GTK_LABEL(label), text);
+}
+
+#ifndef EXTNR
+static void set_stages(GtkWidget *label, int id, int is_tx) {
+  int n = is_tx ? GetTXAStageCount() : GetRXAStageCount();
+  double *us = g_new(double, n);
+  double *peak = g_new(double, n);
+  int *active = g_new(int, n);
+  char text[2048];
+  size_t len = 0;
+
+  if (is_tx) {
+    GetTXAStageTimes(id, us, peak, active);
+  } else {
+    GetRXAStageTimes(id, us, peak, active);
+  }
+
+  text[0] = 0;
+
+  for (int i = 0; i < n; i++) {
+    if (!active[i] || len >= sizeof(text)) { continue; }
+
+    len += snprintf(text + len, sizeof(text) - len, "%-10s %6.1f / %6.1f\n",
+                    is_tx ? GetTXAStageName(i) : GetRXAStageName(i), us[i], peak[i]);
+  }
+
+  if (len > 0 && len < sizeof(text)) { text[len - 1] = 0; }  // drop the last newline
+
+  gtk_label_set_text(GTK_LABEL(label), text);
+  g_free(us);
+  g_free(peak);
+  g_free(active);
+}
+
+#endif
+
+static int refresh_cb(gpointer data) {
+  if (dialog == NULL) { return FALSE; }
+
+  for (int u = 0; u < units; u++) {
+    const RECEIVER *rx = unit_rx[u];
+    int id = rx ? rx->id : transmitter->id;
+    long count = rx ? rx->full_buffer_count : transmitter->full_buffer_count;
+    double time = rx ? rx->full_buffer_time : transmitter->full_buffer_time;
+    double peak = rx ? rx->full_buffer_peak : transmitter->full_buffer_peak;
+    set_value(value_label[u][COL_BUFFER], count > 0 ? time / count : 0.0, peak, count);
+#ifndef EXTNR
+    double avg_us, peak_us;
+    double period = GetDSPLoadPeriod(id);
+    GetDSPLoad(DSPLOAD_XMAIN, id, &avg_us, &peak_us, &count);
+    set_value(value_label[u][COL_DSP], avg_us, peak_us, count);
+
+    if (period > 0.0) {
+      set_value(value_label[u][COL_BUDGET], 100.0 * avg_us / period, 100.0 * peak_us / period, count);
+    }
+
+    GetDSPLoad(DSPLOAD_FEXCHANGE, id, &avg_us, &peak_us, &count);
+    set_value(value_label[u][COL_FEXCHANGE], avg_us, peak_us, count);
+    GetDSPLoad(DSPLOAD_SPECTRUM, id, &avg_us, &peak_us, &count);
+    set_value(value_label[u][COL_SPECTRUM], avg_us, peak_us, count);
+
+    if (rx == NULL) {
+      GetDSPLoad(DSPLOAD_CALCC, id, &avg_us, &peak_us, &count);
+      set_value(value_label[u][COL_PSCALC], avg_us, peak_us, count);
+    }
+
+    set_stages(stage_label[u], id, rx == NULL);
+#endif
+  }
+
+  return TRUE;
+}
+
+static gboolean run_cb(GtkWidget *widget, gpointer data) {
+  dsp_profile = gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(widget));
+  radio_set_dsp_profile();
+  return TRUE;
+}
+
+static gboolean reset_cb(GtkWidget *widget, GdkEventButton *event, gpointer data) {
+  radio_reset_dsp_profile();
+  return TRUE;
+}
+
+void dspload_menu(GtkWidget *parent) {
+  char text[64];
+  int row;
+  dialog = gtk_dialog_new();
+  gtk_window_set_transient_for(GTK_WINDOW(dialog), GTK_WINDOW(parent));
+  GtkWidget *headerbar = gtk_header_bar_new();
+  gtk_window_set_titlebar(GTK_WINDOW(dialog), headerbar);
+  gtk_header_bar_set_show_close_button(GTK_HEADER_BAR(headerbar), TRUE);
+#if defined (__LDESK__)
+  char _title[32];
+  snprintf(_title, 32, "%s - DSP Load", PGNAME);
+  gtk_header_bar_set_title(GTK_HEADER_BAR(headerbar), _title);
+#else
+  gtk_header_bar_set_title(GTK_HEADER_BAR(headerbar), "piHPSDR - DSP Load");
+#endif
+  g_signal_connect (dialog, "delete_event", G_CALLBACK (close_cb), NULL);
+  g_signal_connect (dialog, "destroy", G_CALLBACK (close_cb), NULL);
+  GtkWidget *content = gtk_dialog_get_content_area(GTK_DIALOG(dialog));
+  GtkWidget *grid = gtk_grid_new();
+  gtk_grid_set_column_spacing (GTK_GRID(grid), 10);
+  gtk_grid_set_row_spacing (GTK_GRID(grid), 5);
+  GtkWidget *close_b = gtk_button_new_with_label("Close");
+  gtk_widget_set_name(close_b, "close_button");
+  g_signal_connect (close_b, "button-press-event", G_CALLBACK(close_cb), NULL);
+  gtk_grid_attach(GTK_GRID(grid), close_b, 0, 0, 1, 1);
+  GtkWidget *run_b = gtk_check_button_new_with_label("Measure");
+  gtk_widget_set_name(run_b, "boldlabel");
+  gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(run_b), dsp_profile);
+  g_signal_connect (run_b, "toggled", G_CALLBACK(run_cb), NULL);
+  gtk_grid_attach(GTK_GRID(grid), run_b, 1, 0, 1, 1);
+  GtkWidget *reset_b = gtk_button_new_with_label("Reset");
+  g_signal_connect (reset_b, "button-press-event", G_CALLBACK(reset_cb), NULL);
+  gtk_grid_attach(GTK_GRID(grid), reset_b, 2, 0, 1, 1);
+  //
+  // One row per receiver and one for the transmitter,
+  // times are given as "average / peak" per buffer
+  //
+  row = 1;
+
+  for (int c = 0; c < NUM_COLUMNS; c++) {
+    GtkWidget *label = gtk_label_new(column_title[c]);
+    gtk_widget_set_name(label, "boldlabel");
+    gtk_grid_attach(GTK_GRID(grid), label, c + 1, row, 1, 1);
+  }
+
+  row++;
+  units = 0;
+
+  for (int i = 0; i < receivers && units < MAX_UNITS - 1; i++) {
+    unit_rx[units++] = receiver[i];
+  }
+
+  if (can_transmit) {
+    unit_rx[units++] = NULL;
+  }
+
+  for (int u = 0; u < units; u++) {
+    unit_name(u, text, sizeof(text));
+    GtkWidget *label = gtk_label_new(text);
+    gtk_widget_set_name(label, "boldlabel");
+    gtk_widget_set_halign(label, GTK_ALIGN_START);
+    gtk_grid_attach(GTK_GRID(grid), label, 0, row, 1, 1);
+
+    for (int c = 0; c < NUM_COLUMNS; c++) {
+      value_label[u][c] = gtk_label_new("-");
+      gtk_grid_attach(GTK_GRID(grid), value_label[u][c], c + 1, row, 1, 1);
+    }
+
+    row++;
+  }
+
+  //
+  // Below: the stages of each RXA/TXA pipeline that are currently run,
+  // with their average and peak time per buffer (in us). STAGE_UNITS
+  // of them side by side, each under a title, then the next row.
+  //
+  for (int u = 0; u < units; u++) {
+    int col = 1 + 2 * (u % STAGE_UNITS);
+
+    if (u > 0 && u % STAGE_UNITS == 0) { row += 2; }
+
+    unit_name(u, text, sizeof(text));
+    g_strlcat(text, " stages", sizeof(text));
+    GtkWidget *label = gtk_label_new(text);
+    gtk_widget_set_name(label, "boldlabel");
+    gtk_widget_set_halign(label, GTK_ALIGN_START);
+    gtk_grid_attach(GTK_GRID(grid), label, col, row, 2, 1);
+    stage_label[u] = gtk_label_new("");
+    gtk_widget_set_valign(stage_label[u], GTK_ALIGN_START);
+    gtk_widget_set_halign(stage_label[u], GTK_ALIGN_START);
+    gtk_grid_attach(GTK_GRID(grid), stage_label[u], col, row + 1, 2, 1);
+  }
+
+  gtk_container_add(GTK_CONTAINER(content), grid);
+  sub_menu = dialog;
+  gtk_widget_show_all(dialog);
+  refresh_cb(NULL);
+  refresh_timer = g_timeout_add(1000, refresh_cb, NULL);
+}
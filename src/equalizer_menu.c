@@ -37,6 +37,7 @@
 #if defined (__LDESK__)
   #include "tx_menu.h"
 #endif
+#ifndef HEADLESS
 static GtkWidget *dialog = NULL;
 
 static GtkWidget *rx1_container;
@@ -69,7 +70,7 @@ static gboolean close_cb () {
   cleanup();
   return TRUE;
 }
-
+#endif
 
 void update_eq() {
   if (can_transmit) {
@@ -81,6 +82,7 @@ void update_eq() {
   }
 }
 
+#ifndef HEADLESS
 static void enable_cb (GtkWidget *widget, gpointer data) {
   int val = gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(widget));
 
@@ -392,3 +394,4 @@ void equalizer_menu(GtkWidget *parent) {
     break;
   }
 }
+#endif
@@ -20,6 +20,7 @@
 */
 
 #include <gtk/gtk.h>
+#include <wdsp.h>             // only needed for WDSPwisdomStop
 #include <semaphore.h>
 #include <stdio.h>
 #include <string.h>
@@ -45,7 +46,9 @@
   #include "saturnmain.h"
 #endif
 
+#ifndef HEADLESS
 static GtkWidget *dialog = NULL;
+#endif
 
 void stop_program() {
 #ifdef GPIO
@@ -56,6 +59,11 @@ void stop_program() {
   t_print("%s: protocol stopped\n", __FUNCTION__);
   radio_stop();
   t_print("%s: radio stopped\n", __FUNCTION__);
+  impulse_cache_save();
+#ifndef EXTNR
+  // a background wisdom generation resumes upon next start
+  WDSPwisdomStop();
+#endif
   t_print("%s: cleanup global cURL...\n", __FUNCTION__);
   curl_global_cleanup();
 
@@ -79,6 +87,7 @@ void stop_program() {
   t_print("%s: radio state saved\n", __FUNCTION__);
 }
 
+#ifndef HEADLESS
 static void cleanup() {
   if (dialog != NULL) {
     GtkWidget *tmp = dialog;
@@ -164,3 +173,4 @@ void exit_menu(GtkWidget *parent) {
   sub_menu = dialog;
   gtk_widget_show_all(dialog);
 }
+#endif
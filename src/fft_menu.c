@@ -25,6 +25,7 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include <wdsp.h>             // only needed for the impulse cache
 
 #include "new_menu.h"
 #include "fft_menu.h"
@@ -32,8 +33,21 @@
 #include "message.h"
 
 static GtkWidget *dialog = NULL;
+#ifndef EXTNR
+  static GtkWidget *cache_stats_label = NULL;
+  static guint cache_stats_timer = 0;
+#endif
 
 static void cleanup() {
+#ifndef EXTNR
+
+  if (cache_stats_timer != 0) {
+    g_source_remove(cache_stats_timer);
+    cache_stats_timer = 0;
+  }
+
+#endif
+
   if (dialog != NULL) {
     GtkWidget *tmp = dialog;
     dialog = NULL;
@@ -102,6 +116,24 @@ static void filter_size_cb(GtkWidget *widget, gpointer data) {
   //t_print("WDSP filter size channel=%d changed to %d\n", channel, size);
 }
 
+#ifndef EXTNR
+static gboolean cache_stats_update(gpointer data) {
+  long hits, misses;
+  int entries;
+  char text[128];
+  GetImpulseCacheStats(&hits, &misses, &entries);
+  snprintf(text, sizeof(text), "%d impulses, %ld hits, %ld misses", entries, hits, misses);
+  gtk_label_set_text(GTK_LABEL(cache_stats_label), text);
+  return G_SOURCE_CONTINUE;
+}
+
+static void impulse_cache_cb(GtkWidget *widget, gpointer data) {
+  impulse_cache_enable = gtk_toggle_button_get_active (GTK_TOGGLE_BUTTON (widget));
+  use_impulse_cache(impulse_cache_enable);
+}
+
+#endif
+
 void fft_menu(GtkWidget *parent) {
   GtkWidget *w;
   dialog = gtk_dialog_new();
@@ -222,6 +254,25 @@ void fft_menu(GtkWidget *parent) {
     col++;
   }
 
+#ifndef EXTNR
+  //
+  // WDSP keeps computed filter impulse responses, such that a filter,
+  // mode or sample rate change that has been done before needs no
+  // re-calculation. The cache is saved upon program exit.
+  //
+  w = gtk_label_new("Filter Cache");
+  gtk_widget_set_name(w, "boldlabel");
+  gtk_grid_attach(GTK_GRID(grid), w, 0, 5, 1, 1);
+  w = gtk_check_button_new();
+  gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(w), impulse_cache_enable);
+  gtk_grid_attach(GTK_GRID(grid), w, 1, 5, 1, 1);
+  g_signal_connect(w, "toggled", G_CALLBACK(impulse_cache_cb), NULL);
+  cache_stats_label = gtk_label_new("");
+  gtk_widget_set_halign(cache_stats_label, GTK_ALIGN_START);
+  gtk_grid_attach(GTK_GRID(grid), cache_stats_label, 2, 5, 2, 1);
+  cache_stats_update(NULL);
+  cache_stats_timer = g_timeout_add(1000, cache_stats_update, NULL);
+#endif
   gtk_container_add(GTK_CONTAINER(content), grid);
   sub_menu = dialog;
   gtk_widget_show_all(dialog);
@@ -0,0 +1,384 @@
+/* Copyright (C)
+*
+* 2024,2025 - Heiko Amft, DL1BZ (Project deskHPSDR)
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+//
+// Program frame of the headless deskHPSDR (make headless).
+//
+// This takes the place of main.c: there is no window, no menu and
+// no panadapter/waterfall. The radio is controlled via rigctl (CAT)
+// and TCI only, and everything runs in a plain GLib main loop, so
+// the g_idle_add() and g_timeout_add() calls of the core work as
+// in the GUI version. The radio is chosen from the props files of
+// the last session, that is, the first time the GUI version should
+// be used to set up the radio.
+//
+// Remote displays get the spectrum with the TCI commands
+// rx_spectrum_enable and tx_spectrum_enable (see tci.c).
+//
+// The GUI-only source files are not compiled. The functions they
+// export to the core are replaced here, everything that would open a
+// menu does nothing. sliders.c and zoompan.c are compiled, without
+// their widgets (see there).
+//
+// Command line options, in addition to the --replay options (see iqreplay.h):
+//
+// -V          print the version and exit
+// --radio=N   use the N-th discovered radio (default: the first available one)
+//
+
+#include <glib.h>
+#include <glib-unix.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/resource.h>
+#include <curl/curl.h>
+#include <wdsp.h>    // only needed for WDSPwisdom() and the impulse cache
+
+#include "actions.h"
+#include "audio.h"
+#include "band.h"
+#include "discovered.h"
+#include "exit_menu.h"
+#include "ext.h"
+#include "gpio.h"
+#include "iqconv.h"
+#include "iqreplay.h"
+#include "main.h"
+#include "message.h"
+#include "mode.h"
+#include "new_discovery.h"
+#include "new_menu.h"
+#include "old_discovery.h"
+#include "protocols.h"
+#include "radio.h"
+#include "receiver.h"
+#ifdef SOAPYSDR
+  #include "soapy_discovery.h"
+#endif
+#include "startup.h"
+#include "toolbar.h"
+#include "transmitter.h"
+#include "version.h"
+#include "vfo.h"
+
+struct utsname unameData;
+
+int display_width;
+int display_height;
+int screen_height;
+int screen_width;
+int full_screen;
+
+pthread_t deskhpsdr_main_thread;
+
+static int radio_index = -1;    // --radio=N
+
+#ifndef EXTNR
+  static char impulse_cache_file[1024];
+#endif
+
+//
+// main.c
+//
+void status_text(const char *text) {
+  t_print("%s\n", text);
+}
+
+void impulse_cache_save() {
+#ifndef EXTNR
+
+  if (impulse_cache_file[0] == 0) { return; }
+
+  long hits, misses;
+  int entries;
+  GetImpulseCacheStats(&hits, &misses, &entries);
+  t_print("%s: impulse cache: %ld hits, %ld misses, %d entries\n", __FUNCTION__, hits, misses, entries);
+
+  if (save_impulse_cache(impulse_cache_file) != 0) {
+    t_print("%s: could not write %s\n", __FUNCTION__, impulse_cache_file);
+  }
+
+#endif
+}
+
+int fatal_error(void *data) {
+  static int quit = 0;
+
+  if (quit) {
+    return 0;
+  }
+
+  quit = 1;
+  t_print("deskHPSDR termination due to fatal error: %s\n", (const char *) data);
+  exit(1);
+}
+
+//
+// discovery.c
+//
+#define IPADDR_LEN 20
+static char ipaddr_buf[IPADDR_LEN] = "";
+char *ipaddr_radio = &ipaddr_buf[0];
+
+int discover_only_stemlab = 0;
+
+//
+// toolbar.c
+//
+int function = 0;
+SWITCH *toolbar_switches = switches_controller1[0];
+
+void update_toolbar_labels() {
+}
+
+//
+// new_menu.c: there are no menus
+//
+void new_menu() {
+}
+
+void start_band() {
+}
+
+void start_bandstack() {
+}
+
+void start_mode() {
+}
+
+void start_filter() {
+}
+
+void start_noise() {
+}
+
+void start_vfo(int vfo) {
+}
+
+void start_agc() {
+}
+
+void start_store() {
+}
+
+void start_rx() {
+}
+
+void start_tx() {
+}
+
+void start_diversity() {
+}
+
+void start_ps() {
+}
+
+int menu_active_receiver_changed(void *data) {
+  return FALSE;
+}
+
+//
+// Find the radios and start the chosen one. If there is none,
+// try again every five seconds.
+//
+static int headless_discovery(gpointer data) {
+  int i;
+  FILE *fp = fopen("ip.addr", "r");
+
+  if (fp) {
+    (void) fgets(ipaddr_radio, IPADDR_LEN, fp);
+    fclose(fp);
+    ipaddr_radio[IPADDR_LEN - 1] = 0;
+    // remove possible trailing newline char in ipaddr_radio
+    int len = strnlen(ipaddr_radio, IPADDR_LEN);
+
+    while (--len >= 0) {
+      if (ipaddr_radio[len] != '\n') { break; }
+
+      ipaddr_radio[len] = 0;
+    }
+  }
+
+  selected_device = 0;
+  devices = 0;
+
+  if (!iqreplay_discovery()) {
+    if (enable_protocol_1) {
+      status_text("Protocol 1 ... Discovering Devices");
+      old_discovery();
+    }
+
+    if (enable_protocol_2) {
+      status_text("Protocol 2 ... Discovering Devices");
+      new_discovery();
+    }
+
+#ifdef SOAPYSDR
+
+    if (enable_soapy_protocol) {
+      status_text("SoapySDR ... Discovering Devices");
+      soapy_discovery();
+    }
+
+#endif
+  }
+
+  t_print("%s: found %d devices\n", __FUNCTION__, devices);
+
+  for (i = 0; i < devices; i++) {
+    t_print("%s: %d: %s (protocol %d, %s)\n", __FUNCTION__, i, discovered[i].name, discovered[i].protocol,
+            discovered[i].status == STATE_AVAILABLE ? "available" : "in use");
+  }
+
+  if (radio_index >= 0) {
+    i = radio_index;
+  } else {
+    for (i = 0; i < devices; i++) {
+      if (discovered[i].status == STATE_AVAILABLE) { break; }
+    }
+  }
+
+  if (i >= devices || discovered[i].status != STATE_AVAILABLE) {
+    t_print("%s: no radio available, re-trying in 5 seconds\n", __FUNCTION__);
+    return G_SOURCE_CONTINUE;
+  }
+
+  radio = &discovered[i];
+  status_text("Starting Radio ...");
+  radio_start_radio();
+  return G_SOURCE_REMOVE;
+}
+
+static int init(void *data) {
+  char wisdom_directory[1024];
+  audio_get_cards();
+  iqconv_init();
+  t_print("%s: IQ conversion uses %s code\n", __FUNCTION__, iqconv_impl_name(iqconv_get_impl()));
+#ifndef EXTNR
+  t_print("%s: WDSP filters use %s code\n", __FUNCTION__, GetFirKernelName(GetFirKernel()));
+#endif
+  protocolsRestoreState();
+  (void) getcwd(wisdom_directory, sizeof(wisdom_directory));
+  g_strlcat(wisdom_directory, "/", 1024);
+  t_print("Securing wisdom file in directory: %s\n", wisdom_directory);
+  //
+  // There are no GTK events to handle meanwhile, so there
+  // is no need for a separate wisdom thread
+  //
+#ifdef EXTNR
+  WDSPwisdom (wisdom_directory);
+#else
+
+  if (GetWDSPVersion() % 100 < 26) {
+    WDSPwisdom (wisdom_directory);
+  } else if ((wisdom_quick ? WDSPwisdomQuick (wisdom_directory) : WDSPwisdom (wisdom_directory)) > 1) {
+    t_print("WDSP wisdom file is being built in the background.\n");
+  }
+
+  snprintf(impulse_cache_file, sizeof(impulse_cache_file), "%swdspImpulseCache", wisdom_directory);
+  init_impulse_cache(1);
+
+  if (read_impulse_cache(impulse_cache_file) != 0) {
+    t_print("%s: impulse cache: no valid file %s\n", __FUNCTION__, impulse_cache_file);
+  }
+
+#endif
+
+  if (headless_discovery(NULL) == G_SOURCE_CONTINUE) {
+    g_timeout_add(5000, headless_discovery, NULL);
+  }
+
+  return G_SOURCE_REMOVE;
+}
+
+//
+// SIGINT and SIGTERM take the place of the "Exit" menu
+//
+static int signal_cb(gpointer data) {
+  t_print("%s: terminating ...\n", __FUNCTION__);
+
+  if (radio != NULL) {
+    stop_program();
+  }
+
+  _exit(0);
+}
+
+int main(int argc, char **argv) {
+  int rc;
+  GMainLoop *loop;
+
+  if (argc >= 2 && !strcmp("-V", argv[1])) {
+    uname(&unameData);
+    fprintf(stderr, "deskHPSDR (headless) version %s [%s] (branch %s - commit %s), built date %s with %s\n",
+            build_version, unameData.machine, build_branch, build_commit, build_date, __VERSION__);
+    fprintf(stderr, "Compile-time options      : %sAudioModule=%s\n", build_options, build_audio);
+    exit(0);
+  }
+
+  if (iqreplay_parse_args(&argc, argv) < 0) {
+    exit(1);
+  }
+
+  for (int i = 1; i < argc; i++) {
+    if (!strncmp(argv[i], "--radio=", 8)) {
+      radio_index = atoi(argv[i] + 8);
+    } else {
+      fprintf(stderr, "usage: %s [-V] [--radio=N] [--replay=FILE ...]\n", argv[0]);
+      exit(1);
+    }
+  }
+
+  //
+  // As in main.c: this most likely fails unless we have the
+  // privileges, but then it may help
+  //
+  rc = getpriority(PRIO_PROCESS, 0);
+  t_print("Base priority on startup: %d\n", rc);
+  setpriority(PRIO_PROCESS, 0, -10);
+  rc = getpriority(PRIO_PROCESS, 0);
+  t_print("Base priority after adjustment: %d\n", rc);
+  startup(argv[0]);
+  curl_global_init(CURL_GLOBAL_ALL);
+  deskhpsdr_main_thread = pthread_self();
+  t_print("Build: %s (Branch: %s, Commit: %s, Date: %s), headless\n", build_version, build_branch, build_commit,
+          build_date);
+  uname(&unameData);
+  t_print("sysname: %s, release: %s, machine: %s\n", unameData.sysname, unameData.release, unameData.machine);
+  //
+  // The "screen" size only determines the number of pixels
+  // (that is, the spectrum resolution) for remote clients
+  //
+  display_width  = 1280;
+  display_height = 600;
+  screen_width   = display_width;
+  screen_height  = display_height;
+  full_screen    = 0;
+  loop = g_main_loop_new(NULL, FALSE);
+  g_unix_signal_add(SIGINT, signal_cb, NULL);
+  g_unix_signal_add(SIGTERM, signal_cb, NULL);
+  g_idle_add(init, NULL);
+  g_main_loop_run(loop);
+  g_main_loop_unref(loop);
+  return 0;
+}
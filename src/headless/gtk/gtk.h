@@ -0,0 +1,60 @@
+/* Copyright (C)
+*
+* 2024,2025 - Heiko Amft, DL1BZ (Project deskHPSDR)
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+//
+// Stand-in for <gtk/gtk.h> in the headless build (make headless).
+//
+// The radio core only needs GLib, but many headers pass widgets
+// around in their prototypes. Here the GTK/GDK/cairo types are
+// opaque, so such a prototype still compiles, while any *call*
+// into GTK fails at compile or link time and must be put under
+// #ifndef HEADLESS.
+//
+// The gdk_threads_ functions are (deprecated) aliases of the
+// GLib main loop functions, since GDK only adds its lock.
+//
+
+#ifndef _HEADLESS_GTK_H
+#define _HEADLESS_GTK_H
+
+#include <glib.h>
+
+typedef struct _GtkWidget       GtkWidget;
+typedef struct _GtkGrid         GtkGrid;
+typedef struct _GdkScreen       GdkScreen;
+typedef struct _GdkEventButton  GdkEventButton;
+typedef struct _GdkEventKey     GdkEventKey;
+typedef struct _GdkEventMotion  GdkEventMotion;
+typedef struct _GdkEventScroll  GdkEventScroll;
+typedef union  _GdkEvent        GdkEvent;
+typedef struct _cairo           cairo_t;
+typedef struct _cairo_surface   cairo_surface_t;
+
+typedef struct _GdkRGBA {
+  double red;
+  double green;
+  double blue;
+  double alpha;
+} GdkRGBA;
+
+#define gdk_threads_add_timeout_full g_timeout_add_full
+#define gdk_threads_add_timeout      g_timeout_add
+#define gdk_threads_add_idle         g_idle_add
+
+#endif
@@ -0,0 +1,425 @@
+/* Copyright (C)
+*
+* 2024,2025 - Heiko Amft, DL1BZ (Project deskHPSDR)
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+//
+// Vectorized conversion of 24-bit big-endian IQ samples to double
+// (and back) shared by all protocol modules.
+//
+// The SIMD kernels only deal with contiguous data (stride 6). For
+// interleaved data (P1 frames with more than one receiver, P2 PS and
+// DIVERSITY frames) the scalar loop is used, which is still much faster
+// than converting byte by byte through a state machine.
+//
+// There is no SSE2 kernel since SSE2 has no byte shuffle, so the
+// x86 baseline is SSSE3 (pshufb).
+//
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+  #include <immintrin.h>
+  #define IQCONV_X86
+#endif
+#if defined(__aarch64__)
+  #include <arm_neon.h>
+  #define IQCONV_NEON64
+#endif
+
+#include "iqconv.h"
+
+// The "obscure" constant 1.1920928955078125E-7 is 1/(2^23)
+#define IQ24_SCALE 1.1920928955078125E-7
+
+static int iqconv_impl = IQCONV_SCALAR;
+
+//////////////////////////////////////////////////////////////////////////
+//
+// Scalar versions. These are also used for the "tails" of the SIMD
+// kernels, and for all non-contiguous data.
+//
+//////////////////////////////////////////////////////////////////////////
+
+static void unpack24_scalar(const unsigned char *src, int stride, double *dst, int n) {
+  for (int i = 0; i < n; i++) {
+    int isample = (int)((signed char) src[0]) << 16 | (int)src[1] << 8 | (int)src[2];
+    int qsample = (int)((signed char) src[3]) << 16 | (int)src[4] << 8 | (int)src[5];
+    *dst++ = (double)isample * IQ24_SCALE;
+    *dst++ = (double)qsample * IQ24_SCALE;
+    src += stride;
+  }
+}
+
+//
+// Rounding is "half away from zero", this is what the TX engine
+// always did with floor(x + 0.5) and ceil(x - 0.5).
+//
+static inline int iq_round(double x) {
+  return x >= 0.0 ? (int)(x + 0.5) : (int)(x - 0.5);
+}
+
+static void pack24_scalar(const double *src, unsigned char *dst, int stride, int n, double gain) {
+  for (int i = 0; i < n; i++) {
+    int isample = iq_round(*src++ * gain);
+    int qsample = iq_round(*src++ * gain);
+    dst[0] = (isample >> 16) & 0xFF;
+    dst[1] = (isample >>  8) & 0xFF;
+    dst[2] = (isample      ) & 0xFF;
+    dst[3] = (qsample >> 16) & 0xFF;
+    dst[4] = (qsample >>  8) & 0xFF;
+    dst[5] = (qsample      ) & 0xFF;
+    dst += stride;
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////
+//
+// x86 kernels. These are compiled with target attributes so the rest
+// of the program needs no special compiler flags, and only called if
+// the CPU supports them.
+//
+//////////////////////////////////////////////////////////////////////////
+
+#ifdef IQCONV_X86
+//
+// Shuffle four 3-byte big-endian samples into the upper three bytes
+// of four little-endian 32-bit lanes. An arithmetic shift right by 8
+// then sign-extends them.
+//
+__attribute__((target("ssse3")))
+static void unpack24_ssse3(const unsigned char *src, double *dst, int nsamples) {
+  const __m128i shuf = _mm_set_epi8(9, 10, 11, -1, 6, 7, 8, -1, 3, 4, 5, -1, 0, 1, 2, -1);
+  const __m128d scale = _mm_set1_pd(IQ24_SCALE);
+  int i = 0;
+
+  // a 16-byte load covers 4 samples (12 bytes) plus 4 bytes look-ahead
+  for (; i + 6 <= nsamples; i += 4) {
+    __m128i v = _mm_loadu_si128((const __m128i *)(src + 3 * i));
+    v = _mm_srai_epi32(_mm_shuffle_epi8(v, shuf), 8);
+    _mm_storeu_pd(dst + i,     _mm_mul_pd(_mm_cvtepi32_pd(v), scale));
+    _mm_storeu_pd(dst + i + 2, _mm_mul_pd(_mm_cvtepi32_pd(_mm_unpackhi_epi64(v, v)), scale));
+  }
+
+  unpack24_scalar(src + 3 * i, 6, dst + i, (nsamples - i) / 2);
+}
+
+__attribute__((target("avx2")))
+static void unpack24_avx2(const unsigned char *src, double *dst, int nsamples) {
+  const __m128i shuf = _mm_set_epi8(9, 10, 11, -1, 6, 7, 8, -1, 3, 4, 5, -1, 0, 1, 2, -1);
+  const __m256d scale = _mm256_set1_pd(IQ24_SCALE);
+  int i = 0;
+
+  // two 16-byte loads cover 8 samples (24 bytes) plus 4 bytes look-ahead
+  for (; i + 10 <= nsamples; i += 8) {
+    __m128i v0 = _mm_loadu_si128((const __m128i *)(src + 3 * i));
+    __m128i v1 = _mm_loadu_si128((const __m128i *)(src + 3 * i + 12));
+    v0 = _mm_srai_epi32(_mm_shuffle_epi8(v0, shuf), 8);
+    v1 = _mm_srai_epi32(_mm_shuffle_epi8(v1, shuf), 8);
+    _mm256_storeu_pd(dst + i,     _mm256_mul_pd(_mm256_cvtepi32_pd(v0), scale));
+    _mm256_storeu_pd(dst + i + 4, _mm256_mul_pd(_mm256_cvtepi32_pd(v1), scale));
+  }
+
+  unpack24_scalar(src + 3 * i, 6, dst + i, (nsamples - i) / 2);
+}
+
+//
+// Packing: cvttpd truncates towards zero, so adding +/- 0.5 (with the
+// sign of the sample) first gives "round half away from zero".
+//
+__attribute__((target("ssse3")))
+static void pack24_ssse3(const double *src, unsigned char *dst, int nsamples, double gain) {
+  const __m128i shuf = _mm_set_epi8(-1, -1, -1, -1, 12, 13, 14, 8, 9, 10, 4, 5, 6, 0, 1, 2);
+  const __m128d g = _mm_set1_pd(gain);
+  const __m128d half = _mm_set1_pd(0.5);
+  const __m128d sign = _mm_set1_pd(-0.0);
+  int i = 0;
+
+  // the 16-byte store writes 4 bytes beyond the 4 samples
+  for (; i + 6 <= nsamples; i += 4) {
+    __m128d x0 = _mm_mul_pd(_mm_loadu_pd(src + i), g);
+    __m128d x1 = _mm_mul_pd(_mm_loadu_pd(src + i + 2), g);
+    x0 = _mm_add_pd(x0, _mm_or_pd(half, _mm_and_pd(x0, sign)));
+    x1 = _mm_add_pd(x1, _mm_or_pd(half, _mm_and_pd(x1, sign)));
+    __m128i v = _mm_unpacklo_epi64(_mm_cvttpd_epi32(x0), _mm_cvttpd_epi32(x1));
+    _mm_storeu_si128((__m128i *)(dst + 3 * i), _mm_shuffle_epi8(v, shuf));
+  }
+
+  pack24_scalar(src + i, dst + 3 * i, 6, (nsamples - i) / 2, gain);
+}
+
+__attribute__((target("avx2")))
+static void pack24_avx2(const double *src, unsigned char *dst, int nsamples, double gain) {
+  const __m128i shuf = _mm_set_epi8(-1, -1, -1, -1, 12, 13, 14, 8, 9, 10, 4, 5, 6, 0, 1, 2);
+  const __m256d g = _mm256_set1_pd(gain);
+  const __m256d half = _mm256_set1_pd(0.5);
+  const __m256d sign = _mm256_set1_pd(-0.0);
+  int i = 0;
+
+  for (; i + 6 <= nsamples; i += 4) {
+    __m256d x = _mm256_mul_pd(_mm256_loadu_pd(src + i), g);
+    x = _mm256_add_pd(x, _mm256_or_pd(half, _mm256_and_pd(x, sign)));
+    __m128i v = _mm256_cvttpd_epi32(x);
+    _mm_storeu_si128((__m128i *)(dst + 3 * i), _mm_shuffle_epi8(v, shuf));
+  }
+
+  pack24_scalar(src + i, dst + 3 * i, 6, (nsamples - i) / 2, gain);
+}
+#endif
+
+//////////////////////////////////////////////////////////////////////////
+//
+// ARM64 kernels. NEON is always present on aarch64. A 24-bit sample
+// converts exactly to float, which is then widened to double.
+//
+//////////////////////////////////////////////////////////////////////////
+
+#ifdef IQCONV_NEON64
+static const uint8_t neon_unpack_idx[16] = { 255, 2, 1, 0, 255, 5, 4, 3, 255, 8, 7, 6, 255, 11, 10, 9 };
+static const uint8_t neon_pack_idx[16]   = { 2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, 255, 255, 255, 255 };
+
+static void unpack24_neon(const unsigned char *src, double *dst, int nsamples) {
+  const uint8x16_t idx = vld1q_u8(neon_unpack_idx);
+  const float64x2_t scale = vdupq_n_f64(IQ24_SCALE);
+  int i = 0;
+
+  for (; i + 6 <= nsamples; i += 4) {
+    uint8x16_t b = vqtbl1q_u8(vld1q_u8(src + 3 * i), idx);
+    int32x4_t v = vshrq_n_s32(vreinterpretq_s32_u8(b), 8);
+    float32x4_t f = vcvtq_f32_s32(v);
+    vst1q_f64(dst + i,     vmulq_f64(vcvt_f64_f32(vget_low_f32(f)), scale));
+    vst1q_f64(dst + i + 2, vmulq_f64(vcvt_high_f64_f32(f), scale));
+  }
+
+  unpack24_scalar(src + 3 * i, 6, dst + i, (nsamples - i) / 2);
+}
+
+static void pack24_neon(const double *src, unsigned char *dst, int nsamples, double gain) {
+  const uint8x16_t idx = vld1q_u8(neon_pack_idx);
+  const float64x2_t g = vdupq_n_f64(gain);
+  int i = 0;
+
+  for (; i + 6 <= nsamples; i += 4) {
+    // vcvtaq rounds to nearest with ties away from zero
+    int64x2_t l0 = vcvtaq_s64_f64(vmulq_f64(vld1q_f64(src + i), g));
+    int64x2_t l1 = vcvtaq_s64_f64(vmulq_f64(vld1q_f64(src + i + 2), g));
+    int32x4_t v = vcombine_s32(vmovn_s64(l0), vmovn_s64(l1));
+    vst1q_u8(dst + 3 * i, vqtbl1q_u8(vreinterpretq_u8_s32(v), idx));
+  }
+
+  pack24_scalar(src + i, dst + 3 * i, 6, (nsamples - i) / 2, gain);
+}
+#endif
+
+//////////////////////////////////////////////////////////////////////////
+//
+// Public interface
+//
+//////////////////////////////////////////////////////////////////////////
+
+void iq_unpack24(const unsigned char *src, int stride, double *dst, int n) {
+  if (stride != 6) {
+    unpack24_scalar(src, stride, dst, n);
+    return;
+  }
+
+  switch (iqconv_impl) {
+#ifdef IQCONV_X86
+
+  case IQCONV_SSSE3:
+    unpack24_ssse3(src, dst, 2 * n);
+    break;
+
+  case IQCONV_AVX2:
+    unpack24_avx2(src, dst, 2 * n);
+    break;
+#endif
+#ifdef IQCONV_NEON64
+
+  case IQCONV_NEON:
+    unpack24_neon(src, dst, 2 * n);
+    break;
+#endif
+
+  default:
+    unpack24_scalar(src, 6, dst, n);
+    break;
+  }
+}
+
+void iq_pack24(const double *src, unsigned char *dst, int stride, int n, double gain) {
+  if (stride != 6) {
+    pack24_scalar(src, dst, stride, n, gain);
+    return;
+  }
+
+  switch (iqconv_impl) {
+#ifdef IQCONV_X86
+
+  case IQCONV_SSSE3:
+    pack24_ssse3(src, dst, 2 * n, gain);
+    break;
+
+  case IQCONV_AVX2:
+    pack24_avx2(src, dst, 2 * n, gain);
+    break;
+#endif
+#ifdef IQCONV_NEON64
+
+  case IQCONV_NEON:
+    pack24_neon(src, dst, 2 * n, gain);
+    break;
+#endif
+
+  default:
+    pack24_scalar(src, dst, 6, n, gain);
+    break;
+  }
+}
+
+//
+// 16-bit samples are only used by the original protocol, where
+// TX IQ pairs are always interleaved with audio samples. The LSB mask
+// allows to clear the least significant bit (needed for the HL2).
+//
+void iq_pack16(const double *src, unsigned char *dst, int stride, int n, double gain, int lsbmask) {
+  for (int i = 0; i < n; i++) {
+    int isample = iq_round(*src++ * gain);
+    int qsample = iq_round(*src++ * gain);
+    dst[0] = (isample >> 8) & 0xFF;
+    dst[1] = isample & lsbmask;
+    dst[2] = (qsample >> 8) & 0xFF;
+    dst[3] = qsample & lsbmask;
+    dst += stride;
+  }
+}
+
+int iqconv_impl_available(int impl) {
+  switch (impl) {
+  case IQCONV_SCALAR:
+    return 1;
+#ifdef IQCONV_X86
+
+  case IQCONV_SSSE3:
+    return __builtin_cpu_supports("ssse3");
+
+  case IQCONV_AVX2:
+    return __builtin_cpu_supports("avx2");
+#endif
+#ifdef IQCONV_NEON64
+
+  case IQCONV_NEON:
+    return 1;
+#endif
+
+  default:
+    return 0;
+  }
+}
+
+void iqconv_init() {
+  int impl = IQCONV_SCALAR;
+#ifdef IQCONV_X86
+  __builtin_cpu_init();
+#endif
+
+  for (int i = IQCONV_SCALAR; i < IQCONV_NUM_IMPL; i++) {
+    if (iqconv_impl_available(i)) { impl = i; }
+  }
+
+  iqconv_impl = impl;
+}
+
+int iqconv_get_impl() {
+  return iqconv_impl;
+}
+
+void iqconv_set_impl(int impl) {
+  if (impl >= 0 && impl < IQCONV_NUM_IMPL && iqconv_impl_available(impl)) {
+    iqconv_impl = impl;
+  }
+}
+
+const char *iqconv_impl_name(int impl) {
+  switch (impl) {
+  case IQCONV_SCALAR:
+    return "scalar";
+
+  case IQCONV_SSSE3:
+    return "SSSE3";
+
+  case IQCONV_AVX2:
+    return "AVX2";
+
+  case IQCONV_NEON:
+    return "NEON";
+
+  default:
+    return "unknown";
+  }
+}
+
+//
+// Micro-benchmark: convert a P2-sized frame (n IQ pairs) repeatedly
+// with the given implementation and return the time needed per sample
+// in nanoseconds (or a negative value if the implementation is not
+// available on this CPU).
+//
+double iqconv_benchmark(int impl, int pack, int n) {
+  struct timespec ts, te;
+  int loops = 2000;
+  int saved = iqconv_impl;
+  unsigned char *bytes;
+  double *iq;
+  double ns;
+
+  if (!iqconv_impl_available(impl) || n <= 0) { return -1.0; }
+
+  bytes = malloc(6 * n);
+  iq = malloc(2 * n * sizeof(double));
+
+  if (bytes == NULL || iq == NULL) {
+    free(bytes);
+    free(iq);
+    return -1.0;
+  }
+
+  for (int i = 0; i < 6 * n; i++) {
+    bytes[i] = (unsigned char)(i * 37 + 11);
+  }
+
+  iq_unpack24(bytes, 6, iq, n);
+  iqconv_impl = impl;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  for (int l = 0; l < loops; l++) {
+    if (pack) {
+      iq_pack24(iq, bytes, 6, n, 8388607.0);
+    } else {
+      iq_unpack24(bytes, 6, iq, n);
+    }
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &te);
+  iqconv_impl = saved;
+  ns = (te.tv_sec - ts.tv_sec) * 1.0E9 + (te.tv_nsec - ts.tv_nsec);
+  free(bytes);
+  free(iq);
+  return ns / ((double)loops * 2.0 * n);
+}
@@ -0,0 +1,56 @@
+/* Copyright (C)
+*
+* 2024,2025 - Heiko Amft, DL1BZ (Project deskHPSDR)
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+#ifndef _IQCONV_H
+#define _IQCONV_H
+
+//
+// Conversion between the HPSDR wire format of IQ samples
+// (24-bit or 16-bit signed, big-endian, I followed by Q)
+// and interleaved double IQ buffers.
+//
+// "n" is always the number of IQ pairs, "stride" the distance
+// in bytes between two consecutive IQ pairs (6 for contiguous
+// 24-bit data).
+//
+// iqconv_init() selects the fastest implementation the CPU
+// supports. Before it has been called, the scalar code is used.
+//
+
+enum _iqconv_impl_enum {
+  IQCONV_SCALAR = 0,
+  IQCONV_SSSE3,
+  IQCONV_AVX2,
+  IQCONV_NEON,
+  IQCONV_NUM_IMPL
+};
+
+extern void        iqconv_init(void);
+extern int         iqconv_get_impl(void);
+extern const char *iqconv_impl_name(int impl);
+extern int         iqconv_impl_available(int impl);
+extern void        iqconv_set_impl(int impl);
+
+extern void iq_unpack24(const unsigned char *src, int stride, double *dst, int n);
+extern void iq_pack24(const double *src, unsigned char *dst, int stride, int n, double gain);
+extern void iq_pack16(const double *src, unsigned char *dst, int stride, int n, double gain, int lsbmask);
+
+extern double iqconv_benchmark(int impl, int pack, int n);
+
+#endif
@@ -0,0 +1,685 @@
+/* Copyright (C)
+*
+* 2024,2025 - Heiko Amft, DL1BZ (Project deskHPSDR)
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+//
+// IQ file replay (see iqreplay.h)
+//
+// The replay thread reads the file in chunks, converts the samples to
+// double and hands them to rx_add_iq_samples() of all running receivers,
+// exactly as the protocol threads do. If the receivers run their own DSP
+// workers, the replay thread waits for a free slot instead of letting
+// the worker drop blocks, so every sample of the file is processed.
+//
+
+#include <gtk/gtk.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <wdsp.h>
+
+#include "discovered.h"
+#include "exit_menu.h"
+#include "iqreplay.h"
+#include "main.h"
+#include "message.h"
+#include "radio.h"
+#include "receiver.h"
+#include "ringbuf.h"
+#include "vfo.h"
+
+#define REPLAY_CHUNK 4096          // IQ frames read from the file at once
+
+static const char *format_name[IQREPLAY_NUM_FORMATS] = { "s16", "s24", "s32", "f32" };
+static const int format_bytes[IQREPLAY_NUM_FORMATS] = { 2, 3, 4, 4 };
+
+//
+// configuration from the command line
+//
+static char *replay_file = NULL;
+static char *audio_file = NULL;
+static int opt_format = IQREPLAY_F32;
+static int opt_channels = 2;
+static int opt_rate = 0;
+static long long opt_frequency = 0;
+static int opt_loops = 1;
+static int opt_realtime = 0;
+static int opt_exit = 0;
+
+//
+// the file currently replayed
+//
+static FILE *fp = NULL;
+static int format;
+static int channels;
+static int rate;
+static long long frequency;
+static long data_offset;
+static long long data_bytes;       // -1: up to the end of the file
+static char description[64];
+
+//
+// replay state
+//
+static GThread *replay_thread_id = NULL;
+static volatile int running = 0;
+static int completed = 0;
+static int loops_done;
+static long long position;         // bytes read from the data chunk in this loop
+static long long frames;           // IQ frames fed to the receivers
+static double run_time;            // wall clock seconds while running
+
+//
+// audio output
+//
+static FILE *audio_fp = NULL;
+static unsigned int audio_bytes;
+static unsigned char audio_buffer[4 * 1024];
+static int audio_count;
+
+static inline unsigned int get_le16(const unsigned char *p) {
+  return (unsigned int)p[0] | (unsigned int)p[1] << 8;
+}
+
+static inline unsigned int get_le32(const unsigned char *p) {
+  return (unsigned int)p[0] | (unsigned int)p[1] << 8 | (unsigned int)p[2] << 16 | (unsigned int)p[3] << 24;
+}
+
+static inline void put_le16(unsigned char *p, unsigned int v) {
+  p[0] = v & 0xFF;
+  p[1] = (v >> 8) & 0xFF;
+}
+
+static inline void put_le32(unsigned char *p, unsigned int v) {
+  p[0] = v & 0xFF;
+  p[1] = (v >> 8) & 0xFF;
+  p[2] = (v >> 16) & 0xFF;
+  p[3] = (v >> 24) & 0xFF;
+}
+
+static void usage() {
+  fprintf(stderr, "IQ file replay options:\n"
+          "  --replay=FILE           IQ file (WAV or raw interleaved I/Q)\n"
+          "  --replay-format=FMT     raw files: s16, s24, s32 or f32 (default f32)\n"
+          "  --replay-channels=N     raw files: number of channels (default 2)\n"
+          "  --replay-rate=HZ        sample rate (required for raw files)\n"
+          "  --replay-freq=HZ        center frequency\n"
+          "  --replay-loops=N        replay the file N times, 0 is endless (default 1)\n"
+          "  --replay-audio=FILE     write the audio of the active receiver to a WAV file\n"
+          "  --replay-realtime       replay at the sample rate instead of as fast as possible\n"
+          "  --replay-exit           exit after the replay\n");
+}
+
+//
+// deskHPSDR changes to its working directory at start-up,
+// so file names must be absolute
+//
+static char *absolute_path(const char *name) {
+  if (g_path_is_absolute(name)) { return g_strdup(name); }
+
+  char *cwd = g_get_current_dir();
+  char *path = g_build_filename(cwd, name, NULL);
+  g_free(cwd);
+  return path;
+}
+
+//
+// Parse and remove the --replay options from the command line.
+// Returns -1 (after printing the usage) if an option is invalid.
+//
+int iqreplay_parse_args(int *argc, char **argv) {
+  int n = 1;
+
+  for (int i = 1; i < *argc; i++) {
+    const char *arg = argv[i];
+    const char *val = strchr(arg, '=');
+    int ok = 1;
+
+    if (strncmp(arg, "--replay", 8) != 0) {
+      argv[n++] = argv[i];
+      continue;
+    }
+
+    if (val) { val++; }
+
+    if (val && *val == 0) { val = NULL; }
+
+    if (val == NULL && strcmp(arg, "--replay-realtime") && strcmp(arg, "--replay-exit")) {
+      ok = 0;
+    } else if (!strncmp(arg, "--replay=", 9)) {
+      g_free(replay_file);
+      replay_file = absolute_path(val);
+    } else if (!strncmp(arg, "--replay-format=", 16)) {
+      ok = 0;
+
+      for (int f = 0; f < IQREPLAY_NUM_FORMATS; f++) {
+        if (!strcmp(val, format_name[f])) {
+          opt_format = f;
+          ok = 1;
+        }
+      }
+    } else if (!strncmp(arg, "--replay-channels=", 18)) {
+      opt_channels = atoi(val);
+      ok = (opt_channels >= 2 && (opt_channels & 1) == 0);
+    } else if (!strncmp(arg, "--replay-rate=", 14)) {
+      opt_rate = atoi(val);
+      ok = (opt_rate > 0);
+    } else if (!strncmp(arg, "--replay-freq=", 14)) {
+      opt_frequency = atoll(val);
+      ok = (opt_frequency > 0);
+    } else if (!strncmp(arg, "--replay-loops=", 15)) {
+      opt_loops = atoi(val);
+      ok = (opt_loops >= 0);
+    } else if (!strncmp(arg, "--replay-audio=", 15)) {
+      g_free(audio_file);
+      audio_file = absolute_path(val);
+    } else if (!strcmp(arg, "--replay-realtime")) {
+      opt_realtime = 1;
+    } else if (!strcmp(arg, "--replay-exit")) {
+      opt_exit = 1;
+    } else {
+      ok = 0;
+    }
+
+    if (!ok) {
+      fprintf(stderr, "Invalid option: %s\n", arg);
+      usage();
+      return -1;
+    }
+  }
+
+  argv[n] = NULL;
+  *argc = n;
+  return 0;
+}
+
+int iqreplay_configured() {
+  return replay_file != NULL;
+}
+
+int iqreplay_sample_rate() {
+  return rate;
+}
+
+const char *iqreplay_description() {
+  return description;
+}
+
+//
+// WAV header: find the format and data chunks, and the center frequency
+// in an "auxi" chunk (written by SpectraVue, HDSDR, SDRuno and others).
+// Returns 0 on success.
+//
+static int open_wav() {
+  unsigned char buf[64];
+  unsigned int tag = 0, bits = 0;
+
+  if (fread(buf, 1, 12, fp) != 12 || memcmp(buf, "RIFF", 4) || memcmp(buf + 8, "WAVE", 4)) {
+    return -1;
+  }
+
+  for (;;) {
+    if (fread(buf, 1, 8, fp) != 8) { return -1; }
+
+    unsigned int size = get_le32(buf + 4);
+
+    if (!memcmp(buf, "data", 4)) {
+      data_offset = ftell(fp);
+      data_bytes = (size == 0 || size == 0xFFFFFFFF) ? -1 : size;
+      break;
+    }
+
+    unsigned int n = size < sizeof(buf) ? size : sizeof(buf);
+
+    if (!memcmp(buf, "fmt ", 4)) {
+      if (size < 16 || fread(buf, 1, n, fp) != n) { return -1; }
+
+      tag = get_le16(buf);
+      channels = get_le16(buf + 2);
+      rate = get_le32(buf + 4);
+      bits = get_le16(buf + 14);
+
+      if (tag == 0xFFFE && size >= 26) { tag = get_le16(buf + 24); }  // WAVE_FORMAT_EXTENSIBLE
+    } else if (!memcmp(buf, "auxi", 4)) {
+      if (fread(buf, 1, n, fp) != n) { return -1; }
+
+      if (size >= 36) { frequency = get_le32(buf + 32); }
+    } else {
+      n = 0;
+    }
+
+    if (fseek(fp, (long)(size - n + (size & 1)), SEEK_CUR) != 0) { return -1; }
+  }
+
+  if (tag == 1 && bits == 16) {
+    format = IQREPLAY_S16;
+  } else if (tag == 1 && bits == 24) {
+    format = IQREPLAY_S24;
+  } else if (tag == 1 && bits == 32) {
+    format = IQREPLAY_S32;
+  } else if (tag == 3 && bits == 32) {
+    format = IQREPLAY_F32;
+  } else {
+    t_print("%s: unsupported WAV format %u with %u bits\n", __FUNCTION__, tag, bits);
+    return -1;
+  }
+
+  return 0;
+}
+
+//
+// Center frequency from the file name, e.g. HDSDR_20250101_120000Z_7100kHz_RF.wav
+// or SDRSharp_20250101_120000Z_7100000Hz_IQ.wav
+//
+static long long name_frequency(const char *name) {
+  const char *p = strrchr(name, G_DIR_SEPARATOR);
+
+  if (p == NULL) { p = name; }
+
+  while ((p = strchr(p, '_')) != NULL) {
+    char *end;
+    long long f = strtoll(++p, &end, 10);
+
+    if (end == p) { continue; }
+
+    if (!strncmp(end, "kHz", 3)) { return 1000LL * f; }
+
+    if (!strncmp(end, "Hz", 2)) { return f; }
+  }
+
+  return 0;
+}
+
+//
+// Open the replay file and add the pseudo device to the discovered list.
+// Returns 1 if the device has been added.
+//
+int iqreplay_discovery() {
+  if (replay_file == NULL || devices >= MAX_DEVICES) { return 0; }
+
+  if (fp) { fclose(fp); }
+
+  if ((fp = fopen(replay_file, "rb")) == NULL) {
+    t_print("%s: cannot open %s\n", __FUNCTION__, replay_file);
+    return 0;
+  }
+
+  frequency = 0;
+
+  if (open_wav() != 0) {
+    //
+    // no (valid) WAV file, take it as raw data
+    //
+    format = opt_format;
+    channels = opt_channels;
+    rate = opt_rate;
+    data_offset = 0;
+    data_bytes = -1;
+  }
+
+  if (opt_rate > 0) { rate = opt_rate; }
+
+  if (frequency == 0) { frequency = name_frequency(replay_file); }
+
+  if (opt_frequency > 0) { frequency = opt_frequency; }
+
+  //
+  // The RX engine needs a sample rate of 48000 times a power of two
+  //
+  int scale = rate / 48000;
+
+  if (rate <= 0 || rate % 48000 != 0 || scale > 32 || (scale & (scale - 1)) != 0 || channels < 2) {
+    t_print("%s: %s: sample rate %d or %d channels not supported\n", __FUNCTION__, replay_file, rate, channels);
+    fclose(fp);
+    fp = NULL;
+    return 0;
+  }
+
+  snprintf(description, sizeof(description), "%s %d kHz", format_name[format], rate / 1000);
+  DISCOVERED *d = &discovered[devices];
+  memset(d, 0, sizeof(DISCOVERED));
+  d->protocol = REPLAY_PROTOCOL;
+  d->device = REPLAY_DEVICE;
+  g_strlcpy(d->name, "IQ Replay", sizeof(d->name));
+  d->status = STATE_AVAILABLE;
+  d->supported_receivers = 2;
+  d->supported_transmitters = 0;
+  d->adcs = 1;
+  d->frequency_min = 0.0;
+  d->frequency_max = 61440000.0;
+  t_print("%s: %s (%s, %d channels, %lld Hz)\n", __FUNCTION__, replay_file, description, channels, frequency);
+  devices++;
+  return 1;
+}
+
+static void convert(const unsigned char *src, double *dst, int n) {
+  switch (format) {
+  case IQREPLAY_S16:
+    for (int i = 0; i < n; i++) {
+      dst[i] = (double)(short)get_le16(src) * (1.0 / 32768.0);
+      src += 2;
+    }
+
+    break;
+
+  case IQREPLAY_S24:
+    for (int i = 0; i < n; i++) {
+      int s = (int)((signed char)src[2]) << 16 | (int)src[1] << 8 | (int)src[0];
+      dst[i] = (double)s * (1.0 / 8388608.0);
+      src += 3;
+    }
+
+    break;
+
+  case IQREPLAY_S32:
+    for (int i = 0; i < n; i++) {
+      dst[i] = (double)(int)get_le32(src) * (1.0 / 2147483648.0);
+      src += 4;
+    }
+
+    break;
+
+  case IQREPLAY_F32:
+    for (int i = 0; i < n; i++) {
+      float f;
+      memcpy(&f, src, sizeof(float));
+      dst[i] = (double)f;
+      src += 4;
+    }
+
+    break;
+  }
+}
+
+//
+// A DSP worker drops a block if its ring is full, so wait for a free
+// slot before the next sample completes a block
+//
+static void wait_dsp(RECEIVER *rx) {
+  while (running && rx->dsp_running && ringbuf_count(rx->dsp_ring) >= rx->dsp_ring->nelem - 1) {
+    g_usleep(50);
+  }
+}
+
+//
+// Wait until the DSP workers have processed all queued blocks
+//
+static void drain_dsp() {
+  for (int r = 0; r < receivers; r++) {
+    RECEIVER *rx = receiver[r];
+
+    while (rx->dsp_running && ringbuf_count(rx->dsp_ring) > 0) {
+      g_usleep(100);
+    }
+  }
+}
+
+static void write_audio_header() {
+  unsigned char h[44];
+  memcpy(h, "RIFF", 4);
+  put_le32(h + 4, 36 + audio_bytes);
+  memcpy(h + 8, "WAVEfmt ", 8);
+  put_le32(h + 16, 16);
+  put_le16(h + 20, 1);             // PCM
+  put_le16(h + 22, 2);             // stereo
+  put_le32(h + 24, 48000);
+  put_le32(h + 28, 48000 * 4);
+  put_le16(h + 32, 4);
+  put_le16(h + 34, 16);
+  memcpy(h + 36, "data", 4);
+  put_le32(h + 40, audio_bytes);
+  fseek(audio_fp, 0, SEEK_SET);
+  (void) fwrite(h, 1, sizeof(h), audio_fp);
+  fseek(audio_fp, 0, SEEK_END);
+}
+
+static void flush_audio() {
+  if (audio_fp == NULL) { return; }
+
+  if (audio_count > 0) {
+    audio_bytes += fwrite(audio_buffer, 1, audio_count, audio_fp);
+    audio_count = 0;
+  }
+
+  write_audio_header();
+  fflush(audio_fp);
+}
+
+//
+// Called from the RX engine with the audio of the active receiver
+//
+void iqreplay_audio_samples(short left, short right) {
+  if (audio_fp == NULL) { return; }
+
+  put_le16(audio_buffer + audio_count, (unsigned short)left);
+  put_le16(audio_buffer + audio_count + 2, (unsigned short)right);
+  audio_count += 4;
+
+  if (audio_count >= (int)sizeof(audio_buffer)) {
+    audio_bytes += fwrite(audio_buffer, 1, audio_count, audio_fp);
+    audio_count = 0;
+  }
+}
+
+static void report() {
+  double seconds = (double)frames / (double)rate;
+  long buffers = 0;
+
+  for (int r = 0; r < receivers; r++) {
+    buffers += receiver[r]->full_buffer_count;
+  }
+
+  t_print("IQ replay: %s, %d receiver(s), %lld samples (%.2f s) in %.3f s\n",
+          replay_file, receivers, frames, seconds, run_time);
+
+  if (run_time > 0.0) {
+    t_print("IQ replay: real-time factor %.2f, %.1f buffers/s\n",
+            seconds / run_time, (double)buffers / run_time);
+  }
+
+  for (int r = 0; r < receivers; r++) {
+    const RECEIVER *rx = receiver[r];
+
+    if (rx->full_buffer_count > 0) {
+      t_print("IQ replay: RX%d: %ld buffers, rx_full_buffer avg %.1f peak %.1f us\n", rx->id + 1,
+              rx->full_buffer_count, rx->full_buffer_time / rx->full_buffer_count, rx->full_buffer_peak);
+    }
+
+#ifndef EXTNR
+    double avg_us, peak_us;
+    double period = GetDSPLoadPeriod(rx->id);
+    long count;
+    GetDSPLoad(DSPLOAD_XMAIN, rx->id, &avg_us, &peak_us, &count);
+
+    if (count > 0 && period > 0.0) {
+      t_print("IQ replay: RX%d: DSP avg %.1f peak %.1f us, %.1f%% of the real-time budget\n", rx->id + 1,
+              avg_us, peak_us, 100.0 * avg_us / period);
+    }
+
+    GetDSPLoad(DSPLOAD_FEXCHANGE, rx->id, &avg_us, &peak_us, &count);
+
+    if (count > 0) {
+      t_print("IQ replay: RX%d: fexchange avg %.1f peak %.1f us\n", rx->id + 1, avg_us, peak_us);
+    }
+
+    GetDSPLoad(DSPLOAD_SPECTRUM, rx->id, &avg_us, &peak_us, &count);
+
+    if (count > 0) {
+      t_print("IQ replay: RX%d: Spectrum avg %.1f peak %.1f us\n", rx->id + 1, avg_us, peak_us);
+    }
+
+    int n = GetRXAStageCount();
+    double *us = g_new(double, n);
+    double *peak = g_new(double, n);
+    int *active = g_new(int, n);
+    GetRXAStageTimes(rx->id, us, peak, active);
+
+    for (int i = 0; i < n; i++) {
+      if (active[i]) {
+        t_print("IQ replay: RX%d: stage %-10s avg %6.1f peak %6.1f us\n", rx->id + 1,
+                GetRXAStageName(i), us[i], peak[i]);
+      }
+    }
+
+    g_free(us);
+    g_free(peak);
+    g_free(active);
+#endif
+  }
+}
+
+static int quit_cb(gpointer data) {
+  stop_program();
+  _exit(0);
+}
+
+static gpointer replay_thread(gpointer data) {
+  int frame_bytes = channels * format_bytes[format];
+  unsigned char *raw = g_new(unsigned char, REPLAY_CHUNK * frame_bytes);
+  double *iq = g_new(double, REPLAY_CHUNK * channels);
+  gint64 start = g_get_monotonic_time();
+  long long start_frames = frames;
+  t_print("%s: replaying %s from byte %lld\n", __FUNCTION__, replay_file, position);
+
+  while (running) {
+    size_t want = REPLAY_CHUNK;
+
+    if (data_bytes >= 0 && (long long)want * frame_bytes > data_bytes - position) {
+      want = (data_bytes - position) / frame_bytes;
+    }
+
+    size_t n = want > 0 ? fread(raw, frame_bytes, want, fp) : 0;
+
+    if (n == 0) {
+      //
+      // end of the file (or of the data chunk)
+      //
+      loops_done++;
+
+      if (position > 0 && (opt_loops == 0 || loops_done < opt_loops)) {
+        fseek(fp, data_offset, SEEK_SET);
+        position = 0;
+        continue;
+      }
+
+      completed = 1;
+      break;
+    }
+
+    position += n * frame_bytes;
+    convert(raw, iq, n * channels);
+
+    for (size_t i = 0; i < n && running; i++) {
+      const double *frame = iq + i * channels;
+
+      for (int r = 0; r < receivers; r++) {
+        RECEIVER *rx = receiver[r];
+        //
+        // With more than one IQ pair in the file, each receiver
+        // gets its own pair, otherwise all receivers get the same
+        //
+        const double *pair = frame + 2 * (r % (channels / 2));
+
+        if (rx->samples == rx->buffer_size - 1) { wait_dsp(rx); }
+
+        rx_add_iq_samples(rx, pair[0], pair[1]);
+      }
+    }
+
+    frames += n;
+
+    if (opt_realtime) {
+      gint64 due = start + (gint64)((double)(frames - start_frames) * 1E6 / (double)rate);
+      gint64 now = g_get_monotonic_time();
+
+      if (due > now) { g_usleep(due - now); }
+    }
+  }
+
+  drain_dsp();
+  run_time += (double)(g_get_monotonic_time() - start) * 1E-6;
+  g_free(raw);
+  g_free(iq);
+
+  if (completed) {
+    running = 0;
+    report();
+    flush_audio();
+
+    if (opt_exit) { g_idle_add(quit_cb, NULL); }
+  }
+
+  return NULL;
+}
+
+//
+// Called when the radio is started
+//
+void iqreplay_init() {
+  if (fp == NULL) {
+    g_idle_add(fatal_error, "FATAL: IQ replay file not open");
+    return;
+  }
+
+  if (frequency > 0) {
+    vfo_set_frequency(VFO_A, frequency);
+    vfo_set_frequency(VFO_B, frequency);
+  }
+
+  if (audio_file) {
+    if ((audio_fp = fopen(audio_file, "wb")) == NULL) {
+      t_print("%s: cannot open %s\n", __FUNCTION__, audio_file);
+    } else {
+      audio_bytes = 0;
+      audio_count = 0;
+      write_audio_header();
+    }
+  }
+
+  fseek(fp, data_offset, SEEK_SET);
+  position = 0;
+  frames = 0;
+  loops_done = 0;
+  run_time = 0.0;
+  completed = 0;
+  //
+  // The report needs the DSP load counters
+  //
+  dsp_profile = 1;
+  radio_set_dsp_profile();
+  iqreplay_run();
+}
+
+void iqreplay_run() {
+  if (fp == NULL || completed || replay_thread_id != NULL) { return; }
+
+  running = 1;
+  replay_thread_id = g_thread_new("IQ replay", replay_thread, NULL);
+}
+
+void iqreplay_stop() {
+  running = 0;
+
+  if (replay_thread_id) {
+    g_thread_join(replay_thread_id);
+    replay_thread_id = NULL;
+  }
+
+  flush_audio();
+}
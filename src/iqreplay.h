@@ -0,0 +1,68 @@
+/* Copyright (C)
+*
+* 2024,2025 - Heiko Amft, DL1BZ (Project deskHPSDR)
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+#ifndef _IQREPLAY_H
+#define _IQREPLAY_H
+
+//
+// IQ file replay: a pseudo radio (REPLAY_PROTOCOL) that feeds the
+// receivers from a recorded IQ file instead of from the network.
+//
+// The file is either a WAV file (16/24/32-bit PCM or 32-bit float,
+// sample rate from the header, the center frequency from an "auxi"
+// chunk or from an "_7100kHz" / "_7100000Hz" part of the file name)
+// or raw interleaved I/Q data. By default the samples are pushed into
+// the RX engine as fast as the DSP takes them, and at the end a
+// throughput report (real-time factor, buffers per second, DSP load
+// per receiver and per RXA stage) is written to the log.
+//
+// Command line options (removed from argv before GTK sees them):
+//
+// --replay=FILE           IQ file to replay
+// --replay-format=FMT     raw files: s16, s24, s32 or f32 (default f32)
+// --replay-channels=N     raw files: channels, default 2 (one IQ pair)
+// --replay-rate=HZ        sample rate, required for raw files
+// --replay-freq=HZ        center frequency (overrides the file)
+// --replay-loops=N        replay the file N times (0: endless)
+// --replay-audio=FILE     write the audio of the active receiver to FILE (WAV)
+// --replay-realtime       pace the replay at the sample rate
+// --replay-exit           exit the program after the report
+//
+
+enum _iqreplay_format {
+  IQREPLAY_S16 = 0,
+  IQREPLAY_S24,
+  IQREPLAY_S32,
+  IQREPLAY_F32,
+  IQREPLAY_NUM_FORMATS
+};
+
+extern int  iqreplay_parse_args(int *argc, char **argv);
+extern int  iqreplay_configured(void);
+extern int  iqreplay_discovery(void);
+extern int  iqreplay_sample_rate(void);
+extern const char *iqreplay_description(void);
+
+extern void iqreplay_init(void);
+extern void iqreplay_run(void);
+extern void iqreplay_stop(void);
+
+extern void iqreplay_audio_samples(short left, short right);
+
+#endif
@@ -50,6 +50,9 @@
 #include "radio.h"
 #include "version.h"
 #include "discovery.h"
+#include "protocols.h"
+#include "iqconv.h"
+#include "iqreplay.h"
 #include "new_protocol.h"
 #include "old_protocol.h"
 #ifdef SOAPYSDR
@@ -106,6 +109,9 @@ void status_text(const char *text) {
 
 static pthread_t wisdom_thread_id;
 static int wisdom_running = 0;
+#ifndef EXTNR
+  static char impulse_cache_file[1024];
+#endif
 
 static void* wisdom_thread(void *arg) {
   int wdsp_subversion = GetWDSPVersion() % 100;
@@ -117,10 +123,26 @@ static void* wisdom_thread(void *arg) {
   if (wdsp_subversion < 26) {
     WDSPwisdom ((char *)arg);
   } else {
-    if (WDSPwisdom ((char *)arg)) {
-      t_print("WDSP wisdom file has been rebuilt.\n");
-    } else {
+    //
+    // With "quick wisdom", a missing wisdom file is generated in the
+    // background and this session uses FFTW_MEASURE plans.
+    //
+    switch (wisdom_quick ? WDSPwisdomQuick ((char *)arg) : WDSPwisdom ((char *)arg)) {
+    case 0:
       t_print("Re-using existing WDSP wisdom file.\n");
+      break;
+
+    case 1:
+      t_print("WDSP wisdom file has been rebuilt.\n");
+      break;
+
+    case -1:
+      t_print("WDSP wisdom file could not be built, will be retried upon next start.\n");
+      break;
+
+    default:
+      t_print("WDSP wisdom file is being built in the background.\n");
+      break;
     }
   }
 
@@ -129,6 +151,26 @@ static void* wisdom_thread(void *arg) {
   return NULL;
 }
 
+//
+// Called upon program exit, after the WDSP channels have been closed
+//
+void impulse_cache_save() {
+#ifndef EXTNR
+
+  if (impulse_cache_file[0] == 0) { return; }
+
+  long hits, misses;
+  int entries;
+  GetImpulseCacheStats(&hits, &misses, &entries);
+  t_print("%s: impulse cache: %ld hits, %ld misses, %d entries\n", __FUNCTION__, hits, misses, entries);
+
+  if (save_impulse_cache(impulse_cache_file) != 0) {
+    t_print("%s: could not write %s\n", __FUNCTION__, impulse_cache_file);
+  }
+
+#endif
+}
+
 const char* get_current_gtk_theme(void) {
   GtkSettings *settings = gtk_settings_get_default();
   gchar *theme_name = NULL;
@@ -615,6 +657,59 @@ static int init(void *data) {
   char wisdom_directory[1024];
   t_print("%s\n", __FUNCTION__);
   audio_get_cards();
+  //
+  // Select the fastest IQ sample conversion the CPU supports.
+  // In developer builds, report the speed of all available variants.
+  //
+  iqconv_init();
+  t_print("%s: IQ conversion uses %s code\n", __FUNCTION__, iqconv_impl_name(iqconv_get_impl()));
+#ifdef __DVL__
+
+  for (int i = 0; i < IQCONV_NUM_IMPL; i++) {
+    if (iqconv_impl_available(i)) {
+      t_print("%s: IQ conversion %-6s: unpack %.3f ns/sample, pack %.3f ns/sample\n", __FUNCTION__,
+              iqconv_impl_name(i), iqconv_benchmark(i, 0, 238), iqconv_benchmark(i, 1, 238));
+    }
+  }
+
+#endif
+#ifndef EXTNR
+  //
+  // Same for the multiply-accumulate kernel of the WDSP FFT filters.
+  // The sweep covers buffer sizes 64...4096 and 1...64 partitions
+  // (filter length = buffer size * partitions).
+  //
+  t_print("%s: WDSP filters use %s code\n", __FUNCTION__, GetFirKernelName(GetFirKernel()));
+#ifdef __DVL__
+
+  for (int k = 0; k < 8; k++) {
+    if (!GetFirKernelAvailable(k)) { continue; }
+
+    for (int size = 64; size <= 4096; size *= 4) {
+      t_print("%s: WDSP filter %-7s size %4d: %8.2f %8.2f %8.2f %8.2f usec (1/4/16/64 partitions)\n",
+              __FUNCTION__, GetFirKernelName(k), size,
+              FirKernelBenchmark(k, size, 1), FirKernelBenchmark(k, size, 4),
+              FirKernelBenchmark(k, size, 16), FirKernelBenchmark(k, size, 64));
+    }
+  }
+
+  //
+  // Resampler: polyphase filter versus half-band cascade
+  // (the latter only differs for rate ratios 2^n)
+  //
+  static const int rsmp_rates[][2] = {{1536000, 48000}, {384000, 48000}, {96000, 48000},
+    {48000, 192000}, {48000, 44100}
+  };
+
+  for (int i = 0; i < 5; i++) {
+    t_print("%s: WDSP resampler %7d -> %6d: %8.2f ns (polyphase) %8.2f ns (half-band) per output sample\n",
+            __FUNCTION__, rsmp_rates[i][0], rsmp_rates[i][1],
+            ResampleBenchmark(rsmp_rates[i][0], rsmp_rates[i][1], 0),
+            ResampleBenchmark(rsmp_rates[i][0], rsmp_rates[i][1], 1));
+  }
+
+#endif
+#endif
   cursor_arrow = gdk_cursor_new(GDK_ARROW);
   cursor_watch = gdk_cursor_new(GDK_WATCH);
   gdk_window_set_cursor(gtk_widget_get_window(top_window), cursor_watch);
@@ -623,6 +718,7 @@ static int init(void *data) {
   // If there is one, the "wisdom thread" takes no time
   // Depending on the WDSP version, the file is wdspWisdom or wdspWisdom00.
   //
+  protocolsRestoreState();  // for wisdom_quick
   (void) getcwd(wisdom_directory, sizeof(wisdom_directory));
   g_strlcat(wisdom_directory, "/", 1024);
   t_print("Securing wisdom file in directory: %s\n", wisdom_directory);
@@ -645,6 +741,26 @@ static int init(void *data) {
     status_text(text);
   }
 
+#ifndef EXTNR
+  //
+  // The WDSP filter impulse cache is kept next to the wisdom file.
+  // The file is mapped into memory, so loading it takes no time.
+  //
+  gint64 t0 = g_get_monotonic_time();
+  snprintf(impulse_cache_file, sizeof(impulse_cache_file), "%swdspImpulseCache", wisdom_directory);
+  init_impulse_cache(1);
+
+  if (read_impulse_cache(impulse_cache_file) == 0) {
+    long hits, misses;
+    int entries;
+    GetImpulseCacheStats(&hits, &misses, &entries);
+    t_print("%s: impulse cache: %d entries loaded, time: %lld usec\n", __FUNCTION__, entries,
+            (long long)(g_get_monotonic_time() - t0));
+  } else {
+    t_print("%s: impulse cache: no valid file %s\n", __FUNCTION__, impulse_cache_file);
+  }
+
+#endif
   //
   // When widsom plans are complete, start discovery process
   //
@@ -903,6 +1019,14 @@ int main(int argc, char **argv) {
     exit(0);
   }
 
+  //
+  // Take the IQ file replay options off the command line, GTK would
+  // refuse them
+  //
+  if (iqreplay_parse_args(&argc, argv) < 0) {
+    exit(1);
+  }
+
   //
   // The following call will most likely fail (until this program
   // has the privileges to reduce the nice value). But if the
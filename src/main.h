@@ -50,6 +50,7 @@ extern GtkWidget *topgrid;
 extern pthread_t deskhpsdr_main_thread;
 
 extern void status_text(const char *text);
+extern void impulse_cache_save(void);
 
 extern gboolean keypress_cb(GtkWidget *widget, GdkEventKey *event, gpointer data);
 extern int fatal_error(void *data);
@@ -0,0 +1,170 @@
+/* Copyright (C)
+*
+* 2024,2025 - Heiko Amft, DL1BZ (Project deskHPSDR)
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+//
+// Batched UDP I/O, see netio.h
+//
+
+// recvmmsg and sendmmsg are GNU extensions
+#ifndef _GNU_SOURCE
+  #define _GNU_SOURCE
+#endif
+
+#include <string.h>
+#include <errno.h>
+#include <sys/uio.h>
+
+#include "netio.h"
+#include "message.h"
+
+#if defined(__linux__) && defined(MSG_WAITFORONE)
+  #define NETIO_MMSG
+#endif
+
+#ifdef NETIO_MMSG
+//
+// Set to zero if recvmmsg/sendmmsg turn out not to be available
+// (e.g. on old kernels or in emulated environments)
+//
+static int use_recvmmsg = 1;
+static int use_sendmmsg = 1;
+#endif
+
+int netio_recv(NETIO_STATS *stats, int fd, unsigned char **bufs, int *lens, int size,
+               struct sockaddr_in *addrs, int n) {
+  int rc;
+
+  if (n > NETIO_BATCH) { n = NETIO_BATCH; }
+
+#ifdef NETIO_MMSG
+
+  if (use_recvmmsg) {
+    struct mmsghdr msgs[NETIO_BATCH];
+    struct iovec iovecs[NETIO_BATCH];
+    memset(msgs, 0, n * sizeof(struct mmsghdr));
+
+    for (int i = 0; i < n; i++) {
+      iovecs[i].iov_base = bufs[i];
+      iovecs[i].iov_len = size;
+      msgs[i].msg_hdr.msg_iov = &iovecs[i];
+      msgs[i].msg_hdr.msg_iovlen = 1;
+
+      if (addrs) {
+        msgs[i].msg_hdr.msg_name = &addrs[i];
+        msgs[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_in);
+      }
+    }
+
+    //
+    // MSG_WAITFORONE: block until the first datagram arrives,
+    // then take whatever else is already there.
+    //
+    rc = recvmmsg(fd, msgs, n, MSG_WAITFORONE, NULL);
+
+    if (rc < 0 && errno == ENOSYS) {
+      t_print("%s: recvmmsg not available, falling back to recvfrom\n", __FUNCTION__);
+      use_recvmmsg = 0;
+    } else {
+      stats->calls++;
+
+      if (rc > 0) {
+        stats->packets += rc;
+
+        for (int i = 0; i < rc; i++) {
+          lens[i] = msgs[i].msg_len;
+        }
+      }
+
+      return rc;
+    }
+  }
+
+#endif
+  socklen_t length = sizeof(struct sockaddr_in);
+  rc = recvfrom(fd, bufs[0], size, 0, (struct sockaddr *)addrs, addrs ? &length : NULL);
+  stats->calls++;
+
+  if (rc < 0) { return rc; }
+
+  stats->packets++;
+  lens[0] = rc;
+  return 1;
+}
+
+int netio_send(NETIO_STATS *stats, int fd, unsigned char **bufs, const int *lens,
+               const struct sockaddr *addr, socklen_t addrlen, int n) {
+  int rc;
+
+  if (n > NETIO_BATCH) { n = NETIO_BATCH; }
+
+#ifdef NETIO_MMSG
+
+  if (use_sendmmsg && n > 1) {
+    struct mmsghdr msgs[NETIO_BATCH];
+    struct iovec iovecs[NETIO_BATCH];
+    memset(msgs, 0, n * sizeof(struct mmsghdr));
+
+    for (int i = 0; i < n; i++) {
+      iovecs[i].iov_base = bufs[i];
+      iovecs[i].iov_len = lens[i];
+      msgs[i].msg_hdr.msg_iov = &iovecs[i];
+      msgs[i].msg_hdr.msg_iovlen = 1;
+      msgs[i].msg_hdr.msg_name = (void *)addr;
+      msgs[i].msg_hdr.msg_namelen = addrlen;
+    }
+
+    rc = sendmmsg(fd, msgs, n, 0);
+
+    if (rc < 0 && errno == ENOSYS) {
+      t_print("%s: sendmmsg not available, falling back to sendto\n", __FUNCTION__);
+      use_sendmmsg = 0;
+    } else {
+      stats->calls++;
+
+      if (rc > 0) { stats->packets += rc; }
+
+      return rc;
+    }
+  }
+
+#endif
+
+  for (int i = 0; i < n; i++) {
+    rc = sendto(fd, bufs[i], lens[i], 0, addr, addrlen);
+    stats->calls++;
+
+    if (rc < 0) { return (i > 0) ? i : rc; }
+
+    stats->packets++;
+  }
+
+  return n;
+}
+
+void netio_stats_log(NETIO_STATS *stats) {
+  if (stats->calls == 0) { return; }
+
+  t_print("%s: %s: %lu packets in %lu system calls (%.2f packets/call)\n", __FUNCTION__,
+          stats->name, stats->packets, stats->calls, (double)stats->packets / (double)stats->calls);
+}
+
+void netio_stats_reset(NETIO_STATS *stats) {
+  stats->calls = 0;
+  stats->packets = 0;
+}
@@ -0,0 +1,61 @@
+/* Copyright (C)
+*
+* 2024,2025 - Heiko Amft, DL1BZ (Project deskHPSDR)
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+#ifndef _NETIO_H
+#define _NETIO_H
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+//
+// Batched UDP I/O: on Linux, up to NETIO_BATCH datagrams are
+// received (recvmmsg) or sent (sendmmsg) with a single system call.
+// Elsewhere, or if the kernel does not support these calls, one
+// datagram is transferred per call (recvfrom/sendto).
+//
+// netio_recv blocks until at least one datagram is available (or the
+// socket time-out expires), and then returns what is there, up to n
+// datagrams. It returns the number of datagrams received, or -1 on
+// error (errno is set).
+//
+// netio_send sends n datagrams to the same address, and returns the
+// number of datagrams sent, or -1 on error.
+//
+// Both functions count system calls and datagrams in a NETIO_STATS
+// structure, such that the average number of packets per system call
+// can be reported.
+//
+
+#define NETIO_BATCH 16
+
+typedef struct _netio_stats {
+  const char *name;
+  unsigned long calls;
+  unsigned long packets;
+} NETIO_STATS;
+
+extern int  netio_recv(NETIO_STATS *stats, int fd, unsigned char **bufs, int *lens, int size,
+                       struct sockaddr_in *addrs, int n);
+extern int  netio_send(NETIO_STATS *stats, int fd, unsigned char **bufs, const int *lens,
+                       const struct sockaddr *addr, socklen_t addrlen, int n);
+extern void netio_stats_log(NETIO_STATS *stats);
+extern void netio_stats_reset(NETIO_STATS *stats);
+
+#endif
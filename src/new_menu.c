@@ -49,6 +49,7 @@
 #include "agc_menu.h"
 #include "vox_menu.h"
 #include "diversity_menu.h"
+#include "dspload_menu.h"
 #include "tx_menu.h"
 #include "ps_menu.h"
 #include "encoder_menu.h"
@@ -398,6 +399,13 @@ static gboolean diversity_cb (GtkWidget *widget, GdkEventButton *event, gpointer
   return TRUE;
 }
 
+// cppcheck-suppress constParameterCallback
+static gboolean dspload_cb (GtkWidget *widget, GdkEventButton *event, gpointer data) {
+  cleanup();
+  dspload_menu(top_window);
+  return TRUE;
+}
+
 void start_vfo(int vfo) {
   int old_menu = active_menu;
   cleanup();
@@ -745,11 +753,14 @@ void new_menu() {
     gtk_grid_attach(GTK_GRID(grid), BotSeparator, 0, row, 6, 1);
     row++;
     //
-    // Last row: About and Iconify Button
+    // Last row: About, DSP Load and Iconify Button
     //
     GtkWidget *about_b = gtk_button_new_with_label("About");
     g_signal_connect (about_b, "button-press-event", G_CALLBACK(about_cb), NULL);
     gtk_grid_attach(GTK_GRID(grid), about_b, 0, row, 2, 1);
+    GtkWidget *dspload_b = gtk_button_new_with_label("DSP Load");
+    g_signal_connect (dspload_b, "button-press-event", G_CALLBACK(dspload_cb), NULL);
+    gtk_grid_attach(GTK_GRID(grid), dspload_b, 2, row, 2, 1);
     GtkWidget *minimize_b = gtk_button_new_with_label("Iconify");
     g_signal_connect (minimize_b, "button-press-event", G_CALLBACK(minimize_cb), NULL);
     gtk_grid_attach(GTK_GRID(grid), minimize_b, 4, row, 2, 1);
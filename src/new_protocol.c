@@ -58,6 +58,9 @@
 #include "vox.h"
 #include "ext.h"
 #include "iambic.h"
+#include "iqconv.h"
+#include "ringbuf.h"
+#include "netio.h"
 #include "rigctl.h"
 #include "message.h"
 #ifdef SATURN
@@ -132,17 +135,9 @@ static unsigned long micsamples_sequence = 0;
 #ifdef __APPLE__
   static sem_t *high_priority_sem_ready;
   static sem_t *high_priority_sem_buffer;
-  static sem_t *mic_line_sem;
-  static sem_t *iq_sem[MAX_DDC];
-  static sem_t *txiq_sem;
-  static sem_t *rxaudio_sem;
 #else
   static sem_t high_priority_sem_ready;
   static sem_t high_priority_sem_buffer;
-  static sem_t mic_line_sem;
-  static sem_t iq_sem[MAX_DDC];
-  static sem_t txiq_sem;
-  static sem_t rxaudio_sem;
 #endif
 
 static GThread *high_priority_thread_id;
@@ -171,74 +166,85 @@ static int local_pa_enable = 0;
 // a large ring buffer (about 4k samples), and send them to the
 // radio following the pace of incoming mic samples.
 //
-// TXIQRINGBUF must contain a multiple of 1440 bytes (240 samples).
-// RXAUDIORINGBUF must contain a multiple of 256 bytes (64 samples).
+// Each slot of the TXIQ ring holds one packet (240 samples, 1440 bytes),
+// each slot of the RXAUDIO ring holds one packet (64 samples, 256 bytes).
+// Samples are written directly into the head slot, which is then
+// committed when it is full.
 //
-// The ring buffers must be thread-safe.
+// The ring buffers are single-producer/single-consumer (see ringbuf.h).
 //
 /////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-#define TXIQRINGBUFLEN    97920  // (85 msec)
-#define RXAUDIORINGBUFLEN 16384  // (85 msec)
+#define TXIQRINGLEN    68  // number of TXIQ packets (85 msec)
+#define RXAUDIORINGLEN 64  // number of RXAUDIO packets (85 msec)
 
-static unsigned char *RXAUDIORINGBUF = NULL;
-static unsigned char *TXIQRINGBUF = NULL;
+static RINGBUF txiq_ring;
+static RINGBUF rxaudio_ring;
 
-static volatile int txiq_inptr        = 0;  // pointer updated when writing into the ring buffer
-static volatile int txiq_outptr       = 0;  // pointer updated when reading from the ring buffer
-static volatile int txiq_count        = 0;  // number of samples queued since last sem_post
+static volatile int txiq_count        = 0;  // number of samples in the head slot
 
-static volatile int rxaudio_inptr     = 0;  // pointer updated when writing into the ring buffer
-static volatile int rxaudio_outptr    = 0;  // pointer updated when reading from the ring buffer
-static volatile int rxaudio_count     = 0;  // number of samples queued since last sem_post
+static volatile int rxaudio_count     = 0;  // number of samples in the head slot
 static volatile int rxaudio_drain     = 0;  // a flag for draining the RX audio buffer
 static volatile int rxaudio_flag      = 0;  // 0: RX, 1: TX
 
 static pthread_mutex_t send_rxaudio_mutex   = PTHREAD_MUTEX_INITIALIZER;
 
+//
+// If the radio's FIFO is running low (e.g. after a RX/TX transition,
+// or if a thread has been woken up late) and more TX IQ or audio
+// packets are waiting in the ring buffer, up to this number of
+// packets is sent with a single system call.
+//
+#define TXIQBATCH    4
+#define RXAUDIOBATCH 4
+
+static NETIO_STATS p2_rx_stats = { "P2 RX", 0, 0 };
+static NETIO_STATS p2_txiq_stats = { "P2 TXIQ", 0, 0 };
+static NETIO_STATS p2_rxaudio_stats = { "P2 AUDIO", 0, 0 };
+
 /////////////////////////////////////////////////////////////////////////////
 //
-// PEDESTRIAN BUFFER MANAGEMENT
+// BUFFER MANAGEMENT
 //
 ////////////////////////////////////////////////////////////////////////////
 //
 // Instead of allocating and free-ing (malloc/free) the network buffers
-// at a very high rate, we do it the "pedestrian" way, which may
-// alleviate the system load a little.
+// at a very high rate, we allocate a pool of network buffers *once*
+// and obtain/return buffers from/to a lock-free free list.
 //
-// Therefore we allocate a pool of network buffers *once*, make
-// them a linked list, and simply maintain a "free" flag.
+// The pool is shared by new_protocol_thread() and the Saturn XDMA
+// threads. Its maximum size is the number of buffers that can be
+// queued in the ring buffers plus some buffers in flight, so the
+// pool can never run dry. With HUGEPAGES, the initial arena is placed
+// in huge pages.
 //
-// This ONLY applies to the network buffers filled with data in
-// new_protocol_thread(), so this need not be thread-safe.
+// The consumers still check the "free" flag, so a buffer that has
+// been released twice, or is otherwise stale, is never processed.
 //
 ////////////////////////////////////////////////////////////////////////////
 
-//
-// number of buffers allocated (for statistics)
-//
-static int num_buf = 0;
+#define P2BUFPOOL_INIT 256
+#define P2BUFPOOL_GROW  32
+#define P2BUFPOOL_MAX  (MAX_DDC * RXIQRINGBUFLEN + MICRINGBUFLEN + 64)
+#ifdef HUGEPAGES
+  #define P2BUFPOOL_HUGEPAGE 1
+#else
+  #define P2BUFPOOL_HUGEPAGE 0
+#endif
 
-//
-// head of buffer list
-//
-static mybuffer *buflist = NULL;
+BUFPOOL p2_bufpool;
 
 //
 // The buffers used by new_protocol_thread
 //
 #define RXIQRINGBUFLEN 512
-static volatile mybuffer *iq_buffer[MAX_DDC][RXIQRINGBUFLEN];
-static volatile int iq_inptr[MAX_DDC] = { 0 };
-static volatile int iq_outptr[MAX_DDC] = { 0 };
+static RINGBUF iq_ring[MAX_DDC];
 static volatile int iq_count[MAX_DDC] = { 0 };
 
 static mybuffer *high_priority_buffer;
 
 #define MICRINGBUFLEN 64
-static volatile mybuffer *mic_line_buffer[MICRINGBUFLEN];
-static volatile int mic_inptr = 0;
-static volatile int mic_outptr = 0;
+static RINGBUF mic_ring;
 static volatile int mic_count = 0;
 
 static unsigned char general_buffer[60];
@@ -273,49 +279,13 @@ static gpointer new_protocol_timer_thread(gpointer data);
 static gpointer high_priority_thread(gpointer data);
 static gpointer mic_line_thread(gpointer data);
 static gpointer iq_thread(gpointer data);
+static void  dispatch_packet(mybuffer *mybuf, int bytesread, short sourceport);
 static void  process_iq_data(const unsigned char *buffer, RECEIVER *rx);
 static void  process_ps_iq_data(const unsigned char *buffer);
 static void process_div_iq_data(const unsigned char *buffer);
 static void  process_high_priority(void);
 static void  process_mic_data(const unsigned char *buffer);
 
-//
-// Obtain a free buffer. If no one is available allocate
-// 5 new ones. The buffers are *never* released to the
-// operating system, but marked free upon a protocol restart.
-//
-static mybuffer *get_my_buffer() {
-  int i;
-  mybuffer *bp = buflist;
-
-  while (bp) {
-    if (bp->free) {
-      // found free buffer. Mark as used and return that one.
-      bp->free = 0;
-      return bp;
-    }
-
-    bp = bp->next;
-  }
-
-  //
-  // no free buffer found, allocate some extra ones
-  // and add to the head of the list
-  //
-  for (i = 0; i < 25; i++) {
-    bp = malloc(sizeof(mybuffer));
-    bp->free = 1;
-    bp->next = buflist;
-    buflist = bp;
-    num_buf++;
-  }
-
-  t_print("NewProtocol: number of buffers increased to %d\n", num_buf);
-  // Mark the first buffer in list as used and return that one.
-  buflist->free = 0;
-  return buflist;
-}
-
 void schedule_high_priority() {
   if (protocol == NEW_PROTOCOL) {
     new_protocol_high_priority();
@@ -449,18 +419,22 @@ void new_protocol_init() {
   //
   // These are allocated once and forever
   //
-  if (TXIQRINGBUF != NULL) {
-    t_print("%s: WARNING: TXIQRINGBUF non-NULL\n", __FUNCTION__);
-    g_free(TXIQRINGBUF);
+  if (txiq_ring.data != NULL) {
+    t_print("%s: WARNING: TXIQ ring already allocated\n", __FUNCTION__);
+    ringbuf_destroy(&txiq_ring);
   }
 
-  if (RXAUDIORINGBUF != NULL) {
-    t_print("%s: WARNING: RXAUDIO_RINGGBUF non-NULL\n", __FUNCTION__);
-    g_free(RXAUDIORINGBUF);
+  if (rxaudio_ring.data != NULL) {
+    t_print("%s: WARNING: RXAUDIO ring already allocated\n", __FUNCTION__);
+    ringbuf_destroy(&rxaudio_ring);
   }
 
-  TXIQRINGBUF = g_new(unsigned char, TXIQRINGBUFLEN);
-  RXAUDIORINGBUF = g_new(unsigned char, RXAUDIORINGBUFLEN);
+  ringbuf_init(&txiq_ring, TXIQRINGLEN, 1440);
+  ringbuf_init(&rxaudio_ring, RXAUDIORINGLEN, 256);
+
+  if (p2_bufpool.table == NULL) {
+    bufpool_init(&p2_bufpool, "P2", P2BUFPOOL_INIT, P2BUFPOOL_GROW, P2BUFPOOL_MAX, P2BUFPOOL_HUGEPAGE);
+  }
 
   if (transmitter->local_microphone) {
     if (audio_open_input() != 0) {
@@ -470,28 +444,22 @@ void new_protocol_init() {
   }
 
   //
-  // Initialize semaphores for the never-finishing threads
-  // (HighPrio, Mic, rxIQ) and spawn these threads.
+  // Initialize semaphores and ring buffers for the never-finishing
+  // threads (HighPrio, Mic, rxIQ) and spawn these threads.
   //
 #ifdef __APPLE__
   high_priority_sem_ready = apple_sem(0);
   high_priority_sem_buffer = apple_sem(0);
-  mic_line_sem = apple_sem(0);
-
-  for (i = 0; i < MAX_DDC; i++) {
-    iq_sem[i] = apple_sem(0);
-  }
-
 #else
   (void)sem_init(&high_priority_sem_ready, 0, 0); // check return value!
   (void)sem_init(&high_priority_sem_buffer, 0, 0); // check return value!
-  (void)sem_init(&mic_line_sem, 0, 0); // check return value!
+#endif
+  ringbuf_init(&mic_ring, MICRINGBUFLEN, sizeof(mybuffer *));
 
   for (i = 0; i < MAX_DDC; i++) {
-    (void)sem_init(&iq_sem[i], 0, 0); // check return value!
+    ringbuf_init(&iq_ring[i], RXIQRINGBUFLEN, sizeof(mybuffer *));
   }
 
-#endif
   high_priority_thread_id = g_thread_new( "P2 HP", high_priority_thread, NULL);
   mic_line_thread_id = g_thread_new( "P2 MIC", mic_line_thread, NULL);
 
@@ -1648,32 +1616,27 @@ void new_protocol_menu_stop() {
   P2running = 0;
   //
   // Wait 100 msec so we know that the TX IQ and RX audio
-  // threads block on the semaphore. Then, post the semaphores
+  // threads block on their ring buffers. Then, wake them up
   // such that the threads can read "P2running" and terminate
   //
   usleep(100000);
-#ifdef __APPLE__
-  sem_post(txiq_sem);
-  sem_post(rxaudio_sem);
-#else
-  sem_post(&txiq_sem);
-  sem_post(&rxaudio_sem);
-#endif
+  ringbuf_wakeup(&txiq_ring);
+  ringbuf_wakeup(&rxaudio_ring);
   g_thread_join(new_protocol_rxaudio_thread_id);
   g_thread_join(new_protocol_txiq_thread_id);
-#ifdef __APPLE__
-  sem_close(txiq_sem);
-  sem_close(rxaudio_sem);
-#else
-  sem_destroy(&txiq_sem);
-  sem_destroy(&rxaudio_sem);
-#endif
 
   if (!have_saturn_xdma) {
     g_thread_join(new_protocol_thread_id);
   }
 
   g_thread_join(new_protocol_timer_thread_id);
+  bufpool_stats(&p2_bufpool);
+  netio_stats_log(&p2_rx_stats);
+  netio_stats_log(&p2_txiq_stats);
+  netio_stats_log(&p2_rxaudio_stats);
+  netio_stats_reset(&p2_rx_stats);
+  netio_stats_reset(&p2_txiq_stats);
+  netio_stats_reset(&p2_rxaudio_stats);
   new_protocol_high_priority();
   // let the FPGA rest a while
   usleep(200000); // 200 ms
@@ -1716,30 +1679,7 @@ void new_protocol_menu_start() {
   memset(ddc_sequence, 0, sizeof(ddc_sequence));
   update_action_table();
 
-  //
-  // Mark all buffers free.
-  //
-  if (have_saturn_xdma) {
-#ifdef SATURN
-    saturn_free_buffers();
-#endif
-  } else {
-    mybuffer *mybuf = buflist;
-
-    while (mybuf) {
-      mybuf->free = 1;
-      mybuf = mybuf->next;
-    }
-  }
-
   P2running = 1;
-#ifdef __APPLE__
-  txiq_sem = apple_sem(0);
-  rxaudio_sem = apple_sem(0);
-#else
-  (void)sem_init(&txiq_sem, 0, 0); // check return value!
-  (void)sem_init(&rxaudio_sem, 0, 0); // check return value!
-#endif
   new_protocol_rxaudio_thread_id = g_thread_new( "P2 SPKR", new_protocol_rxaudio_thread, NULL);
   new_protocol_txiq_thread_id = g_thread_new( "P2 TXIQ", new_protocol_txiq_thread, NULL);
 
@@ -1756,9 +1696,29 @@ void new_protocol_menu_start() {
   new_protocol_timer_thread_id = g_thread_new( "P2 task", new_protocol_timer_thread, NULL);
 }
 
+//
+// Put sequence number and 64 audio samples into a RX audio packet
+//
+static void new_protocol_rxaudio_packet(unsigned char *audiobuffer, const unsigned char *p) {
+  audiobuffer[0] = (audio_sequence >> 24) & 0xFF;
+  audiobuffer[1] = (audio_sequence >> 16) & 0xFF;
+  audiobuffer[2] = (audio_sequence >>  8) & 0xFF;
+  audiobuffer[3] = (audio_sequence      ) & 0xFF;
+  audio_sequence++;
+  memcpy(&audiobuffer[4], p, 256);
+}
+
 static gpointer new_protocol_rxaudio_thread(gpointer data) {
-  int nptr;
-  unsigned char audiobuffer[260];
+  const unsigned char *p;
+  int n;
+  unsigned char audiobuffer[RXAUDIOBATCH][260];
+  unsigned char *bufs[RXAUDIOBATCH];
+  int lens[RXAUDIOBATCH];
+
+  for (int i = 0; i < RXAUDIOBATCH; i++) {
+    bufs[i] = audiobuffer[i];
+    lens[i] = sizeof(audiobuffer[i]);
+  }
 
   //
   // Ideally, a RX audio buffer with 64 samples is sent every 1333 usecs.
@@ -1768,36 +1728,26 @@ static gpointer new_protocol_rxaudio_thread(gpointer data) {
   // attempting to send the next one.
   //
   while (P2running) {
-#ifdef __APPLE__
-    sem_wait(rxaudio_sem);
-#else
-    sem_wait(&rxaudio_sem);
-#endif
+    ringbuf_wait(&rxaudio_ring, -1);
 
     if (!P2running) { break; }
 
-    nptr = rxaudio_outptr + 256;
+    n = 1;
 
-    if (nptr >= RXAUDIORINGBUFLEN) { nptr = 0; }
+    if ((p = ringbuf_peek(&rxaudio_ring, &n)) == NULL) { continue; }
 
     if (rxaudio_drain) {
       // remove data from buffer but do not send
-      rxaudio_outptr = nptr;
+      ringbuf_release(&rxaudio_ring, 1);
       continue;
     }
 
-    audiobuffer[0] = (audio_sequence >> 24) & 0xFF;
-    audiobuffer[1] = (audio_sequence >> 16) & 0xFF;
-    audiobuffer[2] = (audio_sequence >>  8) & 0xFF;
-    audiobuffer[3] = (audio_sequence      ) & 0xFF;
-    audio_sequence++;
-    memcpy(&audiobuffer[4], &RXAUDIORINGBUF[rxaudio_outptr], 256);
-    MEMORY_BARRIER;
-    rxaudio_outptr = nptr;
+    new_protocol_rxaudio_packet(audiobuffer[0], p);
+    ringbuf_release(&rxaudio_ring, 1);
 
     if (have_saturn_xdma) {
 #ifdef SATURN
-      saturn_handle_speaker_audio(audiobuffer);
+      saturn_handle_speaker_audio(audiobuffer[0]);
 #endif
     } else {
       //
@@ -1851,15 +1801,28 @@ static gpointer new_protocol_rxaudio_thread(gpointer data) {
       }
 
       FIFO += 64.0;  // number of samples in THIS packet
-      int rc = sendto(data_socket, audiobuffer, sizeof(audiobuffer), 0, (struct sockaddr*)&audio_addr, audio_addr_length);
+      int nsend = 1;
+
+      while (FIFO <= 250.0 && nsend < RXAUDIOBATCH && !rxaudio_drain) {
+        n = 1;
+
+        if ((p = ringbuf_peek(&rxaudio_ring, &n)) == NULL) { break; }
+
+        new_protocol_rxaudio_packet(audiobuffer[nsend++], p);
+        ringbuf_release(&rxaudio_ring, 1);
+        FIFO += 64.0;
+      }
+
+      int rc = netio_send(&p2_rxaudio_stats, data_socket, bufs, lens, (struct sockaddr*)&audio_addr,
+                          audio_addr_length, nsend);
 
       if (rc < 0) {
         g_idle_add(fatal_error, "Audio send failed (Network down?)");
         P2running = 0;
       }
 
-      if (rc != sizeof(audiobuffer)) {
-        t_print("sendto socket failed for %ld bytes of audio: %d\n", (long)sizeof(audiobuffer), rc);
+      if (rc >= 0 && rc != nsend) {
+        t_print("sendto socket failed for %d audio packets: %d\n", nsend, rc);
       }
     }
   }
@@ -1867,9 +1830,29 @@ static gpointer new_protocol_rxaudio_thread(gpointer data) {
   return NULL;
 }
 
+//
+// Put sequence number and 240 IQ samples into a TX IQ packet
+//
+static void new_protocol_txiq_packet(unsigned char *iqbuffer, const unsigned char *p) {
+  iqbuffer[0] = (tx_iq_sequence >> 24) & 0xFF;
+  iqbuffer[1] = (tx_iq_sequence >> 16) & 0xFF;
+  iqbuffer[2] = (tx_iq_sequence >>  8) & 0xFF;
+  iqbuffer[3] = (tx_iq_sequence      ) & 0xFF;
+  tx_iq_sequence++;
+  memcpy(&iqbuffer[4], p, 1440);
+}
+
 static gpointer new_protocol_txiq_thread(gpointer data) {
-  int nptr;
-  unsigned char iqbuffer[1444];
+  const unsigned char *p;
+  int n;
+  unsigned char iqbuffer[TXIQBATCH][1444];
+  unsigned char *bufs[TXIQBATCH];
+  int lens[TXIQBATCH];
+
+  for (int i = 0; i < TXIQBATCH; i++) {
+    bufs[i] = iqbuffer[i];
+    lens[i] = sizeof(iqbuffer[i]);
+  }
 
   //
   // Ideally, a TX IQ buffer with 240 sample is sent every 1250 usecs.
@@ -1880,30 +1863,20 @@ static gpointer new_protocol_txiq_thread(gpointer data) {
   // sending the next one.
   //
   while (P2running) {
-#ifdef __APPLE__
-    sem_wait(txiq_sem);
-#else
-    sem_wait(&txiq_sem);
-#endif
+    ringbuf_wait(&txiq_ring, -1);
 
     if (!P2running) { break; }
 
-    iqbuffer[0] = (tx_iq_sequence >> 24) & 0xFF;
-    iqbuffer[1] = (tx_iq_sequence >> 16) & 0xFF;
-    iqbuffer[2] = (tx_iq_sequence >>  8) & 0xFF;
-    iqbuffer[3] = (tx_iq_sequence      ) & 0xFF;
-    tx_iq_sequence++;
-    nptr = txiq_outptr + 1440;
+    n = 1;
 
-    if (nptr >= TXIQRINGBUFLEN) { nptr = 0; }
+    if ((p = ringbuf_peek(&txiq_ring, &n)) == NULL) { continue; }
 
-    memcpy(&iqbuffer[4], &TXIQRINGBUF[txiq_outptr], 1440);
-    MEMORY_BARRIER;
-    txiq_outptr = nptr;
+    new_protocol_txiq_packet(iqbuffer[0], p);
+    ringbuf_release(&txiq_ring, 1);
 
     if (have_saturn_xdma) {
 #ifdef SATURN
-      saturn_handle_duc_iq(false, iqbuffer);
+      saturn_handle_duc_iq(false, iqbuffer[0]);
 #endif
     } else {
       //
@@ -1945,8 +1918,19 @@ static gpointer new_protocol_txiq_thread(gpointer data) {
       }
 
       FIFO += 240.0;  // number of samples in THIS packet
+      int nsend = 1;
+
+      while (FIFO <= 1250.0 && nsend < TXIQBATCH) {
+        n = 1;
 
-      if (sendto(data_socket, iqbuffer, sizeof(iqbuffer), 0, (struct sockaddr * )&iq_addr, iq_addr_length) < 0) {
+        if ((p = ringbuf_peek(&txiq_ring, &n)) == NULL) { break; }
+
+        new_protocol_txiq_packet(iqbuffer[nsend++], p);
+        ringbuf_release(&txiq_ring, 1);
+        FIFO += 240.0;
+      }
+
+      if (netio_send(&p2_txiq_stats, data_socket, bufs, lens, (struct sockaddr * )&iq_addr, iq_addr_length, nsend) < 0) {
         g_idle_add(fatal_error, "TX IQ send failed (Network down?)");
         P2running = 0;
       }
@@ -1957,6 +1941,11 @@ static gpointer new_protocol_txiq_thread(gpointer data) {
 }
 
 static gpointer new_protocol_thread(gpointer data) {
+  mybuffer *mybufs[NETIO_BATCH];
+  unsigned char *bufs[NETIO_BATCH];
+  int lens[NETIO_BATCH];
+  struct sockaddr_in addrs[NETIO_BATCH];
+  int nbuf = 0;
   t_print("new_protocol_thread\n");
 
   //
@@ -1966,15 +1955,20 @@ static gpointer new_protocol_thread(gpointer data) {
   // DDC-IQ and Microphone packets since they eventually get stuck in WDSP
   // (fexchange calls).
   //
+  // Up to NETIO_BATCH packets are received with one system call, each into
+  // a buffer from the pool. Buffers that have not been filled are kept for
+  // the next call.
+  //
   while (P2running) {
-    int ddc;
-    short sourceport;
-    int bytesread;
-    mybuffer *mybuf;
-    unsigned char *buffer;
-    mybuf = get_my_buffer();
-    buffer = mybuf->buffer;
-    bytesread = recvfrom(data_socket, buffer, NET_BUFFER_SIZE, 0, (struct sockaddr*)&addr, &length);
+    int npkt;
+
+    while (nbuf < NETIO_BATCH) {
+      mybufs[nbuf] = bufpool_get(&p2_bufpool);
+      bufs[nbuf] = mybufs[nbuf]->buffer;
+      nbuf++;
+    }
+
+    npkt = netio_recv(&p2_rx_stats, data_socket, bufs, lens, NET_BUFFER_SIZE, addrs, NETIO_BATCH);
 
     if (!P2running) {
       //
@@ -1982,61 +1976,83 @@ static gpointer new_protocol_thread(gpointer data) {
       // we were doing "recvfrom". In this case, we want to let the main
       // thread terminate gracefully, including writing the props files.
       //
-      mybuf->free = 1;
       break;
     }
 
-    if (bytesread < 0) {
+    if (npkt < 0) {
       t_perror("recvfrom socket failed for new_protocol_thread:");
       g_idle_add(fatal_error, "P2 receive (Network problem?)");
       P2running = 0;
       break;
     }
 
-    sourceport = ntohs(addr.sin_port);
-
-    //t_print("new_protocol_thread: recvd %d bytes on port %d\n",bytesread,sourceport);
-    switch (sourceport) {
-    case RX_IQ_TO_HOST_PORT_0:
-    case RX_IQ_TO_HOST_PORT_1:
-    case RX_IQ_TO_HOST_PORT_2:
-    case RX_IQ_TO_HOST_PORT_3:
-    case RX_IQ_TO_HOST_PORT_4:
-    case RX_IQ_TO_HOST_PORT_5:
-    case RX_IQ_TO_HOST_PORT_6:
-    case RX_IQ_TO_HOST_PORT_7:
-      ddc = sourceport - RX_IQ_TO_HOST_PORT_0;
-      saturn_post_iq_data(ddc, mybuf);
-      break;
-
-    case COMMAND_RESPONSE_TO_HOST_PORT:
-      //
-      // Ignore these packets silently. They occur when
-      // flashing a new firmware using the new protocol
-      // programmer. But this should be done in a separate
-      // program.
-      //
-      mybuf->free = 1;
-      break;
+    for (int i = 0; i < npkt; i++) {
+      dispatch_packet(mybufs[i], lens[i], ntohs(addrs[i].sin_port));
+    }
 
-    case HIGH_PRIORITY_TO_HOST_PORT:
-      saturn_post_high_priority(mybuf);
-      break;
+    //
+    // move unused buffers to the front
+    //
+    for (int i = npkt; i < nbuf; i++) {
+      mybufs[i - npkt] = mybufs[i];
+      bufs[i - npkt] = bufs[i];
+    }
 
-    case MIC_LINE_TO_HOST_PORT:
-      saturn_post_micaudio(bytesread, mybuf);
-      break;
+    nbuf -= npkt;
+  }
 
-    default:
-      t_print("new_protocol_thread: Unknown port %d\n", sourceport);
-      mybuf->free = 1;
-      break;
-    }
+  for (int i = 0; i < nbuf; i++) {
+    bufpool_put(mybufs[i]);
   }
 
   return NULL;
 }
 
+//
+// Hand over a received packet to the processing threads
+//
+static void dispatch_packet(mybuffer *mybuf, int bytesread, short sourceport) {
+  int ddc;
+
+  //t_print("new_protocol_thread: recvd %d bytes on port %d\n",bytesread,sourceport);
+  switch (sourceport) {
+  case RX_IQ_TO_HOST_PORT_0:
+  case RX_IQ_TO_HOST_PORT_1:
+  case RX_IQ_TO_HOST_PORT_2:
+  case RX_IQ_TO_HOST_PORT_3:
+  case RX_IQ_TO_HOST_PORT_4:
+  case RX_IQ_TO_HOST_PORT_5:
+  case RX_IQ_TO_HOST_PORT_6:
+  case RX_IQ_TO_HOST_PORT_7:
+    ddc = sourceport - RX_IQ_TO_HOST_PORT_0;
+    saturn_post_iq_data(ddc, mybuf);
+    break;
+
+  case COMMAND_RESPONSE_TO_HOST_PORT:
+    //
+    // Ignore these packets silently. They occur when
+    // flashing a new firmware using the new protocol
+    // programmer. But this should be done in a separate
+    // program.
+    //
+    bufpool_put(mybuf);
+    break;
+
+  case HIGH_PRIORITY_TO_HOST_PORT:
+    saturn_post_high_priority(mybuf);
+    break;
+
+  case MIC_LINE_TO_HOST_PORT:
+    saturn_post_micaudio(bytesread, mybuf);
+    break;
+
+  default:
+    t_print("new_protocol_thread: Unknown port %d\n", sourceport);
+    bufpool_put(mybuf);
+    break;
+  }
+}
+
 static gpointer high_priority_thread(gpointer data) {
   t_print("high_priority_thread\n");
 
@@ -2048,8 +2064,14 @@ static gpointer high_priority_thread(gpointer data) {
     sem_post(&high_priority_sem_ready);
     sem_wait(&high_priority_sem_buffer);
 #endif
+    // This should not happen: buffer released twice
+    if (high_priority_buffer->free) {
+      t_print("%s: stale buffer %d skipped\n", __FUNCTION__, high_priority_buffer->index);
+      continue;
+    }
+
     process_high_priority();
-    high_priority_buffer->free = 1;
+    bufpool_put(high_priority_buffer);
   }
 
   return NULL;
@@ -2058,31 +2080,30 @@ static gpointer high_priority_thread(gpointer data) {
 static gpointer mic_line_thread(gpointer data) {
   t_print("mic_line_thread\n");
   mybuffer *mybuf;
-  int nptr;
+  mybuffer **p;
+  int n;
 
   //
   // Ideally, a mic sample buffer with 64 samples arrives
   // every 1333 usec, but they may come in bursts
   //
   while (1) {
-#ifdef __APPLE__
-    sem_wait(mic_line_sem);
-#else
-    sem_wait(&mic_line_sem);
-#endif
-    nptr = mic_outptr + 1;
+    ringbuf_wait(&mic_ring, -1);
+    n = 1;
 
-    if (nptr >= MICRINGBUFLEN) { nptr = 0; }
+    if ((p = ringbuf_peek(&mic_ring, &n)) == NULL) { continue; }
 
-    mybuf = (mybuffer *) mic_line_buffer[mic_outptr];
-    MEMORY_BARRIER;
-    mic_outptr = nptr;
+    mybuf = *p;
+    ringbuf_release(&mic_ring, 1);
 
-    // This can happen when restarting the protocol
-    if (mybuf->free) { continue; }
+    // This should not happen: buffer released twice
+    if (mybuf->free) {
+      t_print("%s: stale buffer %d skipped\n", __FUNCTION__, mybuf->index);
+      continue;
+    }
 
     process_mic_data(mybuf->buffer);
-    mybuf->free = 1;
+    bufpool_put(mybuf);
   }
 
   return NULL;
@@ -2111,32 +2132,21 @@ void saturn_post_high_priority(mybuffer *buffer) {
 
 void saturn_post_micaudio(int bytesread, mybuffer *mybuf) {
   if (!P2running) {
-    mybuf->free = 1;
+    bufpool_put(mybuf);
     return;
   }
 
   if (mic_count < 0) {
     mic_count++;
-    mybuf->free = 1;
+    bufpool_put(mybuf);
     return;
   }
 
-  int nptr = mic_inptr + 1;
+  *(mybuffer **)ringbuf_head(&mic_ring) = mybuf;
 
-  if (nptr >= MICRINGBUFLEN) { nptr = 0; }
-
-  if (nptr != mic_outptr) {
-    mic_line_buffer[mic_inptr] = mybuf;
-    MEMORY_BARRIER;
-#ifdef __APPLE__
-    sem_post(mic_line_sem);
-#else
-    sem_post(&mic_line_sem);
-#endif
-    mic_inptr = nptr;
-  } else {
+  if (ringbuf_commit(&mic_ring, 1) != 0) {
     t_print("%s: buffer overflow.\n", __FUNCTION__);
-    mybuf->free = 1;
+    bufpool_put(mybuf);
     // skip 16 mic buffers (21 msec)
     mic_count = -16;
   }
@@ -2145,18 +2155,18 @@ void saturn_post_micaudio(int bytesread, mybuffer *mybuf) {
 void saturn_post_iq_data(int ddc, mybuffer *mybuf) {
   if (ddc < 0 || ddc >= MAX_DDC) {
     t_print("%s: invalid DDC(%d) seen!\n", __FUNCTION__, ddc);
-    mybuf->free = 1;
+    bufpool_put(mybuf);
     return;
   }
 
   if (!P2running) {
-    mybuf->free = 1;
+    bufpool_put(mybuf);
     return;
   }
 
   if (iq_count[ddc] < 0) {
     iq_count[ddc]++;
-    mybuf->free = 1;
+    bufpool_put(mybuf);
     return;
   }
 
@@ -2175,23 +2185,11 @@ void saturn_post_iq_data(int ddc, mybuffer *mybuf) {
   }
 
   ddc_sequence[ddc] = sequence + 1;
-  int iptr = iq_inptr[ddc];
-  int nptr = iptr + 1;
+  *(mybuffer **)ringbuf_head(&iq_ring[ddc]) = mybuf;
 
-  if (nptr >= RXIQRINGBUFLEN) { nptr = 0; }
-
-  if (nptr != iq_outptr[ddc]) {
-    iq_buffer[ddc][iptr] = mybuf;
-    MEMORY_BARRIER;
-    iq_inptr[ddc] = nptr;
-#ifdef __APPLE__
-    sem_post(iq_sem[ddc]);
-#else
-    sem_post(&iq_sem[ddc]);
-#endif
-  } else {
+  if (ringbuf_commit(&iq_ring[ddc], 1) != 0) {
     t_print("%s: DDC(%d) buffer overflow.\n", __FUNCTION__, ddc);
-    mybuf->free = 1;
+    bufpool_put(mybuf);
     // skip 128 incoming buffers
     iq_count[ddc] = -128;
   }
@@ -2202,10 +2200,11 @@ static gpointer iq_thread(gpointer data) {
   //
   // TEMPORARY: additional sequence check here
   //
-  int nptr, optr;
+  int n;
   long sequence;
   long expected_sequence = 0;
-  volatile mybuffer *mybuf;
+  mybuffer **p;
+  mybuffer *mybuf;
   const unsigned char *buffer;
   t_print("iq_thread: ddc=%d\n", ddc);
 
@@ -2217,22 +2216,19 @@ static gpointer iq_thread(gpointer data) {
   // channel.
   //
   while (1) {
-#ifdef __APPLE__
-    sem_wait(iq_sem[ddc]);
-#else
-    sem_wait(&iq_sem[ddc]);
-#endif
-    optr = iq_outptr[ddc];
-    nptr = optr + 1;
+    ringbuf_wait(&iq_ring[ddc], -1);
+    n = 1;
 
-    if (nptr >= RXIQRINGBUFLEN) { nptr = 0; }
+    if ((p = ringbuf_peek(&iq_ring[ddc], &n)) == NULL) { continue; }
 
-    mybuf = iq_buffer[ddc][optr];
-    MEMORY_BARRIER;
-    iq_outptr[ddc] = nptr;
+    mybuf = *p;
+    ringbuf_release(&iq_ring[ddc], 1);
 
-    // This can happen when restarting the protocol
-    if (mybuf->free) { continue; }
+    // This should not happen: buffer released twice
+    if (mybuf->free) {
+      t_print("%s: DDC(%d) stale buffer %d skipped\n", __FUNCTION__, ddc, mybuf->index);
+      continue;
+    }
 
     buffer = (unsigned char *) mybuf->buffer;
     //
@@ -2271,18 +2267,13 @@ static gpointer iq_thread(gpointer data) {
       break;
     }
 
-    mybuf->free = 1;
+    bufpool_put(mybuf);
   }
 
   return NULL;
 }
 
 static void process_iq_data(const unsigned char *buffer, RECEIVER *rx) {
-  int b;
-  int leftsample;
-  int rightsample;
-  double leftsampledouble;
-  double rightsampledouble;
   int samplesperframe = ((buffer[14] & 0xFF) << 8) + (buffer[15] & 0xFF);
 #ifdef P2IQDEBUG
   long long timestamp =
@@ -2297,37 +2288,18 @@ static void process_iq_data(const unsigned char *buffer, RECEIVER *rx) {
   int bitspersample = ((buffer[12] & 0xFF) << 8) + (buffer[13] & 0xFF);
   t_print("%s: rx=%d bitspersample=%d samplesperframe=%d\n", __FUNCTION__, rx->id, bitspersample, samplesperframe);
 #endif
-  b = 16;
-  int i;
-
-  for (i = 0; i < samplesperframe; i++) {
-    leftsample   = (int)((signed char) buffer[b++]) << 16;
-    leftsample  |= (int)((((unsigned char)buffer[b++]) << 8) & 0xFF00);
-    leftsample  |= (int)((unsigned char)buffer[b++] & 0xFF);
-    rightsample  = (int)((signed char)buffer[b++]) << 16;
-    rightsample |= (int)((((unsigned char)buffer[b++]) << 8) & 0xFF00);
-    rightsample |= (int)((unsigned char)buffer[b++] & 0xFF);
-    // The "obscure" constant 1.1920928955078125E-7 is 1/(2^23)
-    leftsampledouble = (double)leftsample * 1.1920928955078125E-7;
-    rightsampledouble = (double)rightsample * 1.1920928955078125E-7;
-    rx_add_iq_samples(rx, leftsampledouble, rightsampledouble);
-  }
+  //
+  // The IQ samples start at offset 16 and are contiguous (6 bytes per IQ pair),
+  // so the whole frame can be handed over to the RX engine in one go.
+  //
+  rx_add_iq_block(rx, buffer + 16, 6, samplesperframe);
 }
 
 //
-// This is the same as process_ps_iq_data except that add_div_iq_samples is called
-// at the end
+// This is the same as process_ps_iq_data except that the samples are fed
+// to the diversity mixer at the end
 //
 static void process_div_iq_data(const unsigned char*buffer) {
-  int b;
-  int leftsample0;
-  int rightsample0;
-  double leftsampledouble0;
-  double rightsampledouble0;
-  int leftsample1;
-  int rightsample1;
-  double leftsampledouble1;
-  double rightsampledouble1;
   int samplesperframe = ((buffer[14] & 0xFF) << 8) + (buffer[15] & 0xFF);
 #ifdef P2IQDEBUG
   long long timestamp =
@@ -2342,49 +2314,27 @@ static void process_div_iq_data(const unsigned char*buffer) {
   int bitspersample = ((buffer[12] & 0xFF) << 8) + (buffer[13] & 0xFF);
   t_print("%s: rx=%d bitspersample=%d samplesperframe=%d\n", __FUNCTION__, rx->id, bitspersample, samplesperframe);
 #endif
-  b = 16;
-  int i;
-
-  for (i = 0; i < samplesperframe; i += 2) {
-    leftsample0   = (int)((signed char) buffer[b++]) << 16;
-    leftsample0  |= (int)((((unsigned char)buffer[b++]) << 8) & 0xFF00);
-    leftsample0  |= (int)((unsigned char)buffer[b++] & 0xFF);
-    rightsample0  = (int)((signed char)buffer[b++]) << 16;
-    rightsample0 |= (int)((((unsigned char)buffer[b++]) << 8) & 0xFF00);
-    rightsample0 |= (int)((unsigned char)buffer[b++] & 0xFF);
-    leftsampledouble0 = (double)leftsample0 * 1.1920928955078125E-7;
-    rightsampledouble0 = (double)rightsample0 * 1.1920928955078125E-7;
-    leftsample1   = (int)((signed char) buffer[b++]) << 16;
-    leftsample1  |= (int)((((unsigned char)buffer[b++]) << 8) & 0xFF00);
-    leftsample1  |= (int)((unsigned char)buffer[b++] & 0xFF);
-    rightsample1  = (int)((signed char)buffer[b++]) << 16;
-    rightsample1 |= (int)((((unsigned char)buffer[b++]) << 8) & 0xFF00);
-    rightsample1 |= (int)((unsigned char)buffer[b++] & 0xFF);
-    leftsampledouble1 = (double)leftsample1 * 1.1920928955078125E-7;
-    rightsampledouble1 = (double)rightsample1 * 1.1920928955078125E-7;
-    rx_add_div_iq_samples(receiver[0], leftsampledouble0, rightsampledouble0, leftsampledouble1, rightsampledouble1);
+  //
+  // The samples of the two ADCs are interleaved, each IQ pair of one ADC
+  // is followed by the IQ pair of the other one (12 bytes per "double" pair).
+  //
+  int pairs = (samplesperframe + 1) / 2;
+  rx_add_div_iq_block(receiver[0], buffer + 16, buffer + 22, 12, pairs);
 
-    //
-    // if both receivers share the sample rate, we can feed data to RX2
-    //
-    if (receivers > 1 && (receiver[0]->sample_rate == receiver[1]->sample_rate)) {
-      rx_add_iq_samples(receiver[1], leftsampledouble1, rightsampledouble1);
-    }
+  //
+  // if both receivers share the sample rate, we can feed data to RX2
+  //
+  if (receivers > 1 && (receiver[0]->sample_rate == receiver[1]->sample_rate)) {
+    rx_add_iq_block(receiver[1], buffer + 22, 12, pairs);
   }
 }
 
 static void process_ps_iq_data(const unsigned char *buffer) {
-  int samplesperframe;
-  int b;
-  int leftsample0;
-  int rightsample0;
-  double leftsampledouble0;
-  double rightsampledouble0;
-  int leftsample1;
-  int rightsample1;
-  double leftsampledouble1;
-  double rightsampledouble1;
-  samplesperframe = ((buffer[14] & 0xFF) << 8) + (buffer[15] & 0xFF);
+  //
+  // A PS frame contains at most 238 IQ pairs (2*119 from each ADC)
+  //
+  double iq[2 * 238];
+  int samplesperframe = ((buffer[14] & 0xFF) << 8) + (buffer[15] & 0xFF);
 #ifdef P2IQDEBUG
   long long timestamp =
     ((long long)(buffer[4] & 0xFF) << 56)
@@ -2398,39 +2348,30 @@ static void process_ps_iq_data(const unsigned char *buffer) {
   int bitspersample = ((buffer[12] & 0xFF) << 8) + (buffer[13] & 0xFF);
   t_print("%s: rx=%d bitspersample=%d samplesperframe=%d\n", __FUNCTION__, rx->id, bitspersample, samplesperframe);
 #endif
-  b = 16;
-  int i;
 
-  for (i = 0; i < samplesperframe; i += 2) {
-    leftsample0   = (int)((signed char) buffer[b++]) << 16;
-    leftsample0  |= (int)((((unsigned char)buffer[b++]) << 8) & 0xFF00);
-    leftsample0  |= (int)((unsigned char)buffer[b++] & 0xFF);
-    rightsample0  = (int)((signed char)buffer[b++]) << 16;
-    rightsample0 |= (int)((((unsigned char)buffer[b++]) << 8) & 0xFF00);
-    rightsample0 |= (int)((unsigned char)buffer[b++] & 0xFF);
-    leftsampledouble0 = (double)leftsample0 * 1.1920928955078125E-7;
-    rightsampledouble0 = (double)rightsample0 * 1.1920928955078125E-7;
-    leftsample1   = (int)((signed char) buffer[b++]) << 16;
-    leftsample1  |= (int)((((unsigned char)buffer[b++]) << 8) & 0xFF00);
-    leftsample1  |= (int)((unsigned char)buffer[b++] & 0xFF);
-    rightsample1  = (int)((signed char)buffer[b++]) << 16;
-    rightsample1 |= (int)((((unsigned char)buffer[b++]) << 8) & 0xFF00);
-    rightsample1 |= (int)((unsigned char)buffer[b++] & 0xFF);
-    leftsampledouble1 = (double)leftsample1 * 1.1920928955078125E-7;
-    rightsampledouble1 = (double)rightsample1 * 1.1920928955078125E-7;
-    tx_add_ps_iq_samples(transmitter, leftsampledouble1, rightsampledouble1, leftsampledouble0, rightsampledouble0);
-    //t_print("%06x,%06x %06x,%06x\n",leftsample0,rightsample0,leftsample1,rightsample1);
+  if (samplesperframe > 238) { samplesperframe = 238; }
+
+  //
+  // The samples are contiguous, so convert the whole frame at once and
+  // then sort out RX feedback (even) and TX feedback (odd) IQ pairs.
+  //
+  iq_unpack24(buffer + 16, 6, iq, samplesperframe);
+
+  for (int i = 0; i + 1 < samplesperframe; i += 2) {
+    const double *rxfb = iq + 2 * i;
+    const double *txfb = rxfb + 2;
+    tx_add_ps_iq_samples(transmitter, txfb[0], txfb[1], rxfb[0], rxfb[1]);
 #if defined(DUMP_TX_DATA)
 
     if ((DUMP_TX_DATA == DUMP_TXFDBK) && (rxiq_count < 1000000)) {
-      rxiqi[rxiq_count] = leftsample1;
-      rxiqq[rxiq_count] = rightsample1;
+      rxiqi[rxiq_count] = (long)(txfb[0] * 8388608.0);
+      rxiqq[rxiq_count] = (long)(txfb[1] * 8388608.0);
       rxiq_count++;
     }
 
     if ((DUMP_TX_DATA == DUMP_RXFDBK) && (rxiq_count < 1000000)) {
-      rxiqi[rxiq_count] = leftsample0;
-      rxiqq[rxiq_count] = rightsample0;
+      rxiqi[rxiq_count] = (long)(rxfb[0] * 8388608.0);
+      rxiqq[rxiq_count] = (long)(rxfb[1] * 8388608.0);
       rxiq_count++;
     }
 
@@ -2636,31 +2577,21 @@ void new_protocol_cw_audio_samples(short left_audio_sample, short right_audio_sa
       //
       rxaudio_drain = 1;
 
-      while (rxaudio_inptr != rxaudio_outptr) { usleep(1000); }
+      while (ringbuf_count(&rxaudio_ring) > 0) { usleep(1000); }
 
       rxaudio_drain = 0;
       rxaudio_flag = 1;
     }
 
-    int iptr = rxaudio_inptr + 4 * rxaudio_count;
-    RXAUDIORINGBUF[iptr++] = (left_audio_sample  >> 8) & 0xFF;
-    RXAUDIORINGBUF[iptr++] = (left_audio_sample      ) & 0xFF;
-    RXAUDIORINGBUF[iptr++] = (right_audio_sample >> 8) & 0xFF;
-    RXAUDIORINGBUF[iptr++] = (right_audio_sample     ) & 0xFF;
+    unsigned char *p = (unsigned char *)ringbuf_head(&rxaudio_ring) + 4 * rxaudio_count;
+    *p++ = (left_audio_sample  >> 8) & 0xFF;
+    *p++ = (left_audio_sample      ) & 0xFF;
+    *p++ = (right_audio_sample >> 8) & 0xFF;
+    *p++ = (right_audio_sample     ) & 0xFF;
     rxaudio_count++;
 
     if (rxaudio_count >= 64) {
-      int nptr = rxaudio_inptr + 256;
-
-      if (nptr >= RXAUDIORINGBUFLEN) { nptr = 0; }
-
-      if (nptr != rxaudio_outptr) {
-        rxaudio_inptr = nptr;
-#ifdef __APPLE__
-        sem_post(rxaudio_sem);
-#else
-        sem_post(&rxaudio_sem);
-#endif
+      if (ringbuf_commit(&rxaudio_ring, 1) == 0) {
         rxaudio_count = 0;
       } else {
         t_print("%s: buffer overflow\n", __FUNCTION__);
@@ -2699,25 +2630,15 @@ void new_protocol_audio_samples(short left_audio_sample, short right_audio_sampl
     rxaudio_flag = 0;
   }
 
-  int iptr = rxaudio_inptr + 4 * rxaudio_count;
-  RXAUDIORINGBUF[iptr++] = (left_audio_sample  >> 8) & 0xFF;
-  RXAUDIORINGBUF[iptr++] = (left_audio_sample      ) & 0xFF;
-  RXAUDIORINGBUF[iptr++] = (right_audio_sample >> 8) & 0xFF;
-  RXAUDIORINGBUF[iptr++] = (right_audio_sample     ) & 0xFF;
+  unsigned char *p = (unsigned char *)ringbuf_head(&rxaudio_ring) + 4 * rxaudio_count;
+  *p++ = (left_audio_sample  >> 8) & 0xFF;
+  *p++ = (left_audio_sample      ) & 0xFF;
+  *p++ = (right_audio_sample >> 8) & 0xFF;
+  *p++ = (right_audio_sample     ) & 0xFF;
   rxaudio_count++;
 
   if (rxaudio_count >= 64) {
-    int nptr = rxaudio_inptr + 256;
-
-    if (nptr >= RXAUDIORINGBUFLEN) { nptr = 0; }
-
-    if (nptr != rxaudio_outptr) {
-      rxaudio_inptr = nptr;
-#ifdef __APPLE__
-      sem_post(rxaudio_sem);
-#else
-      sem_post(&rxaudio_sem);
-#endif
+    if (ringbuf_commit(&rxaudio_ring, 1) == 0) {
       rxaudio_count = 0;
     } else {
       t_print("%s: buffer overflow\n", __FUNCTION__);
@@ -2729,6 +2650,20 @@ void new_protocol_audio_samples(short left_audio_sample, short right_audio_sampl
   pthread_mutex_unlock(&send_rxaudio_mutex);
 }
 
+//
+// Hand over a full TXIQ buffer (240 samples) to the TXIQ thread,
+// called by both new_protocol_iq_samples and new_protocol_iq_block
+//
+static void new_protocol_txiq_commit() {
+  if (ringbuf_commit(&txiq_ring, 1) == 0) {
+    txiq_count = 0;
+  } else {
+    t_print("%s: output buffer overflow\n", __FUNCTION__);
+    // skip 4800 samples ( 25 msec @ 192k )
+    txiq_count = -4800;
+  }
+}
+
 void new_protocol_iq_samples(int isample, int qsample) {
   if (txiq_count < 0) {
     txiq_count++;
@@ -2744,34 +2679,64 @@ void new_protocol_iq_samples(int isample, int qsample) {
   }
 
 #endif
-  int iptr = txiq_inptr + 6 * txiq_count;
-  TXIQRINGBUF[iptr++] = (isample >> 16) & 0xFF;
-  TXIQRINGBUF[iptr++] = (isample >>  8) & 0xFF;
-  TXIQRINGBUF[iptr++] = (isample      ) & 0xFF;
-  TXIQRINGBUF[iptr++] = (qsample >> 16) & 0xFF;
-  TXIQRINGBUF[iptr++] = (qsample >>  8) & 0xFF;
-  TXIQRINGBUF[iptr++] = (qsample      ) & 0xFF;
+  unsigned char *p = (unsigned char *)ringbuf_head(&txiq_ring) + 6 * txiq_count;
+  *p++ = (isample >> 16) & 0xFF;
+  *p++ = (isample >>  8) & 0xFF;
+  *p++ = (isample      ) & 0xFF;
+  *p++ = (qsample >> 16) & 0xFF;
+  *p++ = (qsample >>  8) & 0xFF;
+  *p++ = (qsample      ) & 0xFF;
   txiq_count++;
 
   if (txiq_count >= 240) {
-    int nptr = txiq_inptr + 1440;
+    new_protocol_txiq_commit();
+  }
+}
 
-    if (nptr >= TXIQRINGBUFLEN) { nptr = 0; }
+void new_protocol_iq_block(const double *iq, int n, double gain) {
+  //
+  // Block version of new_protocol_iq_samples: n interleaved double IQ
+  // pairs are scaled with gain, rounded, and packed into the ring
+  // buffer in chunks that end at 240-sample boundaries.
+  //
+#if defined(DUMP_TX_DATA)
+
+  for (int i = 0; i < n; i++) {
+    double is = iq[2 * i] * gain;
+    double qs = iq[2 * i + 1] * gain;
+    new_protocol_iq_samples(is >= 0.0 ? (int)floor(is + 0.5) : (int)ceil(is - 0.5),
+                            qs >= 0.0 ? (int)floor(qs + 0.5) : (int)ceil(qs - 0.5));
+  }
 
-    if (nptr != txiq_outptr) {
-      txiq_inptr = nptr;
-      txiq_count = 0;
-#ifdef __APPLE__
-      sem_post(txiq_sem);
 #else
-      sem_post(&txiq_sem);
-#endif
+
+  while (n > 0) {
+    int chunk;
+
+    if (txiq_count < 0) {
+      chunk = -txiq_count;
+
+      if (chunk > n) { chunk = n; }
+
+      txiq_count += chunk;
     } else {
-      t_print("%s: output buffer overflow\n", __FUNCTION__);
-      // skip 4800 samples ( 25 msec @ 192k )
-      txiq_count = -4800;
+      chunk = 240 - txiq_count;
+
+      if (chunk > n) { chunk = n; }
+
+      iq_pack24(iq, (unsigned char *)ringbuf_head(&txiq_ring) + 6 * txiq_count, 6, chunk, gain);
+      txiq_count += chunk;
+
+      if (txiq_count >= 240) {
+        new_protocol_txiq_commit();
+      }
     }
+
+    iq += 2 * chunk;
+    n -= chunk;
   }
+
+#endif
 }
 
 // cppcheck-suppress constParameterCallback
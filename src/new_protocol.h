@@ -24,6 +24,7 @@
 
 #include "MacOS.h"   // for semaphores
 #include "receiver.h"
+#include "bufpool.h"
 
 #define MAX_DDC 4
 
@@ -57,17 +58,20 @@
 
 /////////////////////////////////////////////////////////////////////////////
 //
-// PEDESTRIAN BUFFER MANAGEMENT
+// BUFFER MANAGEMENT
 //
 ////////////////////////////////////////////////////////////////////////////
 //
-// One buffer. The fences can be used to detect over-writing
+// One buffer, obtained from and returned to a BUFPOOL (see bufpool.h).
+// The fences can be used to detect over-writing
 // (feature currently not used).
 //
 ////////////////////////////////////////////////////////////////////////////
 
 struct mybuffer_ {
-  struct mybuffer_ *next;
+  BUFPOOL        *pool;            // pool this buffer belongs to
+  int             index;           // position within the pool
+  int             next;            // free list link (index + 1, 0: end of list)
   int             free;
   long            lowfence;
   unsigned char   buffer[NET_BUFFER_SIZE];
@@ -91,6 +95,7 @@ extern void tuner_changed(void);
 
 extern void new_protocol_audio_samples(short left_audio_sample, short right_audio_sample);
 extern void new_protocol_iq_samples(int isample, int qsample);
+extern void new_protocol_iq_block(const double *iq, int n, double gain);
 extern void new_protocol_flush_iq_samples(void);
 extern void new_protocol_cw_audio_samples(short l, short r);
 
@@ -100,6 +105,12 @@ extern void saturn_post_iq_data(int ddc, mybuffer *buffer);
 extern void saturn_post_micaudio(int bytes, mybuffer *buffer);
 extern void saturn_post_high_priority(mybuffer *buffer);
 
+//
+// Network buffer pool shared by the P2 receive thread and the
+// Saturn XDMA threads
+//
+extern BUFPOOL p2_bufpool;
+
 //
 // if DUMP_TX_DATA is #defined, the first 1000000 samples
 // after a RXTX transition are dumped to a file at the
@@ -34,6 +34,7 @@
 #include "vfo.h"
 #include "ext.h"
 
+#ifndef HEADLESS
 static GtkWidget *dialog = NULL;
 
 static GtkWidget *nr_container;
@@ -57,6 +58,7 @@ static gboolean close_cb () {
   cleanup();
   return TRUE;
 }
+#endif
 
 void update_noise() {
   int id = active_receiver->id;
@@ -95,6 +97,7 @@ void update_noise() {
   g_idle_add(ext_vfo_update, NULL);
 }
 
+#ifndef HEADLESS
 static void nb_cb(GtkToggleButton *widget, gpointer data) {
   active_receiver->nb = gtk_combo_box_get_active (GTK_COMBO_BOX(widget));
   update_noise();
@@ -546,3 +549,4 @@ void noise_menu(GtkWidget *parent) {
   gtk_widget_hide(nr4_container);
 #endif
 }
+#endif
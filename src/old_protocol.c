@@ -53,6 +53,9 @@
 #include "vfo.h"
 #include "ext.h"
 #include "iambic.h"
+#include "iqconv.h"
+#include "ringbuf.h"
+#include "netio.h"
 #include "message.h"
 
 #define min(x,y) (x<y?x:y)
@@ -188,13 +191,6 @@ static int hl2_iob_present = 0;
   #define USB_TIMEOUT -7
 #endif
 
-#ifdef __APPLE__
-  static sem_t *txring_sem;
-  static sem_t *rxring_sem;
-#else
-  static sem_t txring_sem;
-  static sem_t rxring_sem;
-#endif
 //
 // probably not needed
 //
@@ -206,6 +202,11 @@ static pthread_mutex_t send_audio_mutex   = PTHREAD_MUTEX_INITIALIZER;
 //
 static pthread_mutex_t send_ozy_mutex   = PTHREAD_MUTEX_INITIALIZER;
 
+//
+// statistics for the (batched) UDP receive
+//
+static NETIO_STATS p1_rx_stats = { "P1 RX", 0, 0 };
+
 //
 // Ring buffer for outgoing samples.
 // Samples going to the radio are produced in big chunks.
@@ -228,7 +229,8 @@ static pthread_mutex_t send_ozy_mutex   = PTHREAD_MUTEX_INITIALIZER;
 // in the ring buffer and will then send 126 samples (two ozy buffers)
 // in one shot.
 //
-// TXRINGBUFLEN must be a multiple of 1008 bytes (126 samples)
+// Each slot of the TX ring holds 1008 bytes (126 samples), and the
+// samples are written directly into the head slot of the ring.
 //
 
 // Größe eines Audioframes in Bytes: 2 × 2 Byte für L/R + 4 Byte Padding
@@ -238,11 +240,9 @@ static pthread_mutex_t send_ozy_mutex   = PTHREAD_MUTEX_INITIALIZER;
 #define TXRINGBUFLEN  (TXRING_AUDIO_SAMPLE_BYTES * TXRING_AUDIO_FRAMES_PER_BLOCK * TXRING_MAX_BLOCKS)
 //  #define TXRINGBUFLEN 32256          // 80 msec
 
-static unsigned char *TXRINGBUF = NULL;
-static volatile int txring_inptr  = 0;  // pointer updated when writing into the ring buffer
-static volatile int txring_outptr = 0;  // pointer updated when reading from the ring buffer
+static RINGBUF txring;
 static volatile int txring_flag   = 0;  // 0: RX, 1: TX
-static volatile int txring_count  = 0;  // a sample counter
+static volatile int txring_count  = 0;  // number of samples in the head slot
 static volatile int txring_drain  = 0;  // a flag for draining the output buffer
 
 #ifdef __APPLE__
@@ -261,9 +261,7 @@ static volatile int txring_drain  = 0;  // a flag for draining the output buffer
 #else
   #define RXRINGBUFLEN (1024 * 512)   // must be multiple of 1024 since we queue double-buffers
 #endif
-static unsigned char *RXRINGBUF = NULL;
-static volatile int rxring_inptr  = 0;  // pointer updated when writing into the ring buffer
-static volatile int rxring_outptr = 0;  // pointer updated when reading from the ring buffer
+static RINGBUF rxring;                  // slots of 1024 bytes (two ozy buffers)
 static volatile int rxring_count  = 0;  // a sample counter
 
 #ifdef __APPLE__
@@ -288,43 +286,38 @@ void old_protocol_update_timing(void) {
 
 #ifdef __APPLE__
 static gpointer old_protocol_txiq_thread(gpointer data) {
-  int nptr;
+  const unsigned char *p;
+  int n;
   struct timespec target_time;
   clock_gettime(CLOCK_MONOTONIC, &target_time);  // Startzeitpunkt initialisieren
   old_protocol_update_timing();
   t_print("%s: sr=%d\n", __FUNCTION__, sr);
 
   for (;;) {
-    sem_wait(txring_sem);
-    nptr = txring_outptr + 1008;
+    ringbuf_wait(&txring, -1);
+    n = 1;
 
-    if (nptr >= TXRINGBUFLEN) { nptr = 0; }
+    // Keine Samples vorhanden → skip
+    if ((p = ringbuf_peek(&txring, &n)) == NULL) { continue; }
 
     // Falls TX gestoppt ist oder Drain-Modus aktiv → skip
     if (!P1running || txring_drain) {
-      txring_outptr = nptr;
+      ringbuf_release(&txring, 1);
       continue;
     }
 
     // Versuche exklusiven Zugriff auf TX-Sende-Buffer
     if (pthread_mutex_trylock(&send_ozy_mutex)) {
-      txring_outptr = nptr;
-      continue;
-    }
-
-    // Keine Samples vorhanden → skip
-    if (txring_outptr == nptr) {
-      pthread_mutex_unlock(&send_ozy_mutex);
+      ringbuf_release(&txring, 1);
       continue;
     }
 
     // ➤ Sende genau 1 Paket (besteht aus 2 × 504 Bytes = 1032 Bytes)
-    memcpy(output_buffer + 8, &TXRINGBUF[txring_outptr], 504);
+    memcpy(output_buffer + 8, p, 504);
     ozy_send_buffer();
-    memcpy(output_buffer + 8, &TXRINGBUF[txring_outptr + 504], 504);
+    memcpy(output_buffer + 8, p + 504, 504);
     ozy_send_buffer();
-    MEMORY_BARRIER;
-    txring_outptr = nptr;
+    ringbuf_release(&txring, 1);
     pthread_mutex_unlock(&send_ozy_mutex);
     // 🕒 Dynamisch berechneter Abstand je nach aktueller Sample-Rate
     int interval_us = 126 * 1000000 / (sr ? sr : 48000);
@@ -346,7 +339,8 @@ static gpointer old_protocol_txiq_thread(gpointer data) {
 
 #ifndef __APPLE__
 static gpointer old_protocol_txiq_thread(gpointer data) {
-  int nptr;
+  const unsigned char *p;
+  int n;
 
   //
   // Ideally, an output METIS buffer with 126 samples is sent every 2625 usec.
@@ -363,13 +357,13 @@ static gpointer old_protocol_txiq_thread(gpointer data) {
   // If "txring_drain" is set, drain the buffer
   //
   for (;;) {
-    sem_wait(&txring_sem);
-    nptr = txring_outptr + 1008;
+    ringbuf_wait(&txring, -1);
+    n = 1;
 
-    if (nptr >= TXRINGBUFLEN) { nptr = 0; }
+    if ((p = ringbuf_peek(&txring, &n)) == NULL) { continue; }
 
     if (!P1running || txring_drain) {
-      txring_outptr = nptr;
+      ringbuf_release(&txring, 1);
       continue;
     }
 
@@ -381,7 +375,7 @@ static gpointer old_protocol_txiq_thread(gpointer data) {
       // the sample rate, en/dis-abling PureSignal or
       // DIVERSITY, or executing the RESTART button.
       //
-      txring_outptr = nptr;
+      ringbuf_release(&txring, 1);
     } else {
       //
       // We used to have a fixed sleeping time of 2000 usec, and
@@ -438,12 +432,11 @@ static gpointer old_protocol_txiq_thread(gpointer data) {
       }
 
       FIFO += 126.0;  // number of samples in THIS packet
-      memcpy(output_buffer + 8, &TXRINGBUF[txring_outptr    ], 504);
+      memcpy(output_buffer + 8, p, 504);
       ozy_send_buffer();
-      memcpy(output_buffer + 8, &TXRINGBUF[txring_outptr + 504], 504);
+      memcpy(output_buffer + 8, p + 504, 504);
       ozy_send_buffer();
-      MEMORY_BARRIER;
-      txring_outptr = nptr;
+      ringbuf_release(&txring, 1);
       pthread_mutex_unlock(&send_ozy_mutex);
     }
   }
@@ -587,6 +580,8 @@ void old_protocol_stop() {
   pthread_mutex_lock(&send_ozy_mutex);
   metis_start_stop(0);
   pthread_mutex_unlock(&send_ozy_mutex);
+  netio_stats_log(&p1_rx_stats);
+  netio_stats_reset(&p1_rx_stats);
 }
 
 void old_protocol_run() {
@@ -611,21 +606,14 @@ void old_protocol_init(int rate) {
   t_print("%s: RX ring buffer size: %d bytes\n", __FUNCTION__, RXRINGBUFLEN);
   t_print("%s: TX ring buffer size: %d bytes\n", __FUNCTION__, TXRINGBUFLEN);
 
-  if (TXRINGBUF == NULL) {
-    TXRINGBUF = g_new(unsigned char, TXRINGBUFLEN);
+  if (txring.data == NULL) {
+    ringbuf_init(&txring, TXRING_MAX_BLOCKS, TXRING_AUDIO_SAMPLE_BYTES * TXRING_AUDIO_FRAMES_PER_BLOCK);
   }
 
-  if (RXRINGBUF == NULL) {
-    RXRINGBUF = g_new(unsigned char, RXRINGBUFLEN);
+  if (rxring.data == NULL) {
+    ringbuf_init(&rxring, RXRINGBUFLEN / 1024, 1024);
   }
 
-#ifdef __APPLE__
-  txring_sem = apple_sem(0);
-  rxring_sem = apple_sem(0);
-#else
-  (void) sem_init(&txring_sem, 0, 0);
-  (void) sem_init(&rxring_sem, 0, 0);
-#endif
   pthread_mutex_lock(&send_ozy_mutex);
   old_protocol_set_mic_sample_rate(rate);
   g_thread_new("P1 out", old_protocol_txiq_thread, NULL);
@@ -1060,15 +1048,20 @@ static void open_tcp_socket() {
 
 #ifndef __APPLE__
 static gpointer receive_thread(gpointer arg) {
-  struct sockaddr_in addr;
-  socklen_t length;
-  unsigned char buffer[1032];
+  unsigned char rxbuf[NETIO_BATCH][1032];
+  unsigned char *bufs[NETIO_BATCH];
+  int lens[NETIO_BATCH];
+  int npkt = 0;
+  unsigned char *buffer;
   int bytes_read;
   int ret, left;
   int ep;
   uint32_t sequence;
   t_print( "old_protocol: receive_thread\n");
-  length = sizeof(addr);
+
+  for (int i = 0; i < NETIO_BATCH; i++) {
+    bufs[i] = rxbuf[i];
+  }
 
   for (;;) {
     switch (device) {
@@ -1081,6 +1074,7 @@ static gpointer receive_thread(gpointer arg) {
         if (tcp_socket >= 0) {
           // TCP messages may be split, so collect exactly 1032 bytes.
           // Remember, this is a STREAMING protocol.
+          buffer = rxbuf[0];
           bytes_read = 0;
           left = 1032;
 
@@ -1098,8 +1092,15 @@ static gpointer receive_thread(gpointer arg) {
           if (ret < 0) {
             bytes_read = ret;                        // error case: discard whole packet
           }
+
+          npkt = 1;
+          lens[0] = bytes_read;
         } else if (data_socket >= 0) {
-          bytes_read = recvfrom(data_socket, buffer, sizeof(buffer), 0, (struct sockaddr*)&addr, &length);
+          //
+          // Receive up to NETIO_BATCH packets with one system call
+          //
+          npkt = netio_recv(&p1_rx_stats, data_socket, bufs, lens, sizeof(rxbuf[0]), NULL, NETIO_BATCH);
+          bytes_read = (npkt > 0) ? lens[0] : npkt;
 
           if (bytes_read < 0 && errno != EAGAIN) { t_perror("old_protocol recvfrom UDP:"); }
 
@@ -1122,67 +1123,72 @@ static gpointer receive_thread(gpointer arg) {
         continue;
       }
 
+      for (int i = 0; i < npkt; i++) {
+        buffer = rxbuf[i];
+        bytes_read = lens[i];
+
 #ifdef __APPLE__
-      static struct timespec last_rx_time = {0, 0};
-      struct timespec now_rx;
-      clock_gettime(CLOCK_MONOTONIC, &now_rx);
+        static struct timespec last_rx_time = {0, 0};
+        struct timespec now_rx;
+        clock_gettime(CLOCK_MONOTONIC, &now_rx);
 
-      if (last_rx_time.tv_sec != 0) {
-        long delta_us = (now_rx.tv_sec - last_rx_time.tv_sec) * 1000000 +
-                        (now_rx.tv_nsec - last_rx_time.tv_nsec) / 1000;
+        if (last_rx_time.tv_sec != 0) {
+          long delta_us = (now_rx.tv_sec - last_rx_time.tv_sec) * 1000000 +
+                          (now_rx.tv_nsec - last_rx_time.tv_nsec) / 1000;
 
-        if (delta_us > 3000 || delta_us < 2000) { // optionaler Filter
-          t_print("RX Jitter: Δt = %.3f ms\n", delta_us / 1000.0);
+          if (delta_us > 3000 || delta_us < 2000) { // optionaler Filter
+            t_print("RX Jitter: Δt = %.3f ms\n", delta_us / 1000.0);
+          }
         }
-      }
 
-      last_rx_time = now_rx;
+        last_rx_time = now_rx;
 #endif
 
-      if (buffer[0] == 0xEF && buffer[1] == 0xFE) {
-        switch (buffer[2]) {
-        case 1:
-          // get the end point
-          ep = buffer[3] & 0xFF;
-          // get the sequence number
-          sequence = ((buffer[4] & 0xFF) << 24) + ((buffer[5] & 0xFF) << 16) + ((buffer[6] & 0xFF) << 8) + (buffer[7] & 0xFF);
+        if (buffer[0] == 0xEF && buffer[1] == 0xFE) {
+          switch (buffer[2]) {
+          case 1:
+            // get the end point
+            ep = buffer[3] & 0xFF;
+            // get the sequence number
+            sequence = ((buffer[4] & 0xFF) << 24) + ((buffer[5] & 0xFF) << 16) + ((buffer[6] & 0xFF) << 8) + (buffer[7] & 0xFF);
+
+            // A sequence error with a seqnum of zero usually indicates a METIS restart
+            // and is no error condition
+            if (sequence != 0 && sequence != last_seq_num + 1) {
+              t_print("SEQ ERROR: last %ld, recvd %ld\n", (long) last_seq_num, (long) sequence);
+              sequence_errors++;
+            }
 
-          // A sequence error with a seqnum of zero usually indicates a METIS restart
-          // and is no error condition
-          if (sequence != 0 && sequence != last_seq_num + 1) {
-            t_print("SEQ ERROR: last %ld, recvd %ld\n", (long) last_seq_num, (long) sequence);
-            sequence_errors++;
-          }
+            last_seq_num = sequence;
 
-          last_seq_num = sequence;
+            switch (ep) {
+            case 6: // EP6
+              // process the data
+              queue_two_ozy_input_buffers(&buffer[8], &buffer[520]);
+              break;
+
+            case 4: // EP4
+              // not implemented
+              break;
+
+            default:
+              t_print("unexpected EP %d length=%d\n", ep, bytes_read);
+              break;
+            }
 
-          switch (ep) {
-          case 6: // EP6
-            // process the data
-            queue_two_ozy_input_buffers(&buffer[8], &buffer[520]);
             break;
 
-          case 4: // EP4
-            // not implemented
+          case 2:  // response to a discovery packet
+            t_print("unexepected discovery response when not in discovery mode\n");
             break;
 
           default:
-            t_print("unexpected EP %d length=%d\n", ep, bytes_read);
+            t_print("unexpected packet type: 0x%02X\n", buffer[2]);
             break;
           }
-
-          break;
-
-        case 2:  // response to a discovery packet
-          t_print("unexepected discovery response when not in discovery mode\n");
-          break;
-
-        default:
-          t_print("unexpected packet type: 0x%02X\n", buffer[2]);
-          break;
+        } else {
+          t_print("received bad header bytes on data port %02X,%02X\n", buffer[0], buffer[1]);
         }
-      } else {
-        t_print("received bad header bytes on data port %02X,%02X\n", buffer[0], buffer[1]);
       }
 
       break;
@@ -1779,6 +1785,91 @@ static int st_num_hpsdr_receivers;
 static int st_rxfdbk;
 static int st_txfdbk;
 
+static void process_mic_sample(short sample) {
+  mic_samples++;
+
+  if (mic_samples >= mic_sample_divisor) { // reduce to 48000
+    //
+    // if radio_ptt is set, this usually means the PTT at the microphone connected
+    // to the SDR is pressed. In this case, we take audio from BOTH sources
+    // then we can use a "voice keyer" on some loop-back interface but at the same
+    // time use our microphone.
+    // In most situations only one source will be active so we just add.
+    //
+    float fsample;
+
+    if (radio_ptt) {
+      fsample = (float) sample * 0.00003051;
+
+      if (transmitter->local_microphone) { fsample += audio_get_next_mic_sample(); }
+    } else {
+      fsample = transmitter->local_microphone ? audio_get_next_mic_sample() : (float) sample * 0.00003051;
+    }
+
+    tx_add_mic_sample(transmitter, fsample);
+    mic_samples = 0;
+  }
+}
+
+//
+// process_ozy_frame processes a complete 512-byte frame whose sync
+// bytes have already been checked. Since the layout of the frame
+// (3 sync bytes, 5 control bytes, then iq_samples "slots" each
+// containing one IQ pair per HPSDR receiver followed by a mic sample)
+// is fixed, the receivers' IQ data and the mic samples are taken from
+// the frame with stride loops.
+// The byte-wise state machine process_ozy_byte is only used to re-sync
+// after a sync error.
+//
+static void process_ozy_frame(const unsigned char *frame) {
+  int nrx = st_num_hpsdr_receivers;
+  int stride = (nrx * 6) + 2;
+  int n = (512 - 8) / stride;
+  const unsigned char *iq = frame + 8;
+  const unsigned char *mic = iq + 6 * nrx;
+  memcpy(control_in, frame + 3, 5);
+  process_control_bytes();
+
+  if (radio_is_transmitting() && transmitter->puresignal && st_rxfdbk < nrx && st_txfdbk < nrx) {
+    //
+    // transmitting with PureSignal. Get sample pairs and feed to pscc
+    // A frame contains at most 63 samples (one HPSDR receiver)
+    //
+    double rxfb[2 * 63];
+    double txfb[2 * 63];
+    iq_unpack24(iq + 6 * st_rxfdbk, stride, rxfb, n);
+    iq_unpack24(iq + 6 * st_txfdbk, stride, txfb, n);
+
+    for (int i = 0; i < 2 * n; i += 2) {
+      tx_add_ps_iq_samples(transmitter, txfb[i], txfb[i + 1], rxfb[i], rxfb[i + 1]);
+    }
+  }
+
+  if (!radio_is_transmitting() && diversity_enabled && nrx > 1) {
+    //
+    // receiving with DIVERSITY. Feed sample pairs to diversity mixer.
+    // If the second RX is running, feed aux samples to that receiver.
+    //
+    rx_add_div_iq_block(receiver[0], iq, iq + 6, stride, n);
+
+    if (receivers > 1) { rx_add_iq_block(receiver[1], iq + 6, stride, n); }
+  }
+
+  if ((!radio_is_transmitting() || duplex) && !diversity_enabled) {
+    //
+    // RX without DIVERSITY. Feed samples to RX1 and RX2
+    //
+    rx_add_iq_block(receiver[0], iq, stride, n);
+
+    if (nrx > 1 && receivers > 1) { rx_add_iq_block(receiver[1], iq + 6, stride, n); }
+  }
+
+  for (int i = 0; i < n; i++) {
+    process_mic_sample((short)((mic[0] << 8) | mic[1]));
+    mic += stride;
+  }
+}
+
 static void process_ozy_byte(int b) {
   switch (state) {
   case SYNC_0:
@@ -1930,30 +2021,7 @@ static void process_ozy_byte(int b) {
 
   case MIC_SAMPLE_LOW:
     mic_sample |= (short)(b & 0xFF);
-    mic_samples++;
-
-    if (mic_samples >= mic_sample_divisor) { // reduce to 48000
-      //
-      // if radio_ptt is set, this usually means the PTT at the microphone connected
-      // to the SDR is pressed. In this case, we take audio from BOTH sources
-      // then we can use a "voice keyer" on some loop-back interface but at the same
-      // time use our microphone.
-      // In most situations only one source will be active so we just add.
-      //
-      float fsample;
-
-      if (radio_ptt) {
-        fsample = (float) mic_sample * 0.00003051;
-
-        if (transmitter->local_microphone) { fsample += audio_get_next_mic_sample(); }
-      } else {
-        fsample = transmitter->local_microphone ? audio_get_next_mic_sample() : (float) mic_sample * 0.00003051;
-      }
-
-      tx_add_mic_sample(transmitter, fsample);
-      mic_samples = 0;
-    }
-
+    process_mic_sample(mic_sample);
     nsamples++;
 
     if (nsamples == iq_samples) {
@@ -1972,7 +2040,7 @@ static void queue_two_ozy_input_buffers(unsigned const char *buf1,
   //
   // To achieve minimum overhead in the RX thread, the data is
   // simply put into a large ring buffer. We queue two buffers
-  // in one shot since this halves the number of semamphore operations
+  // in one shot since this halves the number of ring buffer operations
   // at no cost (buffer fly in in pairs anyway)
   //
   if (rxring_count < 0) {
@@ -1980,39 +2048,25 @@ static void queue_two_ozy_input_buffers(unsigned const char *buf1,
     return;
   }
 
-  int nptr = rxring_inptr + 1024;
-
-  if (nptr >= RXRINGBUFLEN) { nptr = 0; }
+  unsigned char *p = ringbuf_head(&rxring);
+  memcpy(p, buf1, 512);
+  memcpy(p + 512, buf2, 512);
 
+  if (ringbuf_commit(&rxring, 1) != 0) {
 #ifdef __APPLE__
-
-  if (nptr == rxring_outptr) {
-    t_print("%s: RX input buffer overflow — overwriting oldest buffer.\n", __FUNCTION__);
-    // Ältestes Paket verwerfen, indem der out-pointer auf das nächste Element zeigt
-    rxring_outptr = (rxring_outptr + 1024) % RXRINGBUFLEN;
-  }
-
-  memcpy((void *)(&RXRINGBUF[rxring_inptr]), buf1, 512);
-  memcpy((void *)(&RXRINGBUF[rxring_inptr + 512]), buf2, 512);
-  MEMORY_BARRIER;
-  rxring_inptr = nptr;
-  sem_post(rxring_sem);
+    //
+    // Only the consumer may advance the read pointer, so we cannot
+    // overwrite the oldest buffer. Drop this one instead, but do not
+    // skip any further buffers.
+    //
+    t_print("%s: RX input buffer overflow — dropping buffer.\n", __FUNCTION__);
 #else
-
-  if (nptr != rxring_outptr) {
-    memcpy((void *)(&RXRINGBUF[rxring_inptr    ]), buf1, 512);
-    memcpy((void *)(&RXRINGBUF[rxring_inptr + 512]), buf2, 512);
-    MEMORY_BARRIER;
-    rxring_inptr = nptr;
-    sem_post(&rxring_sem);
-  } else {
     t_print("%s: input buffer overflow.\n", __FUNCTION__);
     // if an overflow is encountered, skip the next 256 input buffers
     // to allow a "fresh start"
     rxring_count = -256;
-  }
-
 #endif
+  }
 }
 
 static gpointer process_ozy_input_buffer_thread(gpointer arg) {
@@ -2020,20 +2074,20 @@ static gpointer process_ozy_input_buffer_thread(gpointer arg) {
   // This thread constantly monitors the input ring buffer and
   // processes the data whenever a bunch is available. Note this
   // thread does all the fexchange() with WDSP, since it calls
-  // (via process_ozy_byte)
+  // (via process_ozy_frame)
   //
-  // add_iq_samples   ==> RX engine(s)
+  // rx_add_iq_block  ==> RX engine(s)
   // add_mic_sample   ==> TX engine
   //
+  int resync = 0;
+  const unsigned char *p;
+  int n;
+
   for (;;) {
-#ifdef __APPLE__
-    sem_wait(rxring_sem);
-#else
-    sem_wait(&rxring_sem);
-#endif
-    int nptr = rxring_outptr + 1024;
+    ringbuf_wait(&rxring, -1);
+    n = 1;
 
-    if (nptr >= RXRINGBUFLEN) { nptr = 0; }
+    if ((p = ringbuf_peek(&rxring, &n)) == NULL) { continue; }
 
     //
     // This data can change while processing one buffer
@@ -2042,12 +2096,34 @@ static gpointer process_ozy_input_buffer_thread(gpointer arg) {
     st_rxfdbk = rx_feedback_channel();
     st_txfdbk = tx_feedback_channel();
 
-    for (int i = 0; i < 1024; i++) {
-      process_ozy_byte(RXRINGBUF[rxring_outptr + i] & 0xFF);
+    for (int f = 0; f < 1024; f += 512) {
+      const unsigned char *frame = p + f;
+
+      if (state == SYNC_0 && frame[0] == SYNC && frame[1] == SYNC && frame[2] == SYNC) {
+        if (resync) {
+          t_print("%s: P1 frame sync recovered.\n", __FUNCTION__);
+          resync = 0;
+        }
+
+        process_ozy_frame(frame);
+      } else {
+        //
+        // Sync error: feed the bytes through the state machine, which
+        // scans for the next sync pattern. Once a frame has been completed
+        // there at a frame boundary, we are back to frame processing.
+        //
+        if (!resync) {
+          t_print("%s: P1 frame sync error, re-syncing.\n", __FUNCTION__);
+          resync = 1;
+        }
+
+        for (int i = 0; i < 512; i++) {
+          process_ozy_byte(frame[i]);
+        }
+      }
     }
 
-    MEMORY_BARRIER;
-    rxring_outptr = nptr;
+    ringbuf_release(&rxring, 1);
   }
 
   return NULL;
@@ -2097,9 +2173,7 @@ void old_protocol_audio_samples(short left_audio_sample, short right_audio_sampl
     }
 
 #endif
-    // int iptr = txring_inptr + 8 * txring_count;
-    // int iptr = txring_inptr + TXRING_AUDIO_SAMPLE_BYTES * txring_count;
-    int iptr = (txring_inptr + TXRING_AUDIO_SAMPLE_BYTES * txring_count) % TXRINGBUFLEN;
+    unsigned char *p = (unsigned char *)ringbuf_head(&txring) + TXRING_AUDIO_SAMPLE_BYTES * txring_count;
 
     //
     // The HL2 makes no use of audio samples, but instead
@@ -2108,37 +2182,26 @@ void old_protocol_audio_samples(short left_audio_sample, short right_audio_sampl
     // Note special variants of the HL2 *do* have an audio codec!
     //
     if (device == DEVICE_HERMES_LITE2 && !hl2_audio_codec) {
-      TXRINGBUF[iptr++] = 0;
-      TXRINGBUF[iptr++] = 0;
-      TXRINGBUF[iptr++] = 0;
-      TXRINGBUF[iptr++] = 0;
+      *p++ = 0;
+      *p++ = 0;
+      *p++ = 0;
+      *p++ = 0;
     } else {
-      TXRINGBUF[iptr++] = left_audio_sample >> 8;
-      TXRINGBUF[iptr++] = left_audio_sample;
-      TXRINGBUF[iptr++] = right_audio_sample >> 8;
-      TXRINGBUF[iptr++] = right_audio_sample;
+      *p++ = left_audio_sample >> 8;
+      *p++ = left_audio_sample;
+      *p++ = right_audio_sample >> 8;
+      *p++ = right_audio_sample;
     }
 
-    TXRINGBUF[iptr++] = 0;
-    TXRINGBUF[iptr++] = 0;
-    TXRINGBUF[iptr++] = 0;
-    TXRINGBUF[iptr++] = 0;
+    *p++ = 0;
+    *p++ = 0;
+    *p++ = 0;
+    *p++ = 0;
     txring_count++;
 
     // if (txring_count >= 126) {
     if (txring_count >= TXRING_AUDIO_FRAMES_PER_BLOCK) { // also 126
-      // int nptr = txring_inptr + 1008;
-      int nptr = txring_inptr + TXRING_AUDIO_SAMPLE_BYTES * TXRING_AUDIO_FRAMES_PER_BLOCK;
-
-      if (nptr >= TXRINGBUFLEN) { nptr = 0; }
-
-      if (nptr != txring_outptr) {
-#ifdef __APPLE__
-        sem_post(txring_sem);
-#else
-        sem_post(&txring_sem);
-#endif
-        txring_inptr = nptr;
+      if (ringbuf_commit(&txring, 1) == 0) {
         txring_count = 0;
       } else {
         t_print("%s: output buffer overflow.\n", __FUNCTION__);
@@ -2151,52 +2214,73 @@ void old_protocol_audio_samples(short left_audio_sample, short right_audio_sampl
   }
 }
 
-void old_protocol_iq_samples(int isample, int qsample, int side) {
-  if (radio_is_transmitting()) {
-    pthread_mutex_lock(&send_audio_mutex);
+//
+// Drain the TX ring buffer at the first TX IQ sample after a RX->TX transition,
+// must be called with send_audio_mutex locked
+//
+static void old_protocol_txring_drain() {
+#ifdef __APPLE__
 
-    if (txring_count < 0) {
-      txring_count++;
-      pthread_mutex_unlock(&send_audio_mutex);
-      return;
+  if (!txring_flag) {
+    struct timespec start, now;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    txring_drain = 1;
+
+    for (;;) {
+      clock_gettime(CLOCK_MONOTONIC, &now);
+      long elapsed_us = (now.tv_sec - start.tv_sec) * 1000000 +
+                        (now.tv_nsec - start.tv_nsec) / 1000;
+
+      if (elapsed_us > 5000) { break; }
     }
 
-#ifdef __APPLE__
+    txring_drain = 0;
+    txring_flag = 1;
+  }
 
-    if (!txring_flag) {
-      struct timespec start, now;
-      clock_gettime(CLOCK_MONOTONIC, &start);
-      txring_drain = 1;
+#else
 
-      for (;;) {
-        clock_gettime(CLOCK_MONOTONIC, &now);
-        long elapsed_us = (now.tv_sec - start.tv_sec) * 1000000 +
-                          (now.tv_nsec - start.tv_nsec) / 1000;
+  if (!txring_flag) {
+    //
+    // First time we arrive here after a RX->TX transition:
+    // set the "drain" flag, wait 5 msec, clear it
+    // This should drain the txiq ring buffer (which also
+    // contains the audio samples) for minimum CW side tone latency.
+    //
+    txring_drain = 1;
+    usleep(5000);
+    txring_drain = 0;
+    txring_flag = 1;
+  }
 
-        if (elapsed_us > 5000) { break; }
-      }
+#endif
+}
 
-      txring_drain = 0;
-      txring_flag = 1;
-    }
+//
+// Hand over a full TX buffer (126 samples) to the send thread,
+// must be called with send_audio_mutex locked
+//
+static void old_protocol_txring_commit() {
+  if (ringbuf_commit(&txring, 1) == 0) {
+    txring_count = 0;
+  } else {
+    t_print("%s: output buffer overflow.\n", __FUNCTION__);
+    txring_count = -1260;
+  }
+}
 
-#else
+void old_protocol_iq_samples(int isample, int qsample, int side) {
+  if (radio_is_transmitting()) {
+    pthread_mutex_lock(&send_audio_mutex);
 
-    if (!txring_flag) {
-      //
-      // First time we arrive here after a RX->TX transition:
-      // set the "drain" flag, wait 5 msec, clear it
-      // This should drain the txiq ring buffer (which also
-      // contains the audio samples) for minimum CW side tone latency.
-      //
-      txring_drain = 1;
-      usleep(5000);
-      txring_drain = 0;
-      txring_flag = 1;
+    if (txring_count < 0) {
+      txring_count++;
+      pthread_mutex_unlock(&send_audio_mutex);
+      return;
     }
 
-#endif
-    int iptr = txring_inptr + 8 * txring_count;
+    old_protocol_txring_drain();
+    unsigned char *p = (unsigned char *)ringbuf_head(&txring) + 8 * txring_count;
 
     //
     // The HL2 makes no use of audio samples, but instead
@@ -2205,15 +2289,15 @@ void old_protocol_iq_samples(int isample, int qsample, int side) {
     // Note special variants of the HL2 *do* have an audio codec!
     //
     if (device == DEVICE_HERMES_LITE2 && !hl2_audio_codec) {
-      TXRINGBUF[iptr++] = 0;
-      TXRINGBUF[iptr++] = 0;
-      TXRINGBUF[iptr++] = 0;
-      TXRINGBUF[iptr++] = 0;
+      *p++ = 0;
+      *p++ = 0;
+      *p++ = 0;
+      *p++ = 0;
     } else {
-      TXRINGBUF[iptr++] = side  >> 8;
-      TXRINGBUF[iptr++] = side;
-      TXRINGBUF[iptr++] = side >> 8;
-      TXRINGBUF[iptr++] = side;
+      *p++ = side  >> 8;
+      *p++ = side;
+      *p++ = side >> 8;
+      *p++ = side;
     }
 
     if (device == DEVICE_HERMES_LITE2) {
@@ -2225,36 +2309,72 @@ void old_protocol_iq_samples(int isample, int qsample, int side) {
       // The resolution of the IQ samples is thus reduced from 16 to 15 bits,
       // but since the HL2 DAC is 12-bit this is no problem.
       //
-      TXRINGBUF[iptr++] = isample >> 8;
-      TXRINGBUF[iptr++] = isample & 0xFE;
-      TXRINGBUF[iptr++] = qsample >> 8;
-      TXRINGBUF[iptr++] = qsample & 0xFE;
+      *p++ = isample >> 8;
+      *p++ = isample & 0xFE;
+      *p++ = qsample >> 8;
+      *p++ = qsample & 0xFE;
     } else {
-      TXRINGBUF[iptr++] = isample >> 8;
-      TXRINGBUF[iptr++] = isample;
-      TXRINGBUF[iptr++] = qsample >> 8;
-      TXRINGBUF[iptr++] = qsample;
+      *p++ = isample >> 8;
+      *p++ = isample;
+      *p++ = qsample >> 8;
+      *p++ = qsample;
     }
 
     txring_count++;
 
     if (txring_count >= 126) {
-      int nptr = txring_inptr + 1008;
+      old_protocol_txring_commit();
+    }
 
-      if (nptr >= TXRINGBUFLEN) { nptr = 0; }
+    pthread_mutex_unlock(&send_audio_mutex);
+  }
+}
 
-      if (nptr != txring_outptr) {
-#ifdef __APPLE__
-        sem_post(txring_sem);
-#else
-        sem_post(&txring_sem);
-#endif
-        txring_inptr = nptr;
-        txring_count = 0;
+void old_protocol_iq_block(const double *iq, int n, double gain) {
+  //
+  // Block version of old_protocol_iq_samples with side=0 (that is,
+  // no side tone, so the audio part of each TX sample is zero).
+  // The IQ pairs are scaled with gain, rounded and packed into the
+  // ring buffer in chunks that end at 126-sample boundaries.
+  //
+  if (radio_is_transmitting()) {
+    //
+    // For the HL2, clear the LSB of the I and Q samples, see
+    // old_protocol_iq_samples.
+    //
+    int lsbmask = (device == DEVICE_HERMES_LITE2) ? 0xFE : 0xFF;
+    pthread_mutex_lock(&send_audio_mutex);
+
+    while (n > 0) {
+      int chunk;
+
+      if (txring_count < 0) {
+        chunk = -txring_count;
+
+        if (chunk > n) { chunk = n; }
+
+        txring_count += chunk;
       } else {
-        t_print("%s: output buffer overflow.\n", __FUNCTION__);
-        txring_count = -1260;
+        old_protocol_txring_drain();
+        unsigned char *p = (unsigned char *)ringbuf_head(&txring) + 8 * txring_count;
+        chunk = 126 - txring_count;
+
+        if (chunk > n) { chunk = n; }
+
+        for (int i = 0; i < chunk; i++) {
+          memset(p + 8 * i, 0, 4);
+        }
+
+        iq_pack16(iq, p + 4, 8, chunk, gain, lsbmask);
+        txring_count += chunk;
+
+        if (txring_count >= 126) {
+          old_protocol_txring_commit();
+        }
       }
+
+      iq += 2 * chunk;
+      n -= chunk;
     }
 
     pthread_mutex_unlock(&send_audio_mutex);
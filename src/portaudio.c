@@ -305,10 +305,15 @@ int pa_out_cb(const void *inputBuffer, void *outputBuffer, unsigned long framesP
     // util callback is completed
     //
     int newpt = rx->local_audio_buffer_outpt;
+    int empty = 0;
 
     for (unsigned int i = 0; i < framesPerBuffer; i++) {
       if (rx->local_audio_buffer_inpt == newpt) {
-        // Ring buffer empty, send zero sample
+        // Ring buffer empty, send zero sample.
+        // If it ran empty within this call-back, count an under-run
+        if (i > 0 && !empty) { rx->audio_xruns++; }
+
+        empty = 1;
         *out++ = 0.0;
         *out++ = 0.0;
       } else {
@@ -500,6 +505,8 @@ int audio_open_output(RECEIVER *rx) {
   rx->local_audio_buffer = g_new(float, 2 * MY_RING_BUFFER_SIZE);
   rx->local_audio_buffer_inpt = 0;
   rx->local_audio_buffer_outpt = 0;
+  rx->audio_latency = 0;
+  rx->audio_xruns = 0;
 
   if (rx->local_audio_buffer == NULL) {
     t_print("%s: allocate buffer failed\n", __FUNCTION__);
@@ -623,10 +630,20 @@ int audio_write (RECEIVER *rx, float left, float right) {
   cwmode = 0;
 
   if (rx->playstream != NULL && buffer != NULL) {
+    //
+    // The ring buffer is kept at the target latency, but
+    // at most at half filling
+    //
+    int target = 48 * rx->audio_target_latency;
+
+    if (target > MY_RING_BUFFER_SIZE / 2) { target = MY_RING_BUFFER_SIZE / 2; }
+
     int avail = rx->local_audio_buffer_inpt - rx->local_audio_buffer_outpt;
 
     if (avail < 0) { avail += MY_RING_BUFFER_SIZE; }
 
+    rx->audio_latency = avail / 48;
+
     if (avail <  MY_RING_LOW_WATER) {
       //
       // Running the RX-audio for a very long time
@@ -644,7 +661,7 @@ int audio_write (RECEIVER *rx, float left, float right) {
       //
       int oldpt = rx->local_audio_buffer_inpt;
 
-      for (int i = 0; i < MY_RING_BUFFER_SIZE / 2 - avail; i++) {
+      for (int i = 0; i < target - avail; i++) {
         buffer[2 * oldpt] = 0.0;
         buffer[2 * oldpt + 1] = 0.0;
         oldpt++;
@@ -666,7 +683,7 @@ int audio_write (RECEIVER *rx, float left, float right) {
       // deleting half a buffer size of audio, such that the next overrun is in the distant
       // future.
       //
-      int oldpt = rx->local_audio_buffer_inpt - avail + MY_RING_BUFFER_SIZE / 2;
+      int oldpt = rx->local_audio_buffer_inpt - avail + target;
 
       if (oldpt < 0) { oldpt += MY_RING_BUFFER_SIZE; }
 
@@ -28,7 +28,16 @@
 #include "radio.h"
 #include "message.h"
 
+//
+// The properties are kept in a list in the order in which they have been
+// read from the file (or set for the first time), such that the props
+// file keeps its order. For getProperty and setProperty, a hash table
+// gives direct access to the list elements.
+//
 PROPERTY* properties = NULL;
+static PROPERTY *last_property = NULL;
+static GHashTable *property_table = NULL;
+static int num_properties = 0;
 
 void clearProperties() {
   if (properties != NULL) {
@@ -37,10 +46,51 @@ void clearProperties() {
 
     while (properties != NULL) {
       next = properties->next_property;
+      g_free(properties->name);
+      g_free(properties->value);
       free(properties);
       properties = next;
     }
   }
+
+  last_property = NULL;
+  num_properties = 0;
+
+  if (property_table != NULL) {
+    g_hash_table_remove_all(property_table);
+  }
+}
+
+//
+// Append a new property to the list and enter it into the hash table
+//
+static void addProperty(const char *name, const char *value) {
+  PROPERTY *property = malloc(sizeof(PROPERTY));
+  property->name = g_strdup(name);
+  property->value = g_strdup(value);
+  property->next_property = NULL;
+
+  if (last_property == NULL) {
+    properties = property;
+  } else {
+    last_property->next_property = property;
+  }
+
+  last_property = property;
+  num_properties++;
+
+  if (property_table == NULL) {
+    property_table = g_hash_table_new(g_str_hash, g_str_equal);
+  }
+
+  // the key is the name string owned by the property
+  g_hash_table_insert(property_table, property->name, property);
+}
+
+static PROPERTY *findProperty(const char *name) {
+  if (property_table == NULL) { return NULL; }
+
+  return (PROPERTY *) g_hash_table_lookup(property_table, name);
 }
 
 /* --------------------------------------------------------------------------*/
@@ -51,7 +101,7 @@ void clearProperties() {
 */
 void loadProperties(const char* filename) {
   FILE* f = fopen(filename, "r");
-  PROPERTY* property;
+  gint64 t0 = g_get_monotonic_time();
   // t_print("loadProperties: %s\n", filename);
   int lines = 0;
   clearProperties();
@@ -98,11 +148,18 @@ void loadProperties(const char* filename) {
 
         // Beware of "illegal" lines in corrupted files
         if (name != NULL && value != NULL) {
-          property = malloc(sizeof(PROPERTY));
-          property->name = g_strdup(name);
-          property->value = g_strdup(value);
-          property->next_property = properties;
-          properties = property;
+          //
+          // If a name occurs more than once in a (hand-edited) file,
+          // the last occurrence wins, as it always did
+          //
+          PROPERTY *property = findProperty(name);
+
+          if (property) {
+            g_free(property->value);
+            property->value = g_strdup(value);
+          } else {
+            addProperty(name, value);
+          }
 
           if (strcmp(name, "property_version") == 0) {
             version = atof(value);
@@ -112,14 +169,15 @@ void loadProperties(const char* filename) {
     }
 
     if (version >= 0.0 && version != PROPERTY_VERSION) {
-      properties = NULL;
+      clearProperties();
       t_print("loadProperties: version=%f expected version=%f ignoring\n", version, PROPERTY_VERSION);
     }
 
     fclose(f);
   }
 
-  t_print("loadProperties: %s, lines read: %d\n", filename, lines);
+  t_print("loadProperties: %s, lines read: %d, properties: %d, time: %lld usec\n", filename, lines, num_properties,
+          (long long)(g_get_monotonic_time() - t0));
 }
 
 /* --------------------------------------------------------------------------*/
@@ -129,7 +187,8 @@ void loadProperties(const char* filename) {
 * @param filename
 */
 void saveProperties(const char* filename) {
-  PROPERTY* property;
+  const PROPERTY* property;
+  gint64 t0 = g_get_monotonic_time();
   FILE* f = fopen(filename, "w+");
   char line[512];
 
@@ -149,6 +208,8 @@ void saveProperties(const char* filename) {
   }
 
   fclose(f);
+  t_print("saveProperties: %s, properties: %d, time: %lld usec\n", filename, num_properties,
+          (long long)(g_get_monotonic_time() - t0));
 }
 
 /* --------------------------------------------------------------------------*/
@@ -160,19 +221,8 @@ void saveProperties(const char* filename) {
 * @return
 */
 char* getProperty(const char* name) {
-  char* value = NULL;
-  PROPERTY* property = properties;
-
-  while (property) {
-    if (strcmp(name, property->name) == 0) {
-      value = property->value;
-      break;
-    }
-
-    property = property->next_property;
-  }
-
-  return value;
+  const PROPERTY* property = findProperty(name);
+  return property ? property->value : NULL;
 }
 
 /* --------------------------------------------------------------------------*/
@@ -183,27 +233,14 @@ char* getProperty(const char* name) {
 * @param value
 */
 void setProperty(const char* name, const char* value) {
-  PROPERTY* property = properties;
-
-  while (property) {
-    if (strcmp(name, property->name) == 0) {
-      break;
-    }
-
-    property = property->next_property;
-  }
+  PROPERTY* property = findProperty(name);
 
   if (property) {
     // just update
-    free(property->value);
+    g_free(property->value);
     property->value = g_strdup(value);
   } else {
     // new property
-    property = malloc(sizeof(PROPERTY));
-    property->name = g_strdup(name);
-    property->value = g_strdup(value);
-    property->next_property = properties;
-    properties = property;
+    addProperty(name, value);
   }
 }
-
@@ -36,7 +36,9 @@
   #include "new_menu.h"
 #endif
 
+#ifndef HEADLESS
 static GtkWidget *dialog;
+#endif
 
 gboolean enable_protocol_1;
 gboolean enable_protocol_2;
@@ -45,7 +47,9 @@ gboolean enable_stemlab;
 gboolean enable_usbozy;
 gboolean enable_saturn_xdma;
 gboolean autostart;
+gboolean wisdom_quick;
 
+#ifndef HEADLESS
 static void protocolsSaveState() {
   clearProperties();
   SetPropI0("enable_protocol_1",     enable_protocol_1);
@@ -55,8 +59,10 @@ static void protocolsSaveState() {
   SetPropI0("enable_usbozy",         enable_usbozy);
   SetPropI0("enable_saturn_xdma",    enable_saturn_xdma);
   SetPropI0("autostart",             autostart);
+  SetPropI0("wisdom_quick",          wisdom_quick);
   saveProperties("protocols.props");
 }
+#endif
 
 void protocolsRestoreState() {
   loadProperties("protocols.props");
@@ -70,6 +76,7 @@ void protocolsRestoreState() {
   enable_soapy_protocol = TRUE;
   enable_saturn_xdma = TRUE;
   autostart = FALSE;
+  wisdom_quick = TRUE;
   GetPropI0("enable_protocol_1",     enable_protocol_1);
   GetPropI0("enable_protocol_2",     enable_protocol_2);
   GetPropI0("enable_soapy_protocol", enable_soapy_protocol);
@@ -77,9 +84,11 @@ void protocolsRestoreState() {
   GetPropI0("enable_usbozy",         enable_usbozy);
   GetPropI0("enable_saturn_xdma",    enable_saturn_xdma);
   GetPropI0("autostart",             autostart);
+  GetPropI0("wisdom_quick",          wisdom_quick);
   clearProperties();
 }
 
+#ifndef HEADLESS
 static void cleanup() {
   if (dialog != NULL) {
     gtk_widget_destroy(dialog);
@@ -133,6 +142,10 @@ static void autostart_cb(GtkToggleButton *widget, gpointer data) {
   autostart = gtk_toggle_button_get_active(widget);
 }
 
+static void wisdom_quick_cb(GtkToggleButton *widget, gpointer data) {
+  wisdom_quick = gtk_toggle_button_get_active(widget);
+}
+
 void configure_protocols(GtkWidget *parent) {
   int row;
   dialog = gtk_dialog_new();
@@ -206,7 +219,18 @@ void configure_protocols(GtkWidget *parent) {
   gtk_widget_show(b_autostart);
   g_signal_connect(b_autostart, "toggled", G_CALLBACK(autostart_cb), NULL);
   gtk_grid_attach(GTK_GRID(grid), b_autostart, 0, row, 1, 1);
+  row++;
+  //
+  // Takes effect upon the next program start, if the FFTW wisdom
+  // file is then (still) missing
+  //
+  GtkWidget *b_wisdom_quick = gtk_check_button_new_with_label("Build FFTW wisdom in background");
+  gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (b_wisdom_quick), wisdom_quick);
+  gtk_widget_show(b_wisdom_quick);
+  g_signal_connect(b_wisdom_quick, "toggled", G_CALLBACK(wisdom_quick_cb), NULL);
+  gtk_grid_attach(GTK_GRID(grid), b_wisdom_quick, 0, row, 1, 1);
   gtk_container_add(GTK_CONTAINER(content), grid);
   gtk_widget_show_all(dialog);
   gtk_dialog_run(GTK_DIALOG(dialog));
 }
+#endif
@@ -26,6 +26,7 @@ extern gboolean enable_soapy_protocol;
 extern gboolean enable_stemlab;
 extern gboolean enable_usbozy;
 extern gboolean autostart;
+extern gboolean wisdom_quick;
 
 extern void protocolsRestoreState(void);
 extern void configure_protocols(GtkWidget *parent);
@@ -34,6 +34,7 @@
 #include "ext.h"
 #include "message.h"
 
+#ifndef HEADLESS
 static GtkWidget *dialog = NULL;
 static GtkWidget *feedback_l;
 static GtkWidget *correcting_l;
@@ -51,9 +52,11 @@ static char   pk_text[16];
 
 static int running = 0;
 static guint info_timer = 0;
+#endif
 
 #define INFO_SIZE 16
 
+#ifndef HEADLESS
 static GtkWidget *entry[INFO_SIZE];
 
 static void cleanup() {
@@ -137,6 +140,7 @@ static void clear_fields() {
   gtk_entry_set_text(GTK_ENTRY(get_pk), "");
   gtk_entry_set_text(GTK_ENTRY(tx_att), "");
 }
+#endif
 
 //
 // This is periodically when starting  a
@@ -161,7 +165,9 @@ int ps_calibration_timer(gpointer arg) {
     // Initialized two-tone experiment
     //
     state = 1;          // start with PS reset
+#ifndef HEADLESS
     clear_fields();     // clear all data until the next calibration has been done
+#endif
   }
 
   if (transmitter->puresignal) {
@@ -261,6 +267,7 @@ int ps_calibration_timer(gpointer arg) {
   return G_SOURCE_CONTINUE;
 }
 
+#ifndef HEADLESS
 //
 // This is called periodically so it must be a state machine.
 // If this thread is activated without the PS menu being
@@ -793,4 +800,4 @@ void ps_menu(GtkWidget *parent) {
     gtk_entry_set_text(GTK_ENTRY(tx_att), "");
   }
 }
-
+#endif
@@ -20,6 +20,7 @@
 */
 
 #include <gtk/gtk.h>
+#include <string.h>
 #include <pulse/pulseaudio.h>
 #include <pulse/glib-mainloop.h>
 #include <pulse/simple.h>
@@ -28,6 +29,7 @@
 #include "receiver.h"
 #include "transmitter.h"
 #include "audio.h"
+#include "audiofifo.h"
 #include "mode.h"
 #include "vfo.h"
 #include "message.h"
@@ -157,14 +159,31 @@ void audio_get_cards() {
   pa_context_set_state_callback(pa_ctx, state_cb, NULL);
 }
 
+static gpointer audio_out_thread(gpointer data);
+
 int audio_open_output(RECEIVER *rx) {
   int result = 0;
   pa_sample_spec sample_spec;
+  pa_buffer_attr buffer_attr;
   int err;
   g_mutex_lock(&rx->local_audio_mutex);
   sample_spec.rate = 48000;
   sample_spec.channels = 2;
   sample_spec.format = PA_SAMPLE_FLOAT32NE;
+
+  if (rx->audio_target_latency < AUDIO_MIN_LATENCY) { rx->audio_target_latency = AUDIO_MIN_LATENCY; }
+
+  if (rx->audio_target_latency > AUDIO_MAX_LATENCY) { rx->audio_target_latency = AUDIO_MAX_LATENCY; }
+
+  //
+  // The target latency determines the length of the server-side
+  // buffer, the other parameters are left to the server
+  //
+  buffer_attr.maxlength = (uint32_t) -1;
+  buffer_attr.tlength = pa_usec_to_bytes(1000 * rx->audio_target_latency, &sample_spec);
+  buffer_attr.prebuf = (uint32_t) -1;
+  buffer_attr.minreq = (uint32_t) -1;
+  buffer_attr.fragsize = (uint32_t) -1;
   char stream_id[16];
   snprintf(stream_id, 16, "RX-%d", rx->id);
 #if defined (__LDESK__)
@@ -175,7 +194,7 @@ int audio_open_output(RECEIVER *rx) {
                                  stream_id,          // Description of our stream.
                                  &sample_spec,       // Our sample format.
                                  NULL,               // Use default channel map
-                                 NULL,               // Use default attributes
+                                 &buffer_attr,       // Buffer attributes
                                  &err                // error code if returns NULL
                                 );
 #else
@@ -186,7 +205,7 @@ int audio_open_output(RECEIVER *rx) {
                                  stream_id,          // Description of our stream.
                                  &sample_spec,       // Our sample format.
                                  NULL,               // Use default channel map
-                                 NULL,               // Use default attributes
+                                 &buffer_attr,       // Buffer attributes
                                  &err                // error code if returns NULL
                                 );
 #endif
@@ -202,6 +221,13 @@ int audio_open_output(RECEIVER *rx) {
   }
 
   g_mutex_unlock(&rx->local_audio_mutex);
+
+  if (result == 0 && audio_fifo_start(rx, audio_out_thread) < 0) {
+    t_print("%s: cannot start output thread\n", __FUNCTION__);
+    audio_close_output(rx);
+    result = -1;
+  }
+
   return result;
 }
 
@@ -320,6 +346,7 @@ int audio_open_input() {
 }
 
 void audio_close_output(RECEIVER *rx) {
+  audio_fifo_stop(rx);
   g_mutex_lock(&rx->local_audio_mutex);
 
   if (rx->playstream != NULL) {
@@ -426,40 +453,70 @@ int cw_audio_write(RECEIVER *rx, float sample) {
   return result;
 }
 
+//
+// audio_write is called from the DSP thread and only stores the samples
+// in the audio FIFO, the stream is served by audio_out_thread.
+//
 int audio_write(RECEIVER *rx, float left_sample, float right_sample) {
-  int result = 0;
-  int err;
   int txmode = vfo_get_tx_mode();
 
   if (rx == active_receiver && radio_is_transmitting() && (txmode == modeCWU || txmode == modeCWL)) {
     return 0;
   }
 
-  g_mutex_lock(&rx->local_audio_mutex);
+  if (rx->audio_running) {
+    audio_fifo_put(rx, left_sample, right_sample);
+  }
+
+  return 0;
+}
+
+//
+// Output thread: take blocks from the audio FIFO and write them
+// to the stream. pa_simple_write blocks until there is space in
+// the server-side buffer, which is why this is done here and not in
+// the DSP thread. pa_simple does not report under-runs, so we count
+// the cases where the stream latency has dropped below one block.
+//
+static gpointer audio_out_thread(gpointer data) {
+  RECEIVER *rx = (RECEIVER *)data;
+  float buffer[2 * AUDIO_FIFO_BLKSIZE];
+  const float *block;
+  pa_simple *stream;
+  int err;
+  int started = 0;
+
+  while (rx->audio_running) {
+    if ((block = audio_fifo_get(rx, 100)) == NULL) { continue; }
 
-  if (rx->playstream != NULL && rx->local_audio_buffer != NULL) {
     //
-    // Since this is mutex-protected, we know that both rx->playstream
-    // and rx->local_audio_buffer will not be destroyes until we
-    // are finished here.
-    rx->local_audio_buffer[rx->local_audio_buffer_offset * 2] = left_sample;
-    rx->local_audio_buffer[(rx->local_audio_buffer_offset * 2) + 1] = right_sample;
-    rx->local_audio_buffer_offset++;
+    // Copy the block out under the lock, but do the (blocking) write
+    // outside, such that cw_audio_write is not stalled. The stream
+    // itself cannot vanish, since audio_close_output joins this
+    // thread before freeing it.
+    //
+    g_mutex_lock(&rx->local_audio_mutex);
+    stream = rx->playstream;
+    memcpy(buffer, block, sizeof(buffer));
+    g_mutex_unlock(&rx->local_audio_mutex);
+    audio_fifo_release(rx);
 
-    if (rx->local_audio_buffer_offset >= out_buffer_size) {
-      int rc = pa_simple_write(rx->playstream,
-                               rx->local_audio_buffer,
-                               out_buffer_size * sizeof(float) * 2,
-                               &err);
+    if (stream != NULL) {
+      pa_usec_t latency = pa_simple_get_latency(stream, &err);
 
-      if (rc != 0) {
+      if (latency != (pa_usec_t) -1) {
+        if (started && latency < 1000000 * AUDIO_FIFO_BLKSIZE / 48000) { rx->audio_xruns++; }
+
+        rx->audio_latency = latency / 1000 + audio_fifo_latency(rx);
+      }
+
+      if (pa_simple_write(stream, buffer, sizeof(buffer), &err) != 0) {
         t_print("%s: simple_write failed err=%d\n", __FUNCTION__, err);
       }
 
-      rx->local_audio_buffer_offset = 0;
+      started = 1;
     }
   }
 
-  g_mutex_unlock(&rx->local_audio_mutex);
-  return result;
+  return NULL;
 }
@@ -32,6 +32,7 @@
 #include <arpa/inet.h>
 #include <netdb.h>
 #include <termios.h>
+#include <wdsp.h>             // only needed for use_impulse_cache and the DSP pool
 #if defined (__LDESK__)
   #include <unistd.h>
   #include <sys/ioctl.h>
@@ -59,6 +60,7 @@
 #include "new_menu.h"
 #include "new_protocol.h"
 #include "old_protocol.h"
+#include "iqreplay.h"
 #include "store.h"
 #ifdef SOAPYSDR
   #include "soapy_protocol.h"
@@ -118,6 +120,7 @@ int suppress_popup_sliders = 0;
 int controller = NO_CONTROLLER;
 
 GtkWidget *fixed;
+#ifndef HEADLESS
 static GtkWidget *hide_b;
 static GtkWidget *menu_b;
 #if defined (__LDESK__)
@@ -128,6 +131,7 @@ static GtkWidget *meter;
 static GtkWidget *zoompan;
 static GtkWidget *sliders;
 static GtkWidget *toolbar;
+#endif
 
 // RX and TX calibration
 long long frequency_calibration = 0LL;
@@ -362,6 +366,13 @@ double *capture_data = NULL;
 int can_transmit = 0;
 int optimize_for_touchscreen = 0;
 
+int rx_dsp_threads = 0;   // run the DSP of each receiver in its own thread
+int rx_dsp_affinity = 0;  // bind these threads to different CPUs
+int impulse_cache_enable = 1;  // let WDSP re-use filter impulse responses
+int wdsp_cmd_queue = 0;   // WDSP applies slider settings between buffers
+int wdsp_dsp_pool = 0;    // run the WDSP RX channels in a shared thread pool
+int dsp_profile = 0;      // measure the DSP load (DSP load menu)
+
 gboolean duplex = FALSE;
 #if defined (__LDESK__)
   gboolean mute_rx_while_transmitting = TRUE;
@@ -424,6 +435,7 @@ void radio_stop() {
   }
 }
 
+#ifndef HEADLESS
 static void choose_vfo_layout() {
   //
   // a) secure that vfo_layout is a valid pointer
@@ -773,6 +785,16 @@ void radio_reconfigure() {
     tx_reconfigure(transmitter, my_width, my_width, rx_height);
   }
 }
+#else
+//
+// Without a GUI there is no screen layout to re-calculate
+//
+void radio_reconfigure_screen() {
+}
+
+void radio_reconfigure() {
+}
+#endif
 
 //
 // These variables are set in hideall_cb and read
@@ -786,6 +808,7 @@ static int old_zoom = 0;
 static int old_tool = 0;
 static int old_slid = 0;
 
+#ifndef HEADLESS
 static gboolean hideall_cb  (GtkWidget *widget, GdkEventButton *event, gpointer data) {
   //
   // radio_reconfigure must not be called during TX
@@ -826,8 +849,9 @@ static gboolean menu_cb (GtkWidget *widget, GdkEventButton *event, gpointer data
   new_menu();
   return TRUE;
 }
+#endif
 
-#if defined (__LDESK__)
+#if defined (__LDESK__) && !defined (HEADLESS)
 // cppcheck-suppress constParameterCallback
 static gboolean exit_cb (GtkWidget *widget, GdkEventButton *event, gpointer data) {
   stop_program();
@@ -855,6 +879,7 @@ gboolean radio_set_bgcolor(GtkWidget *widget, gpointer data) {
 
 static void radio_create_visual() {
   int y = 0;
+#ifndef HEADLESS
   fixed = gtk_fixed_new();
   g_object_ref(topgrid);  // so it does not get deleted
   gtk_container_remove(GTK_CONTAINER(top_window), topgrid);
@@ -862,10 +887,12 @@ static void radio_create_visual() {
   //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
   radio_set_bgcolor(top_window, NULL);
   //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+#endif
   //t_print("radio: vfo_init\n");
   int my_height = full_screen ? screen_height : display_height;
   int my_width  = full_screen ? screen_width  : display_width;
   VFO_WIDTH = my_width - MENU_WIDTH - METER_WIDTH;
+#ifndef HEADLESS
   vfo_panel = vfo_init(VFO_WIDTH, VFO_HEIGHT);
   gtk_fixed_put(GTK_FIXED(fixed), vfo_panel, 0, y);
   //t_print("radio: meter_init\n");
@@ -916,6 +943,7 @@ static void radio_create_visual() {
   g_signal_connect (exit_b, "button-press-event", G_CALLBACK(exit_cb), NULL) ;
   gtk_fixed_put(GTK_FIXED(fixed), exit_b, VFO_WIDTH + METER_WIDTH, y + 2);
   y += MENU_HEIGHT - 10;
+#endif
 #endif
   //++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
   rx_height = my_height - VFO_HEIGHT;
@@ -945,8 +973,10 @@ static void radio_create_visual() {
     receiver[i]->displaying = 1;
     rx_set_displaying(receiver[i]);
     rx_set_offset(receiver[i], vfo[i].offset);
+#ifndef HEADLESS
     gtk_fixed_put(GTK_FIXED(fixed), receiver[i]->panel, 0, y);
     g_object_ref((gpointer)receiver[i]->panel);
+#endif
     y += rx_height / RECEIVERS;
   }
 
@@ -1066,8 +1096,14 @@ static void radio_create_visual() {
     soapy_protocol_init(FALSE);
     break;
 #endif
+
+  case REPLAY_PROTOCOL:
+    iqreplay_init();
+    break;
   }
 
+#ifndef HEADLESS
+
   if (display_zoompan) {
     zoompan = zoompan_init(my_width, ZOOMPAN_HEIGHT);
     gtk_fixed_put(GTK_FIXED(fixed), zoompan, 0, y);
@@ -1092,6 +1128,8 @@ static void radio_create_visual() {
     gtk_fixed_put(GTK_FIXED(fixed), toolbar, 0, y);
   }
 
+#endif
+
   //
   // Now, if there should only one receiver be displayed
   // at startup, do the change. We must momentarily fake
@@ -1107,8 +1145,10 @@ static void radio_create_visual() {
     radio_change_receivers(r);
   }
 
+#ifndef HEADLESS
   gtk_widget_show_all (top_window);  // ... this shows both the HPSDR and C25 preamp/att sliders
   att_type_changed();                // ... and this hides the „wrong“ ones.
+#endif
 }
 
 void radio_start_radio() {
@@ -1127,7 +1167,9 @@ void radio_start_radio() {
     }
   }
 
+#ifndef HEADLESS
   gdk_window_set_cursor(gtk_widget_get_window(top_window), gdk_cursor_new(GDK_WATCH));
+#endif
   //
   // The behaviour of pop-up menus (Combo-Boxes) can be set to
   // "mouse friendly" (standard case) and "touchscreen friendly"
@@ -1406,6 +1448,11 @@ void radio_start_radio() {
              radio->software_version % 10);
     break;
 #endif
+
+  case REPLAY_PROTOCOL:
+    g_strlcpy(p, "IQ file", 32);
+    g_strlcpy(version, iqreplay_description(), 32);
+    break;
   }
 
   //
@@ -1488,6 +1535,7 @@ void radio_start_radio() {
     break;
 
   case SOAPYSDR_PROTOCOL:
+  case REPLAY_PROTOCOL:
 #if defined (__LDESK__)
     snprintf(text, 1024, "%s by DL1BZ %s[%s] SDR Device: %s (%s %s)",
              PGNAME,
@@ -1505,7 +1553,11 @@ void radio_start_radio() {
     break;
   }
 
+#ifdef HEADLESS
+  t_print("%s: %s\n", __FUNCTION__, text);
+#else
   gtk_window_set_title (GTK_WINDOW (top_window), text);
+#endif
 
   //
   // determine name of the props file
@@ -1519,6 +1571,10 @@ void radio_start_radio() {
     snprintf(property_path, sizeof(property_path), "%s.props", radio->name);
     break;
 
+  case REPLAY_DEVICE:
+    snprintf(property_path, sizeof(property_path), "replay.props");
+    break;
+
   default:
     if (have_saturn_xdma) {
       snprintf(property_path, sizeof(property_path), "saturn.xdma.props");
@@ -1553,6 +1609,7 @@ void radio_start_radio() {
   case NEW_DEVICE_HERMES2:
   case NEW_DEVICE_HERMES_LITE:
   case NEW_DEVICE_HERMES_LITE2:
+  case REPLAY_DEVICE:
     //
     // If there are two MERCURY cards on the ATLAS bus, this is detected
     // in old_protocol.c, But, n_adc can keep the value of 1 since the
@@ -1599,6 +1656,10 @@ void radio_start_radio() {
     filter_board = CHARLY25;
   }
 
+  if (device == REPLAY_DEVICE) {
+    filter_board = NO_FILTER_BOARD;
+  }
+
   /* Set defaults */
   adc[0].antenna = ANTENNA_1;
   adc[0].filters = AUTOMATIC;
@@ -1714,6 +1775,15 @@ void radio_start_radio() {
 
   receivers = RECEIVERS;
   radio_restore_state();
+#ifndef EXTNR
+  //
+  // The cache has been loaded at program start, but must not be
+  // used if disabled. This must be done before creating the
+  // receivers and the transmitter.
+  //
+  use_impulse_cache(impulse_cache_enable);
+#endif
+  radio_set_dsp_pool();
   radio_change_region(region);
   radio_create_visual();
   radio_reconfigure_screen();
@@ -1815,7 +1885,9 @@ void radio_start_radio() {
 
 #endif
   g_idle_add(ext_vfo_update, NULL);
+#ifndef HEADLESS
   gdk_window_set_cursor(gtk_widget_get_window(top_window), gdk_cursor_new(GDK_ARROW));
+#endif
 #ifdef MIDI
 
   for (int i = 0; i < n_midi_devices; i++) {
@@ -1866,12 +1938,16 @@ void radio_change_receivers(int r) {
   case 1:
     receiver[1]->displaying = 0;
     rx_set_displaying(receiver[1]);
+#ifndef HEADLESS
     gtk_container_remove(GTK_CONTAINER(fixed), receiver[1]->panel);
+#endif
     receivers = 1;
     break;
 
   case 2:
+#ifndef HEADLESS
     gtk_fixed_put(GTK_FIXED(fixed), receiver[1]->panel, 0, 0);
+#endif
     receiver[1]->displaying = 1;
     rx_set_displaying(receiver[1]);
     receivers = 2;
@@ -1964,6 +2040,7 @@ static void rxtx(int state) {
         rx_off(receiver[i]);
         receiver[i]->displaying = 0;
         rx_set_displaying(receiver[i]);
+#ifndef HEADLESS
         g_object_ref((gpointer)receiver[i]->panel);
 
         if (receiver[i]->panadapter != NULL) {
@@ -1975,9 +2052,12 @@ static void rxtx(int state) {
         }
 
         gtk_container_remove(GTK_CONTAINER(fixed), receiver[i]->panel);
+#endif
       }
     }
 
+#ifndef HEADLESS
+
     if (transmitter->dialog) {
       gtk_widget_show_all(transmitter->dialog);
 
@@ -1988,6 +2068,8 @@ static void rxtx(int state) {
       gtk_fixed_put(GTK_FIXED(fixed), transmitter->panel, transmitter->x, transmitter->y);
     }
 
+#endif
+
     if (transmitter->puresignal) {
       tx_ps_mox(transmitter, 1);
     }
@@ -2044,6 +2126,7 @@ static void rxtx(int state) {
     tx_off(transmitter);
     transmitter->displaying = 0;
     tx_set_displaying(transmitter);
+#ifndef HEADLESS
 
     if (transmitter->dialog) {
       gtk_window_get_position(GTK_WINDOW(transmitter->dialog), &transmitter->dialog_x, &transmitter->dialog_y);
@@ -2052,6 +2135,8 @@ static void rxtx(int state) {
       gtk_container_remove(GTK_CONTAINER(fixed), transmitter->panel);
     }
 
+#endif
+
     if (!duplex) {
       //
       // Set parameters for the "silence first RXIQ samples after TX/RX transition" feature
@@ -2093,7 +2178,9 @@ static void rxtx(int state) {
       }
 
       for (i = 0; i < receivers; i++) {
+#ifndef HEADLESS
         gtk_fixed_put(GTK_FIXED(fixed), receiver[i]->panel, receiver[i]->x, receiver[i]->y);
+#endif
         rx_on(receiver[i]);
         receiver[i]->displaying = 1;
         rx_set_displaying(receiver[i]);
@@ -2706,6 +2793,7 @@ void radio_set_split(int val) {
 }
 
 static void radio_restore_state() {
+  gint64 t0 = g_get_monotonic_time();
   t_print("%s: path=%s\n", __FUNCTION__, property_path);
   g_mutex_lock(&property_mutex);
   loadProperties(property_path);
@@ -2729,7 +2817,12 @@ static void radio_restore_state() {
 #endif
   GetPropI0("vfo_layout",                                    vfo_layout);
   GetPropI0("optimize_touchscreen",                          optimize_for_touchscreen);
+  GetPropI0("rx_dsp_threads",                                rx_dsp_threads);
+  GetPropI0("rx_dsp_affinity",                               rx_dsp_affinity);
   GetPropI0("capture_max",                                   capture_max);
+  GetPropI0("impulse_cache_enable",                          impulse_cache_enable);
+  GetPropI0("wdsp_cmd_queue",                                wdsp_cmd_queue);
+  GetPropI0("wdsp_dsp_pool",                                 wdsp_dsp_pool);
 
   //
   // TODO: I think some further options related to the GUI
@@ -2749,10 +2842,14 @@ static void radio_restore_state() {
   // (GDK_GRAVITY_NORTH_WEST) where the "position" refers to the top left corner
   // of the window.
   //
+#ifndef HEADLESS
+
   if ((window_x_pos < screen_width - 100) && (window_y_pos < screen_height - 100)) {
     gtk_window_move(GTK_WINDOW(top_window), window_x_pos, window_y_pos);
   }
 
+#endif
+
   GetPropS0("radio_bgcolor_rgb_hex",                         radio_bgcolor_rgb_hex);
   GetPropF0("slider_surface_scale",                          slider_surface_scale);
   GetPropF0("percent_pan_wf",                                percent_pan_wf);
@@ -2937,9 +3034,11 @@ static void radio_restore_state() {
   }
 
   g_mutex_unlock(&property_mutex);
+  t_print("%s: time: %lld usec\n", __FUNCTION__, (long long)(g_get_monotonic_time() - t0));
 }
 
 void radio_save_state() {
+  gint64 t0 = g_get_monotonic_time();
   g_mutex_lock(&property_mutex);
   clearProperties();
 
@@ -2964,7 +3063,9 @@ void radio_save_state() {
   //
   // Obtain window position and save in props file
   //
+#ifndef HEADLESS
   gtk_window_get_position(GTK_WINDOW(top_window), &window_x_pos, &window_y_pos);
+#endif
   SetPropI0("WindowPositionX",                               window_x_pos);
   SetPropI0("WindowPositionY",                               window_y_pos);
   //
@@ -2989,7 +3090,12 @@ void radio_save_state() {
 #endif
   SetPropI0("vfo_layout",                                    vfo_layout);
   SetPropI0("optimize_touchscreen",                          optimize_for_touchscreen);
+  SetPropI0("rx_dsp_threads",                                rx_dsp_threads);
+  SetPropI0("rx_dsp_affinity",                               rx_dsp_affinity);
   SetPropI0("capture_max",                                   capture_max);
+  SetPropI0("impulse_cache_enable",                          impulse_cache_enable);
+  SetPropI0("wdsp_cmd_queue",                                wdsp_cmd_queue);
+  SetPropI0("wdsp_dsp_pool",                                 wdsp_dsp_pool);
   SetPropS0("radio_bgcolor_rgb_hex",                         radio_bgcolor_rgb_hex);
   SetPropF0("slider_surface_scale",                          slider_surface_scale);
   SetPropF0("percent_pan_wf",                                percent_pan_wf);
@@ -3143,6 +3249,7 @@ void radio_save_state() {
   saveProperties(property_path);
   sync();
   g_mutex_unlock(&property_mutex);
+  t_print("%s: time: %lld usec\n", __FUNCTION__, (long long)(g_get_monotonic_time() - t0));
 }
 
 
@@ -3165,6 +3272,7 @@ void radio_save_state() {
 //
 ///////////////////////////////////////////////////////////////////////////////////////////
 
+#ifndef HEADLESS
 // cppcheck-suppress constParameterCallback
 static gboolean eventbox_callback(GtkWidget *widget, GdkEvent *event, gpointer data) {
   //
@@ -3196,6 +3304,7 @@ void my_combo_attach(GtkGrid *grid, GtkWidget *combo, int row, int col, int span
     gtk_grid_attach(GTK_GRID(grid), combo, row, col, spanrow, spancol);
   }
 }
+#endif
 
 //
 // This is used in several places (ant_menu, oc_menu, pa_menu)
@@ -3248,6 +3357,10 @@ void radio_protocol_stop() {
     soapy_protocol_stop_receiver(receiver[0]);
     break;
 #endif
+
+  case REPLAY_PROTOCOL:
+    iqreplay_stop();
+    break;
   }
 }
 
@@ -3266,6 +3379,103 @@ void radio_protocol_run() {
     soapy_protocol_start_receiver(receiver[0]);
     break;
 #endif
+
+  case REPLAY_PROTOCOL:
+    iqreplay_run();
+    break;
+  }
+}
+
+//
+// Create the WDSP DSP thread pool if wdsp_dsp_pool is set, and move the
+// receivers to the pool or back to their own threads. The pool has one
+// thread less than there are CPUs; with rx_dsp_affinity, the threads are
+// bound to the CPUs 1, 2, ... leaving CPU 0 to the GUI and protocol threads.
+// Must only be called at start-up or with the protocol stopped.
+//
+void radio_set_dsp_pool() {
+#ifndef EXTNR
+  int cpus[16];
+  long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+  int n = (ncpu > 1) ? (int)ncpu - 1 : 1;
+
+  if (n > 16) { n = 16; }
+
+  //
+  // The pool may have been created with a different affinity
+  //
+  DestroyDSPPool();
+
+  if (wdsp_dsp_pool) {
+    for (int i = 0; i < n; i++) {
+      cpus[i] = (rx_dsp_affinity && ncpu > 1) ? 1 + i : -1;
+    }
+
+    n = CreateDSPPool(n, cpus);
+    t_print("%s: WDSP DSP pool with %d threads\n", __FUNCTION__, n);
+  }
+
+  for (int i = 0; i < RECEIVERS; i++) {
+    if (receiver[i]) { SetChannelDSPPool(receiver[i]->id, wdsp_dsp_pool); }
+  }
+
+#endif
+}
+
+//
+// Switch the WDSP command queue on or off for all receivers and the transmitter
+//
+void radio_set_cmd_queue() {
+#ifndef EXTNR
+
+  for (int i = 0; i < RECEIVERS; i++) {
+    if (receiver[i]) { SetChannelCommandQueue(receiver[i]->id, wdsp_cmd_queue); }
+  }
+
+  if (can_transmit) { SetChannelCommandQueue(transmitter->id, wdsp_cmd_queue); }
+
+#endif
+}
+
+//
+// Switch the DSP load measurement on or off, and reset the counters
+// of the receivers and the transmitter
+//
+void radio_set_dsp_profile() {
+#ifndef EXTNR
+  SetDSPLoadRun(dsp_profile);
+
+  for (int i = 0; i < RECEIVERS; i++) {
+    if (receiver[i]) { SetRXAStageTiming(receiver[i]->id, dsp_profile); }
+  }
+
+  if (can_transmit) { SetTXAStageTiming(transmitter->id, dsp_profile); }
+
+#endif
+  radio_reset_dsp_profile();
+}
+
+void radio_reset_dsp_profile() {
+  for (int i = 0; i < RECEIVERS; i++) {
+    if (receiver[i]) {
+#ifndef EXTNR
+      ResetDSPLoad(receiver[i]->id);
+      ResetRXAStageTimes(receiver[i]->id);
+#endif
+      receiver[i]->full_buffer_count = 0;
+      receiver[i]->full_buffer_time = 0.0;
+      receiver[i]->full_buffer_peak = 0.0;
+    }
+  }
+
+  if (can_transmit) {
+#ifndef EXTNR
+    ResetDSPLoad(transmitter->id);
+    ResetTXAStageTimes(transmitter->id);
+#endif
+    transmitter->full_buffer_count = 0;
+    transmitter->full_buffer_time = 0.0;
+    transmitter->full_buffer_peak = 0.0;
   }
 }
 
@@ -370,12 +370,22 @@ extern void   radio_end_capture(void);
 extern void   radio_protocol_run(void);
 extern void   radio_protocol_stop(void);
 extern void   radio_protocol_restart(void);
+extern void   radio_set_dsp_pool(void);
+extern void   radio_set_cmd_queue(void);
+extern void   radio_set_dsp_profile(void);
+extern void   radio_reset_dsp_profile(void);
 extern void   radio_start_auto_tune(void);
 extern void   reassign_pa_trim(void);
 
 extern int compare_doubles(const void *a, const void *b);
 
 extern int optimize_for_touchscreen;
+extern int rx_dsp_threads;
+extern int rx_dsp_affinity;
+extern int impulse_cache_enable;
+extern int wdsp_cmd_queue;
+extern int wdsp_dsp_pool;
+extern int dsp_profile;
 extern void my_combo_attach(GtkGrid *grid, GtkWidget *combo, int row, int col, int spanrow, int spancol);
 extern gboolean radio_set_bgcolor(GtkWidget *widget, gpointer data);
 
@@ -38,6 +38,7 @@
 #include "sliders.h"
 #include "new_protocol.h"
 #include "old_protocol.h"
+#include "iqreplay.h"
 #include "screen_menu.h"
 #ifdef SOAPYSDR
   #include "soapy_protocol.h"
@@ -50,6 +51,7 @@
 #include "ext.h"
 #include "message.h"
 
+#ifndef HEADLESS
 static GtkWidget *dialog = NULL;
 static GtkWidget *n2adr_hpf_btn = NULL;
 static gulong callsign_box_signal_id;
@@ -181,17 +183,55 @@ static void anan10e_cb(GtkWidget *widget, gpointer data) {
   radio_protocol_run();
 }
 
+//
+// The DSP worker threads can only be started or stopped
+// while no IQ samples are coming in
+//
+static void rx_dsp_cb(GtkWidget *widget, gpointer data) {
+  int *value = (int *) data;
+  radio_protocol_stop();
+  usleep(200000);
+  *value = gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(widget));
+
+  for (int i = 0; i < RECEIVERS; i++) {
+    rx_set_dsp_thread(receiver[i]);
+  }
+
+  if (value == &rx_dsp_affinity && wdsp_dsp_pool) { radio_set_dsp_pool(); }
+
+  radio_protocol_run();
+}
+
+#ifndef EXTNR
+static void cmd_queue_cb(GtkWidget *widget, gpointer data) {
+  wdsp_cmd_queue = gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(widget));
+  radio_set_cmd_queue();
+}
+
+static void dsp_pool_cb(GtkWidget *widget, gpointer data) {
+  radio_protocol_stop();
+  usleep(200000);
+  wdsp_dsp_pool = gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(widget));
+  radio_set_dsp_pool();
+  radio_protocol_run();
+}
+
+#endif
 static void split_cb(GtkWidget *widget, gpointer data) {
   int new = gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(widget));
   radio_set_split(new);
 }
 
+#endif
+
 //
 // call-able from outside, e.g. toolbar or MIDI, through g_idle_add
 //
 void setDuplex() {
   if (!can_transmit) { return; }
 
+#ifndef HEADLESS
+
   if (duplex) {
     // TX is in separate window, also in full-screen mode
     gtk_container_remove(GTK_CONTAINER(fixed), transmitter->panel);
@@ -206,9 +246,11 @@ void setDuplex() {
     tx_reconfigure(transmitter, width, width, rx_height);
   }
 
+#endif
   g_idle_add(ext_vfo_update, NULL);
 }
 
+#ifndef HEADLESS
 static void duplex_cb(GtkWidget *widget, gpointer data) {
   if (radio_is_transmitting()) {
     //
@@ -226,6 +268,7 @@ static void sat_cb(GtkWidget *widget, gpointer data) {
   sat_mode = gtk_combo_box_get_active(GTK_COMBO_BOX(widget));
   g_idle_add(ext_vfo_update, NULL);
 }
+#endif
 
 void n2adr_oc_settings() {
   //
@@ -299,6 +342,7 @@ void n2adr_oc_settings_tx() {
   schedule_high_priority();
 }
 
+#ifndef HEADLESS
 void load_filters() {
   switch (filter_board) {
   case N2ADR_TX:
@@ -658,6 +702,27 @@ void radio_menu(GtkWidget *parent) {
   row++;
   break;
 #endif
+
+  case REPLAY_PROTOCOL: {
+    //
+    // The sample rate is that of the IQ file, it is shown but cannot be changed
+    //
+    char rate_string[16];
+    label = gtk_label_new("Sample Rate:");
+    gtk_widget_set_name(label, "boldlabel");
+    gtk_widget_set_halign(label, GTK_ALIGN_START);
+    gtk_grid_attach(GTK_GRID(grid), label, 0, row, 1, 1);
+    row++;
+    GtkWidget *sample_rate_combo_box = gtk_combo_box_text_new();
+    snprintf(rate_string, sizeof(rate_string), "%d", iqreplay_sample_rate());
+    gtk_combo_box_text_append(GTK_COMBO_BOX_TEXT(sample_rate_combo_box), NULL, rate_string);
+    gtk_combo_box_set_active(GTK_COMBO_BOX(sample_rate_combo_box), 0);
+    gtk_widget_set_sensitive(sample_rate_combo_box, FALSE);
+    gtk_widget_set_tooltip_text(sample_rate_combo_box, "Replaying an IQ file: the sample rate is that of the file");
+    my_combo_attach(GTK_GRID(grid), sample_rate_combo_box, 0, row, 1, 1);
+    row++;
+  }
+  break;
   }
 
   max_row = row;
@@ -1061,6 +1126,47 @@ void radio_menu(GtkWidget *parent) {
 #endif
   }
 
+  row++;
+  ChkBtn = gtk_check_button_new_with_label("RX DSP Threads");
+  gtk_widget_set_name(ChkBtn, "boldlabel");
+  gtk_widget_set_tooltip_text(ChkBtn,
+                              "Run the DSP of each receiver in its own thread.\n"
+                              "Useful on multi-core machines with several receivers\n"
+                              "and CPU-intensive noise reduction settings");
+  gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (ChkBtn), rx_dsp_threads);
+  gtk_grid_attach(GTK_GRID(grid), ChkBtn, 0, row, 2, 1);
+  g_signal_connect(ChkBtn, "toggled", G_CALLBACK(rx_dsp_cb), &rx_dsp_threads);
+  ChkBtn = gtk_check_button_new_with_label("Bind to CPUs");
+  gtk_widget_set_name(ChkBtn, "boldlabel");
+  gtk_widget_set_tooltip_text(ChkBtn,
+                              "Bind the RX DSP threads to different CPU cores,\n"
+                              "leaving the first core to the GUI and network threads");
+  gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (ChkBtn), rx_dsp_affinity);
+  gtk_grid_attach(GTK_GRID(grid), ChkBtn, 2, row, 2, 1);
+  g_signal_connect(ChkBtn, "toggled", G_CALLBACK(rx_dsp_cb), &rx_dsp_affinity);
+#ifndef EXTNR
+  row++;
+  ChkBtn = gtk_check_button_new_with_label("WDSP Command Queue");
+  gtk_widget_set_name(ChkBtn, "boldlabel");
+  gtk_widget_set_tooltip_text(ChkBtn,
+                              "Apply gain, squelch and shift changes between two\n"
+                              "DSP buffers, so that moving a slider never waits\n"
+                              "for the DSP to finish a buffer");
+  gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (ChkBtn), wdsp_cmd_queue);
+  gtk_grid_attach(GTK_GRID(grid), ChkBtn, 0, row, 2, 1);
+  g_signal_connect(ChkBtn, "toggled", G_CALLBACK(cmd_queue_cb), NULL);
+  ChkBtn = gtk_check_button_new_with_label("WDSP Thread Pool");
+  gtk_widget_set_name(ChkBtn, "boldlabel");
+  gtk_widget_set_tooltip_text(ChkBtn,
+                              "Run the WDSP receiver channels in a pool of\n"
+                              "threads shared by all receivers instead of one\n"
+                              "thread per receiver. \"Bind to CPUs\" also applies\n"
+                              "to the pool threads");
+  gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (ChkBtn), wdsp_dsp_pool);
+  gtk_grid_attach(GTK_GRID(grid), ChkBtn, 2, row, 2, 1);
+  g_signal_connect(ChkBtn, "toggled", G_CALLBACK(dsp_pool_cb), NULL);
+#endif
+
   if (protocol == ORIGINAL_PROTOCOL || protocol == NEW_PROTOCOL) {
     row++;
     ChkBtn = gtk_check_button_new_with_label("Enable TxInhibit Input");
@@ -1235,3 +1341,4 @@ void radio_menu(GtkWidget *parent) {
   sub_menu = dialog;
   gtk_widget_show_all(dialog);
 }
+#endif
@@ -19,10 +19,21 @@
 *
 */
 
+// pthread_setaffinity_np is a GNU extension
+#ifndef _GNU_SOURCE
+  #define _GNU_SOURCE
+#endif
+
 #include <gtk/gtk.h>
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#ifdef __linux__
+  #include <sched.h>
+#endif
 
 #include <wdsp.h>
 
@@ -33,12 +44,15 @@
 #include "channel.h"
 #include "discovered.h"
 #include "filter.h"
+#include "iqconv.h"
+#include "iqreplay.h"
 #include "main.h"
 #include "meter.h"
 #include "mode.h"
 #include "property.h"
 #include "radio.h"
 #include "receiver.h"
+#include "ringbuf.h"
 #include "transmitter.h"
 #include "vfo.h"
 #include "meter.h"
@@ -58,15 +72,18 @@
 #define min(x,y) (x<y?x:y)
 #define max(x,y) (x<y?y:x)
 
+#ifndef HEADLESS
 static int last_x;
 static gboolean has_moved = FALSE;
 static gboolean pressed = FALSE;
 static gboolean making_active = FALSE;
+#endif
 
 //
 // PART 1. Functions releated to the receiver display
 //
 
+#ifndef HEADLESS
 void rx_weak_notify(gpointer data, GObject  *obj) {
   RECEIVER *rx = (RECEIVER *)data;
   t_print("%s: id=%d obj=%p\n", __FUNCTION__, rx->id, obj);
@@ -90,6 +107,7 @@ gboolean rx_button_press_event(GtkWidget *widget, GdkEventButton *event, gpointe
 
   return TRUE;
 }
+#endif
 
 void rx_set_active(RECEIVER *rx) {
   //
@@ -111,6 +129,7 @@ void rx_set_active(RECEIVER *rx) {
   radio_set_alex_antennas();
 }
 
+#ifndef HEADLESS
 // cppcheck-suppress constParameterPointer
 gboolean rx_button_release_event(GtkWidget *widget, GdkEventButton *event, gpointer data) {
   RECEIVER *rx = (RECEIVER *)data;
@@ -253,6 +272,7 @@ gboolean rx_scroll_event(GtkWidget *widget, const GdkEventScroll *event, gpointe
 #endif
   return TRUE;
 }
+#endif
 
 void rx_save_state(const RECEIVER *rx) {
   SetPropI1("receiver.%d.alex_antenna", rx->id,                 rx->alex_antenna);
@@ -265,6 +285,7 @@ void rx_save_state(const RECEIVER *rx) {
 
   SetPropI1("receiver.%d.audio_channel", rx->id,                rx->audio_channel);
   SetPropI1("receiver.%d.local_audio", rx->id,                  rx->local_audio);
+  SetPropI1("receiver.%d.audio_latency", rx->id,                rx->audio_target_latency);
   SetPropS1("receiver.%d.audio_name", rx->id,                   rx->audio_name);
   SetPropI1("receiver.%d.audio_device", rx->id,                 rx->audio_device);
   SetPropI1("receiver.%d.mute_when_not_active", rx->id,         rx->mute_when_not_active);
@@ -365,6 +386,7 @@ void rx_restore_state(RECEIVER *rx) {
 
   GetPropI1("receiver.%d.audio_channel", rx->id,                rx->audio_channel);
   GetPropI1("receiver.%d.local_audio", rx->id,                  rx->local_audio);
+  GetPropI1("receiver.%d.audio_latency", rx->id,                rx->audio_target_latency);
   GetPropS1("receiver.%d.audio_name", rx->id,                   rx->audio_name);
   GetPropI1("receiver.%d.audio_device", rx->id,                 rx->audio_device);
   GetPropI1("receiver.%d.mute_when_not_active", rx->id,         rx->mute_when_not_active);
@@ -458,6 +480,7 @@ void rx_restore_state(RECEIVER *rx) {
   }
 }
 
+#ifndef HEADLESS
 void rx_reconfigure(RECEIVER *rx, int height) {
   int y = 0;
   // now we separate the old myheight: one for panadapter myheight_pan and one for waterfall myheight_wf
@@ -531,24 +554,59 @@ void rx_reconfigure(RECEIVER *rx, int height) {
   gtk_widget_show_all(rx->panel);
   g_mutex_unlock(&rx->display_mutex);
 }
+#endif
+
+//
+// The spectrum is only computed while somebody looks at it. With the GUI
+// this is the panadapter/waterfall of every displaying receiver. In the
+// headless build there is none, and the spectrum is computed only while
+// (remote) clients have asked for it via rx_request_spectrum(). They
+// find the result in rx->pixel_samples (protected by rx->display_mutex),
+// updated with the display frame rate.
+//
+static inline int rx_spectrum_wanted(const RECEIVER *rx) {
+#ifdef HEADLESS
+  return rx->displaying && rx->spectrum_requests > 0;
+#else
+  return rx->displaying;
+#endif
+}
+
+void rx_request_spectrum(RECEIVER *rx, int on) {
+  g_mutex_lock(&rx->display_mutex);
+
+  if (on) {
+    rx->spectrum_requests++;
+  } else if (rx->spectrum_requests > 0) {
+    rx->spectrum_requests--;
+  }
+
+  g_mutex_unlock(&rx->display_mutex);
+}
 
 static int rx_update_display(gpointer data) {
   RECEIVER *rx = (RECEIVER *)data;
 
   if (rx->displaying) {
     if (rx->pixels > 0) {
-      int rc;
       g_mutex_lock(&rx->display_mutex);
-      rc = rx_get_pixels(rx);
 
-      if (rc) {
-        if (rx->display_panadapter) {
-          rx_panadapter_update(rx);
-        }
+      if (rx_spectrum_wanted(rx)) {
+#ifdef HEADLESS
+        (void) rx_get_pixels(rx);
+#else
 
-        if (rx->display_waterfall) {
-          waterfall_update(rx);
+        if (rx_get_pixels(rx)) {
+          if (rx->display_panadapter) {
+            rx_panadapter_update(rx);
+          }
+
+          if (rx->display_waterfall) {
+            waterfall_update(rx);
+          }
         }
+
+#endif
       }
 
       g_mutex_unlock(&rx->display_mutex);
@@ -575,7 +633,9 @@ static int rx_update_display(gpointer data) {
         }
 
         rx->meter = level;
+#ifndef HEADLESS
         meter_update(rx, SMETER, rx->meter, 0.0, 0.0);
+#endif
       }
 
       return TRUE;
@@ -600,6 +660,7 @@ void rx_set_displaying(RECEIVER *rx) {
   }
 }
 
+#ifndef HEADLESS
 static void rx_create_visual(RECEIVER *rx) {
   int y = 0;
   rx->panel = gtk_fixed_new();
@@ -629,6 +690,7 @@ static void rx_create_visual(RECEIVER *rx) {
 
   gtk_widget_show_all(rx->panel);
 }
+#endif
 
 RECEIVER *rx_create_pure_signal_receiver(int id, int sample_rate, int width, int fps) {
   //
@@ -815,6 +877,7 @@ RECEIVER *rx_create_receiver(int id, int pixels, int width, int height) {
   rx->local_audio = 0;
   g_mutex_init(&rx->local_audio_mutex);
   rx->local_audio_buffer = NULL;
+  rx->audio_target_latency = 100;
   g_strlcpy(rx->audio_name, "NO AUDIO", sizeof(rx->audio_name));
   rx->mute_when_not_active = 0;
   rx->audio_channel = STEREO;
@@ -869,6 +932,13 @@ RECEIVER *rx_create_receiver(int id, int pixels, int width, int height) {
     rx->sample_rate = receiver[0]->sample_rate;
   }
 
+  //
+  // When replaying an IQ file, the sample rate is that of the file
+  //
+  if (protocol == REPLAY_PROTOCOL) {
+    rx->sample_rate = iqreplay_sample_rate();
+  }
+
   //
   // allocate buffers
   //
@@ -891,6 +961,9 @@ RECEIVER *rx_create_receiver(int id, int pixels, int width, int height) {
           rx->dsp_size,
           rx->fft_size,
           rx->sample_rate);
+#ifndef EXTNR
+  SetChannelDSPPool(rx->id, wdsp_dsp_pool);
+#endif
   OpenChannel(rx->id,                     // channel
               rx->buffer_size,            // in_size
               rx->dsp_size,               // dsp_size
@@ -901,6 +974,10 @@ RECEIVER *rx_create_receiver(int id, int pixels, int width, int height) {
               1,                          // state (run)
               0.010, 0.025, 0.0, 0.010,   // DelayUp, SlewUp, DelayDown, SlewDown
               1);                         // Wait for data in fexchange0
+#ifndef EXTNR
+  SetChannelCommandQueue(rx->id, wdsp_cmd_queue);
+  SetRXAStageTiming(rx->id, dsp_profile);
+#endif
   //
   // noise blankers
   //
@@ -928,7 +1005,9 @@ RECEIVER *rx_create_receiver(int id, int pixels, int width, int height) {
   rx_create_analyzer(rx);
   rx_set_detector(rx);
   rx_set_average(rx);
+#ifndef HEADLESS
   rx_create_visual(rx);
+#endif
 
   if (rx->local_audio) {
     if (audio_open_output(rx) < 0) {
@@ -940,6 +1019,7 @@ RECEIVER *rx_create_receiver(int id, int pixels, int width, int height) {
   rx_set_agc(rx);
   rx->txrxcount = 0;
   rx->txrxmax = 0;
+  rx_set_dsp_thread(rx);
   return rx;
 }
 
@@ -1081,12 +1161,13 @@ void rx_vfo_changed(RECEIVER *rx) {
 
 //////////////////////////////////////////////////////////////////////////////////////
 //
-// rx_add_iq_samples (rx_add_div_iq_samples),  rx_full_buffer, and rx_process_buffer
+// rx_add_iq_samples (rx_add_div_iq_samples, and their block versions rx_add_iq_block
+// and rx_add_div_iq_block), rx_full_buffer, and rx_process_buffer
 // form the "RX engine".
 //
 //////////////////////////////////////////////////////////////////////////////////////
 
-static void rx_process_buffer(RECEIVER *rx) {
+static void rx_process_buffer(RECEIVER *rx, const double *audio) {
   double left_sample, right_sample;
   short left_audio_sample, right_audio_sample;
   int i;
@@ -1099,8 +1180,8 @@ static void rx_process_buffer(RECEIVER *rx) {
       left_audio_sample = 0;
       right_audio_sample = 0;
     } else {
-      left_sample = rx->audio_output_buffer[i * 2];
-      right_sample = rx->audio_output_buffer[(i * 2) + 1];
+      left_sample = audio[i * 2];
+      right_sample = audio[(i * 2) + 1];
       left_audio_sample = (short)(left_sample * 32767.0);
       right_audio_sample = (short)(right_sample * 32767.0);
     }
@@ -1170,13 +1251,19 @@ static void rx_process_buffer(RECEIVER *rx) {
 
       case SOAPYSDR_PROTOCOL:
         break;
+
+      case REPLAY_PROTOCOL:
+        iqreplay_audio_samples(left_audio_sample, right_audio_sample);
+        break;
       }
     }
   }
 }
 
-void rx_full_buffer(RECEIVER *rx) {
-  int error;
+static void rx_full_buffer(RECEIVER *rx, double *iq) {
+  int error = 0;
+  double *audio = rx->audio_output_buffer;
+  gint64 t0 = dsp_profile ? g_get_monotonic_time() : 0;
 
   //t_print("%s: rx=%p\n",__FUNCTION__,rx);
   //
@@ -1184,16 +1271,17 @@ void rx_full_buffer(RECEIVER *rx) {
   // in this case we should not block the receiver thread
   //
   if (g_mutex_trylock(&rx->mutex)) {
+#ifdef EXTNR
     //
     // noise blanker works on original IQ samples with input sample rate
     //
     switch (rx->nb) {
     case 1:
-      xanbEXT (rx->id, rx->iq_input_buffer, rx->iq_input_buffer);
+      xanbEXT (rx->id, iq, iq);
       break;
 
     case 2:
-      xnobEXT (rx->id, rx->iq_input_buffer, rx->iq_input_buffer);
+      xnobEXT (rx->id, iq, iq);
       break;
 
     default:
@@ -1201,21 +1289,189 @@ void rx_full_buffer(RECEIVER *rx) {
       break;
     }
 
-    fexchange0(rx->id, rx->iq_input_buffer, rx->audio_output_buffer, &error);
+    fexchange0(rx->id, iq, audio, &error);
+#else
+    //
+    // With a noise blanker, this saves one copy of the IQ samples: the
+    // noise blanker (working on the original IQ samples with input sample
+    // rate) writes its output directly into the WDSP input ring. Without
+    // one, the samples are copied there just as fexchange0() would do.
+    // The audio is returned in a buffer of the WDSP channel, copied from
+    // the output ring. We hold rx->mutex, so the WDSP channel is not
+    // re-built while we use these buffers.
+    // If the channel does not exchange data, the noise blanker works in place.
+    //
+    double *in = fexchange0_acquire(rx->id);
+
+    switch (rx->nb) {
+    case 1:
+      xanbEXT (rx->id, iq, in != NULL ? in : iq);
+      break;
+
+    case 2:
+      xnobEXT (rx->id, iq, in != NULL ? in : iq);
+      break;
+
+    default:
+      if (in != NULL) { memcpy(in, iq, 2 * rx->buffer_size * sizeof(double)); }
+
+      break;
+    }
+
+    if (in != NULL) {
+      double *out = fexchange0_commit(rx->id, &error);
+
+      if (out != NULL) { audio = out; }
+
+      iq = in;
+    }
+
+#endif
 
     if (error != 0) {
       t_print("%s: id=%d fexchange0: error=%d\n", __FUNCTION__, rx->id, error);
     }
 
-    if (rx->displaying) {
+    if (rx_spectrum_wanted(rx)) {
       g_mutex_lock(&rx->display_mutex);
-      Spectrum0(1, rx->id, 0, 0, rx->iq_input_buffer);
+      Spectrum0(1, rx->id, 0, 0, iq);
       g_mutex_unlock(&rx->display_mutex);
     }
 
-    rx_process_buffer(rx);
+    rx_process_buffer(rx, audio);
     g_mutex_unlock(&rx->mutex);
   }
+
+  if (t0 != 0) {
+    double dt = (double)(g_get_monotonic_time() - t0);
+    rx->full_buffer_time += dt;
+
+    if (dt > rx->full_buffer_peak) { rx->full_buffer_peak = dt; }
+
+    rx->full_buffer_count++;
+  }
+}
+
+//
+// Optional DSP worker thread (one per receiver).
+//
+// If it is running, rx_add_iq_samples and its block versions fill the
+// input blocks directly into the head slot of rx->dsp_ring, and a full
+// block is just committed there. The protocol threads thus only
+// de-multiplex and enqueue, while noise blankers, fexchange0, the
+// spectrum and the audio output run in the worker.
+// If the worker falls behind, the newest block is dropped.
+//
+#define RX_DSP_RINGLEN 16
+
+static gpointer rx_dsp_thread(gpointer data) {
+  RECEIVER *rx = (RECEIVER *)data;
+  double *iq;
+  int n;
+#ifdef __linux__
+
+  if (rx->dsp_cpu >= 0) {
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    CPU_SET(rx->dsp_cpu, &cpuset);
+
+    if (pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset) != 0) {
+      t_print("%s: RX%d: cannot bind to CPU %d\n", __FUNCTION__, rx->id, rx->dsp_cpu);
+    }
+  }
+
+#endif
+
+  while (rx->dsp_running) {
+    //
+    // The time-out only matters when stopping the thread
+    //
+    if (ringbuf_wait(rx->dsp_ring, 100) == 0) { continue; }
+
+    n = 1;
+
+    if ((iq = ringbuf_peek(rx->dsp_ring, &n)) == NULL) { continue; }
+
+    rx_full_buffer(rx, iq);
+    ringbuf_release(rx->dsp_ring, 1);
+  }
+
+  return NULL;
+}
+
+static void rx_stop_dsp_thread(RECEIVER *rx) {
+  if (!rx->dsp_running) { return; }
+
+  rx->dsp_running = 0;
+  ringbuf_wakeup(rx->dsp_ring);
+  g_thread_join(rx->dsp_thread_id);
+  rx->dsp_thread_id = NULL;
+  t_print("%s: RX%d: blocks=%lu dropped=%lu wakeups=%lu\n", __FUNCTION__, rx->id,
+          rx->dsp_ring->commits, rx->dsp_ring->overflows, rx->dsp_ring->wakeups);
+  ringbuf_reset(rx->dsp_ring);
+  rx->samples = 0;
+}
+
+//
+// Start or stop the DSP worker of a receiver according to rx_dsp_threads
+// and rx_dsp_affinity. Must not be called while IQ samples are
+// coming in, that is, only at start-up or with the protocol stopped.
+// With affinity, CPU 0 is left to the GUI and the protocol threads and
+// the receivers are distributed over the remaining ones.
+//
+void rx_set_dsp_thread(RECEIVER *rx) {
+  char name[16];
+  int cpu = -1;
+
+  if (rx_dsp_affinity) {
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+
+    if (ncpu > 1) { cpu = 1 + rx->id % (ncpu - 1); }
+  }
+
+  if (rx->dsp_running && (!rx_dsp_threads || cpu != rx->dsp_cpu)) {
+    rx_stop_dsp_thread(rx);
+  }
+
+  if (!rx_dsp_threads || rx->dsp_running) { return; }
+
+  if (rx->dsp_ring == NULL) {
+    if (posix_memalign((void **)&rx->dsp_ring, RINGBUF_CACHELINE, sizeof(RINGBUF)) != 0) {
+      rx->dsp_ring = NULL;
+      return;
+    }
+
+    if (ringbuf_init(rx->dsp_ring, RX_DSP_RINGLEN, 2 * rx->buffer_size * sizeof(double)) < 0) {
+      free(rx->dsp_ring);
+      rx->dsp_ring = NULL;
+      return;
+    }
+  }
+
+  ringbuf_reset(rx->dsp_ring);
+  rx->samples = 0;
+  rx->dsp_cpu = cpu;
+  rx->dsp_running = 1;
+  snprintf(name, sizeof(name), "RX%d DSP", rx->id);
+  rx->dsp_thread_id = g_thread_new(name, rx_dsp_thread, rx);
+  t_print("%s: RX%d: DSP worker started, cpu=%d\n", __FUNCTION__, rx->id, cpu);
+}
+
+//
+// The buffer the incoming IQ samples go to, and what happens when it is full
+//
+static inline double *rx_input_block(RECEIVER *rx) {
+  return rx->dsp_running ? (double *)ringbuf_head(rx->dsp_ring) : rx->iq_input_buffer;
+}
+
+static inline void rx_input_block_full(RECEIVER *rx) {
+  if (rx->dsp_running) {
+    ringbuf_commit(rx->dsp_ring, 1);
+  } else {
+    rx_full_buffer(rx, rx->iq_input_buffer);
+  }
+
+  rx->samples = 0;
 }
 
 void rx_add_iq_samples(RECEIVER *rx, double i_sample, double q_sample) {
@@ -1236,13 +1492,13 @@ void rx_add_iq_samples(RECEIVER *rx, double i_sample, double q_sample) {
     rx->txrxcount++;
   }
 
-  rx->iq_input_buffer[rx->samples * 2] = i_sample;
-  rx->iq_input_buffer[(rx->samples * 2) + 1] = q_sample;
+  double *iq = rx_input_block(rx);
+  iq[rx->samples * 2] = i_sample;
+  iq[(rx->samples * 2) + 1] = q_sample;
   rx->samples = rx->samples + 1;
 
   if (rx->samples >= rx->buffer_size) {
-    rx_full_buffer(rx);
-    rx->samples = 0;
+    rx_input_block_full(rx);
   }
 }
 
@@ -1256,6 +1512,85 @@ void rx_add_div_iq_samples(RECEIVER *rx, double i0, double q0, double i1, double
   rx_add_iq_samples(rx, i_sample, q_sample);
 }
 
+//
+// Silence the first txrxmax samples after a TX/RX transition,
+// block version of what is done in rx_add_iq_samples
+//
+static inline void rx_mute_iq(RECEIVER *rx, double *dest, int n) {
+  if (rx->txrxcount < rx->txrxmax) {
+    int m = rx->txrxmax - rx->txrxcount;
+
+    if (m > n) { m = n; }
+
+    memset(dest, 0, 2 * m * sizeof(double));
+    rx->txrxcount += m;
+  }
+}
+
+void rx_add_iq_block(RECEIVER *rx, const unsigned char *buffer, int stride, int n) {
+  //
+  // Block version of rx_add_iq_samples: the samples (24-bit big-endian,
+  // "stride" bytes between consecutive IQ pairs) are converted straight
+  // into the input block, and rx_full_buffer is only called (or the block
+  // queued for the DSP worker) at buffer boundaries.
+  //
+  while (n > 0) {
+    int chunk = rx->buffer_size - rx->samples;
+
+    if (chunk > n) { chunk = n; }
+
+    double *dest = rx_input_block(rx) + 2 * rx->samples;
+    iq_unpack24(buffer, stride, dest, chunk);
+    rx_mute_iq(rx, dest, chunk);
+    rx->samples += chunk;
+    buffer += chunk * stride;
+    n -= chunk;
+
+    if (rx->samples >= rx->buffer_size) {
+      rx_input_block_full(rx);
+    }
+  }
+}
+
+void rx_add_div_iq_block(RECEIVER *rx, const unsigned char *buffer0, const unsigned char *buffer1, int stride,
+                         int n) {
+  //
+  // Block version of rx_add_div_iq_samples. The main samples are converted
+  // in place, the aux samples go through a small scratch buffer and are
+  // mixed onto the main ones.
+  //
+  double aux[2 * 64];
+
+  while (n > 0) {
+    int chunk = rx->buffer_size - rx->samples;
+
+    if (chunk > n) { chunk = n; }
+
+    if (chunk > 64) { chunk = 64; }
+
+    double *dest = rx_input_block(rx) + 2 * rx->samples;
+    iq_unpack24(buffer0, stride, dest, chunk);
+    iq_unpack24(buffer1, stride, aux, chunk);
+
+    for (int i = 0; i < 2 * chunk; i += 2) {
+      double i1 = aux[i];
+      double q1 = aux[i + 1];
+      dest[i]     += div_cos * i1 - div_sin * q1;
+      dest[i + 1] += div_sin * i1 + div_cos * q1;
+    }
+
+    rx_mute_iq(rx, dest, chunk);
+    rx->samples += chunk;
+    buffer0 += chunk * stride;
+    buffer1 += chunk * stride;
+    n -= chunk;
+
+    if (rx->samples >= rx->buffer_size) {
+      rx_input_block_full(rx);
+    }
+  }
+}
+
 void rx_update_zoom(RECEIVER *rx) {
   //
   // This is called whenever rx->zoom or rx->width changes,
@@ -1365,6 +1700,15 @@ void rx_set_framerate(RECEIVER *rx) {
 void rx_change_sample_rate(RECEIVER *rx, int sample_rate) {
   // ToDo: move this outside of the WDSP wrappers and encapsulate WDSP calls
   //       in this function
+
+  //
+  // When replaying an IQ file, the sample rate is fixed to that of the file
+  //
+  if (protocol == REPLAY_PROTOCOL && sample_rate != iqreplay_sample_rate()) {
+    t_print("%s: id=%d rate=%d ignored, replaying at %d\n", __FUNCTION__, rx->id, sample_rate, iqreplay_sample_rate());
+    return;
+  }
+
   g_mutex_lock(&rx->mutex);
   rx->sample_rate = sample_rate;
   schedule_receive_specific();
@@ -1429,7 +1773,8 @@ void rx_change_sample_rate(RECEIVER *rx, int sample_rate) {
           rx->buffer_size, rx->output_samples);
 }
 
-void rx_close(const RECEIVER *rx) {
+void rx_close(RECEIVER *rx) {
+  rx_stop_dsp_thread(rx);
   CloseChannel(rx->id);
 }
 
@@ -61,6 +61,7 @@ typedef struct _receiver {
   double agc_thresh;
   int fps;
   int displaying;
+  int spectrum_requests;  // headless: number of clients that want the spectrum
   int audio_channel; // STEREO or LEFT or RIGHT
   int sample_rate;
   int pixels;
@@ -189,7 +190,8 @@ typedef struct _receiver {
   int waterfall_high;
   int waterfall_automatic;
   cairo_surface_t *panadapter_surface;
-  GdkPixbuf *pixbuf;
+  cairo_surface_t *waterfall_surface;
+  int waterfall_row;    // row of the waterfall surface that is displayed on top
   int local_audio;
   int mute_when_not_active;
   int audio_device;
@@ -226,6 +228,18 @@ typedef struct _receiver {
 
   GMutex local_audio_mutex;
 
+  //
+  // FIFO and thread for the local audio output, see audiofifo.h
+  //
+  struct _ringbuf *audio_fifo;
+  int audio_fifo_offset;
+  GThread *audio_thread_id;
+  volatile int audio_running;
+  int audio_target_latency;        // msec
+  volatile int audio_latency;      // msec, measured
+  unsigned long audio_xruns;
+  unsigned long audio_drops;
+
   int squelch_enable;
   double squelch;
 
@@ -275,6 +289,21 @@ typedef struct _receiver {
   double eq_freq[11];
   double eq_gain[11];
 
+  //
+  // Optional DSP worker thread, see rx_set_dsp_thread()
+  //
+  struct _ringbuf *dsp_ring;   // queue of full input blocks
+  GThread *dsp_thread_id;
+  volatile int dsp_running;
+  int dsp_cpu;                 // CPU the worker is bound to, -1: none
+
+  //
+  // Time spent in rx_full_buffer, only measured if dsp_profile is set
+  //
+  long   full_buffer_count;
+  double full_buffer_time;     // accumulated, in usec
+  double full_buffer_peak;     // worst case, in usec
+
 } RECEIVER;
 
 extern RECEIVER *rx_create_pure_signal_receiver(int id, int sample_rate, int pixels, int fps);
@@ -287,10 +316,13 @@ extern gboolean rx_scroll_event(GtkWidget *widget, const GdkEventScroll *event,
 
 extern void   rx_add_iq_samples(RECEIVER *rx, double i_sample, double q_sample);
 extern void   rx_add_div_iq_samples(RECEIVER *rx, double i0, double q0, double i1, double q1);
+extern void   rx_add_iq_block(RECEIVER *rx, const unsigned char *buffer, int stride, int n);
+extern void   rx_add_div_iq_block(RECEIVER *rx, const unsigned char *buffer0, const unsigned char *buffer1,
+                                  int stride, int n);
 
 extern void   rx_change_sample_rate(RECEIVER *rx, int sample_rate);
 extern void   rx_change_adc(const RECEIVER *rx);
-extern void   rx_close(const RECEIVER *rx);
+extern void   rx_close(RECEIVER *rx);
 extern void   rx_create_analyzer(const RECEIVER *rx);
 extern void   rx_filter_changed(RECEIVER *rx);
 extern int    rx_get_pixels(RECEIVER *rx);
@@ -300,6 +332,7 @@ extern void   rx_mode_changed(RECEIVER *rx);
 extern void   rx_off(const RECEIVER *rx);
 extern void   rx_on(const RECEIVER *rx);
 extern void   rx_reconfigure(RECEIVER *rx, int height);
+extern void   rx_request_spectrum(RECEIVER *rx, int on);
 extern void   rx_restore_state(RECEIVER *rx);
 extern void   rx_save_state(const RECEIVER *rx);
 
@@ -314,6 +347,7 @@ extern void   rx_set_cw_peak(const RECEIVER *rx, int state, double freq);
 extern void   rx_set_detector(const RECEIVER *rx);
 extern void   rx_set_deviation(const RECEIVER *rx);
 extern void   rx_set_displaying(RECEIVER *rx);
+extern void   rx_set_dsp_thread(RECEIVER *rx);
 extern void   rx_set_equalizer(RECEIVER *rx);
 extern void   rx_set_fft_latency(const RECEIVER *rx);
 extern void   rx_set_fft_size(const RECEIVER *rx);
@@ -0,0 +1,192 @@
+/* Copyright (C)
+*
+* 2024,2025 - Heiko Amft, DL1BZ (Project deskHPSDR)
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+//
+// Sleeping and waking up for the SPSC ring buffer, see ringbuf.h.
+// The index arithmetic is inlined in the header.
+//
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <limits.h>
+
+#ifdef __linux__
+  #include <unistd.h>
+  #include <sys/syscall.h>
+  #include <linux/futex.h>
+#endif
+
+#include "ringbuf.h"
+#include "message.h"
+
+#ifdef __linux__
+static inline void futex_wait(atomic_uint *addr, unsigned int val, const struct timespec *ts) {
+  syscall(SYS_futex, (unsigned int *)addr, FUTEX_WAIT_PRIVATE, val, ts, NULL, 0);
+}
+
+static inline void futex_wake(atomic_uint *addr) {
+  syscall(SYS_futex, (unsigned int *)addr, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+}
+#endif
+
+int ringbuf_init(RINGBUF *rb, int nelem, int elemsize) {
+  unsigned char *data;
+
+  if (nelem < 2 || elemsize < 1) {
+    t_print("%s: invalid size %d x %d\n", __FUNCTION__, nelem, elemsize);
+    return -1;
+  }
+
+  //
+  // Allocate the data area cache-line aligned, such that the
+  // first slot does not share a cache line with anything else
+  //
+  if (posix_memalign((void **)&data, RINGBUF_CACHELINE, (size_t)nelem * elemsize) != 0) {
+    t_print("%s: cannot allocate %d x %d bytes\n", __FUNCTION__, nelem, elemsize);
+    return -1;
+  }
+
+  memset(data, 0, (size_t)nelem * elemsize);
+  memset(rb, 0, sizeof(RINGBUF));
+  rb->data = data;
+  rb->nelem = nelem;
+  rb->elemsize = elemsize;
+  atomic_init(&rb->head, 0);
+  atomic_init(&rb->tail, 0);
+  atomic_init(&rb->waiting, 0);
+  atomic_init(&rb->seq, 0);
+#ifndef __linux__
+  pthread_mutex_init(&rb->mutex, NULL);
+  pthread_cond_init(&rb->cond, NULL);
+#endif
+  return 0;
+}
+
+void ringbuf_destroy(RINGBUF *rb) {
+  if (rb->data == NULL) { return; }
+
+  free(rb->data);
+  rb->data = NULL;
+#ifndef __linux__
+  pthread_mutex_destroy(&rb->mutex);
+  pthread_cond_destroy(&rb->cond);
+#endif
+}
+
+//
+// Discard all data. Must only be called while neither the
+// producer nor the consumer is active.
+//
+void ringbuf_reset(RINGBUF *rb) {
+  atomic_store(&rb->head, 0);
+  atomic_store(&rb->tail, 0);
+  rb->head_cache = 0;
+  rb->tail_cache = 0;
+}
+
+int ringbuf_count(RINGBUF *rb) {
+  int h = atomic_load_explicit(&rb->head, memory_order_acquire);
+  int t = atomic_load_explicit(&rb->tail, memory_order_acquire);
+  return (h >= t) ? h - t : h - t + rb->nelem;
+}
+
+//
+// Wake up the consumer. Called from ringbuf_commit only if the
+// consumer has announced that it is going to sleep.
+//
+void ringbuf_signal(RINGBUF *rb) {
+  if (!atomic_exchange(&rb->waiting, 0)) { return; }
+
+  rb->wakeups++;
+  ringbuf_wakeup(rb);
+}
+
+//
+// Unconditionally wake up the consumer, e.g. to make it look
+// at a "running" flag when shutting down.
+//
+void ringbuf_wakeup(RINGBUF *rb) {
+#ifdef __linux__
+  atomic_fetch_add(&rb->seq, 1);
+  futex_wake(&rb->seq);
+#else
+  pthread_mutex_lock(&rb->mutex);
+  atomic_fetch_add(&rb->seq, 1);
+  pthread_cond_signal(&rb->cond);
+  pthread_mutex_unlock(&rb->mutex);
+#endif
+}
+
+//
+// Block until the ring contains data, ringbuf_wakeup has been called,
+// or the time-out (in msec, negative: infinite) has expired.
+// Returns the number of filled slots.
+//
+int ringbuf_wait(RINGBUF *rb, int timeout_ms) {
+  struct timespec ts;
+  int count;
+
+  if ((count = ringbuf_count(rb)) > 0) { return count; }
+
+  unsigned int seq = atomic_load(&rb->seq);
+  atomic_store(&rb->waiting, 1);
+  atomic_thread_fence(memory_order_seq_cst);
+
+  if ((count = ringbuf_count(rb)) > 0) {
+    atomic_store(&rb->waiting, 0);
+    return count;
+  }
+
+#ifdef __linux__
+
+  if (timeout_ms >= 0) {
+    ts.tv_sec = timeout_ms / 1000;
+    ts.tv_nsec = (timeout_ms % 1000) * 1000000;
+  }
+
+  futex_wait(&rb->seq, seq, timeout_ms >= 0 ? &ts : NULL);
+#else
+  pthread_mutex_lock(&rb->mutex);
+
+  if (timeout_ms >= 0) {
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_sec += timeout_ms / 1000;
+    ts.tv_nsec += (timeout_ms % 1000) * 1000000;
+
+    if (ts.tv_nsec > 999999999) {
+      ts.tv_sec++;
+      ts.tv_nsec -= 1000000000;
+    }
+  }
+
+  while (atomic_load(&rb->seq) == seq) {
+    if (timeout_ms >= 0) {
+      if (pthread_cond_timedwait(&rb->cond, &rb->mutex, &ts) == ETIMEDOUT) { break; }
+    } else {
+      pthread_cond_wait(&rb->cond, &rb->mutex);
+    }
+  }
+
+  pthread_mutex_unlock(&rb->mutex);
+#endif
+  atomic_store(&rb->waiting, 0);
+  return ringbuf_count(rb);
+}
@@ -0,0 +1,182 @@
+/* Copyright (C)
+*
+* 2024,2025 - Heiko Amft, DL1BZ (Project deskHPSDR)
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+#ifndef _RINGBUF_H
+#define _RINGBUF_H
+
+#include <stdatomic.h>
+#include <pthread.h>
+
+//
+// Single-producer/single-consumer ring buffer used for all queues
+// between the network (or XDMA) threads and the processing threads.
+//
+// The ring consists of "nelem" slots of "elemsize" bytes each, a slot
+// is the unit of transfer (e.g. one 1440-byte TX IQ packet, or one
+// buffer pointer). As in the hand-written rings this replaces, one slot
+// is always kept free, so the slot at the head can always be written
+// to, even if the ring is full, and the producer decides upon commit
+// what to do with an overflow.
+//
+// Producer:  p = ringbuf_head(rb);   fill slot;  ringbuf_commit(rb, 1)
+//            p = ringbuf_reserve(rb, &n); fill n slots; ringbuf_commit(rb, n)
+// Consumer:  p = ringbuf_peek(rb, &n); use n slots; ringbuf_release(rb, n)
+//            ringbuf_wait(rb, timeout) when the ring is empty
+//
+// Head and tail live in different cache lines, and each side keeps a
+// cached copy of the other side's index, so the cache line of the other
+// side is only touched if the ring seems to be full (producer) or
+// empty (consumer).
+//
+// The consumer only goes to sleep if the ring is empty, and the producer
+// only issues a wake-up (futex on Linux, condition variable otherwise)
+// if the consumer actually sleeps. Thus, while the consumer is busy,
+// committing data costs no system call at all.
+//
+
+#define RINGBUF_CACHELINE 64
+
+typedef struct _ringbuf {
+  //
+  // written by the producer
+  //
+  _Alignas(RINGBUF_CACHELINE) atomic_int head;
+  int tail_cache;
+  unsigned long commits;             // number of successful commits
+  unsigned long wakeups;             // number of wake-ups issued
+  unsigned long overflows;           // number of failed commits
+  //
+  // written by the consumer
+  //
+  _Alignas(RINGBUF_CACHELINE) atomic_int tail;
+  int head_cache;
+  //
+  // wake-up handshake
+  //
+  _Alignas(RINGBUF_CACHELINE) atomic_int waiting;
+  atomic_uint seq;                   // futex word
+#ifndef __linux__
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+#endif
+  //
+  // constant after ringbuf_init
+  //
+  _Alignas(RINGBUF_CACHELINE) unsigned char *data;
+  int nelem;
+  int elemsize;
+} RINGBUF;
+
+extern int  ringbuf_init(RINGBUF *rb, int nelem, int elemsize);
+extern void ringbuf_destroy(RINGBUF *rb);
+extern void ringbuf_reset(RINGBUF *rb);
+extern int  ringbuf_count(RINGBUF *rb);
+extern int  ringbuf_wait(RINGBUF *rb, int timeout_ms);
+extern void ringbuf_wakeup(RINGBUF *rb);
+extern void ringbuf_signal(RINGBUF *rb);
+
+//
+// Slot at the head, this one can always be written to
+//
+static inline void *ringbuf_head(RINGBUF *rb) {
+  int h = atomic_load_explicit(&rb->head, memory_order_relaxed);
+  return rb->data + (size_t)h * rb->elemsize;
+}
+
+//
+// Batch reserve: return the head slot and the number of contiguous
+// slots (up to *n) that can be committed. Returns NULL (and sets *n
+// to zero) if the ring is full.
+//
+static inline void *ringbuf_reserve(RINGBUF *rb, int *n) {
+  int h = atomic_load_explicit(&rb->head, memory_order_relaxed);
+  int t = rb->tail_cache;
+  int avail = (t > h) ? t - h - 1 : rb->nelem - h - (t == 0);
+
+  if (avail < *n) {
+    t = rb->tail_cache = atomic_load_explicit(&rb->tail, memory_order_acquire);
+    avail = (t > h) ? t - h - 1 : rb->nelem - h - (t == 0);
+  }
+
+  if (avail < *n) { *n = avail; }
+
+  return (avail > 0) ? rb->data + (size_t)h * rb->elemsize : NULL;
+}
+
+//
+// Publish n slots starting at the head. Returns 0 on success, and -1
+// if there is not enough space, in which case nothing is published.
+//
+static inline int ringbuf_commit(RINGBUF *rb, int n) {
+  int avail = n;
+  ringbuf_reserve(rb, &avail);
+
+  if (avail < n) {
+    rb->overflows++;
+    return -1;
+  }
+
+  int h = atomic_load_explicit(&rb->head, memory_order_relaxed) + n;
+
+  if (h >= rb->nelem) { h -= rb->nelem; }
+
+  //
+  // The fence orders the head update before reading "waiting",
+  // it pairs with the fence in ringbuf_wait
+  //
+  atomic_store_explicit(&rb->head, h, memory_order_release);
+  atomic_thread_fence(memory_order_seq_cst);
+  rb->commits++;
+
+  if (atomic_load_explicit(&rb->waiting, memory_order_relaxed)) {
+    ringbuf_signal(rb);
+  }
+
+  return 0;
+}
+
+//
+// Return the oldest filled slot and the number of contiguous filled
+// slots (up to *n, use *n = 1 for single slots). Returns NULL (and
+// sets *n to zero) if the ring is empty.
+//
+static inline void *ringbuf_peek(RINGBUF *rb, int *n) {
+  int t = atomic_load_explicit(&rb->tail, memory_order_relaxed);
+  int h = rb->head_cache;
+
+  if (h == t || (h > t && h - t < *n)) {
+    h = rb->head_cache = atomic_load_explicit(&rb->head, memory_order_acquire);
+  }
+
+  int avail = (h >= t) ? h - t : rb->nelem - t;
+
+  if (avail < *n) { *n = avail; }
+
+  return (avail > 0) ? rb->data + (size_t)t * rb->elemsize : NULL;
+}
+
+static inline void ringbuf_release(RINGBUF *rb, int n) {
+  int t = atomic_load_explicit(&rb->tail, memory_order_relaxed) + n;
+
+  if (t >= rb->nelem) { t -= rb->nelem; }
+
+  atomic_store_explicit(&rb->tail, t, memory_order_release);
+}
+
+#endif
@@ -26,6 +26,7 @@
 #include <string.h>
 
 #include "audio.h"
+#include "audiofifo.h"
 #include "new_menu.h"
 #include "rx_menu.h"
 #include "band.h"
@@ -46,8 +47,26 @@ static GtkWidget *local_audio_b = NULL;
 static GtkWidget *output = NULL;
 static GtkWidget *autogain_b;
 static GtkWidget *autogain_time_b;
+static GtkWidget *audio_stats_label = NULL;
+static guint audio_stats_timer = 0;
+static guint audio_latency_timer = 0;
+static RECEIVER *audio_latency_rx = NULL;
+
+static gboolean audio_latency_apply(gpointer data);
 
 static void cleanup() {
+  if (audio_stats_timer != 0) {
+    g_source_remove(audio_stats_timer);
+    audio_stats_timer = 0;
+  }
+
+  if (audio_latency_timer != 0) {
+    g_source_remove(audio_latency_timer);
+    audio_latency_apply(NULL);
+  }
+
+  audio_stats_label = NULL;
+
   if (dialog != NULL) {
     GtkWidget *tmp = dialog;
     dialog = NULL;
@@ -197,6 +216,58 @@ static void local_output_changed_cb(GtkWidget *widget, gpointer data) {
   t_print("local_output_changed rx=%d local_audio=%d\n", active_receiver->id, active_receiver->local_audio);
 }
 
+//
+// A new target latency only takes effect when re-opening the audio device.
+// Since this is expensive, it is done only when the spin button has not
+// been changed for half a second (or when the menu is closed).
+//
+static gboolean audio_latency_apply(gpointer data) {
+  RECEIVER *rx = audio_latency_rx;
+  audio_latency_timer = 0;
+  audio_latency_rx = NULL;
+
+  if (rx != NULL && rx->local_audio) {
+    audio_close_output(rx);
+
+    if (audio_open_output(rx) < 0) {
+      rx->local_audio = 0;
+
+      if (rx == active_receiver && local_audio_b != NULL) {
+        gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON (local_audio_b), FALSE);
+      }
+    }
+  }
+
+  return G_SOURCE_REMOVE;
+}
+
+static void audio_latency_cb(GtkWidget *widget, gpointer data) {
+  active_receiver->audio_target_latency = gtk_spin_button_get_value_as_int(GTK_SPIN_BUTTON(widget));
+
+  if (audio_latency_timer != 0) {
+    g_source_remove(audio_latency_timer);
+  }
+
+  audio_latency_rx = active_receiver;
+  audio_latency_timer = g_timeout_add(500, audio_latency_apply, NULL);
+}
+
+static gboolean audio_stats_update(gpointer data) {
+  char text[64];
+
+  if (audio_stats_label == NULL) { return FALSE; }
+
+  if (active_receiver->local_audio) {
+    snprintf(text, sizeof(text), "Latency %d ms, %lu xruns", active_receiver->audio_latency,
+             active_receiver->audio_xruns);
+  } else {
+    snprintf(text, sizeof(text), "Latency -- ms");
+  }
+
+  gtk_label_set_text(GTK_LABEL(audio_stats_label), text);
+  return TRUE;
+}
+
 static void audio_channel_cb(GtkWidget *widget, gpointer data) {
   int val = gtk_combo_box_get_active(GTK_COMBO_BOX(widget));
 
@@ -490,6 +561,22 @@ void rx_menu(GtkWidget *parent) {
 
     my_combo_attach(GTK_GRID(grid), channel, 2, 3, 1, 1);
     g_signal_connect(channel, "changed", G_CALLBACK(audio_channel_cb), NULL);
+    GtkWidget *latency_label = gtk_label_new("Audio Latency (ms):");
+    gtk_widget_set_name(latency_label, "boldlabel");
+    gtk_widget_set_halign(latency_label, GTK_ALIGN_START);
+    gtk_grid_attach(GTK_GRID(grid), latency_label, 3, 1, 1, 1);
+    GtkWidget *latency_b = gtk_spin_button_new_with_range(AUDIO_MIN_LATENCY, AUDIO_MAX_LATENCY, 10.0);
+    gtk_widget_set_tooltip_text(latency_b,
+                                "Target latency of the local audio output.\n"
+                                "Increase if there are audio drop-outs (xruns).");
+    gtk_spin_button_set_value(GTK_SPIN_BUTTON(latency_b), (double)active_receiver->audio_target_latency);
+    gtk_grid_attach(GTK_GRID(grid), latency_b, 3, 2, 1, 1);
+    g_signal_connect(latency_b, "value_changed", G_CALLBACK(audio_latency_cb), NULL);
+    audio_stats_label = gtk_label_new(NULL);
+    gtk_widget_set_halign(audio_stats_label, GTK_ALIGN_START);
+    gtk_grid_attach(GTK_GRID(grid), audio_stats_label, 3, 3, 1, 1);
+    audio_stats_update(NULL);
+    audio_stats_timer = g_timeout_add(1000, audio_stats_update, NULL);
   }
 
   gtk_container_add(GTK_CONTAINER(content), grid);
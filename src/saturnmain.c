@@ -143,99 +143,9 @@ IQHeadPtr[VNUMDDC];                                                      // ptr
 unsigned char*
 IQBasePtr[VNUMDDC];                                                      // ptr to DMA location in I/Q memory
 
-// Memory buffers to be exchanged with PiHPSDR APIs
-#define MAXMYBUF 3
-#define DDCMYBUF 0
-#define MICMYBUF 1
-#define HPMYBUF  2
-//
-// number of buffers allocated (for statistics)
-//
-static int num_buf[MAXMYBUF];
-
-//
-// head of buffer list
-//
-static mybuffer *buflist[MAXMYBUF];
-
-//
-// Obtain a free buffer. If no one is available allocate
-// new ones. Note these buffer "live" as long as the
-// program lives. They are never released.
-//
-static mybuffer *get_my_buffer(int numlist) {
-  int i, j, first;
-  const char *desc;
-  mybuffer *bp = buflist[numlist];
-
-  while (bp) {
-    if (bp->free) {
-      // found free buffer. Mark as used and return that one.
-      bp->free = 0;
-      return bp;
-    }
-
-    bp = bp->next;
-  }
-
-  //
-  // No buffer free, or the first time we request a buffer:
-  // allocate (a) new one(s). Note we need very few
-  // HighPrio buffers, a limited amount of MicSample buffers,
-  // and a possibly large amount of DDC IQ buffers.
-  //
-  first = (bp == NULL);
-
-  switch (numlist) {
-  case HPMYBUF:
-    j = 1;
-    desc = "HP";
-    break;
-
-  case MICMYBUF:
-    j = 5;
-    desc = "MIC";
-    break;
-
-  case DDCMYBUF:
-    j = 25;
-    desc = "DDC";
-    break;
-
-  default:
-    // NOTREACHED
-    j = 5;
-    desc = "UNKNOWN";
-    break;
-  }
-
-  for (i = 0; i < j; i++) {
-    bp = malloc(sizeof(mybuffer));
-    bp->free = 1;
-    bp->next = buflist[numlist];
-    buflist[numlist] = bp;
-    num_buf[numlist]++;
-  }
-
-  t_print("%s: number of buffer[%s] %s to %d\n", __FUNCTION__, desc,
-          first ? "set" : "increased", num_buf[numlist]);
-  // Mark the first buffer in list as used and return that one.
-  buflist[numlist]->free = 0;
-  return buflist[numlist];
-}
-
-void saturn_free_buffers() {
-  mybuffer *mybuf;
-
-  for (int i = 0; i < MAXMYBUF; i++) {
-    mybuf = buflist[i];
-
-    while (mybuf) {
-      mybuf->free = 1;
-      mybuf = mybuf->next;
-    }
-  }
-}
+// Memory buffers to be exchanged with PiHPSDR APIs are obtained
+// from p2_bufpool (see new_protocol.c), which is shared with the
+// P2 network receive thread.
 
 bool CreateDynamicMemory(void) {                            // return true if error
   uint32_t DDC;
@@ -735,7 +645,7 @@ static gpointer saturn_high_priority_thread(gpointer arg) {
     while (SDRActive) {                            // main loop
       uint16_t SleepCount;                                      // counter for sending next message
       uint8_t PTTBits;                                          // PTT bits - and change means a new message needed
-      mybuffer *mybuf = get_my_buffer(HPMYBUF);
+      mybuffer *mybuf = bufpool_get(&p2_bufpool);
       ReadStatusRegister();
       PTTBits = (uint8_t)GetP2PTTKeyInputs();
       *(uint8_t *)(UDPBuffer + 4) = *(uint8_t *)(mybuf->buffer + 4) = PTTBits;
@@ -765,7 +675,7 @@ static gpointer saturn_high_priority_thread(gpointer arg) {
         *(uint32_t *)mybuf->buffer = htonl(SequenceCounter++);       // add sequence count
         saturn_post_high_priority(mybuf);
       } else {
-        mybuf->free = 1;
+        bufpool_put(mybuf);
       }
 
       if (ServerActive) {
@@ -954,7 +864,7 @@ static gpointer saturn_micaudio_thread(gpointer arg) {
 
       DMAReadFromFPGA(DMAReadfile_fd, MicBasePtr, VDMAMICTRANSFERSIZE, VADDRMICSTREAMREAD);
       // create the packet
-      mybuffer *mybuf = get_my_buffer(MICMYBUF);
+      mybuffer *mybuf = bufpool_get(&p2_bufpool);
       *(uint32_t*)mybuf->buffer = htonl(SequenceCounter++);        // add sequence count
 
       if (TXActive == 2) {
@@ -1119,7 +1029,7 @@ static gpointer saturn_rx_thread(gpointer arg) {
       for (DDC = 0; DDC < VNUMDDC; DDC++) {
         while ((IQHeadPtr[DDC] - IQReadPtr[DDC]) > VIQBYTESPERFRAME) {
           //                    t_print("enough data for packet: DDC= %d\n", DDC);
-          mybuffer *mybuf = get_my_buffer(DDCMYBUF);
+          mybuffer *mybuf = bufpool_get(&p2_bufpool);
           *(uint32_t*)mybuf->buffer = htonl(SequenceCounter[DDC]++);     // add sequence count
           memset(mybuf->buffer + 4, 0, 8);                               // clear the timestamp data
           *(uint16_t*)(mybuf->buffer + 12) = htons(24);                  // bits per sample
@@ -1146,7 +1056,7 @@ static gpointer saturn_rx_thread(gpointer arg) {
               SequenceCounter[DDC] = 0;
             }
 
-            mybuf->free = 1;
+            bufpool_put(mybuf);
           } else {
             saturn_post_iq_data(DDC - 6, mybuf);
           }
@@ -52,6 +52,12 @@
 #include "tx_menu.h"
 #include "toolset.h"
 
+//
+// In the headless build (make headless) there are no widgets. Only the
+// part of the set_* functions that changes the radio state is compiled
+// there, the functions that just show or update a slider do nothing.
+//
+#ifndef HEADLESS
 static int width;
 static int height;
 
@@ -110,6 +116,7 @@ static GtkWidget *squelch_enable;
   static GtkWidget *preamp_scale;
   static gulong preamp_scale_signal_id;
 #endif
+#endif
 
 //
 // general tool for displaying a pop-up slider. This can also be used for a value for which there
@@ -117,6 +124,7 @@ static GtkWidget *squelch_enable;
 // Putting this into a separate function avoids much code repetition.
 //
 
+#ifndef HEADLESS
 int scale_timeout_cb(gpointer data) {
   gtk_widget_destroy(scale_dialog);
   scale_status = NO_ACTION;
@@ -253,6 +261,15 @@ int sliders_active_receiver_changed(void *data) {
 
   return FALSE;
 }
+#else
+void show_popup_slider(enum ACTION action, int rx, double min, double max, double delta, double value,
+                       const char *title) {
+}
+
+int sliders_active_receiver_changed(void *data) {
+  return FALSE;
+}
+#endif
 
 void set_attenuation_value(double value) {
   //t_print("%s value=%f\n",__FUNCTION__,value);
@@ -260,6 +277,7 @@ void set_attenuation_value(double value) {
 
   adc[active_receiver->adc].attenuation = (int)value;
   schedule_high_priority();
+#ifndef HEADLESS
 
   if (display_sliders) {
     gtk_range_set_value (GTK_RANGE(attenuation_scale), (double)adc[active_receiver->adc].attenuation);
@@ -269,8 +287,11 @@ void set_attenuation_value(double value) {
     show_popup_slider(ATTENUATION, active_receiver->adc, 0.0, 31.0, 1.0, (double)adc[active_receiver->adc].attenuation,
                       title);
   }
+
+#endif
 }
 
+#ifndef HEADLESS
 static void attenuation_value_changed_cb(GtkWidget *widget, gpointer data) {
   if (!have_rx_att) { return; }
 
@@ -412,6 +433,7 @@ static void agcgain_value_changed_cb(GtkWidget *widget, gpointer data) {
 
   rx_set_agc(active_receiver);
 }
+#endif
 
 void set_agc_gain(int rx, double value) {
   //t_print("%s value=%f\n",__FUNCTION__, value);
@@ -419,6 +441,7 @@ void set_agc_gain(int rx, double value) {
 
   receiver[rx]->agc_gain = value;
   rx_set_agc(receiver[rx]);
+#ifndef HEADLESS
 
   if (display_sliders && active_receiver->id == rx) {
     g_signal_handler_block(G_OBJECT(agc_scale), agc_scale_signal_id);
@@ -435,18 +458,23 @@ void set_agc_gain(int rx, double value) {
     snprintf(title, 64, "AGC Gain RX%d", rx + 1);
     show_popup_slider(AGC_GAIN, rx, -20.0, 120.0, 1.0, receiver[rx]->agc_gain, title);
   }
+
+#endif
 }
 
+#ifndef HEADLESS
 static void afgain_value_changed_cb(GtkWidget *widget, gpointer data) {
   active_receiver->volume = gtk_range_get_value(GTK_RANGE(af_gain_scale));
   rx_set_af_gain(active_receiver);
 }
+#endif
 
 void set_af_gain(int rx, double value) {
   if (rx >= receivers) { return; }
 
   receiver[rx]->volume = value;
   rx_set_af_gain(receiver[rx]);
+#ifndef HEADLESS
 
   if (display_sliders && rx == active_receiver->id) {
     gtk_range_set_value (GTK_RANGE(af_gain_scale), value);
@@ -455,8 +483,11 @@ void set_af_gain(int rx, double value) {
     snprintf(title, 64, "AF Gain RX%d", rx + 1);
     show_popup_slider(AF_GAIN, rx, -40.0, 0.0, 1.0, value, title);
   }
+
+#endif
 }
 
+#ifndef HEADLESS
 static void rf_gain_value_changed_cb(GtkWidget *widget, gpointer data) {
   adc[active_receiver->adc].gain = gtk_range_get_value(GTK_RANGE(rf_gain_scale));
 
@@ -480,6 +511,7 @@ gboolean update_rf_gain_slider_value(gpointer data) {
   g_free(data);
   return FALSE;
 }
+#endif
 
 void set_rf_gain(int rx, double value) {
   if (!have_rx_gain) { return; }
@@ -496,6 +528,7 @@ void set_rf_gain(int rx, double value) {
   }
 
 #endif
+#ifndef HEADLESS
 
   if (display_sliders && active_receiver->id == rx) {
     if (pthread_equal(pthread_self(), deskhpsdr_main_thread)) {
@@ -517,6 +550,8 @@ void set_rf_gain(int rx, double value) {
     snprintf(title, 64, "RF Gain ADC %d", rxadc);
     show_popup_slider(RF_GAIN, rxadc, adc[rxadc].min_gain, adc[rxadc].max_gain, 1.0, adc[rxadc].gain, title);
   }
+
+#endif
 }
 
 void show_filter_width(int rx, int width) {
@@ -552,6 +587,7 @@ void show_filter_shift(int rx, int shift) {
   show_popup_slider(IF_SHIFT, rx, (double)(min), (double) (max), 1.0, (double) shift, title);
 }
 
+#ifndef HEADLESS
 static void micgain_value_changed_cb(GtkWidget *widget, gpointer data) {
   if (can_transmit) {
     if (optimize_for_touchscreen) {
@@ -569,6 +605,7 @@ static void micgain_value_changed_cb(GtkWidget *widget, gpointer data) {
     g_idle_add(ext_vfo_update, NULL);
   }
 }
+#endif
 
 void set_linein_gain(double value) {
   //t_print("%s value=%f\n",__FUNCTION__, value);
@@ -586,6 +623,7 @@ void set_mic_gain(double value) {
     copy_mode_settings(mode);
 #endif
     tx_set_mic_gain(transmitter);
+#ifndef HEADLESS
 
     if (display_sliders) {
       g_signal_handler_block(G_OBJECT(mic_gain_scale), mic_gain_scale_signal_id);
@@ -600,6 +638,8 @@ void set_mic_gain(double value) {
     } else {
       show_popup_slider(MIC_GAIN, 0, -12.0, 50.0, 1.0, value, "Mic Gain");
     }
+
+#endif
   }
 }
 
@@ -612,6 +652,7 @@ void set_drive(double value) {
   }
 
   radio_set_drive(value);
+#ifndef HEADLESS
 
   if (display_sliders) {
     if (device == DEVICE_HERMES_LITE2 && pa_enabled) {
@@ -630,8 +671,11 @@ void set_drive(double value) {
   } else {
     show_popup_slider(DRIVE, 0, 0.0, drive_max, 1.0, value, "TX Drive");
   }
+
+#endif
 }
 
+#ifndef HEADLESS
 static void drive_value_changed_cb(GtkWidget *widget, gpointer data) {
   double value = 0.0;
 
@@ -666,6 +710,7 @@ static void drive_value_changed_cb(GtkWidget *widget, gpointer data) {
     gtk_range_set_value (GTK_RANGE(widget), value);
   }
 }
+#endif
 
 void show_filter_high(int rx, int var) {
   //t_print("%s var=%d\n",__FUNCTION__,var);
@@ -721,6 +766,7 @@ void show_filter_low(int rx, int var) {
   show_popup_slider(FILTER_CUT_LOW, rx, (double)(min), (double)(max), 1.00, (double) var, title);
 }
 
+#ifndef HEADLESS
 static void squelch_value_changed_cb(GtkWidget *widget, gpointer data) {
   active_receiver->squelch = gtk_range_get_value(GTK_RANGE(widget));
   active_receiver->squelch_enable = (active_receiver->squelch > 0.5);
@@ -1033,6 +1079,31 @@ static void autogain_enable_cb(GtkWidget *widget, gpointer data) {
 }
 #endif
 
+#endif
+#else
+void update_slider_local_mic_input(int src) {
+}
+
+void update_slider_local_mic_button() {
+}
+
+void update_slider_bbcompr_scale(gboolean show_widget) {
+}
+
+void update_slider_bbcompr_button(gboolean show_widget) {
+}
+
+void update_slider_lev_button(gboolean show_widget) {
+}
+
+void update_slider_lev_scale(gboolean show_widget) {
+}
+
+void update_slider_preamp_button(gboolean show_widget) {
+}
+
+void update_slider_preamp_scale(gboolean show_widget) {
+}
 #endif
 
 void set_squelch(RECEIVER *rx) {
@@ -1045,6 +1116,7 @@ void set_squelch(RECEIVER *rx) {
   //
   rx->squelch_enable = (rx->squelch > 0.5);
   rx_set_squelch(rx);
+#ifndef HEADLESS
 
   if (display_sliders && rx->id == active_receiver->id) {
     gtk_range_set_value (GTK_RANGE(squelch_scale), rx->squelch);
@@ -1054,6 +1126,8 @@ void set_squelch(RECEIVER *rx) {
     snprintf(title, 64, "Squelch RX%d (Hz)", rx->id + 1);
     show_popup_slider(SQUELCH, rx->id, 0.0, 100.0, 1.0, rx->squelch, title);
   }
+
+#endif
 }
 
 void show_diversity_gain() {
@@ -1064,6 +1138,7 @@ void show_diversity_phase() {
   show_popup_slider(DIV_PHASE, 0, -180.0, 180.0, 0.1, div_phase, "Diversity Phase");
 }
 
+#ifndef HEADLESS
 // will ce called from radio.c and initializing the slider surface depend from the selected screen size
 GtkWidget *sliders_init(int my_width, int my_height) {
 #if defined (__LDESK__)
@@ -1822,3 +1897,4 @@ GtkWidget *sliders_init(int my_width, int my_height) {
 #endif
   return sliders;
 }
+#endif
@@ -48,10 +48,13 @@
 #include "ext.h"
 #include "message.h"
 #include "toolset.h"
+#include "receiver.h"
+#include "transmitter.h"
 
 #define MAX_TCI_CLIENTS 5
 #define MAXDATASIZE     1024
 #define MAXMSGSIZE      512
+#define SPECTRUM_BINS   64     // must fit into MAXMSGSIZE
 
 int tci_enable = 0;
 int tci_port   = 50001;
@@ -94,6 +97,8 @@ typedef struct _client {
   int count;                    // ping counter
   int rxsensor;                 // enable transmit of S meter data
   int txsensor;                 // enable transmit of drive data
+  int rxspectrum[2];            // enable transmit of RX1/RX2 spectrum
+  int txspectrum;               // enable transmit of TX spectrum
   int idle_queued;              // counter
 } CLIENT;
 
@@ -109,6 +114,7 @@ static GMutex tci_mutex;
 
 static gpointer tci_server(gpointer data);
 static gpointer tci_listener(gpointer data);
+static void tci_set_spectrum(CLIENT *client, int v, int on);
 
 //
 // Launch TCI system. Called upon program start if TCI is
@@ -133,6 +139,14 @@ static void force_close(CLIENT *client) {
   struct linger linger = { 0 };
   linger.l_onoff = 1;
   linger.l_linger = 0;
+
+  //
+  // Withdraw the spectrum requests before the slot can be re-used
+  //
+  for (int v = 0; v <= 2; v++) {
+    tci_set_spectrum(client, v, 0);
+  }
+
   g_mutex_lock(&tci_mutex);
   client->running = 0;
 
@@ -553,6 +567,92 @@ static void tci_send_rx(CLIENT *client, int v) {
   tci_send_text(client, msg);
 }
 
+//
+// The spectrum reports are a deskHPSDR extension of TCI, intended for
+// remote displays of the headless program. The visible part of the
+// spectrum (all of it for TX) is reduced to SPECTRUM_BINS values
+// (the maximum of the pixels of each bin) in dBm, as obtained from
+// WDSP, e.g. "rx_spectrum:0,64,-120,-118,...;"
+//
+static void tci_send_spectrum(CLIENT *client, int v) {
+  char msg[MAXMSGSIZE];
+  int  lvl[SPECTRUM_BINS];
+  GMutex *mutex;
+  const float *samples;
+  int width, len;
+
+  if (v < 0 || v > 2) { return; }
+
+  if (v < 2) {
+    RECEIVER *rx = receiver[v];
+    mutex   = &rx->display_mutex;
+    g_mutex_lock(mutex);
+    samples = rx->pixel_samples + rx->pan;
+    width   = rx->width;
+    len     = snprintf(msg, MAXMSGSIZE, "rx_spectrum:%d,%d", v, SPECTRUM_BINS);
+  } else {
+    mutex   = &transmitter->display_mutex;
+    g_mutex_lock(mutex);
+    samples = transmitter->pixel_samples;
+    width   = transmitter->pixels;
+    len     = snprintf(msg, MAXMSGSIZE, "tx_spectrum:%d", SPECTRUM_BINS);
+  }
+
+  if (samples == NULL || width <= 0) {
+    g_mutex_unlock(mutex);
+    return;
+  }
+
+  for (int i = 0; i < SPECTRUM_BINS; i++) {
+    int first = (i * width) / SPECTRUM_BINS;
+    int last  = ((i + 1) * width) / SPECTRUM_BINS;
+    float max = -200.0F;
+
+    for (int j = first; j < last; j++) {
+      if (samples[j] > max) { max = samples[j]; }
+    }
+
+    lvl[i] = (int) (max - 0.5F);
+  }
+
+  g_mutex_unlock(mutex);
+
+  for (int i = 0; i < SPECTRUM_BINS; i++) {
+    len += snprintf(msg + len, MAXMSGSIZE - len, ",%d", lvl[i]);
+  }
+
+  snprintf(msg + len, MAXMSGSIZE - len, ";");
+  tci_send_text(client, msg);
+}
+
+//
+// Ask the receivers/transmitter to compute the spectrum for this
+// client (see rx_request_spectrum). Each change of a client's
+// setting is passed on once, such that the requests balance.
+//
+static void tci_set_spectrum(CLIENT *client, int v, int on) {
+  int *flag;
+
+  if (v < 0 || v > 2) { return; }
+
+  flag = (v < 2) ? &client->rxspectrum[v] : &client->txspectrum;
+  g_mutex_lock(&tci_mutex);
+
+  if (*flag == on) {
+    g_mutex_unlock(&tci_mutex);
+    return;
+  }
+
+  *flag = on;
+  g_mutex_unlock(&tci_mutex);
+
+  if (v < 2) {
+    rx_request_spectrum(receiver[v], on);
+  } else {
+    tx_request_spectrum(transmitter, on);
+  }
+}
+
 static void tci_send_close(CLIENT *client) {
   RESPONSE *resp = g_new(RESPONSE, 1);
 
@@ -633,6 +733,16 @@ static gboolean tci_reporter(gpointer data) {
       tci_send_drive(client, 0);
     }
 
+    for (int v = 0; v < receivers && v < 2; v++) {
+      if (client->rxspectrum[v]) {
+        tci_send_spectrum(client, v);
+      }
+    }
+
+    if (client->txspectrum && can_transmit) {
+      tci_send_spectrum(client, 2);
+    }
+
     if (receivers > 0 && client->rxsensor && (client->count & 1)) {
       if (receivers == 1) {
         tci_send_smeter(client, 0);
@@ -1063,6 +1173,8 @@ static gpointer tci_listener(gpointer data) {
         // modulation:x;           tci_send_mode(arg1)     do not change mode, ignore y
         // vfo:x,y;                tci_send_vfo(x,y)       do not change frequency
         // rx_smeter,x,y;          tci_send_smeter(x)      undocumented, ignore y
+        // rx_spectrum_enable:x,y; enable:=arg2        deskHPSDR extension, report RX x spectrum
+        // tx_spectrum_enable:x;   enable:=arg1        deskHPSDR extension, report TX spectrum
         //
         // While it was originally decided NOT to respond to any incoming TCI command, there
         // are logbook program which seem to require that. Note that additional arguments are
@@ -1136,6 +1248,12 @@ static gpointer tci_listener(gpointer data) {
           g_mutex_lock(&tci_mutex);
           client->txsensor = (*arg[1] == '1' || !strcmp(arg[1], "true"));
           g_mutex_unlock(&tci_mutex);
+        } else if (!strcmp(arg[0], "rx_spectrum_enable") && argc > 2) {
+          tci_set_spectrum(client, (*arg[1] == '1') ? 1 : 0, (*arg[2] == '1' || !strcmp(arg[2], "true")));
+        } else if (!strcmp(arg[0], "tx_spectrum_enable") && argc > 1) {
+          if (can_transmit) {
+            tci_set_spectrum(client, 2, (*arg[1] == '1' || !strcmp(arg[1], "true")));
+          }
         } else if (!strcmp(arg[0], "modulation") && argc > 1) {
           tci_send_mode(client, (*arg[1] == '1') ? 1 : 0);
         } else if (!strcmp(arg[0], "vfo") && argc > 2) {
@@ -1200,6 +1318,7 @@ static gpointer tci_listener(gpointer data) {
   tci_send_text(client, "stop;");
   tci_send_close(client);
   force_close(client);
+
   t_print("%s: leaving thread\n", __FUNCTION__);
   // update CAT status onscreen
   cat_control--;
@@ -105,10 +105,12 @@ double ctcss_frequencies[CTCSS_FREQUENCIES] = {
 static int p1radio = 0, p2radio = 0; // sine tone to the radio
 static int p1local = 0, p2local = 0; // sine tone to local audio
 
+#ifndef HEADLESS
 static gboolean close_cb() {
   // there is nothing to clean up
   return TRUE;
 }
+#endif
 
 static int clear_out_of_band_warning(gpointer data) {
   //
@@ -303,7 +305,9 @@ void tx_reconfigure(TRANSMITTER *tx, int pixels, int width, int height) {
     t_print("%s: width=%d height=%d\n", __FUNCTION__, width, height);
     tx->width = width;
     tx->height = height;
+#ifndef HEADLESS
     gtk_widget_set_size_request(tx->panel, width, height);
+#endif
     //
     // In duplex mode, pixels = 4*width, else pixels equals width
     tx->pixels = pixels;
@@ -323,7 +327,9 @@ void tx_reconfigure(TRANSMITTER *tx, int pixels, int width, int height) {
     }
   }
 
+#ifndef HEADLESS
   gtk_widget_set_size_request(tx->panadapter, width, height);
+#endif
 }
 
 void tx_save_state(const TRANSMITTER *tx) {
@@ -535,6 +541,30 @@ static double compute_power(double p) {
   return interval * ((1.0 - frac) * (double)i + frac * (double)(i + 1));
 }
 
+//
+// As for the receivers, the TX spectrum is only computed if it is
+// displayed, or (headless build) requested via tx_request_spectrum().
+//
+static inline int tx_spectrum_wanted(const TRANSMITTER *tx) {
+#ifdef HEADLESS
+  return tx->displaying && tx->spectrum_requests > 0;
+#else
+  return tx->displaying;
+#endif
+}
+
+void tx_request_spectrum(TRANSMITTER *tx, int on) {
+  g_mutex_lock(&tx->display_mutex);
+
+  if (on) {
+    tx->spectrum_requests++;
+  } else if (tx->spectrum_requests > 0) {
+    tx->spectrum_requests--;
+  }
+
+  g_mutex_unlock(&tx->display_mutex);
+}
+
 static gboolean tx_update_display(gpointer data) {
   TRANSMITTER *tx = (TRANSMITTER *)data;
   int rc;
@@ -547,7 +577,9 @@ static gboolean tx_update_display(gpointer data) {
     //
     g_mutex_lock(&tx->display_mutex);
 
-    if (tx->puresignal && tx->feedback) {
+    if (!tx_spectrum_wanted(tx)) {
+      rc = 0;
+    } else if (tx->puresignal && tx->feedback) {
       RECEIVER *rx_feedback = receiver[PS_RX_FEEDBACK];
       g_mutex_lock(&rx_feedback->display_mutex);
       rc = rx_get_pixels(rx_feedback);
@@ -602,10 +634,13 @@ static gboolean tx_update_display(gpointer data) {
       rc = tx_get_pixels(tx);
     }
 
+#ifndef HEADLESS
+
     if (rc) {
       tx_panadapter_update(tx);
     }
 
+#endif
     g_mutex_unlock(&tx->display_mutex);
     tx->alc = tx_get_alc(tx);
     double constant1;
@@ -806,16 +841,21 @@ static gboolean tx_update_display(gpointer data) {
       pre_high_swr = 0;
     }
 
+#ifndef HEADLESS
+
     if (!duplex) {
       meter_update(active_receiver, POWER, tx->fwd, tx->alc, tx->swr);
     }
 
+#endif
+
     return TRUE; // keep going
   }
 
   return FALSE; // no more timer events
 }
 
+#ifndef HEADLESS
 void tx_create_dialog(TRANSMITTER *tx) {
   //
   // This creates a small separate window to hold a "small"
@@ -871,6 +911,7 @@ static void tx_create_visual(TRANSMITTER *tx) {
     tx_create_dialog(tx);
   }
 }
+#endif
 
 TRANSMITTER *tx_create_transmitter(int id, int pixels, int width, int height) {
   TRANSMITTER *tx = g_new(TRANSMITTER, 1);
@@ -1193,6 +1234,10 @@ TRANSMITTER *tx_create_transmitter(int id, int pixels, int width, int height) {
               0,                         // state (do not run yet)
               0.010, 0.025, 0.0, 0.010,  // DelayUp, SlewUp, DelayDown, SlewDown
               1);                        // Wait for data in fexchange0
+#ifndef EXTNR
+  SetChannelCommandQueue(tx->id, wdsp_cmd_queue);
+  SetTXAStageTiming(tx->id, dsp_profile);
+#endif
   //
   // Some WDSP settings that are never changed.
   // Most of these are the default anyway.
@@ -1234,7 +1279,9 @@ TRANSMITTER *tx_create_transmitter(int id, int pixels, int width, int height) {
   tx_create_analyzer(tx);
   tx_set_detector(tx);
   tx_set_average(tx);
+#ifndef HEADLESS
   tx_create_visual(tx);
+#endif
   return tx;
 }
 
@@ -1259,7 +1306,6 @@ float fir_apply(float input) {
 
 static void tx_full_buffer(TRANSMITTER *tx) {
   long isample;
-  long qsample;
   double gain;
   double *dp;
   int j;
@@ -1267,6 +1313,7 @@ static void tx_full_buffer(TRANSMITTER *tx) {
   int cwmode;
   int sidetone = 0;
   static int txflag = 0;
+  gint64 t0 = dsp_profile ? g_get_monotonic_time() : 0;
   // It is important to query the TX mode and tune only *once* within this function, to assure that
   // the two "if (cwmode)" clauses give the same result.
   // cwmode only valid in the old protocol, in the new protocol we use a different mechanism
@@ -1397,7 +1444,7 @@ static void tx_full_buffer(TRANSMITTER *tx) {
     }
   }
 
-  if (tx->displaying && !(tx->puresignal && tx->feedback)) {
+  if (tx_spectrum_wanted(tx) && !(tx->puresignal && tx->feedback)) {
     g_mutex_lock(&tx->display_mutex);
     Spectrum0(1, tx->id, 0, 0, tx->iq_output_buffer);
     g_mutex_unlock(&tx->display_mutex);
@@ -1504,31 +1551,28 @@ static void tx_full_buffer(TRANSMITTER *tx) {
       }
     } else {
       //
-      // Original code without pulse shaping and without side tone
+      // Original code without pulse shaping and without side tone.
+      // For P1 and P2, the whole buffer is scaled, rounded and packed
+      // into the wire format in one go.
       //
-      for (j = 0; j < tx->output_samples; j++) {
-        double is, qs;
-        is = tx->iq_output_buffer[j * 2];
-        qs = tx->iq_output_buffer[(j * 2) + 1];
-        isample = is >= 0.0 ? (long)floor(is * gain + 0.5) : (long)ceil(is * gain - 0.5);
-        qsample = qs >= 0.0 ? (long)floor(qs * gain + 0.5) : (long)ceil(qs * gain - 0.5);
-
-        switch (protocol) {
-        case ORIGINAL_PROTOCOL:
-          old_protocol_iq_samples(isample, qsample, 0);
-          break;
+      switch (protocol) {
+      case ORIGINAL_PROTOCOL:
+        old_protocol_iq_block(tx->iq_output_buffer, tx->output_samples, gain);
+        break;
 
-        case NEW_PROTOCOL:
-          new_protocol_iq_samples(isample, qsample);
-          break;
+      case NEW_PROTOCOL:
+        new_protocol_iq_block(tx->iq_output_buffer, tx->output_samples, gain);
+        break;
 #ifdef SOAPYSDR
 
-        case SOAPYSDR_PROTOCOL:
+      case SOAPYSDR_PROTOCOL:
+        for (j = 0; j < tx->output_samples; j++) {
           // SOAPY: just convert the double IQ samples (is,qs) to float.
-          soapy_protocol_iq_samples((float)is, (float)qs);
-          break;
-#endif
+          soapy_protocol_iq_samples((float)tx->iq_output_buffer[j * 2], (float)tx->iq_output_buffer[(j * 2) + 1]);
         }
+
+        break;
+#endif
       }
     }
   } else {   // radio_is_transmitting()
@@ -1547,6 +1591,15 @@ static void tx_full_buffer(TRANSMITTER *tx) {
 
     txflag = 0;
   }
+
+  if (t0 != 0) {
+    double dt = (double)(g_get_monotonic_time() - t0);
+    tx->full_buffer_time += dt;
+
+    if (dt > tx->full_buffer_peak) { tx->full_buffer_peak = dt; }
+
+    tx->full_buffer_count++;
+  }
 }
 
 void tx_add_mic_sample(TRANSMITTER *tx, float mic_sample) {
@@ -1802,7 +1855,7 @@ void tx_add_ps_iq_samples(const TRANSMITTER *tx, double i_sample_tx, double q_sa
         pscc(tx->id, rx_feedback->buffer_size, tx_feedback->iq_input_buffer, rx_feedback->iq_input_buffer);
       }
 
-      if (tx->displaying && tx->feedback) {
+      if (tx_spectrum_wanted(tx) && tx->feedback) {
         g_mutex_lock(&rx_feedback->display_mutex);
         Spectrum0(1, rx_feedback->id, 0, 0, rx_feedback->iq_input_buffer);
         g_mutex_unlock(&rx_feedback->display_mutex);
@@ -32,6 +32,7 @@ typedef struct _transmitter {
   int dac;
   int fps;
   int displaying;
+  int spectrum_requests;  // headless: number of clients that want the spectrum
   int dsp_rate;
   int iq_output_rate;
   int buffer_size;
@@ -195,6 +196,13 @@ typedef struct _transmitter {
   double eq_gain[11];  // gain in dB
   int eq_ctfmode;
 
+  //
+  // Time spent in tx_full_buffer, only measured if dsp_profile is set
+  //
+  long   full_buffer_count;
+  double full_buffer_time;     // accumulated, in usec
+  double full_buffer_peak;     // worst case, in usec
+
 } TRANSMITTER;
 
 extern TRANSMITTER *tx_create_transmitter(int id, int pixels, int width, int height);
@@ -221,6 +229,7 @@ extern double tx_get_alc(const TRANSMITTER *tx);
 extern int    tx_get_pixels(TRANSMITTER *tx);
 extern void   tx_off(const TRANSMITTER *tx);
 extern void   tx_on(const TRANSMITTER *tx);
+extern void   tx_request_spectrum(TRANSMITTER *tx, int on);
 
 extern void   tx_ps_getinfo(const TRANSMITTER *tx, int *info);
 extern double tx_ps_getmx(const TRANSMITTER *tx);
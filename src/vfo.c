@@ -67,11 +67,13 @@
   GMutex copy_string_mutex;
 #endif
 
+#ifndef HEADLESS
 static int my_width;
 static int my_height;
 
 static GtkWidget *vfo_panel;
 static cairo_surface_t *vfo_surface = NULL;
+#endif
 
 int steps[] = {1, 10, 25, 50, 100, 250, 500, 1000, 5000, 6250, 9000, 10000, 12500, 100000, 250000, 500000, 1000000};
 char *step_labels[] = {"1Hz", "10Hz", "25Hz", "50Hz", "100Hz", "250Hz", "500Hz", "1kHz",
@@ -1534,6 +1536,7 @@ void vfo_id_move_to(int id, long long hz) {
   }
 }
 
+#ifndef HEADLESS
 // cppcheck-suppress constParameterCallback
 static gboolean vfo_scroll_event_cb (GtkWidget *widget, GdkEventScroll *event, gpointer data) {
   RECEIVER *rx = active_receiver;
@@ -2642,6 +2645,13 @@ GtkWidget* vfo_init(int width, int height) {
                          | GDK_SCROLL_MASK);
   return vfo_panel;
 }
+#else
+//
+// Without a GUI there is no VFO bar to re-draw
+//
+void vfo_update() {
+}
+#endif
 
 //
 // Some utility functions to get characteristics of the current
@@ -38,6 +38,7 @@
 #include "ext.h"
 #include "radio_menu.h"
 
+#ifndef HEADLESS
 static int myvfo;  //  VFO the menu is referring to
 static GtkWidget *dialog = NULL;
 static GtkWidget *label;
@@ -283,6 +284,7 @@ void vfo_menu(GtkWidget *parent, int id) {
   sub_menu = dialog;
   gtk_widget_show_all(dialog);
 }
+#endif
 
 //
 // This is also called when hitting buttons on the
@@ -25,6 +25,13 @@
 #include <unistd.h>
 #include <semaphore.h>
 #include <string.h>
+#include <stdint.h>
+#if defined(__SSE2__)
+  #include <emmintrin.h>
+#endif
+#if defined(__ARM_NEON)
+  #include <arm_neon.h>
+#endif
 #include "radio.h"
 #include "vfo.h"
 #include "band.h"
@@ -50,7 +57,127 @@ static double hz_per_pixel;
 static int my_width;
 static int my_height;
 
-/* Create a new surface of the appropriate size to store our scribbles */
+//
+// Colour palette. Entries 0 ... WF_PALETTE_SIZE-1 cover the range between
+// the low and the high limit, entry WF_PALETTE_SIZE is used for values
+// above the high limit (values below the low limit use entry 0, which
+// has the "low" colour anyway). Since the limits only affect the scaling
+// of the sample values, the palette need only be re-calculated if one
+// of the six low/high colour components changes; palette_colors holds
+// the components the palette has been built from (-1: not yet built).
+// The entries are in CAIRO_FORMAT_RGB24 format.
+//
+#define WF_PALETTE_SIZE 1024
+
+static uint32_t palette[WF_PALETTE_SIZE + 1];
+static int palette_colors[6] = { -1, -1, -1, -1, -1, -1 };
+
+static inline uint32_t rgb24(int r, int g, int b) {
+  return ((uint32_t)r << 16) | ((uint32_t)g << 8) | (uint32_t)b;
+}
+
+static void waterfall_palette_init() {
+  const int colors[6] = { colorLowR, colorLowG, colorLowB, colorHighR, colorHighG, colorHighB };
+
+  if (memcmp(palette_colors, colors, sizeof(colors)) == 0) { return; }
+
+  for (int i = 0; i < WF_PALETTE_SIZE; i++) {
+    float percent = ((float)i + 0.5f) / (float)WF_PALETTE_SIZE;
+
+    if (percent < 0.222222f) {
+      float local_percent = percent * 4.5f;
+      palette[i] = rgb24((int)((1.0f - local_percent) * colorLowR),
+                         (int)((1.0f - local_percent) * colorLowG),
+                         (int)(colorLowB + local_percent * (255 - colorLowB)));
+    } else if (percent < 0.333333f) {
+      float local_percent = (percent - 0.222222f) * 9.0f;
+      palette[i] = rgb24(0, (int)(local_percent * 255), 255);
+    } else if (percent < 0.444444f) {
+      float local_percent = (percent - 0.333333) * 9.0f;
+      palette[i] = rgb24(0, 255, (int)((1.0f - local_percent) * 255));
+    } else if (percent < 0.555555f) {
+      float local_percent = (percent - 0.444444f) * 9.0f;
+      palette[i] = rgb24((int)(local_percent * 255), 255, 0);
+    } else if (percent < 0.777777f) {
+      float local_percent = (percent - 0.555555f) * 4.5f;
+      palette[i] = rgb24(255, (int)((1.0f - local_percent) * 255), 0);
+    } else if (percent < 0.888888f) {
+      float local_percent = (percent - 0.777777f) * 9.0f;
+      palette[i] = rgb24(255, 0, (int)(local_percent * 255));
+    } else {
+      float local_percent = (percent - 0.888888f) * 9.0f;
+      palette[i] = rgb24((int)((0.75f + 0.25f * (1.0f - local_percent)) * 255.0f),
+                         (int)(local_percent * 255.0f * 0.5f),
+                         255);
+    }
+  }
+
+  palette[0] = rgb24(colorLowR, colorLowG, colorLowB);
+  palette[WF_PALETTE_SIZE] = rgb24(colorHighR, colorHighG, colorHighB);
+  memcpy(palette_colors, colors, sizeof(colors));
+}
+
+//
+// Colourize one waterfall row: the palette index is
+// (sample + offset) * scale, clipped to 0 ... WF_PALETTE_SIZE.
+// The quantization is done four samples at a time with SSE2 or NEON
+// (both are always available on 64-bit x86 resp. ARM CPUs).
+//
+static void waterfall_row(uint32_t *dst, const float *src, int n, float offset, float scale) {
+  int i = 0;
+#if defined(__SSE2__)
+  const __m128 voffset = _mm_set1_ps(offset);
+  const __m128 vscale = _mm_set1_ps(scale);
+  const __m128 vzero = _mm_setzero_ps();
+  const __m128 vmax = _mm_set1_ps((float)WF_PALETTE_SIZE);
+
+  for (; i + 4 <= n; i += 4) {
+    int32_t idx[4];
+    __m128 x = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(src + i), voffset), vscale);
+    x = _mm_min_ps(_mm_max_ps(x, vzero), vmax);
+    _mm_storeu_si128((__m128i *)idx, _mm_cvttps_epi32(x));
+    dst[i]     = palette[idx[0]];
+    dst[i + 1] = palette[idx[1]];
+    dst[i + 2] = palette[idx[2]];
+    dst[i + 3] = palette[idx[3]];
+  }
+
+#elif defined(__ARM_NEON)
+  const float32x4_t voffset = vdupq_n_f32(offset);
+  const float32x4_t vscale = vdupq_n_f32(scale);
+  const float32x4_t vzero = vdupq_n_f32(0.0f);
+  const float32x4_t vmax = vdupq_n_f32((float)WF_PALETTE_SIZE);
+
+  for (; i + 4 <= n; i += 4) {
+    int32_t idx[4];
+    float32x4_t x = vmulq_f32(vaddq_f32(vld1q_f32(src + i), voffset), vscale);
+    x = vminq_f32(vmaxq_f32(x, vzero), vmax);
+    vst1q_s32(idx, vcvtq_s32_f32(x));
+    dst[i]     = palette[idx[0]];
+    dst[i + 1] = palette[idx[1]];
+    dst[i + 2] = palette[idx[2]];
+    dst[i + 3] = palette[idx[3]];
+  }
+
+#endif
+
+  for (; i < n; i++) {
+    float x = (src[i] + offset) * scale;
+
+    if (x > (float)WF_PALETTE_SIZE) { x = (float)WF_PALETTE_SIZE; }
+
+    if (!(x > 0.0f)) { x = 0.0f; }
+
+    dst[i] = palette[(int)x];
+  }
+}
+
+//
+// The waterfall is stored in a cairo image surface whose rows are used
+// as a circular buffer: a new line is written to the row above the
+// current top row (rx->waterfall_row), and the surface is painted in two
+// parts, such that the rows need not be shifted when a new line comes in.
+//
 static gboolean
 waterfall_configure_event_cb (GtkWidget         *widget,
                               GdkEventConfigure *event,
@@ -58,9 +185,18 @@ waterfall_configure_event_cb (GtkWidget         *widget,
   RECEIVER *rx = (RECEIVER *)data;
   my_width = gtk_widget_get_allocated_width (widget);
   my_height = gtk_widget_get_allocated_height (widget);
-  rx->pixbuf = gdk_pixbuf_new(GDK_COLORSPACE_RGB, FALSE, 8, my_width, my_height);
-  unsigned char *pixels = gdk_pixbuf_get_pixels (rx->pixbuf);
-  memset(pixels, 0, my_width * my_height * 3);
+
+  if (rx->waterfall_surface) {
+    cairo_surface_destroy (rx->waterfall_surface);
+  }
+
+  rx->waterfall_surface = cairo_image_surface_create(CAIRO_FORMAT_RGB24, my_width, my_height);
+  cairo_surface_flush(rx->waterfall_surface);
+  memset(cairo_image_surface_get_data(rx->waterfall_surface), 0,
+         cairo_image_surface_get_stride(rx->waterfall_surface) * my_height);
+  cairo_surface_mark_dirty(rx->waterfall_surface);
+  rx->waterfall_row = 0;
+  waterfall_palette_init();
   return TRUE;
 }
 
@@ -80,8 +216,28 @@ waterfall_draw_cb (GtkWidget *widget,
   int b_height = allocation.height;
   int box_height = 30;
   //++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
-  gdk_cairo_set_source_pixbuf (cr, rx->pixbuf, 0, 0);
-  cairo_paint (cr); // vor dem Zeichnen der Box aufrufen, sinst wird der pixbuf überschrieben !
+  //
+  // vor dem Zeichnen der Box aufrufen, sonst wird der Wasserfall überschrieben !
+  // rows top ... height-1 of the surface go to the top of the widget,
+  // rows 0 ... top-1 below
+  //
+  int top = rx->waterfall_row;
+  int wf_height = cairo_image_surface_get_height(rx->waterfall_surface);
+  cairo_save(cr);
+  cairo_rectangle(cr, 0.0, 0.0, b_width, wf_height - top);
+  cairo_clip(cr);
+  cairo_set_source_surface (cr, rx->waterfall_surface, 0.0, -top);
+  cairo_paint (cr);
+  cairo_restore(cr);
+
+  if (top > 0) {
+    cairo_save(cr);
+    cairo_rectangle(cr, 0.0, wf_height - top, b_width, top);
+    cairo_clip(cr);
+    cairo_set_source_surface (cr, rx->waterfall_surface, 0.0, wf_height - top);
+    cairo_paint (cr);
+    cairo_restore(cr);
+  }
 
   //++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
   if (display_info_bar && active_receiver->display_waterfall && (active_receiver->display_panadapter == 0
@@ -201,17 +357,18 @@ static gboolean waterfall_scroll_event_cb (GtkWidget *widget, GdkEventScroll *ev
 }
 
 void waterfall_update(RECEIVER *rx) {
-  if (rx->pixbuf) {
+  if (rx->waterfall_surface) {
     const float *samples;
     long long vfofreq = vfo[rx->id].frequency; // access only once to be thread-safe
     int  freq_changed = 0;                    // flag whether we have just "rotated"
     int pan = rx->pan;
     int zoom = rx->zoom;
-    unsigned char *pixels = gdk_pixbuf_get_pixels (rx->pixbuf);
-    int width = gdk_pixbuf_get_width(rx->pixbuf);
-    int height = gdk_pixbuf_get_height(rx->pixbuf);
-    int rowstride = gdk_pixbuf_get_rowstride(rx->pixbuf);
-    hz_per_pixel = (double)rx->sample_rate / ((double)my_width * rx->zoom);
+    cairo_surface_flush(rx->waterfall_surface);
+    unsigned char *pixels = cairo_image_surface_get_data (rx->waterfall_surface);
+    int width = cairo_image_surface_get_width(rx->waterfall_surface);
+    int height = cairo_image_surface_get_height(rx->waterfall_surface);
+    int rowstride = cairo_image_surface_get_stride(rx->waterfall_surface);
+    hz_per_pixel = (double)rx->sample_rate / ((double)width * rx->zoom);
 
     //
     // The existing waterfall corresponds to a VFO frequency rx->waterfall_frequency, a zoom value rx->waterfall_zoom and
@@ -233,32 +390,32 @@ void waterfall_update(RECEIVER *rx) {
         int rotpan  = rx->waterfall_pan - pan;                                        // shift due to pan   change
         int rotate_pixels = rotfreq + rotpan;
 
-        if (rotate_pixels >= my_width || rotate_pixels <= -my_width) {
+        if (rotate_pixels >= width || rotate_pixels <= -width) {
           //
           // If horizontal shift is too large, re-init waterfall
           //
-          memset(pixels, 0, my_width * my_height * 3);
+          memset(pixels, 0, rowstride * height);
           rx->waterfall_frequency = vfofreq;
           rx->waterfall_pan = pan;
         } else {
           //
-          // If rotate_pixels != 0, shift waterfall horizontally and set "freq changed" flag
+          // If rotate_pixels != 0, shift waterfall horizontally (row by row) and set "freq changed" flag
           // calculated which VFO/pan value combination the shifted waterfall corresponds to
           //
           //
           if (rotate_pixels < 0) {
             // shift left, and clear the right-most part
-            memmove(pixels, &pixels[-rotate_pixels * 3], ((my_width * my_height) + rotate_pixels) * 3);
-
-            for (int i = 0; i < my_height; i++) {
-              memset(&pixels[((i * my_width) + (width + rotate_pixels)) * 3], 0, -rotate_pixels * 3);
+            for (int i = 0; i < height; i++) {
+              uint32_t *row = (uint32_t *)(pixels + i * rowstride);
+              memmove(row, &row[-rotate_pixels], (width + rotate_pixels) * sizeof(uint32_t));
+              memset(&row[width + rotate_pixels], 0, -rotate_pixels * sizeof(uint32_t));
             }
           } else if (rotate_pixels > 0) {
             // shift right, and clear left-most part
-            memmove(&pixels[rotate_pixels * 3], pixels, ((my_width * my_height) - rotate_pixels) * 3);
-
-            for (int i = 0; i < my_height; i++) {
-              memset(&pixels[(i * my_width) * 3], 0, rotate_pixels * 3);
+            for (int i = 0; i < height; i++) {
+              uint32_t *row = (uint32_t *)(pixels + i * rowstride);
+              memmove(&row[rotate_pixels], row, (width - rotate_pixels) * sizeof(uint32_t));
+              memset(row, 0, rotate_pixels * sizeof(uint32_t));
             }
           }
 
@@ -275,7 +432,7 @@ void waterfall_update(RECEIVER *rx) {
       // waterfall frequency not (yet) set, sample rate changed, or zoom value changed:
       // (re-) init waterfall
       //
-      memset(pixels, 0, my_width * my_height * 3);
+      memset(pixels, 0, rowstride * height);
       rx->waterfall_frequency = vfofreq;
       rx->waterfall_pan = pan;
       rx->waterfall_zoom = zoom;
@@ -293,13 +450,10 @@ void waterfall_update(RECEIVER *rx) {
     // improvement.
     //
     if (!freq_changed) {
-      memmove(&pixels[rowstride], pixels, (height - 1)*rowstride);
       float soffset;
       float average;
-      unsigned char *p;
-      p = pixels;
       samples = rx->pixel_samples;
-      float wf_low, wf_high, rangei;
+      float wf_low, wf_high;
       int id = rx->id;
       int b = vfo[id].band;
       const BAND *band = band_get_band(b);
@@ -331,62 +485,15 @@ void waterfall_update(RECEIVER *rx) {
         wf_high = (float) rx->waterfall_high;
       }
 
-      rangei = 1.0F / (wf_high - wf_low);
-
-      for (int i = 0; i < width; i++) {
-        float sample = samples[i + pan] + soffset;
-
-        if (sample < wf_low) {
-          *p++ = colorLowR;
-          *p++ = colorLowG;
-          *p++ = colorLowB;
-        } else if (sample > wf_high) {
-          *p++ = colorHighR;
-          *p++ = colorHighG;
-          *p++ = colorHighB;
-        } else {
-          float percent = (sample - wf_low) * rangei;
-
-          if (percent < 0.222222f) {
-            float local_percent = percent * 4.5f;
-            *p++ = (int)((1.0f - local_percent) * colorLowR);
-            *p++ = (int)((1.0f - local_percent) * colorLowG);
-            *p++ = (int)(colorLowB + local_percent * (255 - colorLowB));
-          } else if (percent < 0.333333f) {
-            float local_percent = (percent - 0.222222f) * 9.0f;
-            *p++ = 0;
-            *p++ = (int)(local_percent * 255);
-            *p++ = 255;
-          } else if (percent < 0.444444f) {
-            float local_percent = (percent - 0.333333) * 9.0f;
-            *p++ = 0;
-            *p++ = 255;
-            *p++ = (int)((1.0f - local_percent) * 255);
-          } else if (percent < 0.555555f) {
-            float local_percent = (percent - 0.444444f) * 9.0f;
-            *p++ = (int)(local_percent * 255);
-            *p++ = 255;
-            *p++ = 0;
-          } else if (percent < 0.777777f) {
-            float local_percent = (percent - 0.555555f) * 4.5f;
-            *p++ = 255;
-            *p++ = (int)((1.0f - local_percent) * 255);
-            *p++ = 0;
-          } else if (percent < 0.888888f) {
-            float local_percent = (percent - 0.777777f) * 9.0f;
-            *p++ = 255;
-            *p++ = 0;
-            *p++ = (int)(local_percent * 255);
-          } else {
-            float local_percent = (percent - 0.888888f) * 9.0f;
-            *p++ = (int)((0.75f + 0.25f * (1.0f - local_percent)) * 255.0f);
-            *p++ = (int)(local_percent * 255.0f * 0.5f);
-            *p++ = 255;
-          }
-        }
-      }
+      //
+      // The new line goes to the row above the current top row
+      //
+      rx->waterfall_row = (rx->waterfall_row + height - 1) % height;
+      waterfall_row((uint32_t *)(pixels + rx->waterfall_row * rowstride), samples + pan, width,
+                    soffset - wf_low, (float)WF_PALETTE_SIZE / (wf_high - wf_low));
     }
 
+    cairo_surface_mark_dirty(rx->waterfall_surface);
     gtk_widget_queue_draw (rx->waterfall);
   }
 }
@@ -394,7 +501,8 @@ void waterfall_update(RECEIVER *rx) {
 void waterfall_init(RECEIVER *rx, int width, int height) {
   my_width = width;
   my_height = height;
-  rx->pixbuf = NULL;
+  rx->waterfall_surface = NULL;
+  rx->waterfall_row = 0;
   rx->waterfall_frequency = 0;
   rx->waterfall_sample_rate = 0;
   rx->waterfall = gtk_drawing_area_new ();
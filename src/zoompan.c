@@ -36,6 +36,11 @@
 #include "ext.h"
 #include "message.h"
 
+//
+// In the headless build (make headless) there are no widgets, and
+// set_zoom/set_pan only change the receiver.
+//
+#ifndef HEADLESS
 static int width;
 static int height;
 
@@ -92,6 +97,11 @@ static void zoom_value_changed_cb(GtkWidget *widget, gpointer data) {
   g_mutex_unlock(&pan_zoom_mutex);
   g_idle_add(ext_vfo_update, NULL);
 }
+#else
+int zoompan_active_receiver_changed(void *data) {
+  return FALSE;
+}
+#endif
 
 void set_zoom(int rx, double value) {
   //t_print("set_zoom: %f\n",value);
@@ -105,6 +115,7 @@ void set_zoom(int rx, double value) {
 
   receiver[rx]->zoom = ival;
   rx_update_zoom(receiver[rx]);
+#ifndef HEADLESS
 
   if (display_zoompan && active_receiver->id == rx) {
     gtk_range_set_value (GTK_RANGE(zoom_scale), receiver[rx]->zoom);
@@ -114,9 +125,11 @@ void set_zoom(int rx, double value) {
     show_popup_slider(ZOOM, rx, 1.0, MAX_ZOOM, 1.0, receiver[rx]->zoom, title);
   }
 
+#endif
   g_idle_add(ext_vfo_update, NULL);
 }
 
+#ifndef HEADLESS
 void remote_set_zoom(int rx, double value) {
   //t_print("remote_set_zoom: rx=%d zoom=%f\n",rx,value);
   g_mutex_lock(&pan_zoom_mutex);
@@ -139,6 +152,7 @@ static void pan_value_changed_cb(GtkWidget *widget, gpointer data) {
 
   g_mutex_unlock(&pan_zoom_mutex);
 }
+#endif
 
 void set_pan(int rx, double value) {
   //t_print("set_pan: value=%f\n",value);
@@ -156,6 +170,7 @@ void set_pan(int rx, double value) {
   if (ival > (receiver[rx]->pixels - receiver[rx]->width)) { ival = receiver[rx]->pixels - receiver[rx]->width; }
 
   receiver[rx]->pan = ival;
+#ifndef HEADLESS
 
   if (display_zoompan && rx == active_receiver->id) {
     gtk_range_set_value (GTK_RANGE(pan_scale), receiver[rx]->pan);
@@ -164,8 +179,11 @@ void set_pan(int rx, double value) {
     snprintf(title, 64, "Pan RX%d", rx + 1);
     show_popup_slider(PAN, rx, 0.0, receiver[rx]->pixels - receiver[rx]->width, 1.00, receiver[rx]->pan, title);
   }
+
+#endif
 }
 
+#ifndef HEADLESS
 void remote_set_pan(int rx, double value) {
   //t_print("remote_set_pan: rx=%d pan=%f\n",rx,value);
   if (rx >= receivers) { return; }
@@ -309,3 +327,4 @@ GtkWidget *zoompan_init(int my_width, int my_height) {
   g_mutex_init(&pan_zoom_mutex);
   return zoompan;
 }
+#endif
@@ -28,6 +28,124 @@ warren@wpratt.com
 
 struct _rxa rxa[MAX_CHANNELS];
 
+/********************************************************************************************************
+*                                                   *
+*                       RXA Stages                          *
+*                                                   *
+********************************************************************************************************/
+
+static void rxa_shift (int channel)      { xshift (rxa[channel].shift.p); }
+static void rxa_rsmpin (int channel)     { xresample (rxa[channel].rsmpin.p); }
+static void rxa_gen0 (int channel)       { xgen (rxa[channel].gen0.p); }
+static void rxa_adcmeter (int channel)   { xmeter (rxa[channel].adcmeter.p); }
+static void rxa_bpsnbain0 (int channel)  { xbpsnbain (rxa[channel].bpsnba.p, 0); }
+static void rxa_nbp0 (int channel)       { xnbp (rxa[channel].nbp0.p, 0); }
+static void rxa_smeter (int channel)     { xmeter (rxa[channel].smeter.p); }
+static void rxa_sender (int channel)     { xsender (rxa[channel].sender.p); }
+static void rxa_amsqcap (int channel)    { xamsqcap (rxa[channel].amsq.p); }
+static void rxa_bpsnbaout0 (int channel) { xbpsnbaout (rxa[channel].bpsnba.p, 0); }
+static void rxa_amd (int channel)        { xamd (rxa[channel].amd.p); }
+static void rxa_fmd (int channel)        { xfmd (rxa[channel].fmd.p); }
+static void rxa_fmsq (int channel)       { xfmsq (rxa[channel].fmsq.p); }
+static void rxa_bpsnbain1 (int channel)  { xbpsnbain (rxa[channel].bpsnba.p, 1); }
+static void rxa_bpsnbaout1 (int channel) { xbpsnbaout (rxa[channel].bpsnba.p, 1); }
+static void rxa_snba (int channel)       { xsnba (rxa[channel].snba.p); }
+static void rxa_eqp (int channel)        { xeqp (rxa[channel].eqp.p); }
+static void rxa_anf0 (int channel)       { xanf (rxa[channel].anf.p, 0); }
+static void rxa_anr0 (int channel)       { xanr (rxa[channel].anr.p, 0); }
+static void rxa_emnr0 (int channel)      { xemnr (rxa[channel].emnr.p, 0); }
+static void rxa_bp1_0 (int channel)      { xbandpass (rxa[channel].bp1.p, 0); }
+static void rxa_agc (int channel)        { xwcpagc (rxa[channel].agc.p); }
+static void rxa_anf1 (int channel)       { xanf (rxa[channel].anf.p, 1); }
+static void rxa_anr1 (int channel)       { xanr (rxa[channel].anr.p, 1); }
+static void rxa_emnr1 (int channel)      { xemnr (rxa[channel].emnr.p, 1); }
+static void rxa_bp1_1 (int channel)      { xbandpass (rxa[channel].bp1.p, 1); }
+static void rxa_agcmeter (int channel)   { xmeter (rxa[channel].agcmeter.p); }
+static void rxa_sip1 (int channel)       { xsiphon (rxa[channel].sip1.p, 0); }
+static void rxa_cbl (int channel)        { xcbl (rxa[channel].cbl.p); }
+static void rxa_speak (int channel)      { xspeak (rxa[channel].speak.p); }
+static void rxa_mpeak (int channel)      { xmpeak (rxa[channel].mpeak.p); }
+static void rxa_ssql (int channel)       { xssql (rxa[channel].ssql.p); }
+static void rxa_panel (int channel)      { xpanel (rxa[channel].panel.p); }
+static void rxa_amsq (int channel)       { xamsq (rxa[channel].amsq.p); }
+static void rxa_rsmpout (int channel)    { xresample (rxa[channel].rsmpout.p); }
+
+//
+// A stage whose block is switched off only copies its input to its output. All
+// of them work in place on midbuff (the resamplers are bypassed by RXAResCheck),
+// so these can be left out of the pipeline.
+//
+static int rxa_shift_on (int channel)      { return rxa[channel].shift.p->run; }
+static int rxa_rsmpin_on (int channel)     { return rxa[channel].rsmpin.p->run; }
+static int rxa_gen0_on (int channel)       { return rxa[channel].gen0.p->run; }
+static int rxa_bpsnba0_on (int channel)    { return rxa[channel].bpsnba.p->run && rxa[channel].bpsnba.p->position == 0; }
+static int rxa_nbp0_on (int channel)       { return rxa[channel].nbp0.p->run && rxa[channel].nbp0.p->position == 0; }
+static int rxa_sender_on (int channel)     { return rxa[channel].sender.p->run && rxa[channel].sender.p->flag; }
+static int rxa_amsq_on (int channel)       { return rxa[channel].amsq.p->run; }
+static int rxa_amd_on (int channel)        { return rxa[channel].amd.p->run; }
+static int rxa_fmd_on (int channel)        { return rxa[channel].fmd.p->run; }
+static int rxa_fmsq_on (int channel)       { return rxa[channel].fmsq.p->run; }
+static int rxa_bpsnba1_on (int channel)    { return rxa[channel].bpsnba.p->run && rxa[channel].bpsnba.p->position == 1; }
+static int rxa_snba_on (int channel)       { return rxa[channel].snba.p->run; }
+static int rxa_eqp_on (int channel)        { return rxa[channel].eqp.p->run; }
+static int rxa_anf0_on (int channel)       { return rxa[channel].anf.p->run && rxa[channel].anf.p->position == 0; }
+static int rxa_anr0_on (int channel)       { return rxa[channel].anr.p->run && rxa[channel].anr.p->position == 0; }
+static int rxa_emnr0_on (int channel)      { return rxa[channel].emnr.p->run && rxa[channel].emnr.p->position == 0; }
+static int rxa_bp1_0_on (int channel)      { return rxa[channel].bp1.p->run && rxa[channel].bp1.p->position == 0; }
+static int rxa_agc_on (int channel)        { return rxa[channel].agc.p->run; }
+static int rxa_anf1_on (int channel)       { return rxa[channel].anf.p->run && rxa[channel].anf.p->position == 1; }
+static int rxa_anr1_on (int channel)       { return rxa[channel].anr.p->run && rxa[channel].anr.p->position == 1; }
+static int rxa_emnr1_on (int channel)      { return rxa[channel].emnr.p->run && rxa[channel].emnr.p->position == 1; }
+static int rxa_bp1_1_on (int channel)      { return rxa[channel].bp1.p->run && rxa[channel].bp1.p->position == 1; }
+static int rxa_cbl_on (int channel)        { return rxa[channel].cbl.p->run; }
+static int rxa_speak_on (int channel)      { return rxa[channel].speak.p->run; }
+static int rxa_mpeak_on (int channel)      { return rxa[channel].mpeak.p->run; }
+static int rxa_ssql_on (int channel)       { return rxa[channel].ssql.p->run; }
+static int rxa_rsmpout_on (int channel)    { return rxa[channel].rsmpout.p->run; }
+
+//
+// The meters, the siphon and the patch panel always run
+//
+static const pipestage rxa_stages[] = {
+  { "shift",      rxa_shift,      rxa_shift_on   },
+  { "rsmpin",     rxa_rsmpin,     rxa_rsmpin_on  },
+  { "gen0",       rxa_gen0,       rxa_gen0_on    },
+  { "adcmeter",   rxa_adcmeter,   0              },
+  { "bpsnbain0",  rxa_bpsnbain0,  rxa_bpsnba0_on },
+  { "nbp0",       rxa_nbp0,       rxa_nbp0_on    },
+  { "smeter",     rxa_smeter,     0              },
+  { "sender",     rxa_sender,     rxa_sender_on  },
+  { "amsqcap",    rxa_amsqcap,    rxa_amsq_on    },
+  { "bpsnbaout0", rxa_bpsnbaout0, rxa_bpsnba0_on },
+  { "amd",        rxa_amd,        rxa_amd_on     },
+  { "fmd",        rxa_fmd,        rxa_fmd_on     },
+  { "fmsq",       rxa_fmsq,       rxa_fmsq_on    },
+  { "bpsnbain1",  rxa_bpsnbain1,  rxa_bpsnba1_on },
+  { "bpsnbaout1", rxa_bpsnbaout1, rxa_bpsnba1_on },
+  { "snba",       rxa_snba,       rxa_snba_on    },
+  { "eqp",        rxa_eqp,        rxa_eqp_on     },
+  { "anf0",       rxa_anf0,       rxa_anf0_on    },
+  { "anr0",       rxa_anr0,       rxa_anr0_on    },
+  { "emnr0",      rxa_emnr0,      rxa_emnr0_on   },
+  { "bp1_0",      rxa_bp1_0,      rxa_bp1_0_on   },
+  { "agc",        rxa_agc,        rxa_agc_on     },
+  { "anf1",       rxa_anf1,       rxa_anf1_on    },
+  { "anr1",       rxa_anr1,       rxa_anr1_on    },
+  { "emnr1",      rxa_emnr1,      rxa_emnr1_on   },
+  { "bp1_1",      rxa_bp1_1,      rxa_bp1_1_on   },
+  { "agcmeter",   rxa_agcmeter,   0              },
+  { "sip1",       rxa_sip1,       0              },
+  { "cbl",        rxa_cbl,        rxa_cbl_on     },
+  { "speak",      rxa_speak,      rxa_speak_on   },
+  { "mpeak",      rxa_mpeak,      rxa_mpeak_on   },
+  { "ssql",       rxa_ssql,       rxa_ssql_on    },
+  { "panel",      rxa_panel,      0              },
+  { "amsq",       rxa_amsq,       rxa_amsq_on    },
+  { "rsmpout",    rxa_rsmpout,    rxa_rsmpout_on }
+};
+
+#define RXA_NSTAGES ((int)(sizeof (rxa_stages) / sizeof (rxa_stages[0])))
+
 void create_rxa (int channel) {
   rxa[channel].mode = RXA_LSB;
   rxa[channel].inbuff  = (double *) malloc0 (1 * ch[channel].dsp_insize  * sizeof (complex));
@@ -454,11 +572,14 @@ void create_rxa (int channel) {
                              0.0,                      // select cutoff automatically
                              0,                        // select ncoef automatically
                              1.0);                     // gain
+  // stage pipeline, composed by RXAResCheck
+  rxa[channel].pipe.p = create_pipeline (channel, rxa_stages, RXA_NSTAGES);
   // turn OFF / ON resamplers as needed
   RXAResCheck (channel);
 }
 
 void destroy_rxa (int channel) {
+  destroy_pipeline (rxa[channel].pipe.p);
   destroy_resample (rxa[channel].rsmpout.p);
   destroy_panel (rxa[channel].panel.p);
   destroy_ssql (rxa[channel].ssql.p);
@@ -526,41 +647,11 @@ void flush_rxa (int channel) {
 }
 
 void xrxa (int channel) {
-  xshift (rxa[channel].shift.p);
-  xresample (rxa[channel].rsmpin.p);
-  xgen (rxa[channel].gen0.p);
-  xmeter (rxa[channel].adcmeter.p);
-  xbpsnbain (rxa[channel].bpsnba.p, 0);
-  xnbp (rxa[channel].nbp0.p, 0);
-  xmeter (rxa[channel].smeter.p);
-  xsender (rxa[channel].sender.p);
-  xamsqcap (rxa[channel].amsq.p);
-  xbpsnbaout (rxa[channel].bpsnba.p, 0);
-  xamd (rxa[channel].amd.p);
-  xfmd (rxa[channel].fmd.p);
-  xfmsq (rxa[channel].fmsq.p);
-  xbpsnbain (rxa[channel].bpsnba.p, 1);
-  xbpsnbaout (rxa[channel].bpsnba.p, 1);
-  xsnba (rxa[channel].snba.p);
-  xeqp (rxa[channel].eqp.p);
-  xanf (rxa[channel].anf.p, 0);
-  xanr (rxa[channel].anr.p, 0);
-  xemnr (rxa[channel].emnr.p, 0);
-  xbandpass (rxa[channel].bp1.p, 0);
-  xwcpagc (rxa[channel].agc.p);
-  xanf (rxa[channel].anf.p, 1);
-  xanr (rxa[channel].anr.p, 1);
-  xemnr (rxa[channel].emnr.p, 1);
-  xbandpass (rxa[channel].bp1.p, 1);
-  xmeter (rxa[channel].agcmeter.p);
-  xsiphon (rxa[channel].sip1.p, 0);
-  xcbl (rxa[channel].cbl.p);
-  xspeak (rxa[channel].speak.p);
-  xmpeak (rxa[channel].mpeak.p);
-  xssql (rxa[channel].ssql.p);
-  xpanel (rxa[channel].panel.p);
-  xamsq (rxa[channel].amsq.p);
-  xresample (rxa[channel].rsmpout.p);
+  if (_InterlockedAnd (&rxa[channel].pipe.p->dirty, 1)) {
+    build_pipeline (rxa[channel].pipe.p);
+  }
+
+  xpipeline (rxa[channel].pipe.p);
 }
 
 void setInputSamplerate_rxa (int channel) {
@@ -699,6 +790,7 @@ void setDSPBuffsize_rxa (int channel) {
   // output resampler
   setBuffers_resample (rxa[channel].rsmpout.p, rxa[channel].midbuff, rxa[channel].outbuff);
   setSize_resample (rxa[channel].rsmpout.p, ch[channel].dsp_size);
+  RXAResCheck (channel);
 }
 
 /********************************************************************************************************
@@ -760,6 +852,17 @@ void RXAResCheck (int channel) {
 
   if (ch[channel].dsp_rate != ch[channel].out_rate) { a->run = 1; }
   else { a->run = 0; }
+
+  // without a resampler, the pipeline's input resp. output is midbuff itself
+  rxa[channel].pipein  = rxa[channel].rsmpin.p->run  ? rxa[channel].inbuff  : rxa[channel].midbuff;
+  rxa[channel].pipeout = rxa[channel].rsmpout.p->run ? rxa[channel].outbuff : rxa[channel].midbuff;
+  setBuffers_shift (rxa[channel].shift.p, rxa[channel].pipein, rxa[channel].pipein);
+  RXAPipeCheck (channel);
+}
+
+void RXAPipeCheck (int channel) {
+  // re-compose the pipeline before the next buffer
+  InterlockedBitTestAndSet (&rxa[channel].pipe.p->dirty, 0);
 }
 
 void RXAbp1Check (int channel, int amd_run, int snba_run,
@@ -793,6 +896,7 @@ void RXAbp1Set (int channel) {
   if (!old && a->run) { flush_bandpass (a); }
 
   setUpdate_fircore (a->p);
+  RXAPipeCheck (channel);
 }
 
 void RXAbpsnbaCheck (int channel, int mode, int notch_run) {
@@ -890,6 +994,7 @@ void RXAbpsnbaSet (int channel) {
   }
 
   setUpdate_fircore (a->bpsnba->p);
+  RXAPipeCheck (channel);
 }
 
 /********************************************************************************************************
@@ -927,4 +1032,43 @@ void RXASetMP (int channel, int mp) {
   SetRXAFMSQMP        (channel, mp);
   SetRXAFMMPde        (channel, mp);
   SetRXAFMMPaud       (channel, mp);
-}
\ No newline at end of file
+}
+/********************************************************************************************************
+*                                                   *
+*                      RXA Stage Timing                         *
+*                                                   *
+********************************************************************************************************/
+
+PORT
+int GetRXAStageCount (void) {
+  return RXA_NSTAGES;
+}
+
+PORT
+const char* GetRXAStageName (int stage) {
+  if (stage < 0 || stage >= RXA_NSTAGES) { return ""; }
+
+  return rxa_stages[stage].name;
+}
+
+PORT
+void SetRXAStageTiming (int channel, int run) {
+  EnterCriticalSection (&ch[channel].csDSP);
+  reset_pipeline_times (rxa[channel].pipe.p);
+  rxa[channel].pipe.p->timing = run;
+  LeaveCriticalSection (&ch[channel].csDSP);
+}
+
+PORT
+void GetRXAStageTimes (int channel, double* us, double* peak_us, int* active) {
+  // us[], peak_us[] and active[] must hold GetRXAStageCount() entries;
+  // does not take csDSP, so it does not wait for the buffer being processed
+  get_pipeline_times (rxa[channel].pipe.p, us, peak_us, active);
+}
+
+PORT
+void ResetRXAStageTimes (int channel) {
+  EnterCriticalSection (&ch[channel].csDSP);
+  reset_pipeline_times (rxa[channel].pipe.p);
+  LeaveCriticalSection (&ch[channel].csDSP);
+}
@@ -58,6 +58,8 @@ struct _rxa {
   double* inbuff;
   double* outbuff;
   double* midbuff;
+  double* pipein;     // inbuff, or midbuff when the input resampler is not needed
+  double* pipeout;    // outbuff, or midbuff when the output resampler is not needed
   int mode;
   double meter[RXA_METERTYPE_LAST];
   CRITICAL_SECTION* pmtupdate[RXA_METERTYPE_LAST];
@@ -136,6 +138,9 @@ struct _rxa {
   struct {
     SSQL p;
   } ssql;
+  struct {
+    PIPELINE p;
+  } pipe;
 };
 
 extern struct _rxa rxa[];
@@ -162,6 +167,8 @@ extern __declspec (dllexport) void SetRXAMode (int channel, int mode);
 
 extern void RXAResCheck (int channel);
 
+extern void RXAPipeCheck (int channel);
+
 extern void RXAbp1Check (int channel, int amd_run, int snba_run, int emnr_run, int anf_run, int anr_run);
 
 extern void RXAbp1Set (int channel);
@@ -170,4 +177,16 @@ extern void RXAbpsnbaCheck (int channel, int mode, int notch_run);
 
 extern void RXAbpsnbaSet (int channel);
 
+// Stage Timing
+
+extern __declspec (dllexport) int GetRXAStageCount (void);
+
+extern __declspec (dllexport) const char* GetRXAStageName (int stage);
+
+extern __declspec (dllexport) void SetRXAStageTiming (int channel, int run);
+
+extern __declspec (dllexport) void GetRXAStageTimes (int channel, double* us, double* peak_us, int* active);
+
+extern __declspec (dllexport) void ResetRXAStageTimes (int channel);
+
 #endif
\ No newline at end of file
@@ -28,6 +28,112 @@ warren@wpratt.com
 
 struct _txa txa[MAX_CHANNELS];
 
+/********************************************************************************************************
+*                                                   *
+*                       TXA Stages                          *
+*                                                   *
+********************************************************************************************************/
+
+static void txa_rsmpin (int channel)     { xresample (txa[channel].rsmpin.p); }
+static void txa_gen0 (int channel)       { xgen (txa[channel].gen0.p); }
+static void txa_panel (int channel)      { xpanel (txa[channel].panel.p); }
+static void txa_phrot (int channel)      { xphrot (txa[channel].phrot.p); }
+static void txa_micmeter (int channel)   { xmeter (txa[channel].micmeter.p); }
+static void txa_amsqcap (int channel)    { xamsqcap (txa[channel].amsq.p); }
+static void txa_amsq (int channel)       { xamsq (txa[channel].amsq.p); }
+static void txa_eqp (int channel)        { xeqp (txa[channel].eqp.p); }
+static void txa_eqmeter (int channel)    { xmeter (txa[channel].eqmeter.p); }
+static void txa_preemph0 (int channel)   { xemphp (txa[channel].preemph.p, 0); }
+static void txa_leveler (int channel)    { xwcpagc (txa[channel].leveler.p); }
+static void txa_lvlrmeter (int channel)  { xmeter (txa[channel].lvlrmeter.p); }
+static void txa_cfcomp (int channel)     { xcfcomp (txa[channel].cfcomp.p, 0); }
+static void txa_cfcmeter (int channel)   { xmeter (txa[channel].cfcmeter.p); }
+static void txa_bp0 (int channel)        { xbandpass (txa[channel].bp0.p, 0); }
+static void txa_compressor (int channel) { xcompressor (txa[channel].compressor.p); }
+static void txa_bp1 (int channel)        { xbandpass (txa[channel].bp1.p, 0); }
+static void txa_osctrl (int channel)     { xosctrl (txa[channel].osctrl.p); }
+static void txa_bp2 (int channel)        { xbandpass (txa[channel].bp2.p, 0); }
+static void txa_compmeter (int channel)  { xmeter (txa[channel].compmeter.p); }
+static void txa_alc (int channel)        { xwcpagc (txa[channel].alc.p); }
+static void txa_ammod (int channel)      { xammod (txa[channel].ammod.p); }
+static void txa_preemph1 (int channel)   { xemphp (txa[channel].preemph.p, 1); }
+static void txa_fmmod (int channel)      { xfmmod (txa[channel].fmmod.p); }
+static void txa_gen1 (int channel)       { xgen (txa[channel].gen1.p); }
+static void txa_uslew (int channel)      { xuslew (txa[channel].uslew.p); }
+static void txa_alcmeter (int channel)   { xmeter (txa[channel].alcmeter.p); }
+static void txa_sip1 (int channel)       { xsiphon (txa[channel].sip1.p, 0); }
+static void txa_iqc (int channel)        { xiqc (txa[channel].iqc.p0); }
+static void txa_cfir (int channel)       { xcfir (txa[channel].cfir.p); }
+static void txa_rsmpout (int channel)    { xresample (txa[channel].rsmpout.p); }
+static void txa_outmeter (int channel)   { xmeter (txa[channel].outmeter.p); }
+
+//
+// A stage whose block is switched off only copies its input to its output. All
+// of them work in place on midbuff (the resamplers are bypassed by TXAResCheck),
+// so these can be left out of the pipeline.
+//
+static int txa_rsmpin_on (int channel)     { return txa[channel].rsmpin.p->run; }
+static int txa_gen0_on (int channel)       { return txa[channel].gen0.p->run; }
+static int txa_phrot_on (int channel)      { return txa[channel].phrot.p->run || txa[channel].phrot.p->reverse; }
+static int txa_amsq_on (int channel)       { return txa[channel].amsq.p->run; }
+static int txa_eqp_on (int channel)        { return txa[channel].eqp.p->run; }
+static int txa_preemph0_on (int channel)   { return txa[channel].preemph.p->run && txa[channel].preemph.p->position == 0; }
+static int txa_leveler_on (int channel)    { return txa[channel].leveler.p->run; }
+static int txa_cfcomp_on (int channel)     { return txa[channel].cfcomp.p->run && txa[channel].cfcomp.p->position == 0; }
+static int txa_bp0_on (int channel)        { return txa[channel].bp0.p->run && txa[channel].bp0.p->position == 0; }
+static int txa_compressor_on (int channel) { return txa[channel].compressor.p->run; }
+static int txa_bp1_on (int channel)        { return txa[channel].bp1.p->run && txa[channel].bp1.p->position == 0; }
+static int txa_osctrl_on (int channel)     { return txa[channel].osctrl.p->run; }
+static int txa_bp2_on (int channel)        { return txa[channel].bp2.p->run && txa[channel].bp2.p->position == 0; }
+static int txa_alc_on (int channel)        { return txa[channel].alc.p->run; }
+static int txa_ammod_on (int channel)      { return txa[channel].ammod.p->run; }
+static int txa_preemph1_on (int channel)   { return txa[channel].preemph.p->run && txa[channel].preemph.p->position == 1; }
+static int txa_fmmod_on (int channel)      { return txa[channel].fmmod.p->run; }
+static int txa_gen1_on (int channel)       { return txa[channel].gen1.p->run; }
+static int txa_cfir_on (int channel)       { return txa[channel].cfir.p->run; }
+static int txa_rsmpout_on (int channel)    { return txa[channel].rsmpout.p->run; }
+
+//
+// The panel (MIC gain), the meters, up-slew, the siphon and the PureSignal
+// correction always run
+//
+static const pipestage txa_stages[] = {
+  { "rsmpin",     txa_rsmpin,     txa_rsmpin_on     },
+  { "gen0",       txa_gen0,       txa_gen0_on       },
+  { "panel",      txa_panel,      0                 },
+  { "phrot",      txa_phrot,      txa_phrot_on      },
+  { "micmeter",   txa_micmeter,   0                 },
+  { "amsqcap",    txa_amsqcap,    txa_amsq_on       },
+  { "amsq",       txa_amsq,       txa_amsq_on       },
+  { "eqp",        txa_eqp,        txa_eqp_on        },
+  { "eqmeter",    txa_eqmeter,    0                 },
+  { "preemph0",   txa_preemph0,   txa_preemph0_on   },
+  { "leveler",    txa_leveler,    txa_leveler_on    },
+  { "lvlrmeter",  txa_lvlrmeter,  0                 },
+  { "cfcomp",     txa_cfcomp,     txa_cfcomp_on     },
+  { "cfcmeter",   txa_cfcmeter,   0                 },
+  { "bp0",        txa_bp0,        txa_bp0_on        },
+  { "compressor", txa_compressor, txa_compressor_on },
+  { "bp1",        txa_bp1,        txa_bp1_on        },
+  { "osctrl",     txa_osctrl,     txa_osctrl_on     },
+  { "bp2",        txa_bp2,        txa_bp2_on        },
+  { "compmeter",  txa_compmeter,  0                 },
+  { "alc",        txa_alc,        txa_alc_on        },
+  { "ammod",      txa_ammod,      txa_ammod_on      },
+  { "preemph1",   txa_preemph1,   txa_preemph1_on   },
+  { "fmmod",      txa_fmmod,      txa_fmmod_on      },
+  { "gen1",       txa_gen1,       txa_gen1_on       },
+  { "uslew",      txa_uslew,      0                 },
+  { "alcmeter",   txa_alcmeter,   0                 },
+  { "sip1",       txa_sip1,       0                 },
+  { "iqc",        txa_iqc,        0                 },
+  { "cfir",       txa_cfir,       txa_cfir_on       },
+  { "rsmpout",    txa_rsmpout,    txa_rsmpout_on    },
+  { "outmeter",   txa_outmeter,   0                 }
+};
+
+#define TXA_NSTAGES ((int)(sizeof (txa_stages) / sizeof (txa_stages[0])))
+
 void create_txa (int channel) {
   txa[channel].mode   = TXA_LSB;
   txa[channel].f_low  = -5000.0;
@@ -440,12 +546,15 @@ void create_txa (int channel) {
                               TXA_OUT_PK,                 // index for peak value
                               -1,                     // index for gain value
                               0);                     // pointer for gain computation
+  // stage pipeline, composed by TXAResCheck
+  txa[channel].pipe.p = create_pipeline (channel, txa_stages, TXA_NSTAGES);
   // turn OFF / ON resamplers as needed
   TXAResCheck (channel);
 }
 
 void destroy_txa (int channel) {
   // in reverse order, free each item we created
+  destroy_pipeline (txa[channel].pipe.p);
   destroy_meter (txa[channel].outmeter.p);
   destroy_resample (txa[channel].rsmpout.p);
   destroy_cfir(txa[channel].cfir.p);
@@ -519,38 +628,11 @@ void flush_txa (int channel) {
 }
 
 void xtxa (int channel) {
-  xresample (txa[channel].rsmpin.p);        // input resampler
-  xgen (txa[channel].gen0.p);           // input signal generator
-  xpanel (txa[channel].panel.p);          // includes MIC gain
-  xphrot (txa[channel].phrot.p);          // phase rotator
-  xmeter (txa[channel].micmeter.p);       // MIC meter
-  xamsqcap (txa[channel].amsq.p);         // downward expander capture
-  xamsq (txa[channel].amsq.p);          // downward expander action
-  xeqp (txa[channel].eqp.p);            // pre-EQ
-  xmeter (txa[channel].eqmeter.p);        // EQ meter
-  xemphp (txa[channel].preemph.p, 0);       // FM pre-emphasis (first option)
-  xwcpagc (txa[channel].leveler.p);       // Leveler
-  xmeter (txa[channel].lvlrmeter.p);        // Leveler Meter
-  xcfcomp (txa[channel].cfcomp.p, 0);       // Continuous Frequency Compressor with post-EQ
-  xmeter (txa[channel].cfcmeter.p);       // CFC+PostEQ Meter
-  xbandpass (txa[channel].bp0.p, 0);        // primary bandpass filter
-  xcompressor (txa[channel].compressor.p);    // COMP compressor
-  xbandpass (txa[channel].bp1.p, 0);        // aux bandpass (runs if COMP)
-  xosctrl (txa[channel].osctrl.p);        // CESSB Overshoot Control
-  xbandpass (txa[channel].bp2.p, 0);        // aux bandpass (runs if CESSB)
-  xmeter (txa[channel].compmeter.p);        // COMP meter
-  xwcpagc (txa[channel].alc.p);         // ALC
-  xammod (txa[channel].ammod.p);          // AM Modulator
-  xemphp (txa[channel].preemph.p, 1);       // FM pre-emphasis (second option)
-  xfmmod (txa[channel].fmmod.p);          // FM Modulator
-  xgen (txa[channel].gen1.p);           // output signal generator (TUN and Two-tone)
-  xuslew (txa[channel].uslew.p);          // up-slew for AM, FM, and gens
-  xmeter (txa[channel].alcmeter.p);       // ALC Meter
-  xsiphon (txa[channel].sip1.p, 0);       // siphon data for display
-  xiqc (txa[channel].iqc.p0);           // PureSignal correction
-  xcfir(txa[channel].cfir.p);           // compensating FIR filter (used Protocol_2 only)
-  xresample (txa[channel].rsmpout.p);       // output resampler
-  xmeter (txa[channel].outmeter.p);       // output meter
+  if (_InterlockedAnd (&txa[channel].pipe.p->dirty, 1)) {
+    build_pipeline (txa[channel].pipe.p);
+  }
+
+  xpipeline (txa[channel].pipe.p);
   // print_peak_env ("env_exception.txt", ch[channel].dsp_outsize, txa[channel].outbuff, 0.7);
 }
 
@@ -574,11 +656,11 @@ void setOutputSamplerate_txa (int channel) {
   // output resampler
   setBuffers_resample (txa[channel].rsmpout.p, txa[channel].midbuff, txa[channel].outbuff);
   setOutRate_resample (txa[channel].rsmpout.p, ch[channel].out_rate);
-  TXAResCheck (channel);
   // output meter
   setBuffers_meter (txa[channel].outmeter.p, txa[channel].outbuff);
   setSize_meter (txa[channel].outmeter.p, ch[channel].dsp_outsize);
   setSamplerate_meter (txa[channel].outmeter.p, ch[channel].out_rate);
+  TXAResCheck (channel);
 }
 
 void setDSPSamplerate_txa (int channel) {
@@ -622,10 +704,10 @@ void setDSPSamplerate_txa (int channel) {
   // output resampler
   setBuffers_resample (txa[channel].rsmpout.p, txa[channel].midbuff, txa[channel].outbuff);
   setInRate_resample (txa[channel].rsmpout.p, ch[channel].dsp_rate);
-  TXAResCheck (channel);
   // output meter
   setBuffers_meter (txa[channel].outmeter.p, txa[channel].outbuff);
   setSize_meter (txa[channel].outmeter.p, ch[channel].dsp_outsize);
+  TXAResCheck (channel);
 }
 
 void setDSPBuffsize_txa (int channel) {
@@ -700,6 +782,7 @@ void setDSPBuffsize_txa (int channel) {
   // output meter
   setBuffers_meter (txa[channel].outmeter.p, txa[channel].outbuff);
   setSize_meter (txa[channel].outmeter.p, ch[channel].dsp_outsize);
+  TXAResCheck (channel);
 }
 
 /********************************************************************************************************
@@ -775,6 +858,17 @@ void TXAResCheck (int channel) {
 
   if (ch[channel].dsp_rate != ch[channel].out_rate) { a->run = 1; }
   else { a->run = 0; }
+
+  // without a resampler, the pipeline's input resp. output is midbuff itself
+  txa[channel].pipein  = txa[channel].rsmpin.p->run  ? txa[channel].inbuff  : txa[channel].midbuff;
+  txa[channel].pipeout = txa[channel].rsmpout.p->run ? txa[channel].outbuff : txa[channel].midbuff;
+  setBuffers_meter (txa[channel].outmeter.p, txa[channel].pipeout);
+  TXAPipeCheck (channel);
+}
+
+void TXAPipeCheck (int channel) {
+  // re-compose the pipeline before the next buffer
+  InterlockedBitTestAndSet (&txa[channel].pipe.p->dirty, 0);
 }
 
 int TXAUslewCheck (int channel) {
@@ -861,6 +955,8 @@ void TXASetupBPFilters (int channel) {
 
     break;
   }
+
+  TXAPipeCheck (channel);
 }
 
 /********************************************************************************************************
@@ -893,3 +989,43 @@ void SetTXAFMAFFilter (int channel, double low, double high) {
   SetTXAFMPreEmphFreqs (channel, low, high);
   SetTXAFMAFFreqs (channel, low, high);
 }
+
+/********************************************************************************************************
+*                                                   *
+*                      TXA Stage Timing                         *
+*                                                   *
+********************************************************************************************************/
+
+PORT
+int GetTXAStageCount (void) {
+  return TXA_NSTAGES;
+}
+
+PORT
+const char* GetTXAStageName (int stage) {
+  if (stage < 0 || stage >= TXA_NSTAGES) { return ""; }
+
+  return txa_stages[stage].name;
+}
+
+PORT
+void SetTXAStageTiming (int channel, int run) {
+  EnterCriticalSection (&ch[channel].csDSP);
+  reset_pipeline_times (txa[channel].pipe.p);
+  txa[channel].pipe.p->timing = run;
+  LeaveCriticalSection (&ch[channel].csDSP);
+}
+
+PORT
+void GetTXAStageTimes (int channel, double* us, double* peak_us, int* active) {
+  // us[], peak_us[] and active[] must hold GetTXAStageCount() entries;
+  // does not take csDSP, so it does not wait for the buffer being processed
+  get_pipeline_times (txa[channel].pipe.p, us, peak_us, active);
+}
+
+PORT
+void ResetTXAStageTimes (int channel) {
+  EnterCriticalSection (&ch[channel].csDSP);
+  reset_pipeline_times (txa[channel].pipe.p);
+  LeaveCriticalSection (&ch[channel].csDSP);
+}
@@ -70,6 +70,8 @@ struct _txa {
   double* inbuff;
   double* outbuff;
   double* midbuff;
+  double* pipein;     // inbuff, or midbuff when the input resampler is not needed
+  double* pipeout;    // outbuff, or midbuff when the output resampler is not needed
   int mode;
   double f_low;
   double f_high;
@@ -137,6 +139,9 @@ struct _txa {
   struct {
     CFIR p;
   } cfir;
+  struct {
+    PIPELINE p;
+  } pipe;
 };
 
 extern struct _txa txa[];
@@ -165,6 +170,20 @@ extern __declspec (dllexport) void SetTXAMode (int channel, int mode);
 
 extern void TXAResCheck (int channel);
 
+extern void TXAPipeCheck (int channel);
+
 extern void TXASetupBPFilters (int channel);
 
+// Stage Timing
+
+extern __declspec (dllexport) int GetTXAStageCount (void);
+
+extern __declspec (dllexport) const char* GetTXAStageName (int stage);
+
+extern __declspec (dllexport) void SetTXAStageTiming (int channel, int run);
+
+extern __declspec (dllexport) void GetTXAStageTimes (int channel, double* us, double* peak_us, int* active);
+
+extern __declspec (dllexport) void ResetTXAStageTimes (int channel);
+
 #endif
\ No newline at end of file
@@ -213,12 +213,16 @@ PORT
 void SetRXAAMSQRun (int channel, int run) {
   EnterCriticalSection (&ch[channel].csDSP);
   rxa[channel].amsq.p->run = run;
+  RXAPipeCheck (channel);
   LeaveCriticalSection (&ch[channel].csDSP);
 }
 
 PORT
 void SetRXAAMSQThreshold (int channel, double threshold) {
   double thresh = pow (10.0, threshold / 20.0);
+
+  if (queue_cmdD (channel, SetRXAAMSQThreshold, threshold)) { return; }
+
   EnterCriticalSection (&ch[channel].csDSP);
   rxa[channel].amsq.p->tail_thresh = 0.9 * thresh;
   rxa[channel].amsq.p->unmute_thresh =  thresh;
@@ -247,6 +251,7 @@ PORT
 void SetTXAAMSQRun (int channel, int run) {
   EnterCriticalSection (&ch[channel].csDSP);
   txa[channel].amsq.p->run = run;
+  TXAPipeCheck (channel);
   LeaveCriticalSection (&ch[channel].csDSP);
 }
 
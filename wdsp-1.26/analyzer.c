@@ -226,14 +226,14 @@ void eliminate(int disp, int ss, int LO) {
 
   if (a->flip[LO])
     for (i = ilim - begin, k = 0; i > ilim - end; i--, k++) {
-      mag = (a->fft_out[ss][LO])[i][0] * (a->fft_out[ss][LO])[i][0] + (a->fft_out[ss][LO])[i][1] * (a->fft_out[ss][LO])[i][1];
+      mag = (double)(a->fft_out[ss][LO])[i][0] * (a->fft_out[ss][LO])[i][0] + (double)(a->fft_out[ss][LO])[i][1] * (a->fft_out[ss][LO])[i][1];
 
       if ((a->spec_flag[ss] == 0) || (mag < (a->result[ss])[k])) {
         (a->result[ss])[k] = mag;
       }
     } else
     for (i = begin, k = 0; i < end; i++, k++) {
-      mag = (a->fft_out[ss][LO])[i][0] * (a->fft_out[ss][LO])[i][0] + (a->fft_out[ss][LO])[i][1] * (a->fft_out[ss][LO])[i][1];
+      mag = (double)(a->fft_out[ss][LO])[i][0] * (a->fft_out[ss][LO])[i][0] + (double)(a->fft_out[ss][LO])[i][1] * (a->fft_out[ss][LO])[i][1];
 
       if ((a->spec_flag[ss] == 0) || (mag < (a->result[ss])[k])) {
         (a->result[ss])[k] = mag;
@@ -279,7 +279,7 @@ void Celiminate(int disp, int ss, int LO) {
 
   if (a->flip[LO]) {
     for (i = ilim - begin0, k = 0; i > ilim - end0; i--, k++) {
-      mag = (a->fft_out[ss][LO])[i][0] * (a->fft_out[ss][LO])[i][0] + (a->fft_out[ss][LO])[i][1] * (a->fft_out[ss][LO])[i][1];
+      mag = (double)(a->fft_out[ss][LO])[i][0] * (a->fft_out[ss][LO])[i][0] + (double)(a->fft_out[ss][LO])[i][1] * (a->fft_out[ss][LO])[i][1];
 
       if ((a->spec_flag[ss] == 0) || (mag < (a->result[ss])[k])) {
         (a->result[ss])[k] = mag;
@@ -287,7 +287,7 @@ void Celiminate(int disp, int ss, int LO) {
     }
 
     for (i = ilim - begin1; i > ilim - end1; i--, k++) {
-      mag = (a->fft_out[ss][LO])[i][0] * (a->fft_out[ss][LO])[i][0] + (a->fft_out[ss][LO])[i][1] * (a->fft_out[ss][LO])[i][1];
+      mag = (double)(a->fft_out[ss][LO])[i][0] * (a->fft_out[ss][LO])[i][0] + (double)(a->fft_out[ss][LO])[i][1] * (a->fft_out[ss][LO])[i][1];
 
       if ((a->spec_flag[ss] == 0) || (mag < (a->result[ss])[k])) {
         (a->result[ss])[k] = mag;
@@ -295,7 +295,7 @@ void Celiminate(int disp, int ss, int LO) {
     }
   } else {
     for (i = begin0, k = 0; i < end0; i++, k++) {
-      mag = (a->fft_out[ss][LO])[i][0] * (a->fft_out[ss][LO])[i][0] + (a->fft_out[ss][LO])[i][1] * (a->fft_out[ss][LO])[i][1];
+      mag = (double)(a->fft_out[ss][LO])[i][0] * (a->fft_out[ss][LO])[i][0] + (double)(a->fft_out[ss][LO])[i][1] * (a->fft_out[ss][LO])[i][1];
 
       if ((a->spec_flag[ss] == 0) || (mag < (a->result[ss])[k])) {
         (a->result[ss])[k] = mag;
@@ -303,7 +303,7 @@ void Celiminate(int disp, int ss, int LO) {
     }
 
     for (i = begin1; i < end1; i++, k++) {
-      mag = (a->fft_out[ss][LO])[i][0] * (a->fft_out[ss][LO])[i][0] + (a->fft_out[ss][LO])[i][1] * (a->fft_out[ss][LO])[i][1];
+      mag = (double)(a->fft_out[ss][LO])[i][0] * (a->fft_out[ss][LO])[i][0] + (double)(a->fft_out[ss][LO])[i][1] * (a->fft_out[ss][LO])[i][1];
 
       if ((a->spec_flag[ss] == 0) || (mag < (a->result[ss])[k])) {
         (a->result[ss])[k] = mag;
@@ -653,6 +653,17 @@ void stitch(int disp) {
   }
 }
 
+//
+// Make the dispatcher thread look for work. Called when new input samples
+// are available, and when all ffts of a frame are done (input_busy reset).
+//
+static void wake_dispatcher(DP a) {
+  EnterCriticalSection(&a->DispatchSection);
+  a->dispatch_pending = 1;
+  WakeConditionVariable(&a->DispatchCond);
+  LeaveCriticalSection(&a->DispatchSection);
+}
+
 DWORD WINAPI spectra (void *pargs) {
   int i, j;
   int disp = ((int)(uintptr_t)pargs) >> 12;
@@ -679,7 +690,8 @@ DWORD WINAPI spectra (void *pargs) {
       return 0;
     }
 
-    fftw_execute (a->plan[ss][LO]);
+    FFTW(execute) (a->plan[ss][LO]);
+    InterlockedIncrement(&a->fft_count);
   }
 
   if (a->stop) {
@@ -704,13 +716,19 @@ DWORD WINAPI spectra (void *pargs) {
     if (a->stitch_flag == ((((uint64_t)1) << a->num_stitch) - 1)) {
       a->stitch_flag = 0;
       LeaveCriticalSection(&a->StitchSection);
+      //
+      // The ffts may run in parallel in the worker pool, so the input
+      // buffers are only released after stitching, such that new ffts
+      // do not overwrite the results while they are being stitched.
+      //
+      stitch(disp);
 
       for (j = 0; j < dMAX_STITCH; j++)
         for (i = 0; i < dMAX_NUM_FFT; i++) {
           InterlockedBitTestAndReset(&(a->input_busy[j][i]), 0);
         }
 
-      stitch(disp);
+      wake_dispatcher(a);
     } else {
       LeaveCriticalSection(&a->StitchSection);
     }
@@ -839,18 +857,18 @@ void DetectMaxBin(int disp, int ss, int LO) {
 
   // If 'run' is set and the FFT Output is from the correct disp, ss, LO ...
   if (a->dmb_run && disp == a->dmb_disp && ss == a->dmb_ss && LO == a->dmb_LO) {
-    fftw_complex* fft_out = a->fft_out[ss][LO];
+    FFTW(complex)* fft_out = a->fft_out[ss][LO];
     dmb_max = 1.0e-60;
     EnterCriticalSection(&a->cs_dmb);
 
     for (i = a->dmb_begin0; i <= a->dmb_end0; i++) {
-      mag = fft_out[i][0] * fft_out[i][0] + fft_out[i][1] * fft_out[i][1];
+      mag = (double)fft_out[i][0] * fft_out[i][0] + (double)fft_out[i][1] * fft_out[i][1];
 
       if (mag > dmb_max) { dmb_max = mag; }
     }
 
     for (i = a->dmb_begin1; i <= a->dmb_end1; i++) {
-      mag = fft_out[i][0] * fft_out[i][0] + fft_out[i][1] * fft_out[i][1];
+      mag = (double)fft_out[i][0] * fft_out[i][0] + (double)fft_out[i][1] * fft_out[i][1];
 
       if (mag > dmb_max) { dmb_max = mag; }
     }
@@ -890,7 +908,6 @@ DWORD WINAPI Cspectra (void *pargs) {
   int ss = (((int)(uintptr_t)pargs) >> 4) & 255;
   int LO = ((int)(uintptr_t)pargs) & 15;
   DP a = pdisp[disp];
-  int trans_size = a->size * sizeof(double);
 
   if (a->stop) {
     InterlockedDecrement(a->pnum_threads);
@@ -912,7 +929,8 @@ DWORD WINAPI Cspectra (void *pargs) {
       return 0;
     }
 
-    fftw_execute (a->Cplan[ss][LO]);
+    FFTW(execute) (a->Cplan[ss][LO]);
+    InterlockedIncrement(&a->fft_count);
     // Detect value of Max FFT Bin in a freq range
     DetectMaxBin(disp, ss, LO);
     //
@@ -924,8 +942,14 @@ DWORD WINAPI Cspectra (void *pargs) {
   }
 
   if (InterlockedBitTestAndReset(&(a->snap[ss][LO]), 0)) {
-    memcpy((char *)(a->snap_buff[ss][LO]), (char *)(a->fft_out[ss][LO]) + trans_size, trans_size);
-    memcpy((char *)(a->snap_buff[ss][LO]) + trans_size, (char *)(a->fft_out[ss][LO]), trans_size);
+    // swap halves, the fft output may be single precision
+    const FFTREAL* fft_out = (FFTREAL *)a->fft_out[ss][LO];
+
+    for (i = 0; i < a->size; i++) {
+      (a->snap_buff[ss][LO])[i] = fft_out[a->size + i];
+      (a->snap_buff[ss][LO])[a->size + i] = fft_out[i];
+    }
+
     SetEvent(a->hSnapEvent[ss][LO]);
   }
 
@@ -946,13 +970,19 @@ DWORD WINAPI Cspectra (void *pargs) {
     if (a->stitch_flag == ((((uint64_t)1) << a->num_stitch) - 1)) {
       a->stitch_flag = 0;
       LeaveCriticalSection(&a->StitchSection);
+      //
+      // The ffts may run in parallel in the worker pool, so the input
+      // buffers are only released after stitching, such that new ffts
+      // do not overwrite the results while they are being stitched.
+      //
+      stitch(disp);
 
       for (j = 0; j < dMAX_STITCH; j++)
         for (i = 0; i < dMAX_NUM_FFT; i++) {
           InterlockedBitTestAndReset(&(a->input_busy[j][i]), 0);
         }
 
-      stitch(disp);
+      wake_dispatcher(a);
     } else {
       LeaveCriticalSection(&a->StitchSection);
     }
@@ -1114,10 +1144,14 @@ void __cdecl sendbuf(void *arg) {
           a->IQO_idx[a->ss][a->LO] = a->IQout_index[a->ss][a->LO];
           InterlockedIncrement(a->pnum_threads);
 
-          if (a->type == 0) {
-            QueueUserWorkItem(spectra, (void *)(((uintptr_t)arg << 12) + (a->ss << 4) + a->LO), 0);
-          } else {
-            QueueUserWorkItem(Cspectra, (void *)(((uintptr_t)arg << 12) + (a->ss << 4) + a->LO), 0);
+          if (!QueueUserWorkItem(a->type == 0 ? (void *)spectra : (void *)Cspectra,
+                                 (void *)(((uintptr_t)arg << 12) + (a->ss << 4) + a->LO), 0)) {
+            //
+            // worker queue full: try again upon the next wake-up
+            //
+            InterlockedDecrement(a->pnum_threads);
+            InterlockedBitTestAndReset(&(a->input_busy[a->ss][a->LO]), 0);
+            continue;
           }
 
           if ((a->IQout_index[a->ss][a->LO] += a->incr) >= a->bsize) {
@@ -1134,7 +1168,19 @@ void __cdecl sendbuf(void *arg) {
         }
       }
 
-    Sleep(1);
+    //
+    // Sleep until new input arrives or ffts have completed. The time-out
+    // is only a safety net, all changes of state issue a wake-up, and a
+    // spurious wake-up only causes an additional scan.
+    //
+    EnterCriticalSection(&a->DispatchSection);
+
+    if (!a->dispatch_pending && !a->end_dispatcher) {
+      SleepConditionVariableCS(&a->DispatchCond, &a->DispatchSection, 100);
+    }
+
+    a->dispatch_pending = 0;
+    LeaveCriticalSection(&a->DispatchSection);
   }
 
   InterlockedBitTestAndReset(&a->dispatcher, 0);
@@ -1263,6 +1309,7 @@ void SetAnalyzer (  int disp,     // display identifier
   int i, j;
   EnterCriticalSection(&a->SetAnalyzerSection);
   a->end_dispatcher = 1;
+  wake_dispatcher(a);
 
   while (InterlockedAnd(&a->dispatcher, 1)) {
     Sleep(1);
@@ -1292,12 +1339,12 @@ void SetAnalyzer (  int disp,     // display identifier
   if (sz != a->size) {
     for (i = 0; i < a->max_stitch; i++)
       for (j = 0; j < a->max_num_fft; j++) {
-        if (a->plan[i][j]) { fftw_destroy_plan (a->plan[i][j]); }
+        if (a->plan[i][j]) { FFTW(destroy_plan) (a->plan[i][j]); }
 
-        if (a->Cplan[i][j]) { fftw_destroy_plan (a->Cplan[i][j]); }
+        if (a->Cplan[i][j]) { FFTW(destroy_plan) (a->Cplan[i][j]); }
 
-        a->plan[i][j] = fftw_plan_dft_r2c_1d(sz, a->fft_in[i][j], a->fft_out[i][j], FFTW_PATIENT);
-        a->Cplan[i][j] = fftw_plan_dft_1d(sz, a->Cfft_in[i][j], a->fft_out[i][j], FFTW_FORWARD, FFTW_PATIENT);
+        a->plan[i][j] = FFTW(plan_dft_r2c_1d)(sz, a->fft_in[i][j], a->fft_out[i][j], wisdom_rigor);
+        a->Cplan[i][j] = FFTW(plan_dft_1d)(sz, a->Cfft_in[i][j], a->fft_out[i][j], FFTW_FORWARD, wisdom_rigor);
       }
 
     // Setup DetectMaxBin for a 'size' change.
@@ -1425,6 +1472,8 @@ void XCreateAnalyzer( int disp,
   InitializeCriticalSectionAndSpinCount(&a->ResampleSection, 0);
   InitializeCriticalSectionAndSpinCount(&a->SetAnalyzerSection, 0);
   InitializeCriticalSectionAndSpinCount(&a->StitchSection, 0);
+  InitializeCriticalSectionAndSpinCount(&a->DispatchSection, 0);
+  InitializeConditionVariable(&a->DispatchCond);
 
   for (i = 0; i < dMAX_PIXOUTS; i++) {
     InitializeCriticalSectionAndSpinCount(&a->PB_ControlsSection[i], 0);
@@ -1448,9 +1497,9 @@ void XCreateAnalyzer( int disp,
     for (j = 0; j < a->max_num_fft; j++) {
       a->plan[i][j] = 0;
       a->Cplan[i][j] = 0;
-      a->fft_in[i][j]   = (double*) malloc0 (sizeof(double) * a->max_size);
-      a->Cfft_in[i][j]  = (fftw_complex*) fftw_malloc(sizeof(fftw_complex) * a->max_size);
-      a->fft_out[i][j]  = (fftw_complex*) fftw_malloc(sizeof(fftw_complex) * a->max_size);
+      a->fft_in[i][j]   = (FFTREAL*) malloc0 (sizeof(FFTREAL) * a->max_size);
+      a->Cfft_in[i][j]  = (FFTW(complex)*) FFTW(malloc)(sizeof(FFTW(complex)) * a->max_size);
+      a->fft_out[i][j]  = (FFTW(complex)*) FFTW(malloc)(sizeof(FFTW(complex)) * a->max_size);
     }
 
   a->pre_av_out = (double*) malloc0 (sizeof(double) * a->max_size * a->max_stitch);
@@ -1515,11 +1564,21 @@ void DestroyAnalyzer(int disp) {
   DP a = pdisp[disp];
   int i, j;
   a->end_dispatcher = 1;
+  wake_dispatcher(a);
 
   while (InterlockedAnd(&a->dispatcher, 1)) {
     Sleep(1);
   }
 
+  //
+  // ffts may still be queued in, or executed by, the worker pool
+  //
+  a->stop = 1;
+
+  while (_InterlockedAnd(a->pnum_threads, 1023)) {
+    Sleep(1);
+  }
+
   for (i = 0; i < a->max_stitch; i++)
     for (j = 0; j < a->max_num_fft; j++) {
       _aligned_free  (a->I_samples[i][j]);
@@ -1557,11 +1616,11 @@ void DestroyAnalyzer(int disp) {
 
   for (i = 0; i < a->max_stitch; i++)
     for (j = 0; j < a->max_num_fft; j++) {
-      fftw_destroy_plan (a->plan[i][j]);
-      fftw_destroy_plan (a->Cplan[i][j]);
-      fftw_free (a->Cfft_in[i][j]);
+      FFTW(destroy_plan) (a->plan[i][j]);
+      FFTW(destroy_plan) (a->Cplan[i][j]);
+      FFTW(free) (a->Cfft_in[i][j]);
       _aligned_free (a->fft_in[i][j]);
-      fftw_free (a->fft_out[i][j]);
+      FFTW(free) (a->fft_out[i][j]);
     }
 
   for (i = 0; i < a->max_stitch; i++) {
@@ -1583,6 +1642,7 @@ void DestroyAnalyzer(int disp) {
   }
 
   DeleteCriticalSection(&a->StitchSection);
+  DeleteCriticalSection(&a->DispatchSection);
   DeleteCriticalSection(&a->SetAnalyzerSection);
   DeleteCriticalSection(&a->ResampleSection);
 
@@ -1618,6 +1678,19 @@ void GetPixels  ( int disp,
   }
 }
 
+//
+// Statistics: number of ffts executed and frames dropped since the
+// analyzer has been created, and the number of ffts currently queued
+// in (or being executed by) the worker pool.
+//
+PORT
+void GetDisplayStats (int disp, long *ffts, int *queue_depth, long *dropped) {
+  DP a = pdisp[disp];
+  *ffts = a->fft_count;
+  *queue_depth = (int)*a->pnum_threads;
+  *dropped = a->dropped_frames;
+}
+
 PORT
 void SnapSpectrum(  int disp,
                     int ss,
@@ -1707,6 +1780,8 @@ void CloseBuffer(int disp, int ss, int LO) {
 
   if (a->have_samples[ss][LO] > a->max_writeahead) {
     //if we're receiving samples too much faster than we're consuming them, skip some
+    a->dropped_frames += (a->have_samples[ss][LO] - a->max_writeahead + a->incr - 1) / a->incr;
+
     if ((a->IQout_index[ss][LO] += a->have_samples[ss][LO] - a->max_writeahead) >= a->bsize) {
       a->IQout_index[ss][LO] -= a->bsize;
     }
@@ -1731,6 +1806,7 @@ void CloseBuffer(int disp, int ss, int LO) {
     _beginthread(sendbuf, 0, (void *)(uintptr_t)disp);
   } else {
     LeaveCriticalSection(&a->SetAnalyzerSection);
+    wake_dispatcher(a);
   }
 }
 
@@ -1750,6 +1826,8 @@ void Spectrum(int disp, int ss, int LO, dINREAL* pI, dINREAL* pQ) {
 
   if (a->have_samples[ss][LO] > a->max_writeahead) {
     //if we're receiving samples too much faster than we're consuming them, skip some
+    a->dropped_frames += (a->have_samples[ss][LO] - a->max_writeahead + a->incr - 1) / a->incr;
+
     if ((a->IQout_index[ss][LO] += a->have_samples[ss][LO] - a->max_writeahead) >= a->bsize) {
       a->IQout_index[ss][LO] -= a->bsize;
     }
@@ -1774,6 +1852,7 @@ void Spectrum(int disp, int ss, int LO, dINREAL* pI, dINREAL* pQ) {
     _beginthread(sendbuf, 0, (void *)(uintptr_t)disp);
   } else {
     LeaveCriticalSection(&a->SetAnalyzerSection);
+    wake_dispatcher(a);
   }
 }
 
@@ -1799,6 +1878,8 @@ void Spectrum2(int run, int disp, int ss, int LO, dINREAL* pbuff) {
 
     if (a->have_samples[ss][LO] > a->max_writeahead) {
       //if we're receiving samples too much faster than we're consuming them, skip some
+      a->dropped_frames += (a->have_samples[ss][LO] - a->max_writeahead + a->incr - 1) / a->incr;
+
       if ((a->IQout_index[ss][LO] += a->have_samples[ss][LO] - a->max_writeahead) >= a->bsize) {
         a->IQout_index[ss][LO] -= a->bsize;
       }
@@ -1823,6 +1904,7 @@ void Spectrum2(int run, int disp, int ss, int LO, dINREAL* pbuff) {
       _beginthread(sendbuf, 0, (void *)(uintptr_t)disp);
     } else {
       LeaveCriticalSection(&a->SetAnalyzerSection);
+      wake_dispatcher(a);
     }
   }
 }
@@ -1834,6 +1916,7 @@ void Spectrum0(int run, int disp, int ss, int LO, double* pbuff) {
     dINREAL *Ipointer;
     dINREAL *Qpointer;
     DP a = pdisp[disp];
+    double t0 = dspload_run ? dspload_now () : 0.0;
     EnterCriticalSection(&a->SetAnalyzerSection);
     Ipointer = &((a->I_samples[ss][LO])[a->IQin_index[ss][LO]]);
     Qpointer = &((a->Q_samples[ss][LO])[a->IQin_index[ss][LO]]);
@@ -1849,6 +1932,8 @@ void Spectrum0(int run, int disp, int ss, int LO, double* pbuff) {
 
     if (a->have_samples[ss][LO] > a->max_writeahead) {
       //if we're receiving samples too much faster than we're consuming them, skip some
+      a->dropped_frames += (a->have_samples[ss][LO] - a->max_writeahead + a->incr - 1) / a->incr;
+
       if ((a->IQout_index[ss][LO] += a->have_samples[ss][LO] - a->max_writeahead) >= a->bsize) {
         a->IQout_index[ss][LO] -= a->bsize;
       }
@@ -1873,7 +1958,10 @@ void Spectrum0(int run, int disp, int ss, int LO, double* pbuff) {
       _beginthread(sendbuf, 0, (void *)(uintptr_t)disp);
     } else {
       LeaveCriticalSection(&a->SetAnalyzerSection);
+      wake_dispatcher(a);
     }
+
+    if (t0 > 0.0) { dspload_add (DSPLOAD_SPECTRUM, disp, t0); }
   }
 }
 
@@ -92,15 +92,20 @@ typedef struct _dp {
   double (*ac1[dMAX_CAL_SETS][dMAX_M]);
   double (*ac0[dMAX_CAL_SETS][dMAX_M]);
 
-  fftw_plan plan[dMAX_STITCH][dMAX_NUM_FFT];        // fftw plans
-  fftw_plan Cplan[dMAX_STITCH][dMAX_NUM_FFT];
-  double *fft_in[dMAX_STITCH][dMAX_NUM_FFT];        // pointers to fftw real input vectors
-  fftw_complex *Cfft_in[dMAX_STITCH][dMAX_NUM_FFT];   // pointers to fftw complex input vectors
-  fftw_complex *fft_out[dMAX_STITCH][dMAX_NUM_FFT];   // pointers to fftw complex output vectors
+  FFTW(plan) plan[dMAX_STITCH][dMAX_NUM_FFT];       // fftw plans
+  FFTW(plan) Cplan[dMAX_STITCH][dMAX_NUM_FFT];
+  FFTREAL *fft_in[dMAX_STITCH][dMAX_NUM_FFT];       // pointers to fftw real input vectors
+  FFTW(complex) *Cfft_in[dMAX_STITCH][dMAX_NUM_FFT];  // pointers to fftw complex input vectors
+  FFTW(complex) *fft_out[dMAX_STITCH][dMAX_NUM_FFT];  // pointers to fftw complex output vectors
   volatile LONG *pnum_threads;              // pointer to current number of active worker threads
   int stop;                       // when set, fft threads will be returned to the pool
   int end_dispatcher;                   // set this flag to one to destroy the dispatcher thread
   volatile int dispatcher;                // one if the dispatcher thread is alive & active
+  int dispatch_pending;                   // set (under DispatchSection) to make the dispatcher look for work
+  CRITICAL_SECTION DispatchSection;
+  CONDITION_VARIABLE DispatchCond;            // signalled when new input is available or ffts have completed
+  volatile LONG fft_count;                  // number of ffts executed
+  volatile LONG dropped_frames;               // number of fft frames skipped since the input was too far ahead
   int ss;                         // sub-span being processed
   int LO;                         // LO (within current sub-span) being processed
   int flag;
@@ -198,6 +203,9 @@ void Spectrum2(int run, int disp, int ss, int LO, dINREAL* pbuff);
 extern __declspec( dllexport )
 void Spectrum0(int run, int disp, int ss, int LO, double* pbuff);
 
+extern __declspec( dllexport )
+void GetDisplayStats (int disp, long *ffts, int *queue_depth, long *dropped);
+
 extern __declspec( dllexport )
 void SnapSpectrum(  int disp,
                     int ss,
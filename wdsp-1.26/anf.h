@@ -41,9 +41,11 @@ typedef struct _anf {
   int delay;
   double two_mu;
   double gamma;
-  double d [ANF_DLINE_SIZE];
+  double d [2 * ANF_DLINE_SIZE];
   double w [ANF_DLINE_SIZE];
   int in_idx;
+  int method;
+  struct _fdlms* fd;
 
   double lidx;
   double lidx_min;
@@ -79,6 +81,10 @@ extern void destroy_anf (ANF a);
 
 extern void flush_anf (ANF a);
 
+extern void calc_anf (ANF a);
+
+extern void decalc_anf (ANF a);
+
 extern void xanf (ANF a, int position);
 
 extern void setBuffers_anf (ANF a, double* in, double* out);
@@ -103,4 +109,6 @@ extern __declspec (dllexport) void SetRXAANFLeakage (int channel, double leakage
 
 extern __declspec (dllexport) void SetRXAANFPosition (int channel, int position);
 
+extern __declspec (dllexport) void SetRXAANFMethod (int channel, int method);
+
 #endif
\ No newline at end of file
@@ -66,22 +66,141 @@ ANR create_anr  (
   a->den_mult = den_mult;
   a->lincr = lincr;
   a->ldecr = ldecr;
-  memset (a->d, 0, sizeof(double) * ANR_DLINE_SIZE);
+  a->method = 1;
+  memset (a->d, 0, sizeof(double) * 2 * ANR_DLINE_SIZE);
   memset (a->w, 0, sizeof(double) * ANR_DLINE_SIZE);
+  calc_anr (a);
   return a;
 }
 
 void destroy_anr (ANR a) {
+  decalc_anr (a);
   _aligned_free (a);
 }
 
+//
+// method 0: reference implementation, see xanr()
+// method 1: same algorithm, but every sample is stored twice in the delay line
+//           (dline_size apart) such that the taps are contiguous, sigma is kept
+//           as a running sum and the weight update is fused with computing the
+//           output for the next sample. Needs delay > 0.
+// method 2: frequency-domain block LMS (fdlms.c) for large tap counts. Used if
+//           the buffer size is a multiple of n_taps, otherwise method 1 is used.
+//           The leakage is applied, but not adapted, in this mode.
+//
+
+void calc_anr (ANR a) {
+  if (a->method == 2 && a->n_taps > 0 && a->buff_size % a->n_taps == 0) {
+    a->fd = create_fdlms (a->n_taps, a->delay);
+  }
+}
+
+void decalc_anr (ANR a) {
+  if (a->fd) {
+    destroy_fdlms (a->fd);
+    a->fd = NULL;
+  }
+}
+
+static void xanr_fast (ANR a) {
+  int i, j, idx;
+  const int n_taps = a->n_taps;
+  const int size = a->dline_size;
+  double* w = a->w;
+  double* u;
+  double* un;
+  double c0, c1, x;
+  double y, y0, y1, y2, y3, error, sigma, inv_sigp;
+  double nel, nev;
+  idx = a->in_idx;
+  u = a->d + idx + a->delay;
+  // start each buffer with exact values of y and sigma, the running sum must not drift
+  y0 = y1 = y2 = y3 = 0.0;
+  sigma = 0.0;
+
+  for (j = 0; j < n_taps; j++) {
+    sigma += u[j] * u[j];
+  }
+
+  for (j = 0; j + 3 < n_taps; j += 4) {
+    y0 += w[j + 0] * u[j + 0];
+    y1 += w[j + 1] * u[j + 1];
+    y2 += w[j + 2] * u[j + 2];
+    y3 += w[j + 3] * u[j + 3];
+  }
+
+  for (; j < n_taps; j++) {
+    y0 += w[j] * u[j];
+  }
+
+  y = (y0 + y1) + (y2 + y3);
+
+  for (i = 0; i < a->buff_size; i++) {
+    x = a->in_buff[2 * i + 0];
+    a->d[idx] = x;
+    a->d[idx + size] = x;
+    inv_sigp = 1.0 / (sigma + 1e-10);
+    error = x - y;
+    a->out_buff[2 * i + 0] = y;
+    a->out_buff[2 * i + 1] = 0.0;
+
+    if ((nel = error * (1.0 - a->two_mu * sigma * inv_sigp)) < 0.0) { nel = -nel; }
+
+    if ((nev = x - (1.0 - a->two_mu * a->ngamma) * y - a->two_mu * error * sigma * inv_sigp) < 0.0) { nev = -nev; }
+
+    if (nev < nel) {
+      if ((a->lidx += a->lincr) > a->lidx_max) { a->lidx = a->lidx_max; }
+    } else {
+      if ((a->lidx -= a->ldecr) < a->lidx_min) { a->lidx = a->lidx_min; }
+    }
+
+    a->ngamma = a->gamma * (a->lidx * a->lidx) * (a->lidx * a->lidx) * a->den_mult;
+    c0 = 1.0 - a->two_mu * a->ngamma;
+    c1 = a->two_mu * error * inv_sigp;
+    // the taps for the next sample are those of this sample, shifted by one
+    idx = (idx + a->mask) & a->mask;
+    un = a->d + idx + a->delay;
+    y0 = y1 = y2 = y3 = 0.0;
+
+    for (j = 0; j + 3 < n_taps; j += 4) {
+      w[j + 0] = c0 * w[j + 0] + c1 * u[j + 0];
+      w[j + 1] = c0 * w[j + 1] + c1 * u[j + 1];
+      w[j + 2] = c0 * w[j + 2] + c1 * u[j + 2];
+      w[j + 3] = c0 * w[j + 3] + c1 * u[j + 3];
+      y0 += w[j + 0] * un[j + 0];
+      y1 += w[j + 1] * un[j + 1];
+      y2 += w[j + 2] * un[j + 2];
+      y3 += w[j + 3] * un[j + 3];
+    }
+
+    for (; j < n_taps; j++) {
+      w[j] = c0 * w[j] + c1 * u[j];
+      y0 += w[j] * un[j];
+    }
+
+    y = (y0 + y1) + (y2 + y3);
+    sigma += un[0] * un[0] - u[n_taps - 1] * u[n_taps - 1];
+
+    if (sigma < 0.0) { sigma = 0.0; }
+
+    u = un;
+  }
+
+  a->in_idx = idx;
+}
+
 void xanr (ANR a, int position) {
   int i, j, idx;
   double c0, c1;
   double y, error, sigma, inv_sigp;
   double nel, nev;
 
-  if (a->run && (a->position == position)) {
+  if (a->run && (a->position == position) && a->fd) {
+    xfdlms (a->fd, a->in_buff, a->out_buff, a->buff_size, 0, a->two_mu, 1.0 - a->two_mu * a->ngamma);
+  } else if (a->run && (a->position == position) && a->method != 0
+             && a->delay > 0 && a->n_taps > 0 && a->n_taps + a->delay <= a->dline_size) {
+    xanr_fast (a);
+  } else if (a->run && (a->position == position)) {
     for (i = 0; i < a->buff_size; i++) {
       a->d[a->in_idx] = a->in_buff[2 * i + 0];
       y = 0;
@@ -125,9 +244,11 @@ void xanr (ANR a, int position) {
 }
 
 void flush_anr (ANR a) {
-  memset (a->d, 0, sizeof(double) * ANR_DLINE_SIZE);
+  memset (a->d, 0, sizeof(double) * 2 * ANR_DLINE_SIZE);
   memset (a->w, 0, sizeof(double) * ANR_DLINE_SIZE);
   a->in_idx = 0;
+
+  if (a->fd) { flush_fdlms (a->fd); }
 }
 
 void setBuffers_anr (ANR a, double* in, double* out) {
@@ -140,7 +261,9 @@ void setSamplerate_anr (ANR a, int rate) {
 }
 
 void setSize_anr (ANR a, int size) {
+  decalc_anr (a);
   a->buff_size = size;
+  calc_anr (a);
   flush_anr(a);
 }
 
@@ -168,10 +291,12 @@ SetRXAANRRun (int channel, int run) {
 PORT void
 SetRXAANRVals (int channel, int taps, int delay, double gain, double leakage) {
   EnterCriticalSection (&ch[channel].csDSP);
+  decalc_anr (rxa[channel].anr.p);
   rxa[channel].anr.p->n_taps = taps;
   rxa[channel].anr.p->delay = delay;
   rxa[channel].anr.p->two_mu = gain;
   rxa[channel].anr.p->gamma = leakage;
+  calc_anr (rxa[channel].anr.p);
   flush_anr (rxa[channel].anr.p);
   LeaveCriticalSection (&ch[channel].csDSP);
 }
@@ -179,7 +304,9 @@ SetRXAANRVals (int channel, int taps, int delay, double gain, double leakage) {
 PORT void
 SetRXAANRTaps (int channel, int taps) {
   EnterCriticalSection (&ch[channel].csDSP);
+  decalc_anr (rxa[channel].anr.p);
   rxa[channel].anr.p->n_taps = taps;
+  calc_anr (rxa[channel].anr.p);
   flush_anr (rxa[channel].anr.p);
   LeaveCriticalSection (&ch[channel].csDSP);
 }
@@ -187,7 +314,9 @@ SetRXAANRTaps (int channel, int taps) {
 PORT void
 SetRXAANRDelay (int channel, int delay) {
   EnterCriticalSection (&ch[channel].csDSP);
+  decalc_anr (rxa[channel].anr.p);
   rxa[channel].anr.p->delay = delay;
+  calc_anr (rxa[channel].anr.p);
   flush_anr (rxa[channel].anr.p);
   LeaveCriticalSection (&ch[channel].csDSP);
 }
@@ -213,6 +342,17 @@ SetRXAANRPosition (int channel, int position) {
   EnterCriticalSection (&ch[channel].csDSP);
   rxa[channel].anr.p->position = position;
   rxa[channel].bp1.p->position = position;
+  RXAPipeCheck (channel);
   flush_anr (rxa[channel].anr.p);
   LeaveCriticalSection (&ch[channel].csDSP);
-}
\ No newline at end of file
+}
+
+PORT void
+SetRXAANRMethod (int channel, int method) {
+  EnterCriticalSection (&ch[channel].csDSP);
+  decalc_anr (rxa[channel].anr.p);
+  rxa[channel].anr.p->method = method;
+  calc_anr (rxa[channel].anr.p);
+  flush_anr (rxa[channel].anr.p);
+  LeaveCriticalSection (&ch[channel].csDSP);
+}
@@ -41,9 +41,11 @@ typedef struct _anr {
   int delay;
   double two_mu;
   double gamma;
-  double d [ANR_DLINE_SIZE];
+  double d [2 * ANR_DLINE_SIZE];
   double w [ANR_DLINE_SIZE];
   int in_idx;
+  int method;
+  struct _fdlms* fd;
 
   double lidx;
   double lidx_min;
@@ -79,6 +81,10 @@ extern void destroy_anr (ANR a);
 
 extern void flush_anr (ANR a);
 
+extern void calc_anr (ANR a);
+
+extern void decalc_anr (ANR a);
+
 extern void xanr (ANR a, int position);
 
 extern void setBuffers_anr (ANR a, double* in, double* out);
@@ -103,4 +109,6 @@ extern __declspec (dllexport) void SetRXAANRLeakage (int channel, double leakage
 
 extern __declspec (dllexport) void SetRXAANRPosition (int channel, int position);
 
+extern __declspec (dllexport) void SetRXAANRMethod (int channel, int method);
+
 #endif
\ No newline at end of file
@@ -39,9 +39,9 @@ void calc_bps (BPS a) {
   impulse = fir_bandpass(a->size + 1, a->f_low, a->f_high, a->samplerate, a->wintype, 1, 1.0 / (double)(2 * a->size));
   a->mults = fftcv_mults(2 * a->size, impulse);
   a->CFor = fftw_plan_dft_1d(2 * a->size, (fftw_complex *)a->infilt, (fftw_complex *)a->product, FFTW_FORWARD,
-                             FFTW_PATIENT);
+                             wisdom_rigor);
   a->CRev = fftw_plan_dft_1d(2 * a->size, (fftw_complex *)a->product, (fftw_complex *)a->out, FFTW_BACKWARD,
-                             FFTW_PATIENT);
+                             wisdom_rigor);
   _aligned_free(impulse);
 }
 
@@ -138,6 +138,7 @@ void SetRXABPSRun (int channel, int run)
 {
   EnterCriticalSection (&ch[channel].csDSP);
   rxa[channel].bp1.p->run = run;
+  RXAPipeCheck (channel);
   LeaveCriticalSection (&ch[channel].csDSP);
 }
 
@@ -189,6 +190,7 @@ void SetTXABPSRun (int channel, int run)
 {
   EnterCriticalSection (&ch[channel].csDSP);
   txa[channel].bp1.p->run = run;
+  TXAPipeCheck (channel);
   LeaveCriticalSection (&ch[channel].csDSP);
 }
 
@@ -370,6 +372,7 @@ PORT
 void SetRXABandpassRun (int channel, int run) {
   EnterCriticalSection (&ch[channel].csDSP);
   rxa[channel].bp1.p->run = run;
+  RXAPipeCheck (channel);
   LeaveCriticalSection (&ch[channel].csDSP);
 }
 
@@ -447,6 +450,7 @@ PORT
 void SetTXABandpassRun (int channel, int run) {
   EnterCriticalSection (&ch[channel].csDSP);
   txa[channel].bp1.p->run = run;
+  TXAPipeCheck (channel);
   LeaveCriticalSection (&ch[channel].csDSP);
 }
 
@@ -53,6 +53,18 @@ void size_calcc (CALCC a) {
   a->rxs = (double *) malloc0 (a->nsamps * sizeof (complex));
   a->txs = (double *) malloc0 (a->nsamps * sizeof (complex));
   a->ccbld = create_builder(a->nsamps + a->npsamps, a->ints);
+
+  for (i = 0; i < 2; i++) {
+    a->fit[i].a = a;
+    a->fit[i].bld = create_builder(a->nsamps + a->npsamps, a->ints);
+  }
+
+  a->fit[0].y = a->yc;
+  a->fit[0].c = a->cc;
+  a->fit[0].info = &(a->binfo[2]);
+  a->fit[1].y = a->ys;
+  a->fit[1].c = a->cs;
+  a->fit[1].info = &(a->binfo[3]);
   a->ctrl.cpi = (int *) malloc0 (a->ints * sizeof (int));
   a->ctrl.sindex = (int *) malloc0 (a->ints * sizeof (int));
   a->ctrl.sbase = (int *) malloc0 (a->ints * sizeof (int));
@@ -89,6 +101,8 @@ void desize_calcc (CALCC a) {
   _aligned_free (a->ctrl.sbase);
   _aligned_free (a->ctrl.sindex);
   _aligned_free (a->ctrl.cpi);
+  destroy_builder(a->fit[1].bld);
+  destroy_builder(a->fit[0].bld);
   destroy_builder(a->ccbld);
   _aligned_free (a->rxs);
   _aligned_free (a->txs);
@@ -164,6 +178,7 @@ CALCC create_calcc (int channel, int runcal, int size, int rate, int ints, int s
                  20.0e-09,                 // delta (delay stepsize)
                  0.0);                   // delay
   InitializeCriticalSectionAndSpinCount (&a->disp.cs_disp, 2500);
+  a->Sem_Fit = CreateSemaphore(0, 0, 2, 0);
   a->util.ints = a->ints;
   a->util.channel = a->channel;
   size_calcc (a);
@@ -216,6 +231,7 @@ void destroy_calcc (CALCC a) {
   _aligned_free (a->temptx);                                            // remove later
   _aligned_free (a->temprx);                                            // remove later
   desize_calcc (a);
+  CloseHandle(a->Sem_Fit);
   DeleteCriticalSection (&a->disp.cs_disp);
   destroy_delay (a->txdelay);
   destroy_delay (a->rxdelay);
@@ -322,6 +338,35 @@ void rxscheck (int rints, double* tvec, double* coef, int* info) {
   if (out < 0.00) { *info |= 0x0020; }
 }
 
+static DWORD WINAPI psfit (void *arg) {
+  struct _fit *f = (struct _fit *)arg;
+  CALCC a = f->a;
+  xbuilder(f->bld, f->points, a->x, f->y, a->ints, a->t, f->info, f->c, a->ptol);
+  ReleaseSemaphore(a->Sem_Fit, 1, 0);
+  return 0;
+}
+
+static void fit (CALCC a, int points) {
+  // The three fits are independent: cc and cs go to the worker pool
+  // (or are done right here if it cannot take them), cm is done by
+  // this thread.
+  int i;
+
+  for (i = 0; i < 2; i++) {
+    a->fit[i].points = points;
+
+    if (!QueueUserWorkItem((void *)psfit, (void *)&a->fit[i], 0)) {
+      psfit ((void *)&a->fit[i]);
+    }
+  }
+
+  xbuilder(a->ccbld, points, a->x, a->ym, a->ints, a->t, &(a->binfo[1]), a->cm, a->ptol);
+
+  for (i = 0; i < 2; i++) {
+    WaitForSingleObject(a->Sem_Fit, INFINITE);
+  }
+}
+
 void calc (CALCC a) {
   int i;
   double norm;
@@ -443,13 +488,9 @@ void calc (CALCC a) {
       a->ys[i] = sval;
     }
 
-    xbuilder(a->ccbld, a->tsamps, a->x, a->ym, a->ints, a->t, &(a->binfo[1]), a->cm, a->ptol);
-    xbuilder(a->ccbld, a->tsamps, a->x, a->yc, a->ints, a->t, &(a->binfo[2]), a->cc, a->ptol);
-    xbuilder(a->ccbld, a->tsamps, a->x, a->ys, a->ints, a->t, &(a->binfo[3]), a->cs, a->ptol);
+    fit (a, a->tsamps);
   } else {
-    xbuilder(a->ccbld, a->nsamps, a->x, a->ym, a->ints, a->t, &(a->binfo[1]), a->cm, a->ptol);
-    xbuilder(a->ccbld, a->nsamps, a->x, a->yc, a->ints, a->t, &(a->binfo[2]), a->cc, a->ptol);
-    xbuilder(a->ccbld, a->nsamps, a->x, a->ys, a->ints, a->t, &(a->binfo[3]), a->cs, a->ptol);
+    fit (a, a->nsamps);
   }
 
   if (a->pin) { // tune
@@ -502,8 +543,11 @@ void __cdecl doPSCalcCorrection (void *arg) {
     WaitForSingleObject(a->Sem_CalcCorr, INFINITE);
 
     if (!InterlockedAnd(&a->calccorr_bypass, 0xffffffff)) {
+      double t0 = dspload_run ? dspload_now () : 0.0;
       calc(a);
 
+      if (t0 > 0.0) { dspload_add (DSPLOAD_CALCC, a->channel, t0); }
+
       if (a->scOK) {
         EnterCriticalSection (&a->ctrl.cs_SafeToEnd);
 
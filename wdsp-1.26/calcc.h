@@ -70,6 +70,15 @@ typedef struct _calcc {
   int* binfo;
   double txdel;
   BLDR ccbld;
+  struct _fit {         // the cc and cs fits, run in parallel to the cm fit
+    struct _calcc* a;
+    BLDR bld;
+    int points;
+    double* y;
+    double* c;
+    int* info;
+  } fit[2];
+  HANDLE Sem_Fit;
   volatile long savecorr_bypass;
   HANDLE Sem_SaveCorr;
   volatile long restcorr_bypass;
@@ -138,6 +147,20 @@ extern void flush_calcc (CALCC a);
 
 extern __declspec(dllexport) void pscc (int channel, int size, double* tx, double* rx);
 
+extern __declspec(dllexport) void SetPSRunCal (int channel, int run);
+
+extern __declspec(dllexport) void SetPSMox (int channel, int mox);
+
+extern __declspec(dllexport) void GetPSInfo (int channel, int *info);
+
+extern __declspec(dllexport) void SetPSControl (int channel, int reset, int mancal, int automode, int turnon);
+
+extern __declspec(dllexport) void SetPSHWPeak (int channel, double peak);
+
+extern __declspec(dllexport) void SetPSFeedbackRate (int channel, int rate);
+
+extern __declspec(dllexport) void SetPSIntsAndSpi (int channel, int ints, int spi);
+
 extern void __cdecl PSSaveCorrection(void* pargs);
 
 extern void __cdecl PSRestoreCorrection(void* pargs);
@@ -114,5 +114,6 @@ PORT void
 SetRXACBLRun(int channel, int setit) {
   EnterCriticalSection (&ch[channel].csDSP);
   rxa[channel].cbl.p->run = setit;
+  RXAPipeCheck (channel);
   LeaveCriticalSection (&ch[channel].csDSP);
 }
\ No newline at end of file
@@ -181,13 +181,13 @@ void calc_cfcomp(CFCOMP a) {
   a->msize = a->fsize / 2 + 1;
   a->window    = (double *)malloc0 (a->fsize  * sizeof(double));
   a->inaccum   = (double *)malloc0 (a->iasize * sizeof(double));
-  a->forfftin  = (double *)malloc0 (a->fsize  * sizeof(double));
-  a->forfftout = (double *)malloc0 (a->msize  * sizeof(complex));
+  a->forfftin  = (FFTREAL *)malloc0 (a->fsize  * sizeof(FFTREAL));
+  a->forfftout = (FFTREAL *)malloc0 (a->msize  * sizeof(fftcomplex));
   a->cmask     = (double *)malloc0 (a->msize  * sizeof(double));
   a->mask      = (double *)malloc0 (a->msize  * sizeof(double));
   a->cfc_gain  = (double *)malloc0 (a->msize  * sizeof(double));
-  a->revfftin  = (double *)malloc0 (a->msize  * sizeof(complex));
-  a->revfftout = (double *)malloc0 (a->fsize  * sizeof(double));
+  a->revfftin  = (FFTREAL *)malloc0 (a->msize  * sizeof(fftcomplex));
+  a->revfftout = (FFTREAL *)malloc0 (a->fsize  * sizeof(FFTREAL));
   a->save      = (double **)malloc0(a->ovrlp  * sizeof(double *));
 
   for (i = 0; i < a->ovrlp; i++) {
@@ -197,8 +197,8 @@ void calc_cfcomp(CFCOMP a) {
   a->outaccum = (double *)malloc0(a->oasize * sizeof(double));
   a->nsamps = 0;
   a->saveidx = 0;
-  a->Rfor = fftw_plan_dft_r2c_1d(a->fsize, a->forfftin, (fftw_complex *)a->forfftout, FFTW_ESTIMATE);
-  a->Rrev = fftw_plan_dft_c2r_1d(a->fsize, (fftw_complex *)a->revfftin, a->revfftout, FFTW_ESTIMATE);
+  a->Rfor = FFTW(plan_dft_r2c_1d)(a->fsize, a->forfftin, (FFTW(complex) *)a->forfftout, FFTW_ESTIMATE);
+  a->Rrev = FFTW(plan_dft_c2r_1d)(a->fsize, (FFTW(complex) *)a->revfftin, a->revfftout, FFTW_ESTIMATE);
   calc_cfcwindow(a);
   a->pregain  = (2.0 * a->winfudge) / (double)a->fsize;
   a->postgain = 0.5 / ((double)a->ovrlp * a->winfudge);
@@ -226,8 +226,8 @@ void decalc_cfcomp(CFCOMP a) {
   _aligned_free (a->ep);
   _aligned_free (a->gp);
   _aligned_free (a->fp);
-  fftw_destroy_plan(a->Rrev);
-  fftw_destroy_plan(a->Rfor);
+  FFTW(destroy_plan)(a->Rrev);
+  FFTW(destroy_plan)(a->Rfor);
   _aligned_free(a->outaccum);
 
   for (i = 0; i < a->ovrlp; i++) {
@@ -313,8 +313,8 @@ void calc_mask (CFCOMP a) {
     double mag, test;
 
     for (i = 0; i < a->msize; i++) {
-      mag = sqrt (a->forfftout[2 * i + 0] * a->forfftout[2 * i + 0]
-                  + a->forfftout[2 * i + 1] * a->forfftout[2 * i + 1]);
+      mag = sqrt ((double)a->forfftout[2 * i + 0] * a->forfftout[2 * i + 0]
+                  + (double)a->forfftout[2 * i + 1] * a->forfftout[2 * i + 1]);
       comp = a->cfc_gain[i];
       test = comp * mag;
 
@@ -369,7 +369,7 @@ void xcfcomp (CFCOMP a, int pos) {
 
       a->iaoutidx = (a->iaoutidx + a->incr) % a->iasize;
       a->nsamps -= a->incr;
-      fftw_execute (a->Rfor);
+      FFTW(execute) (a->Rfor);
       calc_mask(a);
 
       for (i = 0; i < a->msize; i++) {
@@ -377,7 +377,7 @@ void xcfcomp (CFCOMP a, int pos) {
         a->revfftin[2 * i + 1] = a->mask[i] * a->forfftout[2 * i + 1];
       }
 
-      fftw_execute (a->Rrev);
+      FFTW(execute) (a->Rrev);
 
       for (i = 0; i < a->fsize; i++) {
         a->save[a->saveidx][i] = a->postgain * a->window[i] * a->revfftout[i];
@@ -440,6 +440,7 @@ void SetTXACFCOMPRun (int channel, int run) {
   if (a->run != run) {
     EnterCriticalSection (&ch[channel].csDSP);
     a->run = run;
+    TXAPipeCheck (channel);
     LeaveCriticalSection (&ch[channel].csDSP);
   }
 }
@@ -451,6 +452,7 @@ void SetTXACFCOMPPosition (int channel, int pos) {
   if (a->position != pos) {
     EnterCriticalSection (&ch[channel].csDSP);
     a->position = pos;
+    TXAPipeCheck (channel);
     LeaveCriticalSection (&ch[channel].csDSP);
   }
 }
@@ -39,15 +39,15 @@ typedef struct _cfcomp {
   double* window;
   int iasize;
   double* inaccum;
-  double* forfftin;
-  double* forfftout;
+  FFTREAL* forfftin;
+  FFTREAL* forfftout;
   int msize;
   double* cmask;
   double* mask;
   int mask_ready;
   double* cfc_gain;
-  double* revfftin;
-  double* revfftout;
+  FFTREAL* revfftin;
+  FFTREAL* revfftout;
   double** save;
   int oasize;
   double* outaccum;
@@ -62,8 +62,8 @@ typedef struct _cfcomp {
   int oainidx;
   int oaoutidx;
   int saveidx;
-  fftw_plan Rfor;
-  fftw_plan Rrev;
+  FFTW(plan) Rfor;
+  FFTW(plan) Rrev;
 
   int comp_method;
   int nfreqs;
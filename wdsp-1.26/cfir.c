@@ -235,6 +235,7 @@ PORT
 void SetTXACFIRRun (int channel, int run) {
   EnterCriticalSection(&ch[channel].csDSP);
   txa[channel].cfir.p->run = run;
+  TXAPipeCheck (channel);
   LeaveCriticalSection(&ch[channel].csDSP);
 }
 
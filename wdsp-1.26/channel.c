@@ -60,7 +60,12 @@ void pre_main_build (int channel) {
 
 void post_main_build (int channel) {
   InterlockedBitTestAndSet (&ch[channel].run, 0);
-  start_thread (channel);
+
+  if (ch[channel].pooled) {
+    InterlockedExchange (&ch[channel].pool_claim, 0);
+  } else {
+    start_thread (channel);
+  }
 
   if (ch[channel].state == 1) {
     InterlockedBitTestAndSet (&ch[channel].exchange, 0);
@@ -108,8 +113,16 @@ void pre_main_destroy (int channel) {
   InterlockedBitTestAndReset (&ch[channel].exchange, 0);
   InterlockedBitTestAndReset (&ch[channel].run, 0);
   InterlockedBitTestAndSet (&ch[channel].iob.pc->exec_bypass, 0);
-  ReleaseSemaphore (a->Sem_BuffReady, 1, 0);
-  Sleep (25);
+
+  if (ch[channel].pooled) {
+    // wait for a pool worker to finish, and keep the others off until re-built
+    while (InterlockedCompareExchange (&ch[channel].pool_claim, 1, 0) != 0) { Sleep (1); }
+
+    InterlockedExchange (&ch[channel].pool_pending, 0);
+  } else {
+    ReleaseSemaphore (a->Sem_BuffReady, 1, 0);
+    Sleep (25);
+  }
 }
 
 void post_main_destroy (int channel) {
@@ -138,6 +151,7 @@ void flushChannel (void* p) {
       flush_iobuffs(channel);
       InterlockedBitTestAndSet(&a->exec_bypass, 0);
       flush_main(channel);
+      xcmdq(channel);
       LeaveCriticalSection(&ch[channel].csEXCH);
       LeaveCriticalSection(&ch[channel].csDSP);
       InterlockedBitTestAndReset(&ch[channel].flushflag, 0);
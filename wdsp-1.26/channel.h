@@ -53,6 +53,9 @@ struct _ch {
     IOB pc, pd, pe, pf;   // copies for console calls, dsp, exchange, and flush thread
     volatile long ch_upslew;
   } iob;
+  int pooled;         // when 1, dsp is run by the shared DSP pool instead of an own thread
+  volatile long pool_pending; // buffers posted to the DSP pool, not yet processed
+  volatile long pool_claim;   // set while a pool worker (or a re-build) owns the channel
 };
 
 extern struct _ch ch[];
@@ -65,6 +68,14 @@ PORT void CloseChannel (int channel);
 
 extern void flushChannel (void* p);
 
+extern void pre_main_build (int channel);
+
+extern void post_main_build (int channel);
+
+extern void pre_main_destroy (int channel);
+
+extern void post_main_destroy (int channel);
+
 PORT void SetType (int channel, int type);
 
 PORT void SetInputBuffsize (int channel, int in_size);
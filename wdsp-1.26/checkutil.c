@@ -0,0 +1,72 @@
+/*  checkutil.c
+
+This file is part of a program that implements a Software-Defined Radio.
+
+Copyright (C) 2025 Heiko Amft, DL1BZ
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+#include "comm.h"
+#include "checkutil.h"
+
+//
+// A linear congruential generator: the signals must be the same on
+// every platform and in every build, which rand() does not guarantee.
+//
+static unsigned int seed;
+
+void check_seed (unsigned int s) {
+  seed = s;
+}
+
+double check_uniform (void) {
+  seed = seed * 1664525u + 1013904223u;
+  return ((double)(seed >> 8) + 0.5) / (double)(1u << 24);
+}
+
+double check_gauss (void) {
+  return sqrt (-2.0 * log (check_uniform ())) * cos (TWOPI * check_uniform ());
+}
+
+double check_snr (const double* ref, const double* x, int n) {
+  double sig = 0.0, err = 0.0;
+  int k;
+
+  for (k = 0; k < n; k++) {
+    sig += ref[k] * ref[k];
+    err += (x[k] - ref[k]) * (x[k] - ref[k]);
+  }
+
+  if (err == 0.0) { return 1000.0; }
+
+  return 10.0 * log10 (sig / err);
+}
+
+double check_max_reldev (const double* ref, const double* x, int n) {
+  double dev = 0.0;
+  int k;
+
+  for (k = 0; k < n; k++) {
+    double d = fabs (x[k] - ref[k]);
+
+    if (fabs (ref[k]) > 1.0e-300) { d /= fabs (ref[k]); }
+
+    if (d > dev) { dev = d; }
+  }
+
+  return dev;
+}
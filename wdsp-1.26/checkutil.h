@@ -0,0 +1,52 @@
+/*  checkutil.h
+
+This file is part of a program that implements a Software-Defined Radio.
+
+Copyright (C) 2025 Heiko Amft, DL1BZ
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+/********************************************************************************************************
+*                                                   *
+*                     Check Program Helpers                       *
+*                                                   *
+********************************************************************************************************/
+
+//
+// Test signals and comparisons shared by the check programs (snrcheck,
+// emnrcheck, see "make check"). Not part of the library.
+//
+
+#ifndef _checkutil_h
+#define _checkutil_h
+
+// seed the generator, such that each case gets the same signals
+extern void check_seed (unsigned int seed);
+
+// uniformly distributed in (0, 1)
+extern double check_uniform (void);
+
+// normally distributed, zero mean and unit variance
+extern double check_gauss (void);
+
+// SNR (dB) of x relative to the reference ref, both n doubles, 1000.0 if identical
+extern double check_snr (const double* ref, const double* x, int n);
+
+// largest relative deviation of x from the reference ref, both n doubles
+extern double check_max_reldev (const double* ref, const double* x, int n);
+
+#endif
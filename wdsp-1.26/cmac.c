@@ -0,0 +1,321 @@
+/*  cmac.c
+
+This file is part of a program that implements a Software-Defined Radio.
+
+Copyright (C) 2025 Heiko Amft, DL1BZ
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+#include "comm.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  #define CMAC_X86
+  #include <immintrin.h>
+#endif
+#if defined(__aarch64__)
+  #define CMAC_NEON64
+  #include <arm_neon.h>
+#endif
+
+// number of complex values per cache block, the accumulator block stays in L1
+#define CMAC_BLOCK 512
+
+typedef void (*cmac_fn)(FFTREAL* acc, const FFTREAL* x, const FFTREAL* m, int n);
+
+static void cmac_scalar (FFTREAL* acc, const FFTREAL* x, const FFTREAL* m, int n) {
+  int i;
+
+  for (i = 0; i < n; i++) {
+    acc[2 * i + 0] += x[2 * i + 0] * m[2 * i + 0] - x[2 * i + 1] * m[2 * i + 1];
+    acc[2 * i + 1] += x[2 * i + 0] * m[2 * i + 1] + x[2 * i + 1] * m[2 * i + 0];
+  }
+}
+
+#ifdef CMAC_X86
+//
+// Interleaved complex product with one fmaddsub:
+// (xr, xi) * mr -/+ (xi, xr) * mi  =  (xr*mr - xi*mi, xi*mr + xr*mi)
+//
+#ifdef WDSP_FLOAT
+__attribute__((target("avx2,fma")))
+static void cmac_avx2 (FFTREAL* acc, const FFTREAL* x, const FFTREAL* m, int n) {
+  int i = 0;
+
+  for (; i + 4 <= n; i += 4) {
+    __m256 vx = _mm256_loadu_ps (x + 2 * i);
+    __m256 vm = _mm256_loadu_ps (m + 2 * i);
+    __m256 xs = _mm256_permute_ps (vx, 0xB1);
+    __m256 p  = _mm256_fmaddsub_ps (vx, _mm256_moveldup_ps (vm), _mm256_mul_ps (xs, _mm256_movehdup_ps (vm)));
+    _mm256_storeu_ps (acc + 2 * i, _mm256_add_ps (_mm256_loadu_ps (acc + 2 * i), p));
+  }
+
+  cmac_scalar (acc + 2 * i, x + 2 * i, m + 2 * i, n - i);
+}
+
+__attribute__((target("avx512f")))
+static void cmac_avx512 (FFTREAL* acc, const FFTREAL* x, const FFTREAL* m, int n) {
+  int i = 0;
+
+  for (; i + 8 <= n; i += 8) {
+    __m512 vx = _mm512_loadu_ps (x + 2 * i);
+    __m512 vm = _mm512_loadu_ps (m + 2 * i);
+    __m512 xs = _mm512_permute_ps (vx, 0xB1);
+    __m512 p  = _mm512_fmaddsub_ps (vx, _mm512_moveldup_ps (vm), _mm512_mul_ps (xs, _mm512_movehdup_ps (vm)));
+    _mm512_storeu_ps (acc + 2 * i, _mm512_add_ps (_mm512_loadu_ps (acc + 2 * i), p));
+  }
+
+  cmac_scalar (acc + 2 * i, x + 2 * i, m + 2 * i, n - i);
+}
+#else
+__attribute__((target("avx2,fma")))
+static void cmac_avx2 (FFTREAL* acc, const FFTREAL* x, const FFTREAL* m, int n) {
+  int i = 0;
+
+  for (; i + 2 <= n; i += 2) {
+    __m256d vx = _mm256_loadu_pd (x + 2 * i);
+    __m256d vm = _mm256_loadu_pd (m + 2 * i);
+    __m256d xs = _mm256_permute_pd (vx, 0x5);
+    __m256d p  = _mm256_fmaddsub_pd (vx, _mm256_movedup_pd (vm), _mm256_mul_pd (xs, _mm256_permute_pd (vm, 0xF)));
+    _mm256_storeu_pd (acc + 2 * i, _mm256_add_pd (_mm256_loadu_pd (acc + 2 * i), p));
+  }
+
+  cmac_scalar (acc + 2 * i, x + 2 * i, m + 2 * i, n - i);
+}
+
+__attribute__((target("avx512f")))
+static void cmac_avx512 (FFTREAL* acc, const FFTREAL* x, const FFTREAL* m, int n) {
+  int i = 0;
+
+  for (; i + 4 <= n; i += 4) {
+    __m512d vx = _mm512_loadu_pd (x + 2 * i);
+    __m512d vm = _mm512_loadu_pd (m + 2 * i);
+    __m512d xs = _mm512_permute_pd (vx, 0x55);
+    __m512d p  = _mm512_fmaddsub_pd (vx, _mm512_movedup_pd (vm), _mm512_mul_pd (xs, _mm512_permute_pd (vm, 0xFF)));
+    _mm512_storeu_pd (acc + 2 * i, _mm512_add_pd (_mm512_loadu_pd (acc + 2 * i), p));
+  }
+
+  cmac_scalar (acc + 2 * i, x + 2 * i, m + 2 * i, n - i);
+}
+#endif
+#endif
+
+#ifdef CMAC_NEON64
+//
+// vld2/vst2 split the interleaved data into real and imaginary parts
+//
+#ifdef WDSP_FLOAT
+static void cmac_neon (FFTREAL* acc, const FFTREAL* x, const FFTREAL* m, int n) {
+  int i = 0;
+
+  for (; i + 4 <= n; i += 4) {
+    float32x4x2_t vx = vld2q_f32 (x + 2 * i);
+    float32x4x2_t vm = vld2q_f32 (m + 2 * i);
+    float32x4x2_t va = vld2q_f32 (acc + 2 * i);
+    va.val[0] = vfmaq_f32 (va.val[0], vx.val[0], vm.val[0]);
+    va.val[0] = vfmsq_f32 (va.val[0], vx.val[1], vm.val[1]);
+    va.val[1] = vfmaq_f32 (va.val[1], vx.val[0], vm.val[1]);
+    va.val[1] = vfmaq_f32 (va.val[1], vx.val[1], vm.val[0]);
+    vst2q_f32 (acc + 2 * i, va);
+  }
+
+  cmac_scalar (acc + 2 * i, x + 2 * i, m + 2 * i, n - i);
+}
+#else
+static void cmac_neon (FFTREAL* acc, const FFTREAL* x, const FFTREAL* m, int n) {
+  int i = 0;
+
+  for (; i + 2 <= n; i += 2) {
+    float64x2x2_t vx = vld2q_f64 (x + 2 * i);
+    float64x2x2_t vm = vld2q_f64 (m + 2 * i);
+    float64x2x2_t va = vld2q_f64 (acc + 2 * i);
+    va.val[0] = vfmaq_f64 (va.val[0], vx.val[0], vm.val[0]);
+    va.val[0] = vfmsq_f64 (va.val[0], vx.val[1], vm.val[1]);
+    va.val[1] = vfmaq_f64 (va.val[1], vx.val[0], vm.val[1]);
+    va.val[1] = vfmaq_f64 (va.val[1], vx.val[1], vm.val[0]);
+    vst2q_f64 (acc + 2 * i, va);
+  }
+
+  cmac_scalar (acc + 2 * i, x + 2 * i, m + 2 * i, n - i);
+}
+#endif
+#endif
+
+static cmac_fn cmac_kernels[CMAC_NUM_KERNELS] = {
+  cmac_scalar,
+#ifdef CMAC_X86
+  cmac_avx2,
+  cmac_avx512,
+#else
+  NULL,
+  NULL,
+#endif
+#ifdef CMAC_NEON64
+  cmac_neon
+#else
+  NULL
+#endif
+};
+
+static volatile LONG cmac_kernel = CMAC_SCALAR;
+static volatile LONG cmac_initialized = 0;
+
+static void run_cmac (cmac_fn fn, FFTREAL* accum, FFTREAL** x, FFTREAL** m, int nparts, int n) {
+  int i, p, len;
+
+  for (i = 0; i < n; i += CMAC_BLOCK) {
+    len = n - i < CMAC_BLOCK ? n - i : CMAC_BLOCK;
+    memset (accum + 2 * i, 0, len * sizeof (fftcomplex));
+
+    for (p = 0; p < nparts; p++) {
+      (*fn)(accum + 2 * i, x[p] + 2 * i, m[p] + 2 * i, len);
+    }
+  }
+}
+
+void xcmac (FFTREAL* accum, FFTREAL** x, FFTREAL** m, int nparts, int n) {
+  run_cmac (cmac_kernels[cmac_kernel], accum, x, m, nparts, n);
+}
+
+PORT int GetFirKernelAvailable (int kernel) {
+  switch (kernel) {
+  case CMAC_SCALAR:
+    return 1;
+#ifdef CMAC_X86
+
+  case CMAC_AVX2:
+    return __builtin_cpu_supports ("avx2") && __builtin_cpu_supports ("fma");
+
+  case CMAC_AVX512:
+    return __builtin_cpu_supports ("avx512f");
+#endif
+#ifdef CMAC_NEON64
+
+  case CMAC_NEON:
+    return 1;
+#endif
+
+  default:
+    return 0;
+  }
+}
+
+void init_cmac (void) {
+  int i, kernel = CMAC_SCALAR;
+
+  if (InterlockedAnd (&cmac_initialized, 1)) { return; }
+
+#ifdef CMAC_X86
+  __builtin_cpu_init ();
+#endif
+
+  for (i = CMAC_SCALAR; i < CMAC_NUM_KERNELS; i++)
+    if (GetFirKernelAvailable (i)) { kernel = i; }
+
+  InterlockedExchange (&cmac_kernel, kernel);
+  InterlockedExchange (&cmac_initialized, 1);
+}
+
+PORT int GetFirKernel (void) {
+  init_cmac ();
+  return cmac_kernel;
+}
+
+PORT void SetFirKernel (int kernel) {
+  init_cmac ();
+
+  if (kernel >= 0 && kernel < CMAC_NUM_KERNELS && GetFirKernelAvailable (kernel)) {
+    InterlockedExchange (&cmac_kernel, kernel);
+  }
+}
+
+PORT const char* GetFirKernelName (int kernel) {
+  switch (kernel) {
+  case CMAC_SCALAR:
+    return "scalar";
+
+  case CMAC_AVX2:
+    return "AVX2";
+
+  case CMAC_AVX512:
+    return "AVX-512";
+
+  case CMAC_NEON:
+    return "NEON";
+
+  default:
+    return "unknown";
+  }
+}
+
+//
+// Time the multiply-accumulate of one buffer for a filter with buffer
+// size 'size' and 'nparts' partitions (i.e., nc = nparts * size) and
+// return the time per buffer in microseconds, or a negative value if
+// the kernel is not available on this CPU.
+//
+PORT double FirKernelBenchmark (int kernel, int size, int nparts) {
+  struct timespec ts, te;
+  int i, p, l, loops, n = 2 * size;
+  FFTREAL* accum;
+  FFTREAL** x;
+  FFTREAL** m;
+  double us;
+  init_cmac ();
+
+  if (kernel < 0 || kernel >= CMAC_NUM_KERNELS || !GetFirKernelAvailable (kernel) || size <= 0 || nparts <= 0) {
+    return -1.0;
+  }
+
+  accum = (FFTREAL *) malloc0 (n * sizeof (fftcomplex));
+  x = (FFTREAL **) malloc0 (nparts * sizeof (FFTREAL *));
+  m = (FFTREAL **) malloc0 (nparts * sizeof (FFTREAL *));
+
+  for (p = 0; p < nparts; p++) {
+    x[p] = (FFTREAL *) malloc0 (n * sizeof (fftcomplex));
+    m[p] = (FFTREAL *) malloc0 (n * sizeof (fftcomplex));
+
+    for (i = 0; i < 2 * n; i++) {
+      x[p][i] = (FFTREAL) sin (0.001 * (i + 1) * (p + 1));
+      m[p][i] = (FFTREAL) cos (0.002 * (i + 1) * (p + 1));
+    }
+  }
+
+  // about 10^7 complex MACs, but at least 10 buffers
+  loops = 10000000 / (n * nparts);
+
+  if (loops < 10) { loops = 10; }
+
+  run_cmac (cmac_kernels[kernel], accum, x, m, nparts, n);
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+
+  for (l = 0; l < loops; l++) {
+    run_cmac (cmac_kernels[kernel], accum, x, m, nparts, n);
+  }
+
+  clock_gettime (CLOCK_MONOTONIC, &te);
+  us = ((te.tv_sec - ts.tv_sec) * 1.0e6 + (te.tv_nsec - ts.tv_nsec) * 1.0e-3) / loops;
+
+  for (p = 0; p < nparts; p++) {
+    _aligned_free (x[p]);
+    _aligned_free (m[p]);
+  }
+
+  _aligned_free (m);
+  _aligned_free (x);
+  _aligned_free (accum);
+  return us;
+}
@@ -0,0 +1,61 @@
+/*  cmac.h
+
+This file is part of a program that implements a Software-Defined Radio.
+
+Copyright (C) 2025 Heiko Amft, DL1BZ
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+/********************************************************************************************************
+*                                                   *
+*         Complex Multiply-Accumulate Kernels for the Partitioned Overlap-Save Filter     *
+*                                                   *
+********************************************************************************************************/
+
+//
+// accum[i] = sum over p of x[p][i] * m[p][i], for n complex values in
+// the (interleaved) FFTW layout. Implementations for plain C, AVX2/FMA,
+// AVX-512 and NEON are compiled in where the compiler supports them,
+// the fastest one the CPU can execute is selected at run time.
+//
+
+#ifndef _cmac_h
+#define _cmac_h
+
+enum _cmac_kernel {
+  CMAC_SCALAR = 0,
+  CMAC_AVX2,
+  CMAC_AVX512,
+  CMAC_NEON,
+  CMAC_NUM_KERNELS
+};
+
+extern void init_cmac (void);
+
+extern void xcmac (FFTREAL* accum, FFTREAL** x, FFTREAL** m, int nparts, int n);
+
+extern int GetFirKernel (void);
+
+extern void SetFirKernel (int kernel);
+
+extern int GetFirKernelAvailable (int kernel);
+
+extern const char* GetFirKernelName (int kernel);
+
+extern double FirKernelBenchmark (int kernel, int size, int nparts);
+
+#endif
@@ -0,0 +1,169 @@
+/*  cmdq.c
+
+This file is part of a program that implements a Software-Defined Radio.
+
+Copyright (C) 2025 Heiko Amft, DL1BZ
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+#include "comm.h"
+
+static cmdq cmdqs[MAX_CHANNELS];
+
+//
+// Make room for a call: returns the slot to be filled, or 0 if the queue is
+// not used (disabled, called by the DSP thread itself, channel not exchanging
+// data, queue full). In the latter case, the queued calls are executed first
+// such that the order is preserved, and then the caller does the call itself.
+//
+static cmdq_item* cmdq_slot (int channel, long* pos) {
+  CMDQ q = &cmdqs[channel];
+  cmdq_item* it;
+  long dif;
+
+  if (!q->run || q->applying) { return 0; }
+
+  if (_InterlockedAnd (&ch[channel].exchange, 1)) {
+    *pos = q->tail;
+
+    for (;;) {
+      it = &q->item[*pos & (CMDQ_SIZE - 1)];
+      dif = it->seq - *pos;
+
+      if (dif == 0) {
+        if (InterlockedCompareExchange (&q->tail, *pos + 1, *pos) == *pos) { return it; }
+
+        *pos = q->tail;
+      } else if (dif < 0) {
+        break;
+      } else {
+        *pos = q->tail;
+      }
+    }
+  }
+
+  EnterCriticalSection (&ch[channel].csDSP);
+
+  if (!q->applying) { xcmdq (channel); }
+
+  LeaveCriticalSection (&ch[channel].csDSP);
+  InterlockedIncrement (&q->direct);
+  return 0;
+}
+
+static void cmdq_publish (int channel, cmdq_item* it, long pos) {
+  MemoryBarrier ();
+  it->seq = pos + 1;
+  InterlockedIncrement (&cmdqs[channel].queued);
+}
+
+//
+// Called at the top of a setter: returns 1 if the call has been queued
+// (the setter then returns), 0 if the setter has to do its work now.
+//
+int queue_cmdI (int channel, void (*fn)(int, int), int value) {
+  long pos;
+  cmdq_item* it = cmdq_slot (channel, &pos);
+
+  if (!it) { return 0; }
+
+  it->fni = fn;
+  it->fnd = 0;
+  it->ival = value;
+  cmdq_publish (channel, it, pos);
+  return 1;
+}
+
+int queue_cmdD (int channel, void (*fn)(int, double), double value) {
+  long pos;
+  cmdq_item* it = cmdq_slot (channel, &pos);
+
+  if (!it) { return 0; }
+
+  it->fni = 0;
+  it->fnd = fn;
+  it->dval = value;
+  cmdq_publish (channel, it, pos);
+  return 1;
+}
+
+//
+// Execute the queued calls, csDSP must be held
+//
+void xcmdq (int channel) {
+  CMDQ q = &cmdqs[channel];
+  cmdq_item* it;
+  void (*fni)(int, int);
+  void (*fnd)(int, double);
+  int ival;
+  double dval;
+  long pos = q->head;
+  q->applying = 1;
+
+  for (;;) {
+    it = &q->item[pos & (CMDQ_SIZE - 1)];
+
+    if (it->seq != pos + 1) { break; }
+
+    MemoryBarrier ();
+    fni = it->fni;
+    fnd = it->fnd;
+    ival = it->ival;
+    dval = it->dval;
+    MemoryBarrier ();
+    it->seq = pos + CMDQ_SIZE;
+    pos++;
+
+    if (fni) { fni (channel, ival); }
+    else { fnd (channel, dval); }
+  }
+
+  q->head = pos;
+  q->applying = 0;
+}
+
+PORT
+void SetChannelCommandQueue (int channel, int run) {
+  CMDQ q = &cmdqs[channel];
+  int i;
+  EnterCriticalSection (&ch[channel].csDSP);
+
+  if (run && !q->run) {
+    for (i = 0; i < CMDQ_SIZE; i++) {
+      q->item[i].seq = i;
+    }
+
+    q->head = 0;
+    q->tail = 0;
+    q->queued = 0;
+    q->direct = 0;
+    MemoryBarrier ();
+    q->run = 1;
+  } else if (!run && q->run) {
+    q->run = 0;
+    MemoryBarrier ();
+    xcmdq (channel);
+  }
+
+  LeaveCriticalSection (&ch[channel].csDSP);
+}
+
+PORT
+void GetChannelCommandQueueStats (int channel, long* queued, long* direct) {
+  *queued = cmdqs[channel].queued;
+  *direct = cmdqs[channel].direct;
+}
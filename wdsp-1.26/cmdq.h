@@ -0,0 +1,70 @@
+/*  cmdq.h
+
+This file is part of a program that implements a Software-Defined Radio.
+
+Copyright (C) 2025 Heiko Amft, DL1BZ
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+/********************************************************************************************************
+*                                                   *
+*                 Lock-Free Command Queue for Parameter Updates               *
+*                                                   *
+********************************************************************************************************/
+
+//
+// If enabled for a channel, setters that are typically driven by sliders
+// (gains, squelch thresholds, shift frequency) do not wait for csDSP, which
+// is held by the DSP thread for a complete buffer. They put the call into a
+// bounded multi-producer queue instead, and the DSP thread executes the
+// queued calls between two buffers.
+//
+
+#ifndef _cmdq_h
+#define _cmdq_h
+
+#define CMDQ_SIZE 64      // must be a power of two
+
+typedef struct _cmdq_item {
+  volatile long seq;    // sequence number, tells whether the slot is free or filled
+  void (*fni)(int, int);
+  void (*fnd)(int, double);
+  int ival;
+  double dval;
+} cmdq_item;
+
+typedef struct _cmdq {
+  int run;          // queue enabled
+  volatile long applying;   // DSP thread is executing queued calls
+  volatile long tail;     // next slot to fill (producers)
+  long head;          // next slot to execute (consumer, holding csDSP)
+  volatile long queued;   // statistics: calls executed via the queue
+  volatile long direct;   // statistics: calls executed immediately
+  cmdq_item item[CMDQ_SIZE];
+} cmdq, *CMDQ;
+
+extern int queue_cmdI (int channel, void (*fn)(int, int), int value);
+
+extern int queue_cmdD (int channel, void (*fn)(int, double), double value);
+
+extern void xcmdq (int channel);
+
+extern void SetChannelCommandQueue (int channel, int run);
+
+extern void GetChannelCommandQueueStats (int channel, long* queued, long* direct);
+
+#endif
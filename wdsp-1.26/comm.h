@@ -45,6 +45,22 @@ warren@wpratt.com
 #endif
 #include "fftw3.h"
 
+//
+// Precision of the FFT-based filter kernel (fircore), of the spectral
+// noise reduction (emnr) and compander (cfcomp), and of the analyzer
+// FFTs. Compile with -DWDSP_FLOAT to use single-precision FFTW (fftwf)
+// and float buffers inside these kernels only. The buffers passed
+// between the DSP modules stay in double precision, so the memory traffic
+// at the stage boundaries is the same in both builds.
+//
+#ifdef WDSP_FLOAT
+  #define FFTREAL             float
+  #define FFTW(name)          fftwf_ ## name
+#else
+  #define FFTREAL             double
+  #define FFTW(name)          fftw_ ## name
+#endif
+
 #include "amd.h"
 #include "ammod.h"
 #include "amsq.h"
@@ -57,15 +73,20 @@ warren@wpratt.com
 #include "cfcomp.h"
 #include "cfir.h"
 #include "channel.h"
+#include "cmac.h"
+#include "cmdq.h"
 #include "compress.h"
 #include "delay.h"
 #include "dexp.h"
 #include "div.h"
+#include "dspload.h"
+#include "dsppool.h"
 #include "eer.h"
 #include "emnr.h"
 #include "emph.h"
 #include "eq.h"
 #include "fcurve.h"
+#include "fdlms.h"
 #include "fir.h"
 #include "firmin.h"
 #include "fmd.h"
@@ -87,6 +108,7 @@ warren@wpratt.com
 #include "nobII.h"
 #include "osctrl.h"
 #include "patchpanel.h"
+#include "pipeline.h"
 #include "resample.h"
 #include "rmatch.h"
 #include "RXA.h"
@@ -133,6 +155,7 @@ warren@wpratt.com
 // wisdom definitions
 #define MAX_WISDOM_SIZE_DISPLAY     262144
 #define MAX_WISDOM_SIZE_FILTER      262144        // was 32769
+extern int wisdom_rigor;                          // planner flags, see wisdom.c
 
 // math definitions
 #define PI                3.1415926535897932
@@ -140,4 +163,44 @@ warren@wpratt.com
 
 // miscellaneous
 typedef double complex[2];
+typedef FFTREAL fftcomplex[2];
 #define PORT              __declspec( dllexport )
+
+#ifndef _fftcopy_h
+#define _fftcopy_h
+
+//
+// Copy n complex samples from a (double) buffer of the DSP chain into a
+// buffer of an FFT kernel, and back
+//
+static inline void fft_load (FFTREAL* dst, const double* src, int n) {
+#ifdef WDSP_FLOAT
+  int i;
+
+  for (i = 0; i < 2 * n; i++) {
+    dst[i] = (FFTREAL)src[i];
+  }
+
+#else
+  memcpy (dst, src, n * sizeof (complex));
+#endif
+}
+
+static inline void fft_store (double* dst, const FFTREAL* src, int n) {
+#ifdef WDSP_FLOAT
+  int i;
+
+  for (i = 0; i < 2 * n; i++) {
+    dst[i] = (double)src[i];
+  }
+
+#else
+
+  if (dst != src) {
+    memcpy (dst, src, n * sizeof (complex));
+  }
+
+#endif
+}
+
+#endif
@@ -102,6 +102,8 @@ SetTXACompressorRun (int channel, int run) {
 
 PORT void
 SetTXACompressorGain (int channel, double gain) {
+  if (queue_cmdD (channel, SetTXACompressorGain, gain)) { return; }
+
   EnterCriticalSection (&ch[channel].csDSP);
   txa[channel].compressor.p->gain = pow (10.0, gain / 20.0);
   LeaveCriticalSection (&ch[channel].csDSP);
@@ -0,0 +1,96 @@
+/*  dspload.c
+
+This file is part of a program that implements a Software-Defined Radio.
+
+Copyright (C) 2025 Heiko Amft, DL1BZ
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+#include "comm.h"
+
+//
+// 'index' is the channel number, or the display number for DSPLOAD_SPECTRUM.
+// Each counter is only updated by the one thread doing that work for the
+// channel (display), so no locking is needed.
+//
+static dspload_count counts[DSPLOAD_NCOUNTERS][dMAX_DISPLAYS];
+
+volatile long dspload_run = 0;
+
+double dspload_now (void) {
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1.0e9 + ts.tv_nsec;
+}
+
+void dspload_add (int counter, int index, double t0) {
+  dspload_count* c = &counts[counter][index];
+  double dt = dspload_now () - t0;
+  c->ns += dt;
+
+  if (dt > c->peak) { c->peak = dt; }
+
+  c->count++;
+}
+
+/********************************************************************************************************
+*                                                   *
+*                           Properties                          *
+*                                                   *
+********************************************************************************************************/
+
+PORT
+void SetDSPLoadRun (int run) {
+  if (run) { InterlockedBitTestAndSet (&dspload_run, 0); }
+  else { InterlockedBitTestAndReset (&dspload_run, 0); }
+}
+
+PORT
+void ResetDSPLoad (int index) {
+  // all counters for this channel (display) number
+  int i;
+
+  if (index < 0 || index >= dMAX_DISPLAYS) { return; }
+
+  for (i = 0; i < DSPLOAD_NCOUNTERS; i++) {
+    memset (&counts[i][index], 0, sizeof (dspload_count));
+  }
+}
+
+PORT
+void GetDSPLoad (int counter, int index, double* avg_us, double* peak_us, long* count) {
+  // average and worst case time per call since reset, in microseconds
+  dspload_count c;
+
+  if (counter < 0 || counter >= DSPLOAD_NCOUNTERS || index < 0 || index >= dMAX_DISPLAYS) {
+    *avg_us = *peak_us = 0.0;
+    *count = 0;
+    return;
+  }
+
+  c = counts[counter][index];
+  *avg_us = (c.count > 0) ? 1.0e-3 * c.ns / c.count : 0.0;
+  *peak_us = 1.0e-3 * c.peak;
+  *count = c.count;
+}
+
+PORT
+double GetDSPLoadPeriod (int channel) {
+  // the signal time of one DSP buffer of the channel, in microseconds: the
+  // budget for processing it (DSPLOAD_XMAIN and the stage times)
+  return 1.0e6 * ch[channel].dsp_size / ch[channel].dsp_rate;
+}
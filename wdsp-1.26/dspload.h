@@ -0,0 +1,67 @@
+/*  dspload.h
+
+This file is part of a program that implements a Software-Defined Radio.
+
+Copyright (C) 2025 Heiko Amft, DL1BZ
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+/********************************************************************************************************
+*                                                   *
+*                      DSP Load Counters                          *
+*                                                   *
+********************************************************************************************************/
+
+//
+// Time spent per call in the entry points that do the work of a channel, to
+// find out which channel (and, with the stage timing of RXA.c/TXA.c, which
+// block) uses the CPU. Counting is switched on and off globally, when off
+// it costs a single flag test per call.
+//
+
+#ifndef _dspload_h
+#define _dspload_h
+
+enum _dspload_counter {
+  DSPLOAD_XMAIN = 0,    // processing one DSP buffer, per channel
+  DSPLOAD_FEXCHANGE,    // fexchange0() and fexchange0_commit(), per channel
+  DSPLOAD_SPECTRUM,     // Spectrum0(), per display
+  DSPLOAD_CALCC,      // PureSignal correction calculation, per (TXA) channel
+  DSPLOAD_NCOUNTERS
+};
+
+typedef struct _dspload_count {
+  long count;         // number of calls since reset
+  double ns;          // accumulated time
+  double peak;        // worst case
+} dspload_count;
+
+extern volatile long dspload_run;
+
+extern double dspload_now (void);
+
+extern void dspload_add (int counter, int index, double t0);
+
+extern void SetDSPLoadRun (int run);
+
+extern void ResetDSPLoad (int index);
+
+extern void GetDSPLoad (int counter, int index, double* avg_us, double* peak_us, long* count);
+
+extern double GetDSPLoadPeriod (int channel);
+
+#endif
@@ -0,0 +1,183 @@
+/*  dsppool.c
+
+This file is part of a program that implements a Software-Defined Radio.
+
+Copyright (C) 2025 Heiko Amft, DL1BZ
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+#include "comm.h"
+
+static struct _dsppool {
+  volatile long run;
+  volatile long nthreads;   // number of workers currently running
+  int cpu[DSPPOOL_MAX_THREADS]; // CPU to bind worker to, -1 for none
+  HANDLE Sem_Work;      // one count per buffer posted to a pooled channel
+  volatile long next;     // where the next worker starts scanning the channels
+} dsppool;
+
+static void bind_worker (int cpu) {
+  if (cpu < 0) { return; }
+
+#if defined(_WIN32)
+  SetThreadAffinityMask (GetCurrentThread (), (DWORD_PTR)1 << cpu);
+#elif defined(__linux__)
+  cpu_set_t cpuset;
+  CPU_ZERO (&cpuset);
+  CPU_SET (cpu, &cpuset);
+  pthread_setaffinity_np (pthread_self (), sizeof (cpuset), &cpuset);
+#endif
+}
+
+//
+// Run all buffers posted to a channel, unless another worker is already
+// doing so. While a channel is re-built, pre_main_destroy() holds the
+// claim, so the workers keep off.
+//
+static void serve_channel (int channel) {
+  if (ch[channel].pool_pending <= 0) { return; }
+
+  if (InterlockedCompareExchange (&ch[channel].pool_claim, 1, 0) != 0) { return; }
+
+  do {
+    for (;;) {
+      EnterCriticalSection (&ch[channel].csDSP);
+
+      if (!_InterlockedAnd (&ch[channel].run, 1) || ch[channel].pool_pending <= 0) {
+        LeaveCriticalSection (&ch[channel].csDSP);
+        break;
+      }
+
+      InterlockedDecrement (&ch[channel].pool_pending);
+      xmain (channel);
+      LeaveCriticalSection (&ch[channel].csDSP);
+    }
+
+    InterlockedExchange (&ch[channel].pool_claim, 0);
+    // a buffer may have been posted after the last check
+  } while (ch[channel].pool_pending > 0
+           && InterlockedCompareExchange (&ch[channel].pool_claim, 1, 0) == 0);
+}
+
+static void dsppool_worker (void* pargs) {
+#if defined(_WIN32)
+  DWORD taskIndex = 0;
+  HANDLE hTask = AvSetMmThreadCharacteristics(TEXT("Pro Audio"), &taskIndex);
+
+  if (hTask != 0) { AvSetMmThreadPriority(hTask, 2); }
+  else { SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_HIGHEST); }
+
+#endif
+  int i, start;
+  bind_worker (dsppool.cpu[(int)(uintptr_t)pargs]);
+
+  while (_InterlockedAnd (&dsppool.run, 1)) {
+    WaitForSingleObject (dsppool.Sem_Work, INFINITE);
+    start = (int)(InterlockedIncrement (&dsppool.next) % MAX_CHANNELS);
+
+    for (i = 0; i < MAX_CHANNELS; i++) {
+      serve_channel ((start + i) % MAX_CHANNELS);
+    }
+  }
+
+  InterlockedDecrement (&dsppool.nthreads);
+#if defined(_WIN32)
+
+  if (hTask != 0) { AvRevertMmThreadCharacteristics (hTask); }
+
+#endif
+}
+
+void post_dsppool (int channel, int n) {
+  InterlockedExchangeAdd (&ch[channel].pool_pending, n);
+  ReleaseSemaphore (dsppool.Sem_Work, n, 0);
+}
+
+//
+// Start the pool with nthreads workers, the i-th bound to cpus[i] if cpus
+// is not NULL (and cpus[i] >= 0). Returns the number of workers running.
+//
+PORT
+int CreateDSPPool (int nthreads, int* cpus) {
+  int i;
+
+  if (_InterlockedAnd (&dsppool.run, 1)) { return dsppool.nthreads; }
+
+  if (nthreads < 1) { nthreads = 1; }
+
+  if (nthreads > DSPPOOL_MAX_THREADS) { nthreads = DSPPOOL_MAX_THREADS; }
+
+  dsppool.Sem_Work = CreateSemaphore(0, 0, 1000000, 0);
+  InterlockedBitTestAndSet (&dsppool.run, 0);
+
+  for (i = 0; i < nthreads; i++) {
+    dsppool.cpu[i] = cpus ? cpus[i] : -1;
+    InterlockedIncrement (&dsppool.nthreads);
+    _beginthread (dsppool_worker, 0, (void *)(uintptr_t)i);
+  }
+
+  return nthreads;
+}
+
+//
+// All channels are moved back to their own threads before the pool stops
+//
+PORT
+void DestroyDSPPool (void) {
+  int i, n;
+
+  if (!_InterlockedAnd (&dsppool.run, 1)) { return; }
+
+  for (i = 0; i < MAX_CHANNELS; i++) {
+    if (ch[i].pooled) { SetChannelDSPPool (i, 0); }
+  }
+
+  InterlockedBitTestAndReset (&dsppool.run, 0);
+  n = dsppool.nthreads;
+  ReleaseSemaphore (dsppool.Sem_Work, n, 0);
+
+  while (_InterlockedAnd (&dsppool.nthreads, 0xffffffff)) { Sleep (1); }
+
+  CloseHandle (dsppool.Sem_Work);
+}
+
+PORT
+int GetDSPPoolThreads (void) {
+  return _InterlockedAnd (&dsppool.run, 1) ? dsppool.nthreads : 0;
+}
+
+//
+// Move a channel to the pool (pooled=1) or back to its own thread. The
+// channel may or may not be open; if it is, its i/o buffers are rebuilt
+// as in SetInputBuffsize().
+//
+PORT
+void SetChannelDSPPool (int channel, int pooled) {
+  pooled = pooled && _InterlockedAnd (&dsppool.run, 1);
+
+  if (pooled == ch[channel].pooled) { return; }
+
+  if (_InterlockedAnd (&ch[channel].run, 1)) {
+    pre_main_destroy (channel);
+    post_main_destroy (channel);
+    ch[channel].pooled = pooled;
+    pre_main_build (channel);
+    post_main_build (channel);
+  } else {
+    ch[channel].pooled = pooled;
+  }
+}
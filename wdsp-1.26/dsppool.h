@@ -0,0 +1,51 @@
+/*  dsppool.h
+
+This file is part of a program that implements a Software-Defined Radio.
+
+Copyright (C) 2025 Heiko Amft, DL1BZ
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+/********************************************************************************************************
+*                                                   *
+*                     Shared DSP Thread Pool                      *
+*                                                   *
+********************************************************************************************************/
+
+//
+// Instead of having its own wdspmain thread, a channel can be run by a
+// pool of worker threads shared by all such channels. The workers are
+// optionally bound to CPU cores. A channel is executed by at most one
+// worker at a time, so its buffers are still processed in order.
+//
+
+#ifndef _dsppool_h
+#define _dsppool_h
+
+#define DSPPOOL_MAX_THREADS 16
+
+extern void post_dsppool (int channel, int n);
+
+extern int CreateDSPPool (int nthreads, int* cpus);
+
+extern void DestroyDSPPool (void);
+
+extern int GetDSPPoolThreads (void);
+
+extern void SetChannelDSPPool (int channel, int pooled);
+
+#endif
@@ -155,6 +155,122 @@ double e1xb (double x) {
   return e1;
 }
 
+/********************************************************************************************************
+*                                                   *
+*                     Fast Gain Functions                       *
+*                                                   *
+********************************************************************************************************/
+
+// The functions below are used by calc_gain() for gain methods 0 and 1 when
+// 'fast_gain' is set. They contain no branches and no library calls other than
+// sqrt(), such that the compiler can vectorize the loops over the bins.
+//
+// fexp():   exp(x) for |x| <= 700 by range reduction to |r| <= ln(2)/2 and a
+//           degree 10 Taylor polynomial, relative error < 1.0e-13.
+//
+// Gain method 0 needs exp(-v/2) * I0(v/2) and exp(-v/2) * I1(v/2).  These are
+// evaluated with the same polynomial approximations as bessI0() and bessI1(), but
+// with the exponentials cancelled analytically, such that one fexp() per bin
+// remains. The result differs from the reference by rounding errors (< 1.0e-12).
+//
+// Gain method 1 needs exp(E1(v)/2). For v <= 1, E1(v) = P(v) - ln(v) (Abramowitz
+// and Stegun 5.1.53, absolute error < 2.5e-7), hence exp(E1(v)/2) = exp(P(v)/2) / sqrt(v)
+// and no logarithm is needed. For v > 1, v * exp(v) * E1(v) = R(v) (5.1.54, absolute
+// error < 2.0e-8). The relative error of the mask is thereby below 1.5e-7.
+
+static inline double fexp (double x) {
+  union {
+    double d;
+    long long i;
+  } s;
+  double t, r, p;
+  x = x < -700.0 ? -700.0 : x;
+  x = x >  700.0 ?  700.0 : x;
+  s.d = x * 1.4426950408889634 + 6755399441055744.0;        // n = round (x / ln(2))
+  t = s.d - 6755399441055744.0;
+  r = x - t * 6.93147180369123816490e-01 - t * 1.90821492927058770002e-10;
+  p = (((((((((  2.7557319223985893e-07  * r
+                 + 2.7557319223985888e-06) * r
+               + 2.4801587301587302e-05) * r
+              + 1.9841269841269841e-04) * r
+             + 1.3888888888888889e-03) * r
+            + 8.3333333333333333e-03) * r
+           + 4.1666666666666667e-02) * r
+          + 1.6666666666666667e-01) * r
+         + 0.5) * r
+        + 1.0) * r
+      + 1.0;
+  s.i = (s.i - 0x4338000000000000LL + 1023) << 52;          // 2^n
+  return p * s.d;
+}
+
+static inline double fgain_mmse (double v, double gamma, double gf1p5) {
+  // gf1p5 * sqrt(v) / gamma * exp(-v/2) * ((1 + v) * I0(v/2) + v * I1(v/2))
+  double x, p, e, rs, i0s, i1s, i0l, i1l;
+  x = 0.5 * v;
+  e = fexp (- x);
+  p = x * (1.0 / 3.75);
+  p = p * p;
+  i0s = e
+        * ((((((  0.0045813  * p
+                  + 0.0360768) * p
+                + 0.2659732) * p
+               + 1.2067492) * p
+              + 3.0899424) * p
+             + 3.5156229) * p
+           + 1.0);
+  i1s = e * x
+        * (((((( 0.00032411  * p
+                 + 0.00301532) * p
+               + 0.02658733) * p
+              + 0.15084934) * p
+             + 0.51498869) * p
+            + 0.87890594) * p
+           + 0.5);
+  p = 3.75 / x;
+  rs = 1.0 / sqrt (x);
+  i0l = rs
+        * (((((((( + 0.00392377  * p
+                   - 0.01647633) * p
+                 + 0.02635537) * p
+                - 0.02057706) * p
+               + 0.00916281) * p
+              - 0.00157565) * p
+             + 0.00225319) * p
+            + 0.01328592) * p
+           + 0.39894228);
+  i1l = rs
+        * (((((((( - 0.00420059  * p
+                   + 0.01787654) * p
+                 - 0.02895312) * p
+                + 0.02282967) * p
+               - 0.01031555) * p
+              + 0.00163801) * p
+             - 0.00362018) * p
+            - 0.03988024) * p
+           + 0.39894228);
+  i0s = x <= 3.75 ? i0s : i0l;
+  i1s = x <= 3.75 ? i1s : i1l;
+  return gf1p5 * sqrt (v) / gamma * ((1.0 + v) * i0s + v * i1s);
+}
+
+static inline double fexp_e1 (double v) {
+  // exp(min(700, E1(v) / 2)), the limit is reached for v = 0 only
+  double e, ps, rl, t;
+  e = fexp (- v);
+  ps = ((((( 0.00107857  * v
+             - 0.00976004) * v
+           + 0.05519968) * v
+          - 0.24991055) * v
+         + 0.99999193) * v
+        - 0.57721566);
+  rl = ((((v + 8.5733287401) * v + 18.0590169730) * v + 8.6347608925) * v + 0.2677737343)
+       / ((((v + 9.5733223454) * v + 25.6329561486) * v + 21.0996530827) * v + 3.9584969228);
+  t = v <= 1.0 ? 0.5 * ps : 0.5 * rl * e / v;
+  t = fexp (t) * (v <= 1.0 ? 1.0 / sqrt (v) : 1.0);
+  return v > 0.0 ? t : fexp (700.0);
+}
+
 /********************************************************************************************************
 *                                                   *
 *                     Main Body of Code                     *
@@ -347,11 +463,11 @@ void calc_emnr(EMNR a) {
   a->msize = a->fsize / 2 + 1;
   a->window = (double *)malloc0(a->fsize * sizeof(double));
   a->inaccum = (double *)malloc0(a->iasize * sizeof(double));
-  a->forfftin = (double *)malloc0(a->fsize * sizeof(double));
-  a->forfftout = (double *)malloc0(a->msize * sizeof(complex));
+  a->forfftin = (FFTREAL *)malloc0(a->fsize * sizeof(FFTREAL));
+  a->forfftout = (FFTREAL *)malloc0(a->msize * sizeof(fftcomplex));
   a->mask = (double *)malloc0(a->msize * sizeof(double));
-  a->revfftin = (double *)malloc0(a->msize * sizeof(complex));
-  a->revfftout = (double *)malloc0(a->fsize * sizeof(double));
+  a->revfftin = (FFTREAL *)malloc0(a->msize * sizeof(fftcomplex));
+  a->revfftout = (FFTREAL *)malloc0(a->fsize * sizeof(FFTREAL));
   a->save = (double **)malloc0(a->ovrlp * sizeof(double *));
 
   for (i = 0; i < a->ovrlp; i++) {
@@ -361,8 +477,8 @@ void calc_emnr(EMNR a) {
   a->outaccum = (double *)malloc0(a->oasize * sizeof(double));
   a->nsamps = 0;
   a->saveidx = 0;
-  a->Rfor = fftw_plan_dft_r2c_1d(a->fsize, a->forfftin, (fftw_complex *)a->forfftout, FFTW_ESTIMATE);
-  a->Rrev = fftw_plan_dft_c2r_1d(a->fsize, (fftw_complex *)a->revfftin, a->revfftout, FFTW_ESTIMATE);
+  a->Rfor = FFTW(plan_dft_r2c_1d)(a->fsize, a->forfftin, (FFTW(complex) *)a->forfftout, FFTW_ESTIMATE);
+  a->Rrev = FFTW(plan_dft_c2r_1d)(a->fsize, (FFTW(complex) *)a->revfftin, a->revfftout, FFTW_ESTIMATE);
   calc_window(a);
   //
   // g
@@ -630,8 +746,8 @@ void decalc_emnr(EMNR a) {
   _aligned_free(a->g.lambda_d);
   _aligned_free(a->g.lambda_y);
   //
-  fftw_destroy_plan(a->Rrev);
-  fftw_destroy_plan(a->Rfor);
+  FFTW(destroy_plan)(a->Rrev);
+  FFTW(destroy_plan)(a->Rfor);
   _aligned_free(a->outaccum);
 
   for (i = 0; i < a->ovrlp; i++) {
@@ -664,6 +780,7 @@ EMNR create_emnr (int run, int position, int size, double* in, double* out, int
   a->g.gain_method = gain_method;
   a->g.npe_method = npe_method;
   a->g.ae_run = ae_run;
+  a->g.fast_gain = 1;
   calc_emnr (a);
   return a;
 }
@@ -1011,11 +1128,78 @@ int getZeta( EMNR a, double gamma, double eps, double* zeta) {
   return 0;
 }
 
+// Gain methods 0 and 1 with the fast functions, see above.
+// The loops over the bins have no dependencies between bins.
+
+static void calc_gain_mmse_fast (EMNR a) {
+  double* mask = a->g.mask;
+  double* lambda_y = a->g.lambda_y;
+  double* lambda_d = a->g.lambda_d;
+  double* prev_mask = a->g.prev_mask;
+  double* prev_gamma = a->g.prev_gamma;
+  const int msize = a->msize;
+  const double alpha = a->g.alpha;
+  const double eps_floor = a->g.eps_floor;
+  const double gamma_max = a->g.gamma_max;
+  const double xi_min = a->g.xi_min;
+  const double gmax = a->g.gmax;
+  const double gf1p5 = a->g.gf1p5;
+  const double qr = a->g.q / (1.0 - a->g.q);
+  const double iq = 1.0 / (1.0 - a->g.q);
+  double snr, gamma, eps_hat, v, m;
+  int k;
+
+  for (k = 0; k < msize; k++) {
+    snr = lambda_y[k] / lambda_d[k];
+    gamma = min (snr, gamma_max);
+    eps_hat = alpha * prev_mask[k] * prev_mask[k] * prev_gamma[k]
+              + (1.0 - alpha) * max (gamma - 1.0, eps_floor);
+    eps_hat = max (eps_hat, xi_min);
+    v = (eps_hat / (1.0 + eps_hat)) * gamma;
+    m = fgain_mmse (v, gamma, gf1p5);
+    // witchHat / (1 + witchHat) = 1 / (1 + q / (1 - q) * (1 + eps) * exp(-v))
+    m *= 1.0 / (1.0 + qr * (1.0 + m * m * snr * iq) * fexp (- min (v, 700.0)));
+    m = m > gmax ? gmax : m;
+    m = m != m ? 0.01 : m;
+    prev_gamma[k] = gamma;
+    prev_mask[k] = m;
+    mask[k] = m;
+  }
+}
+
+static void calc_gain_lsa_fast (EMNR a) {
+  double* mask = a->g.mask;
+  double* lambda_y = a->g.lambda_y;
+  double* lambda_d = a->g.lambda_d;
+  double* prev_mask = a->g.prev_mask;
+  double* prev_gamma = a->g.prev_gamma;
+  const int msize = a->msize;
+  const double alpha = a->g.alpha;
+  const double eps_floor = a->g.eps_floor;
+  const double gamma_max = a->g.gamma_max;
+  const double gmax = a->g.gmax;
+  double gamma, eps_hat, ehr, m;
+  int k;
+
+  for (k = 0; k < msize; k++) {
+    gamma = min (lambda_y[k] / lambda_d[k], gamma_max);
+    eps_hat = alpha * prev_mask[k] * prev_mask[k] * prev_gamma[k]
+              + (1.0 - alpha) * max (gamma - 1.0, eps_floor);
+    ehr = eps_hat / (1.0 + eps_hat);
+    m = ehr * fexp_e1 (ehr * gamma);
+    m = m > gmax ? gmax : m;
+    m = m != m ? 0.01 : m;
+    prev_gamma[k] = gamma;
+    prev_mask[k] = m;
+    mask[k] = m;
+  }
+}
+
 void calc_gain (EMNR a) {
   int k;
 
   for (k = 0; k < a->g.msize; k++) {
-    a->g.lambda_y[k] = a->g.y[2 * k + 0] * a->g.y[2 * k + 0] + a->g.y[2 * k + 1] * a->g.y[2 * k + 1];
+    a->g.lambda_y[k] = (double)a->g.y[2 * k + 0] * a->g.y[2 * k + 0] + (double)a->g.y[2 * k + 1] * a->g.y[2 * k + 1];
   }
 
   switch (a->g.npe_method) {
@@ -1036,6 +1220,11 @@ void calc_gain (EMNR a) {
   case 0: {
     double gamma, eps_hat, v;
 
+    if (a->g.fast_gain) {
+      calc_gain_mmse_fast (a);
+      break;
+    }
+
     for (k = 0; k < a->g.msize; k++) {
       gamma = min (a->g.lambda_y[k] / a->g.lambda_d[k], a->g.gamma_max);
       eps_hat = a->g.alpha * a->g.prev_mask[k] * a->g.prev_mask[k] * a->g.prev_gamma[k]
@@ -1066,6 +1255,11 @@ void calc_gain (EMNR a) {
   case 1: {
     double gamma, eps_hat, v, ehr;
 
+    if (a->g.fast_gain) {
+      calc_gain_lsa_fast (a);
+      break;
+    }
+
     for (k = 0; k < a->g.msize; k++) {
       gamma = min (a->g.lambda_y[k] / a->g.lambda_d[k], a->g.gamma_max);
       eps_hat = a->g.alpha * a->g.prev_mask[k] * a->g.prev_mask[k] * a->g.prev_gamma[k]
@@ -1158,24 +1352,42 @@ void calc_gain (EMNR a) {
 
 void xemnr (EMNR a, int pos) {
   if (a->run && pos == a->position) {
-    int i, j, k, sbuff, sbegin;
+    int i, j, n, sbuff;
     double g1;
+    double* src;
+    double* dst;
 
-    for (i = 0; i < 2 * a->bsize; i += 2) {
-      a->inaccum[a->iainidx] = a->in[i];
-      a->iainidx = (a->iainidx + 1) % a->iasize;
+    // The rings are at least as long as any block that is written to or read
+    // from them, so each access wraps at most once and is done in two pieces.
+    n = min (a->bsize, a->iasize - a->iainidx);
+    dst = a->inaccum + a->iainidx;
+
+    for (i = 0; i < n; i++) {
+      dst[i] = a->in[2 * i];
     }
 
+    for (i = n; i < a->bsize; i++) {
+      a->inaccum[i - n] = a->in[2 * i];
+    }
+
+    a->iainidx = (a->iainidx + a->bsize) % a->iasize;
     a->nsamps += a->bsize;
 
     while (a->nsamps >= a->fsize) {
-      for (i = 0, j = a->iaoutidx; i < a->fsize; i++, j = (j + 1) % a->iasize) {
-        a->forfftin[i] = a->window[i] * a->inaccum[j];
+      n = min (a->fsize, a->iasize - a->iaoutidx);
+      src = a->inaccum + a->iaoutidx;
+
+      for (i = 0; i < n; i++) {
+        a->forfftin[i] = a->window[i] * src[i];
+      }
+
+      for (i = n; i < a->fsize; i++) {
+        a->forfftin[i] = a->window[i] * a->inaccum[i - n];
       }
 
       a->iaoutidx = (a->iaoutidx + a->incr) % a->iasize;
       a->nsamps -= a->incr;
-      fftw_execute (a->Rfor);
+      FFTW(execute) (a->Rfor);
       calc_gain(a);
 
       for (i = 0; i < a->msize; i++) {
@@ -1184,21 +1396,37 @@ void xemnr (EMNR a, int pos) {
         a->revfftin[2 * i + 1] = g1 * a->forfftout[2 * i + 1];
       }
 
-      fftw_execute (a->Rrev);
+      FFTW(execute) (a->Rrev);
 
       for (i = 0; i < a->fsize; i++) {
         a->save[a->saveidx][i] = a->window[i] * a->revfftout[i];
       }
 
+      n = min (a->incr, a->oasize - a->oainidx);
+      dst = a->outaccum + a->oainidx;
+
       for (i = a->ovrlp; i > 0; i--) {
-        sbuff = (a->saveidx + i) % a->ovrlp;
-        sbegin = a->incr * (a->ovrlp - i);
-
-        for (j = sbegin, k = a->oainidx; j < a->incr + sbegin; j++, k = (k + 1) % a->oasize) {
-          if ( i == a->ovrlp) {
-            a->outaccum[k]  = a->save[sbuff][j];
-          } else {
-            a->outaccum[k] += a->save[sbuff][j];
+        sbuff = a->saveidx + i;
+
+        if (sbuff >= a->ovrlp) { sbuff -= a->ovrlp; }
+
+        src = a->save[sbuff] + a->incr * (a->ovrlp - i);
+
+        if (i == a->ovrlp) {
+          for (j = 0; j < n; j++) {
+            dst[j] = src[j];
+          }
+
+          for (j = n; j < a->incr; j++) {
+            a->outaccum[j - n] = src[j];
+          }
+        } else {
+          for (j = 0; j < n; j++) {
+            dst[j] += src[j];
+          }
+
+          for (j = n; j < a->incr; j++) {
+            a->outaccum[j - n] += src[j];
           }
         }
       }
@@ -1207,11 +1435,20 @@ void xemnr (EMNR a, int pos) {
       a->oainidx = (a->oainidx + a->incr) % a->oasize;
     }
 
-    for (i = 0; i < a->bsize; i++) {
-      a->out[2 * i + 0] = a->outaccum[a->oaoutidx];
+    n = min (a->bsize, a->oasize - a->oaoutidx);
+    src = a->outaccum + a->oaoutidx;
+
+    for (i = 0; i < n; i++) {
+      a->out[2 * i + 0] = src[i];
+      a->out[2 * i + 1] = 0.0;
+    }
+
+    for (i = n; i < a->bsize; i++) {
+      a->out[2 * i + 0] = a->outaccum[i - n];
       a->out[2 * i + 1] = 0.0;
-      a->oaoutidx = (a->oaoutidx + 1) % a->oasize;
     }
+
+    a->oaoutidx = (a->oaoutidx + a->bsize) % a->oasize;
   } else if (a->out != a->in) {
     memcpy (a->out, a->in, a->bsize * sizeof (complex));
   }
@@ -1275,11 +1512,19 @@ void SetRXAEMNRaeRun (int channel, int run) {
   LeaveCriticalSection (&ch[channel].csDSP);
 }
 
+PORT
+void SetRXAEMNRfastGain (int channel, int run) {
+  EnterCriticalSection (&ch[channel].csDSP);
+  rxa[channel].emnr.p->g.fast_gain = run;
+  LeaveCriticalSection (&ch[channel].csDSP);
+}
+
 PORT
 void SetRXAEMNRPosition (int channel, int position) {
   EnterCriticalSection (&ch[channel].csDSP);
   rxa[channel].emnr.p->position = position;
   rxa[channel].bp1.p->position  = position;
+  RXAPipeCheck (channel);
   LeaveCriticalSection (&ch[channel].csDSP);
 }
 
@@ -39,12 +39,12 @@ typedef struct _emnr {
   double* window;
   int iasize;
   double* inaccum;
-  double* forfftin;
-  double* forfftout;
+  FFTREAL* forfftin;
+  FFTREAL* forfftout;
   int msize;
   double* mask;
-  double* revfftin;
-  double* revfftout;
+  FFTREAL* revfftin;
+  FFTREAL* revfftout;
   double** save;
   int oasize;
   double* outaccum;
@@ -59,15 +59,16 @@ typedef struct _emnr {
   int oainidx;
   int oaoutidx;
   int saveidx;
-  fftw_plan Rfor;
-  fftw_plan Rrev;
+  FFTW(plan) Rfor;
+  FFTW(plan) Rrev;
   struct _g {
     int gain_method;
     int npe_method;
     int ae_run;
+    int fast_gain;
     double msize;
     double* mask;
-    double* y;
+    FFTREAL* y;
     double* lambda_y;
     double* lambda_d;
     double* prev_mask;
@@ -0,0 +1,168 @@
+/*  emnrcheck.c
+
+This file is part of a program that implements a Software-Defined Radio.
+
+Copyright (C) 2025 Heiko Amft, DL1BZ
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+/********************************************************************************************************
+*                                                   *
+*                     EMNR Fast Gain Comparison                   *
+*                                                   *
+********************************************************************************************************/
+
+//
+// emnrcheck compares the gain mask of the fast gain functions of the EMNR
+// (fast_gain, see emnr.c) with that of the exact ones, for gain methods 0
+// and 1 and noise power estimation methods 0 and 1. It is not part of the
+// library, "make gaincheck" (and "make check") builds and runs it.
+//
+//   emnrcheck [-n frames] [-s fft-size]
+//
+// Two EMNR instances, one with and one without fast_gain, get the same
+// synthetic spectra: complex Gaussian noise whose level drops by 60 dB
+// now and then, plus carriers that sweep from 30 dB below to 50 dB above
+// the noise, and occasional wide-band bursts. This covers the a-posteriori
+// SNR (gamma) from far below 1 up to gamma_max. Before each frame, the
+// mask history of the exact instance is copied to the fast one, such that
+// the deviation of each frame is that of the gain functions alone.
+//
+// Reported is the largest relative deviation of the mask, it must not
+// exceed
+//
+//   method 0 (MMSE):  1.0e-10  (the fast path only differs by rounding)
+//   method 1 (LSA):   1.0e-6   (E1 approximation, Abramowitz and Stegun)
+//
+// return values of main()
+//
+//  0  all deviations within the bounds
+//  1  bad command line
+//  3  at least one deviation exceeds its bound
+//
+
+#include "comm.h"
+#include "checkutil.h"
+#include <unistd.h>
+
+extern void calc_gain (EMNR a);
+
+static const double bound[2] = { 1.0e-10, 1.0e-6 };
+
+//
+// Spectrum of frame 'n' into the FFT output buffer y (msize bins)
+//
+static void fill_spectrum (FFTREAL* y, int msize, int n) {
+  int k;
+  double noise = (n / 50) % 4 == 3 ? 1.0e-3 : 1.0;       // 60 dB drop
+  double tone = pow (10.0, (-30.0 + 80.0 * ((n % 100) / 99.0)) / 20.0);
+  double burst = n % 37 == 0 ? 300.0 : 0.0;
+
+  for (k = 0; k < msize; k++) {
+    double re = noise * check_gauss ();
+    double im = noise * check_gauss ();
+
+    if (k % 97 == 13 || k % 211 == 50) { re += tone; }
+
+    if (burst > 0.0 && k > msize / 4 && k < msize / 2) { re += burst * check_gauss (); }
+
+    y[2 * k + 0] = (FFTREAL) re;
+    y[2 * k + 1] = (FFTREAL) im;
+  }
+}
+
+//
+// Run 'nframes' frames through both instances, return the largest
+// relative deviation of the masks
+//
+static double run_case (int gain_method, int npe_method, int fsize, int nframes) {
+  EMNR a[2];
+  double* buf;
+  double dev = 0.0;
+  int i, n, msize;
+  check_seed (4711);
+  buf = (double *) malloc0 (fsize * sizeof (complex));
+
+  for (i = 0; i < 2; i++) {
+    a[i] = create_emnr (1, 0, fsize, buf, buf, fsize, 4, 48000, 0, 1.0, gain_method, npe_method, 0);
+    a[i]->g.fast_gain = i;
+  }
+
+  msize = a[0]->msize;
+
+  for (n = 0; n < nframes; n++) {
+    fill_spectrum (a[0]->g.y, msize, n);
+    memcpy (a[1]->g.y, a[0]->g.y, msize * sizeof (fftcomplex));
+    memcpy (a[1]->g.prev_mask, a[0]->g.prev_mask, msize * sizeof (double));
+    memcpy (a[1]->g.prev_gamma, a[0]->g.prev_gamma, msize * sizeof (double));
+    calc_gain (a[0]);
+    calc_gain (a[1]);
+    dev = fmax (dev, check_max_reldev (a[0]->g.mask, a[1]->g.mask, msize));
+  }
+
+  for (i = 0; i < 2; i++) {
+    destroy_emnr (a[i]);
+  }
+
+  _aligned_free (buf);
+  return dev;
+}
+
+static void usage (void) {
+  fprintf (stderr, "usage: emnrcheck [-n frames] [-s fft-size]\n");
+}
+
+int main (int argc, char** argv) {
+  int nframes = 400, fsize = 4096;
+  int opt, gm, npe, failed = 0;
+
+  while ((opt = getopt (argc, argv, "n:s:")) != -1) {
+    switch (opt) {
+    case 'n':
+      nframes = atoi (optarg);
+      break;
+
+    case 's':
+      fsize = atoi (optarg);
+      break;
+
+    default:
+      usage ();
+      return 1;
+    }
+  }
+
+  if (argc != optind || nframes < 1 || fsize < 64 || (fsize & (fsize - 1)) != 0) {
+    usage ();
+    return 1;
+  }
+
+  // the plans are not used here
+  wisdom_rigor = FFTW_ESTIMATE;
+
+  for (gm = 0; gm <= 1; gm++) {
+    for (npe = 0; npe <= 1; npe++) {
+      double dev = run_case (gm, npe, fsize, nframes);
+      printf ("gain method %d, npe method %d: max. relative deviation %.3e (bound %.1e)%s\n",
+              gm, npe, dev, bound[gm], dev > bound[gm] ? "  EXCEEDED" : "");
+
+      if (dev > bound[gm]) { failed++; }
+    }
+  }
+
+  return failed ? 3 : 0;
+}
@@ -106,6 +106,7 @@ PORT
 void SetTXAFMEmphPosition (int channel, int position) {
   EnterCriticalSection (&ch[channel].csDSP);
   txa[channel].preemph.p->position = position;
+  TXAPipeCheck (channel);
   LeaveCriticalSection (&ch[channel].csDSP);
 }
 
@@ -169,9 +170,9 @@ void calc_emph (EMPH a) {
   a->mults = fc_mults(a->size, a->f_low, a->f_high, -20.0 * log10(a->f_high / a->f_low), 0.0, a->ctype, a->rate,
                       1.0 / (2.0 * a->size), 0, 0);
   a->CFor = fftw_plan_dft_1d(2 * a->size, (fftw_complex *)a->infilt, (fftw_complex *)a->product, FFTW_FORWARD,
-                             FFTW_PATIENT);
+                             wisdom_rigor);
   a->CRev = fftw_plan_dft_1d(2 * a->size, (fftw_complex *)a->product, (fftw_complex *)a->out, FFTW_BACKWARD,
-                             FFTW_PATIENT);
+                             wisdom_rigor);
 }
 
 void decalc_emph (EMPH a) {
@@ -284,6 +284,7 @@ PORT
 void SetRXAEQRun (int channel, int run) {
   EnterCriticalSection (&ch[channel].csDSP);
   rxa[channel].eqp.p->run = run;
+  RXAPipeCheck (channel);
   LeaveCriticalSection (&ch[channel].csDSP);
 }
 
@@ -425,6 +426,7 @@ PORT
 void SetTXAEQRun (int channel, int run) {
   EnterCriticalSection (&ch[channel].csDSP);
   txa[channel].eqp.p->run = run;
+  TXAPipeCheck (channel);
   LeaveCriticalSection (&ch[channel].csDSP);
 }
 
@@ -574,9 +576,9 @@ void calc_eq (EQ a) {
   a->infilt = (double *)malloc0(2 * a->size * sizeof(complex));
   a->product = (double *)malloc0(2 * a->size * sizeof(complex));
   a->CFor = fftw_plan_dft_1d(2 * a->size, (fftw_complex *)a->infilt, (fftw_complex *)a->product, FFTW_FORWARD,
-                             FFTW_PATIENT);
+                             wisdom_rigor);
   a->CRev = fftw_plan_dft_1d(2 * a->size, (fftw_complex *)a->product, (fftw_complex *)a->out, FFTW_BACKWARD,
-                             FFTW_PATIENT);
+                             wisdom_rigor);
   a->mults = eq_mults(a->size, a->nfreqs, a->F, a->G, a->samplerate, a->scale, a->ctfmode, a->wintype);
 }
 
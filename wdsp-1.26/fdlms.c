@@ -0,0 +1,142 @@
+/*  fdlms.c
+
+This file is part of a program that implements a Software-Defined Radio.
+
+Copyright (C) 2025 Heiko Amft, DL1BZ
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+#include "comm.h"
+
+FDLMS create_fdlms (int n, int delay) {
+  FDLMS a = (FDLMS) malloc0 (sizeof (fdlms));
+  a->n = n;
+  a->delay = delay;
+  a->m = 2 * n;
+  a->xr = (double *) malloc0 ((2 * n + delay) * sizeof (double));
+  a->e = (double *) malloc0 (n * sizeof (double));
+  a->tbuff = (FFTREAL *) malloc0 (a->m * sizeof (FFTREAL));
+  a->U = (FFTREAL *) malloc0 ((n + 1) * sizeof (fftcomplex));
+  a->W = (FFTREAL *) malloc0 ((n + 1) * sizeof (fftcomplex));
+  a->F = (FFTREAL *) malloc0 ((n + 1) * sizeof (fftcomplex));
+  a->Ptfor = FFTW(plan_dft_r2c_1d) (a->m, a->tbuff, (FFTW(complex) *)a->F, FFTW_ESTIMATE);
+  a->Ptrev = FFTW(plan_dft_c2r_1d) (a->m, (FFTW(complex) *)a->F, a->tbuff, FFTW_ESTIMATE);
+  return a;
+}
+
+void destroy_fdlms (FDLMS a) {
+  FFTW(destroy_plan) (a->Ptrev);
+  FFTW(destroy_plan) (a->Ptfor);
+  _aligned_free (a->F);
+  _aligned_free (a->W);
+  _aligned_free (a->U);
+  _aligned_free (a->tbuff);
+  _aligned_free (a->e);
+  _aligned_free (a->xr);
+  _aligned_free (a);
+}
+
+void flush_fdlms (FDLMS a) {
+  memset (a->xr, 0, (2 * a->n + a->delay) * sizeof (double));
+  memset (a->W, 0, (a->n + 1) * sizeof (fftcomplex));
+}
+
+//
+// Processes 'size' complex samples (a multiple of n), only the real part is used.
+// The output is the prediction (ANR) or the prediction error (ANF). 'two_mu' and
+// 'c0' (the leakage factor) have the same meaning as in the time-domain filters.
+//
+void xfdlms (FDLMS a, double* in, double* out, int size, int out_error, double two_mu, double c0) {
+  int i, k, b;
+  const int n = a->n;
+  const double scale = 1.0 / (double)a->m;
+  const double cn = pow (c0, (double)n);
+  double ur, ui, er, ei, pw, y, sigma;
+
+  for (b = 0; b < size; b += n) {
+    memmove (a->xr, a->xr + n, (n + a->delay) * sizeof (double));
+
+    for (i = 0; i < n; i++) {
+      a->xr[n + a->delay + i] = in[2 * (b + i) + 0];
+    }
+
+    // spectrum of the reference window, 2 * n samples ending 'delay' samples ago
+    for (i = 0; i < a->m; i++) {
+      a->tbuff[i] = a->xr[i];
+    }
+
+    FFTW(execute) (a->Ptfor);
+    memcpy (a->U, a->F, (n + 1) * sizeof (fftcomplex));
+
+    // filter output, the last n samples of the circular convolution are valid
+    for (k = 0; k <= n; k++) {
+      ur = a->U[2 * k + 0];
+      ui = a->U[2 * k + 1];
+      a->F[2 * k + 0] = ur * a->W[2 * k + 0] - ui * a->W[2 * k + 1];
+      a->F[2 * k + 1] = ur * a->W[2 * k + 1] + ui * a->W[2 * k + 0];
+    }
+
+    FFTW(execute) (a->Ptrev);
+
+    for (i = 0; i < n; i++) {
+      y = scale * a->tbuff[n + i];
+      a->e[i] = in[2 * (b + i) + 0] - y;
+      out[2 * (b + i) + 0] = out_error ? a->e[i] : y;
+      out[2 * (b + i) + 1] = 0.0;
+    }
+
+    // error spectrum
+    for (i = 0; i < n; i++) {
+      a->tbuff[i] = 0.0;
+      a->tbuff[n + i] = a->e[i];
+    }
+
+    FFTW(execute) (a->Ptfor);
+
+    // gradient, normalised like the time-domain NLMS (energy of n taps = half the window)
+    sigma = 0.0;
+
+    for (i = 0; i < a->m; i++) {
+      sigma += a->xr[i] * a->xr[i];
+    }
+
+    pw = two_mu / (0.5 * sigma + 1.0e-10);
+
+    for (k = 0; k <= n; k++) {
+      ur = a->U[2 * k + 0];
+      ui = a->U[2 * k + 1];
+      er = a->F[2 * k + 0];
+      ei = a->F[2 * k + 1];
+      a->F[2 * k + 0] = pw * (ur * er + ui * ei);
+      a->F[2 * k + 1] = pw * (ur * ei - ui * er);
+    }
+
+    FFTW(execute) (a->Ptrev);
+
+    // gradient constraint: keep the first n lags (causal part) only
+    for (i = 0; i < n; i++) {
+      a->tbuff[i] *= scale;
+      a->tbuff[n + i] = 0.0;
+    }
+
+    FFTW(execute) (a->Ptfor);
+
+    for (k = 0; k < 2 * (n + 1); k++) {
+      a->W[k] = cn * a->W[k] + a->F[k];
+    }
+  }
+}
@@ -0,0 +1,62 @@
+/*  fdlms.h
+
+This file is part of a program that implements a Software-Defined Radio.
+
+Copyright (C) 2025 Heiko Amft, DL1BZ
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+/********************************************************************************************************
+*                                                   *
+*             Frequency-Domain Block LMS Engine for the ANR and ANF Filters           *
+*                                                   *
+********************************************************************************************************/
+
+//
+// Overlap-save block LMS with gradient constraint. The block length equals
+// the number of taps, and the FFT size is twice as large. The weights are
+// updated once per block with the gradient summed over the block and the
+// step size normalised to the input power as in the time-domain NLMS. The
+// cost per sample is O(log(n_taps)) instead of O(n_taps).
+//
+
+#ifndef _fdlms_h
+#define _fdlms_h
+
+typedef struct _fdlms {
+  int n;                      // taps, also the block length
+  int delay;                  // decorrelation delay of the reference
+  int m;                      // FFT size, 2 * n
+  double* xr;                 // input history, 2 * n + delay samples
+  double* e;                  // error of the current block
+  FFTREAL* tbuff;             // time domain work buffer
+  FFTREAL* U;                 // spectrum of the reference window
+  FFTREAL* W;                 // spectrum of the weights
+  FFTREAL* F;                 // frequency domain work buffer
+  FFTW(plan) Ptfor;
+  FFTW(plan) Ptrev;
+} fdlms, *FDLMS;
+
+extern FDLMS create_fdlms (int n, int delay);
+
+extern void destroy_fdlms (FDLMS a);
+
+extern void flush_fdlms (FDLMS a);
+
+extern void xfdlms (FDLMS a, double* in, double* out, int size, int out_error, double two_mu, double c0);
+
+#endif
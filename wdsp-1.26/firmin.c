@@ -136,13 +136,13 @@ void plan_firopt (FIROPT a) {
     a->fftout[i] = (double *) malloc0 (2 * a->size * sizeof (complex));
     a->fmask[i] = (double *) malloc0 (2 * a->size * sizeof (complex));
     a->pcfor[i] = fftw_plan_dft_1d(2 * a->size, (fftw_complex *)a->fftin, (fftw_complex *)a->fftout[i], FFTW_FORWARD,
-                                   FFTW_PATIENT);
+                                   wisdom_rigor);
     a->maskplan[i] = fftw_plan_dft_1d(2 * a->size, (fftw_complex *)a->maskgen, (fftw_complex *)a->fmask[i], FFTW_FORWARD,
-                                      FFTW_PATIENT);
+                                      wisdom_rigor);
   }
 
   a->accum = (double *) malloc0 (2 * a->size * sizeof (complex));
-  a->crev = fftw_plan_dft_1d(2 * a->size, (fftw_complex *)a->accum, (fftw_complex *)a->out, FFTW_BACKWARD, FFTW_PATIENT);
+  a->crev = fftw_plan_dft_1d(2 * a->size, (fftw_complex *)a->accum, (fftw_complex *)a->out, FFTW_BACKWARD, wisdom_rigor);
 }
 
 void calc_firopt (FIROPT a) {
@@ -284,38 +284,46 @@ void plan_fircore (FIRCORE a) {
   a->cset = 0;
   a->buffidx = 0;
   a->idxmask = a->nfor - 1;
-  a->fftin = (double *) malloc0 (2 * a->size * sizeof (complex));
-  a->fftout   = (double **) malloc0 (a->nfor * sizeof (double *));
-  a->fmask    = (double ***) malloc0 (2 * sizeof (double **));
-  a->fmask[0] = (double **) malloc0 (a->nfor * sizeof (double *));
-  a->fmask[1] = (double **) malloc0 (a->nfor * sizeof (double *));
-  a->maskgen = (double *) malloc0 (2 * a->size * sizeof (complex));
-  a->pcfor = (fftw_plan *) malloc0 (a->nfor * sizeof (fftw_plan));
-  a->maskplan    = (fftw_plan **) malloc0 (2 * sizeof (fftw_plan *));
-  a->maskplan[0] = (fftw_plan *) malloc0 (a->nfor * sizeof (fftw_plan));
-  a->maskplan[1] = (fftw_plan *) malloc0 (a->nfor * sizeof (fftw_plan));
+  a->fftin = (FFTREAL *) malloc0 (2 * a->size * sizeof (fftcomplex));
+  a->fftout   = (FFTREAL **) malloc0 (a->nfor * sizeof (FFTREAL *));
+  a->xord     = (FFTREAL **) malloc0 (a->nfor * sizeof (FFTREAL *));
+  a->fmask    = (FFTREAL ***) malloc0 (2 * sizeof (FFTREAL **));
+  a->fmask[0] = (FFTREAL **) malloc0 (a->nfor * sizeof (FFTREAL *));
+  a->fmask[1] = (FFTREAL **) malloc0 (a->nfor * sizeof (FFTREAL *));
+  a->maskgen = (FFTREAL *) malloc0 (2 * a->size * sizeof (fftcomplex));
+  a->pcfor = (FFTW(plan) *) malloc0 (a->nfor * sizeof (FFTW(plan)));
+  a->maskplan    = (FFTW(plan) **) malloc0 (2 * sizeof (FFTW(plan) *));
+  a->maskplan[0] = (FFTW(plan) *) malloc0 (a->nfor * sizeof (FFTW(plan)));
+  a->maskplan[1] = (FFTW(plan) *) malloc0 (a->nfor * sizeof (FFTW(plan)));
 
   for (i = 0; i < a->nfor; i++) {
-    a->fftout[i]   = (double *) malloc0 (2 * a->size * sizeof (complex));
-    a->fmask[0][i] = (double *) malloc0 (2 * a->size * sizeof (complex));
-    a->fmask[1][i] = (double *) malloc0 (2 * a->size * sizeof (complex));
-    a->pcfor[i] = fftw_plan_dft_1d(2 * a->size, (fftw_complex *)a->fftin, (fftw_complex *)a->fftout[i], FFTW_FORWARD,
-                                   FFTW_PATIENT);
-    a->maskplan[0][i] = fftw_plan_dft_1d(2 * a->size, (fftw_complex *)a->maskgen, (fftw_complex *)a->fmask[0][i],
-                                         FFTW_FORWARD, FFTW_PATIENT);
-    a->maskplan[1][i] = fftw_plan_dft_1d(2 * a->size, (fftw_complex *)a->maskgen, (fftw_complex *)a->fmask[1][i],
-                                         FFTW_FORWARD, FFTW_PATIENT);
+    a->fftout[i]   = (FFTREAL *) malloc0 (2 * a->size * sizeof (fftcomplex));
+    a->fmask[0][i] = (FFTREAL *) malloc0 (2 * a->size * sizeof (fftcomplex));
+    a->fmask[1][i] = (FFTREAL *) malloc0 (2 * a->size * sizeof (fftcomplex));
+    a->pcfor[i] = FFTW(plan_dft_1d)(2 * a->size, (FFTW(complex) *)a->fftin, (FFTW(complex) *)a->fftout[i], FFTW_FORWARD,
+                                    wisdom_rigor);
+    a->maskplan[0][i] = FFTW(plan_dft_1d)(2 * a->size, (FFTW(complex) *)a->maskgen, (FFTW(complex) *)a->fmask[0][i],
+                                          FFTW_FORWARD, wisdom_rigor);
+    a->maskplan[1][i] = FFTW(plan_dft_1d)(2 * a->size, (FFTW(complex) *)a->maskgen, (FFTW(complex) *)a->fmask[1][i],
+                                          FFTW_FORWARD, wisdom_rigor);
   }
 
-  a->accum = (double *) malloc0 (2 * a->size * sizeof (complex));
-  a->crev = fftw_plan_dft_1d(2 * a->size, (fftw_complex *)a->accum, (fftw_complex *)a->out, FFTW_BACKWARD, FFTW_PATIENT);
+  a->accum = (FFTREAL *) malloc0 (2 * a->size * sizeof (fftcomplex));
+#ifdef WDSP_FLOAT
+  // the reverse fft cannot write to the (double) output buffer
+  a->revout = (FFTREAL *) malloc0 (2 * a->size * sizeof (fftcomplex));
+#else
+  a->revout = a->out;
+#endif
+  a->crev = FFTW(plan_dft_1d)(2 * a->size, (FFTW(complex) *)a->accum, (FFTW(complex) *)a->revout, FFTW_BACKWARD,
+                              wisdom_rigor);
   a->masks_ready = 0;
 }
 
 void calc_fircore (FIRCORE a, int flip) {
   // call for change in frequency, rate, wintype, gain
   // must also call after a call to plan_firopt()
-  int i;
+  int i, set;
 
   if (a->mp) {
     mp_imp (a->nc, a->impulse, a->imp, 16, 0);
@@ -323,11 +331,20 @@ void calc_fircore (FIRCORE a, int flip) {
     memcpy (a->imp, a->impulse, a->nc * sizeof (complex));
   }
 
+  // If the last flip happened while xfircore() was running, it may still
+  // use the set we are going to overwrite. xfircore() holds the lock only
+  // to pick up the current set, so we never block the audio thread.
+  EnterCriticalSection (&a->update);
+  set = 1 - a->cset;
+  LeaveCriticalSection (&a->update);
+
+  while (InterlockedAnd (&a->active, 3) == set + 1) { Sleep (0); }
+
   for (i = 0; i < a->nfor; i++) {
     // I right-justified the impulse response => take output from left side of output buff, discard right side
     // Be careful about flipping an asymmetrical impulse response.
-    memcpy (&(a->maskgen[2 * a->size]), &(a->imp[2 * a->size * i]), a->size * sizeof(complex));
-    fftw_execute (a->maskplan[1 - a->cset][i]);
+    fft_load (&(a->maskgen[2 * a->size]), &(a->imp[2 * a->size * i]), a->size);
+    FFTW(execute) (a->maskplan[set][i]);
   }
 
   a->masks_ready = 1;
@@ -348,6 +365,7 @@ FIRCORE create_fircore (int size, double* in, double* out, int nc, int mp, doubl
   a->nc = nc;
   a->mp = mp;
   InitializeCriticalSectionAndSpinCount (&a->update, 2500);
+  init_cmac ();
   plan_fircore (a);
   a->impulse = (double *) malloc0 (a->nc * sizeof (complex));
   a->imp     = (double *) malloc0 (a->nc * sizeof (complex));
@@ -358,16 +376,19 @@ FIRCORE create_fircore (int size, double* in, double* out, int nc, int mp, doubl
 
 void deplan_fircore (FIRCORE a) {
   int i;
-  fftw_destroy_plan (a->crev);
+  FFTW(destroy_plan) (a->crev);
+#ifdef WDSP_FLOAT
+  _aligned_free (a->revout);
+#endif
   _aligned_free (a->accum);
 
   for (i = 0; i < a->nfor; i++) {
     _aligned_free (a->fftout[i]);
     _aligned_free (a->fmask[0][i]);
     _aligned_free (a->fmask[1][i]);
-    fftw_destroy_plan (a->pcfor[i]);
-    fftw_destroy_plan (a->maskplan[0][i]);
-    fftw_destroy_plan (a->maskplan[1][i]);
+    FFTW(destroy_plan) (a->pcfor[i]);
+    FFTW(destroy_plan) (a->maskplan[0][i]);
+    FFTW(destroy_plan) (a->maskplan[1][i]);
   }
 
   _aligned_free (a->maskplan[0]);
@@ -378,6 +399,7 @@ void deplan_fircore (FIRCORE a) {
   _aligned_free (a->fmask[0]);
   _aligned_free (a->fmask[1]);
   _aligned_free (a->fmask);
+  _aligned_free (a->xord);
   _aligned_free (a->fftout);
   _aligned_free (a->fftin);
 }
@@ -392,44 +414,35 @@ void destroy_fircore (FIRCORE a) {
 
 void flush_fircore (FIRCORE a) {
   int i;
-  memset (a->fftin, 0, 2 * a->size * sizeof (complex));
+  memset (a->fftin, 0, 2 * a->size * sizeof (fftcomplex));
 
   for (i = 0; i < a->nfor; i++) {
-    memset (a->fftout[i], 0, 2 * a->size * sizeof (complex));
+    memset (a->fftout[i], 0, 2 * a->size * sizeof (fftcomplex));
   }
 
   a->buffidx = 0;
 }
 
 void xfircore (FIRCORE a) {
-  //[2.10.3.9]MW0LGE refactor to remove pointer chase in the loops
-  int i, j, k;
-  memcpy (&(a->fftin[2 * a->size]), a->in, a->size * sizeof (complex));
-  fftw_execute (a->pcfor[a->buffidx]);
-  k = a->buffidx;
-  memset (a->accum, 0, 2 * a->size * sizeof (complex));
+  int j, k, cset;
+  fft_load (&(a->fftin[2 * a->size]), a->in, a->size);
+  FFTW(execute) (a->pcfor[a->buffidx]);
   EnterCriticalSection (&a->update);
-  double* accum = a->accum;
-  double** fftout = a->fftout;
-  double*** fmask = a->fmask;
-  int cset = a->cset;
-  int idxmask = a->idxmask;
-  int sz = a->size;
-  int nfor = a->nfor;
-
-  for (j = 0; j < nfor; j++) {
-    for (i = 0; i < 2 * sz; i++) {
-      accum[2 * i + 0] += fftout[k][2 * i + 0] * fmask[cset][j][2 * i + 0] - fftout[k][2 * i + 1] * fmask[cset][j][2 * i + 1];
-      accum[2 * i + 1] += fftout[k][2 * i + 0] * fmask[cset][j][2 * i + 1] + fftout[k][2 * i + 1] * fmask[cset][j][2 * i + 0];
-    }
+  cset = a->cset;
+  InterlockedExchange (&a->active, cset + 1);
+  LeaveCriticalSection (&a->update);
 
-    k = (k + idxmask) & idxmask;
+  for (j = 0, k = a->buffidx; j < a->nfor; j++) {
+    a->xord[j] = a->fftout[k];
+    k = (k + a->idxmask) & a->idxmask;
   }
 
-  LeaveCriticalSection (&a->update);
-  a->buffidx = (a->buffidx + 1) & idxmask;
-  fftw_execute (a->crev);
-  memcpy (a->fftin, &(a->fftin[2 * a->size]), a->size * sizeof(complex));
+  xcmac (a->accum, a->xord, a->fmask[cset], a->nfor, 2 * a->size);
+  InterlockedExchange (&a->active, 0);
+  a->buffidx = (a->buffidx + 1) & a->idxmask;
+  FFTW(execute) (a->crev);
+  fft_store (a->out, a->revout, a->size);
+  memcpy (a->fftin, &(a->fftin[2 * a->size]), a->size * sizeof(fftcomplex));
 }
 
 void setBuffers_fircore (FIRCORE a, double* in, double* out) {
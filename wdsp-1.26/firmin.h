@@ -141,18 +141,21 @@ typedef struct _fircore {
   double* impulse;    // impulse response of filter
   double* imp;
   int nfor;       // number of buffers in delay line
-  double* fftin;      // fft input buffer
-  double*** fmask;    // frequency domain masks
-  double** fftout;    // fftout delay line
-  double* accum;      // frequency domain accumulator
+  FFTREAL* fftin;     // fft input buffer
+  FFTREAL*** fmask;   // frequency domain masks
+  FFTREAL** fftout;   // fftout delay line
+  FFTREAL* accum;     // frequency domain accumulator
+  FFTREAL* revout;    // reverse fft output, same as 'out' unless WDSP_FLOAT
+  FFTREAL** xord;     // fftout delay line in partition order, for xcmac()
   int buffidx;      // fft out buffer index
   int idxmask;      // mask for index computations
-  double* maskgen;    // input for mask generation FFT
-  fftw_plan* pcfor;   // array of forward FFT plans
-  fftw_plan crev;     // reverse fft plan
-  fftw_plan** maskplan; // plans for frequency domain masks
+  FFTREAL* maskgen;   // input for mask generation FFT
+  FFTW(plan)* pcfor;  // array of forward FFT plans
+  FFTW(plan) crev;    // reverse fft plan
+  FFTW(plan)** maskplan;  // plans for frequency domain masks
   CRITICAL_SECTION update;
   int cset;
+  volatile LONG active; // mask set in use by xfircore() + 1, 0 if none
   int mp;
   int masks_ready;
 } fircore, *FIRCORE;
@@ -241,11 +241,14 @@ PORT
 void SetRXAFMSQRun (int channel, int run) {
   EnterCriticalSection (&ch[channel].csDSP);
   rxa[channel].fmsq.p->run = run;
+  RXAPipeCheck (channel);
   LeaveCriticalSection (&ch[channel].csDSP);
 }
 
 PORT
 void SetRXAFMSQThreshold (int channel, double threshold) {
+  if (queue_cmdD (channel, SetRXAFMSQThreshold, threshold)) { return; }
+
   EnterCriticalSection (&ch[channel].csDSP);
   rxa[channel].fmsq.p->tail_thresh = threshold;
   rxa[channel].fmsq.p->unmute_thresh = 0.9 * threshold;
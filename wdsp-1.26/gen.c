@@ -559,6 +559,7 @@ PORT
 void SetRXAPreGenRun (int channel, int run) {
   EnterCriticalSection (&ch[channel].csDSP);
   rxa[channel].gen0.p->run = run;
+  RXAPipeCheck (channel);
   LeaveCriticalSection (&ch[channel].csDSP);
 }
 
@@ -628,6 +629,7 @@ PORT
 void SetTXAPreGenRun (int channel, int run) {
   EnterCriticalSection (&ch[channel].csDSP);
   txa[channel].gen0.p->run = run;
+  TXAPipeCheck (channel);
   LeaveCriticalSection (&ch[channel].csDSP);
 }
 
@@ -759,6 +761,7 @@ PORT
 void SetTXAPostGenRun (int channel, int run) {
   EnterCriticalSection (&ch[channel].csDSP);
   txa[channel].gen1.p->run = run;
+  TXAPipeCheck (channel);
   LeaveCriticalSection (&ch[channel].csDSP);
 }
 
@@ -318,6 +318,7 @@ void SetRXASPCWRun (int channel, int run) {
   SPEAK a = rxa[channel].speak.p;
   EnterCriticalSection (&a->cs_update);
   a->run = run;
+  RXAPipeCheck (channel);
   LeaveCriticalSection (&a->cs_update);
 }
 
@@ -482,6 +483,7 @@ void SetRXAmpeakRun (int channel, int run) {
   MPEAK a = rxa[channel].mpeak.p;
   EnterCriticalSection (&a->cs_update);
   a->run = run;
+  RXAPipeCheck (channel);
   LeaveCriticalSection (&a->cs_update);
 }
 
@@ -646,6 +648,7 @@ void SetTXAPHROTRun (int channel, int run) {
   PHROT a = txa[channel].phrot.p;
   EnterCriticalSection (&a->cs_update);
   a->run = run;
+  TXAPipeCheck (channel);
 
   if (a->run) { flush_phrot (a); }
 
@@ -677,6 +680,7 @@ void SetTXAPHROTReverse (int channel, int reverse) {
   PHROT a = txa[channel].phrot.p;
   EnterCriticalSection(&a->cs_update);
   a->reverse = reverse;
+  TXAPipeCheck (channel);
   LeaveCriticalSection(&a->cs_update);
 }
 
@@ -28,6 +28,11 @@ mw0lge@grange-lane.co.uk
 
 #define _CRT_SECURE_NO_WARNINGS
 #include "comm.h"
+#if defined(linux) || defined(__APPLE__)
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <fcntl.h>
+#endif
 
 /********************************************************************************************************
 *                                                   *
@@ -70,15 +75,101 @@ uint32_t fnv1a_hash32(const void* data, size_t len) {
 typedef struct _cache_entry {
   HASH_T  hash;
   int   N;              // N complex entries in impulse. Leave as signed int as that is used everywhere
+  int   mapped;           // impulse points into the mapped cache file, do not free
   double* impulse;
   struct _cache_entry* next;
 } cache_entry;
 
+//
+// Cache file layout. The file is mapped into memory as a whole and the
+// impulses are used in place, so even a large cache costs (almost) no
+// time at startup. All impulses start at a multiple of 64 bytes.
+//
+//   header                       cache_file_header
+//   index, bucket by bucket      cache_file_entry[sum of counts], most recently used first
+//   impulses                     double[2 * N] each
+//
+#define CACHE_FILE_MAGIC    "WDSPIMPC"
+#define CACHE_FILE_VERSION  2
+#define CACHE_FILE_ALIGN    64
+
+typedef struct _cache_file_header {
+  char    magic[8];
+  uint32_t  version;
+  uint32_t  buckets;
+  uint32_t  counts[CACHE_BUCKETS];
+} cache_file_header;
+
+typedef struct _cache_file_entry {
+  uint64_t  hash;
+  int32_t   N;
+  uint32_t  reserved;
+  uint64_t  offset;         // from the start of the file
+} cache_file_entry;
+
 static size_t _cache_counts[CACHE_BUCKETS] = { 0 };
 static cache_entry* _cache_heads[CACHE_BUCKETS] = { NULL };
 static CRITICAL_SECTION _cs_use_cache;
 static int _run = 0;
 static int _use_cache = 1;
+static long _hits = 0;
+static long _misses = 0;
+static void* _map = NULL;
+static size_t _map_size = 0;
+
+#if defined(linux) || defined(__APPLE__)
+static void* map_cache_file(const char* path, size_t* size) {
+  struct stat st;
+  void* p;
+  int fd = open(path, O_RDONLY);
+
+  if (fd < 0) { return NULL; }
+
+  if (fstat(fd, &st) != 0 || st.st_size <= 0) { close(fd); return NULL; }
+
+  p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+
+  if (p == MAP_FAILED) { return NULL; }
+
+  *size = st.st_size;
+  return p;
+}
+
+static void unmap_cache_file(void* p, size_t size) {
+  munmap(p, size);
+}
+#else
+static void* map_cache_file(const char* path, size_t* size) {
+  FILE* fp = fopen(path, "rb");
+  long len;
+  void* p;
+
+  if (!fp) { return NULL; }
+
+  fseek(fp, 0, SEEK_END);
+  len = ftell(fp);
+  fseek(fp, 0, SEEK_SET);
+
+  if (len <= 0 || (p = malloc0(len)) == NULL) { fclose(fp); return NULL; }
+
+  if (fread(p, 1, len, fp) != (size_t)len) { _aligned_free(p); fclose(fp); return NULL; }
+
+  fclose(fp);
+  *size = len;
+  return p;
+}
+
+static void unmap_cache_file(void* p, size_t size) {
+  _aligned_free(p);
+}
+#endif
+
+static void free_cache_entry(cache_entry* e) {
+  if (!e->mapped) { _aligned_free(e->impulse); }
+
+  _aligned_free(e);
+}
 
 void remove_impulse_cache_tail(size_t bucket) {
   if (bucket >= CACHE_BUCKETS) { return; }
@@ -90,8 +181,7 @@ void remove_impulse_cache_tail(size_t bucket) {
   }
 
   if (*pp) {
-    _aligned_free((*pp)->impulse);
-    _aligned_free(*pp);
+    free_cache_entry(*pp);
     *pp = NULL;
     _cache_counts[bucket]--;
   }
@@ -103,25 +193,31 @@ void free_impulse_cache(void) {
 
     while (e) {
       cache_entry* next = e->next;
-      _aligned_free(e->impulse);
-      _aligned_free(e);
+      free_cache_entry(e);
       e = next;
     }
 
     _cache_heads[b] = NULL;
     _cache_counts[b] = 0;
   }
+
+  if (_map) {
+    unmap_cache_file(_map, _map_size);
+    _map = NULL;
+    _map_size = 0;
+  }
 }
 
 double* get_impulse_cache_entry(size_t bucket, HASH_T hash) {
   if (!_run) { return NULL; }
 
-  int use;
+  double* imp = NULL;
   EnterCriticalSection(&_cs_use_cache);
-  use = _use_cache;
-  LeaveCriticalSection(&_cs_use_cache);
 
-  if (!use || bucket >= CACHE_BUCKETS) { return NULL; }
+  if (!_use_cache || bucket >= CACHE_BUCKETS) {
+    LeaveCriticalSection(&_cs_use_cache);
+    return NULL;
+  }
 
   // lru, least recently used, moves cache hit to head
   // old cache entries will move towards the tail and eventually be dumped
@@ -136,27 +232,34 @@ double* get_impulse_cache_entry(size_t bucket, HASH_T hash) {
         _cache_heads[bucket] = e;
       }
 
-      double* imp = (double*) malloc0(e->N * sizeof(complex));
+      imp = (double*) malloc0(e->N * sizeof(complex));
       memcpy(imp, e->impulse, e->N * sizeof(complex));
-      return imp;
+      break;
     }
 
     prev = e;
     e = e->next;
   }
 
-  return NULL;
+  if (imp) {
+    _hits++;
+  } else {
+    _misses++;
+  }
+
+  LeaveCriticalSection(&_cs_use_cache);
+  return imp;
 }
 
 void add_impulse_to_cache(size_t bucket, HASH_T hash, int N, double* impulse) {
   if (!_run) { return; }
 
-  int use;
   EnterCriticalSection(&_cs_use_cache);
-  use = _use_cache;
-  LeaveCriticalSection(&_cs_use_cache);
 
-  if (!use || bucket >= CACHE_BUCKETS) { return; }
+  if (!_use_cache || bucket >= CACHE_BUCKETS) {
+    LeaveCriticalSection(&_cs_use_cache);
+    return;
+  }
 
   if (_cache_counts[bucket] >= MAX_CACHE_ENTRIES) { remove_impulse_cache_tail(bucket); }
 
@@ -168,92 +271,160 @@ void add_impulse_to_cache(size_t bucket, HASH_T hash, int N, double* impulse) {
   e->next = _cache_heads[bucket];
   _cache_heads[bucket] = e;
   _cache_counts[bucket]++;
-}
-
-PORT
-int save_impulse_cache(const char* path) {
-  if (!_run) { return 0; }
-
-  int use;
-  EnterCriticalSection(&_cs_use_cache);
-  use = _use_cache;
   LeaveCriticalSection(&_cs_use_cache);
+}
 
-  if (!use) { return 0; }
-
-  FILE* fp = fopen(path, "wb");
+static int write_impulse_cache(FILE* fp) {
+  cache_file_header hdr;
+  cache_file_entry rec;
+  static const char zero[CACHE_FILE_ALIGN] = { 0 };
+  uint64_t offset, pad;
+  size_t total = 0;
+  memset(&hdr, 0, sizeof(hdr));
+  memcpy(hdr.magic, CACHE_FILE_MAGIC, sizeof(hdr.magic));
+  hdr.version = CACHE_FILE_VERSION;
+  hdr.buckets = CACHE_BUCKETS;
 
-  if (!fp) { return -1; }
+  for (size_t b = 0; b < CACHE_BUCKETS; b++) {
+    hdr.counts[b] = (uint32_t)_cache_counts[b];
+    total += _cache_counts[b];
+  }
 
-  uint32_t buckets = CACHE_BUCKETS;
+  if (fwrite(&hdr, sizeof(hdr), 1, fp) != 1) { return -1; }
 
-  if (fwrite(&buckets, sizeof(buckets), 1, fp) != 1) { fclose(fp); return -1; }
+  // first pass: index, the data offsets follow from the sizes
+  offset = sizeof(hdr) + total * sizeof(cache_file_entry);
+  offset = (offset + CACHE_FILE_ALIGN - 1) & ~(uint64_t)(CACHE_FILE_ALIGN - 1);
+  memset(&rec, 0, sizeof(rec));
 
   for (size_t b = 0; b < CACHE_BUCKETS; b++) {
-    uint32_t count = 0;
+    for (cache_entry * e = _cache_heads[b]; e; e = e->next) {
+      rec.hash = e->hash;
+      rec.N = e->N;
+      rec.offset = offset;
 
-    for (cache_entry * e = _cache_heads[b]; e; e = e->next) { count++; }
+      if (fwrite(&rec, sizeof(rec), 1, fp) != 1) { return -1; }
 
-    if (fwrite(&count, sizeof(count), 1, fp) != 1) { fclose(fp); return -1; }
+      offset += e->N * sizeof(complex);
+      offset = (offset + CACHE_FILE_ALIGN - 1) & ~(uint64_t)(CACHE_FILE_ALIGN - 1);
+    }
+  }
+
+  // second pass: impulses
+  offset = sizeof(hdr) + total * sizeof(cache_file_entry);
 
+  for (size_t b = 0; b < CACHE_BUCKETS; b++) {
     for (cache_entry * e = _cache_heads[b]; e; e = e->next) {
-      if (fwrite(&e->hash, sizeof(HASH_T), 1, fp) != 1) { fclose(fp); return -1; }
+      pad = (CACHE_FILE_ALIGN - offset % CACHE_FILE_ALIGN) % CACHE_FILE_ALIGN;
+
+      if (pad && fwrite(zero, 1, pad, fp) != pad) { return -1; }
 
-      if (fwrite(&e->N, sizeof(e->N), 1, fp) != 1) { fclose(fp); return -1; }
+      if (fwrite(e->impulse, sizeof(complex), e->N, fp) != (size_t)e->N) { return -1; }
 
-      if (fwrite(e->impulse, sizeof(complex), e->N, fp) != (size_t)e->N) { fclose(fp); return -1; }
+      offset += pad + e->N * sizeof(complex);
     }
   }
 
-  fclose(fp);
   return 0;
 }
 
 PORT
-int read_impulse_cache(const char* path) {
+int save_impulse_cache(const char* path) {
   if (!_run) { return 0; }
 
-  free_impulse_cache();
-  int use;
+  char tmp[1024];
+  int rc;
   EnterCriticalSection(&_cs_use_cache);
-  use = _use_cache;
-  LeaveCriticalSection(&_cs_use_cache);
 
-  if (!use) { return 0; }
+  if (!_use_cache) {
+    LeaveCriticalSection(&_cs_use_cache);
+    return 0;
+  }
 
-  FILE* fp = fopen(path, "rb");
+  //
+  // The old file may still be mapped, so do not overwrite it
+  // but write a new one and then replace the old one.
+  //
+  snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+  FILE* fp = fopen(tmp, "wb");
 
-  if (!fp) { return -1; }
+  if (!fp) {
+    LeaveCriticalSection(&_cs_use_cache);
+    return -1;
+  }
 
-  uint32_t buckets;
+  rc = write_impulse_cache(fp);
 
-  if (fread(&buckets, sizeof(buckets), 1, fp) != 1) { fclose(fp); return -1; }
+  if (fclose(fp) != 0) { rc = -1; }
 
-  if (buckets != CACHE_BUCKETS) { fclose(fp); return -1; }
+  LeaveCriticalSection(&_cs_use_cache);
 
-  for (size_t b = 0; b < buckets; b++) {
-    uint32_t count;
+  if (rc == 0) {
+    remove(path);
+    rc = rename(tmp, path) == 0 ? 0 : -1;
+  } else {
+    remove(tmp);
+  }
 
-    if (fread(&count, sizeof(count), 1, fp) != 1) { fclose(fp); return -1; }
+  return rc;
+}
 
-    cache_entry* tail = NULL;
+PORT
+int read_impulse_cache(const char* path) {
+  if (!_run) { return 0; }
+
+  EnterCriticalSection(&_cs_use_cache);
+  free_impulse_cache();
 
-    for (uint32_t i = 0; i < count; i++) {
-      HASH_T hash;
-      int    N;
+  if (!_use_cache) {
+    LeaveCriticalSection(&_cs_use_cache);
+    return 0;
+  }
+
+  size_t size = 0, total = 0;
+  unsigned char* base = map_cache_file(path, &size);
+  cache_file_header* hdr = (cache_file_header*)base;
+
+  if (!base) {
+    LeaveCriticalSection(&_cs_use_cache);
+    return -1;
+  }
+
+  if (size < sizeof(cache_file_header) || memcmp(hdr->magic, CACHE_FILE_MAGIC, sizeof(hdr->magic))
+      || hdr->version != CACHE_FILE_VERSION || hdr->buckets != CACHE_BUCKETS) {
+    unmap_cache_file(base, size);
+    LeaveCriticalSection(&_cs_use_cache);
+    return -1;
+  }
 
-      if (fread(&hash, sizeof(HASH_T), 1, fp) != 1) { fclose(fp); return -1; }
+  for (size_t b = 0; b < CACHE_BUCKETS; b++) { total += hdr->counts[b]; }
 
-      if (fread(&N, sizeof(N), 1, fp) != 1) { fclose(fp); return -1; }
+  if (total > (size - sizeof(cache_file_header)) / sizeof(cache_file_entry)) {
+    unmap_cache_file(base, size);
+    LeaveCriticalSection(&_cs_use_cache);
+    return -1;
+  }
+
+  _map = base;
+  _map_size = size;
+  const cache_file_entry* rec = (const cache_file_entry*)(base + sizeof(cache_file_header));
 
-      double* data = (double*)malloc0(N * sizeof(complex));
+  for (size_t b = 0; b < CACHE_BUCKETS; b++) {
+    cache_entry* tail = NULL;
 
-      if (fread(data, sizeof(complex), N, fp) != (size_t)N) { _aligned_free(data); fclose(fp); return -1; }
+    for (uint32_t i = 0; i < hdr->counts[b]; i++, rec++) {
+      if (rec->N <= 0 || rec->offset % CACHE_FILE_ALIGN || rec->offset > size
+          || (uint64_t)rec->N * sizeof(complex) > size - rec->offset) {
+        free_impulse_cache();
+        LeaveCriticalSection(&_cs_use_cache);
+        return -1;
+      }
 
       cache_entry* e = (cache_entry*)malloc0(sizeof(cache_entry));
-      e->hash = hash;
-      e->N = N;
-      e->impulse = data;
+      e->hash = (HASH_T)rec->hash;
+      e->N = rec->N;
+      e->mapped = 1;
+      e->impulse = (double*)(base + rec->offset);
       e->next = NULL;
 
       if (tail) {
@@ -267,7 +438,7 @@ int read_impulse_cache(const char* path) {
     }
   }
 
-  fclose(fp);
+  LeaveCriticalSection(&_cs_use_cache);
   return 0;
 }
 
@@ -278,6 +449,26 @@ void use_impulse_cache(int use) {
   LeaveCriticalSection(&_cs_use_cache);
 }
 
+PORT
+void GetImpulseCacheStats(long* hits, long* misses, int* entries) {
+  int n = 0;
+
+  if (!_run) {
+    *hits = *misses = 0;
+    *entries = 0;
+    return;
+  }
+
+  EnterCriticalSection(&_cs_use_cache);
+  *hits = _hits;
+  *misses = _misses;
+
+  for (size_t b = 0; b < CACHE_BUCKETS; b++) { n += (int)_cache_counts[b]; }
+
+  *entries = n;
+  LeaveCriticalSection(&_cs_use_cache);
+}
+
 PORT
 void init_impulse_cache(int use) {
   //InitializeCriticalSection(&_cs_use_cache);
@@ -417,6 +417,8 @@ void create_iobuffs (int channel) {
   a->r2_active_buffsize = DSP_MULT * a->r2_size;
   a->r1_baseptr = (double*) malloc0 (a->r1_active_buffsize * sizeof (complex));
   a->r2_baseptr = (double*) malloc0 (a->r2_active_buffsize * sizeof (complex));
+  a->zbuff = (double*) malloc0 (a->out_size * sizeof (complex));
+  a->obuff = (double*) malloc0 (a->out_size * sizeof (complex));
   a->r1_inidx = 0;
   a->r1_outidx = 0;
   a->r1_unqueuedsamps = 0;
@@ -447,6 +449,8 @@ void destroy_iobuffs (int channel) {
   CloseHandle (a->Sem_OutReady);
   CloseHandle (a->Sem_BuffReady);
   DeleteCriticalSection(&a->r2_ControlSection);
+  _aligned_free (a->obuff);
+  _aligned_free (a->zbuff);
   _aligned_free (a->r2_baseptr);
   _aligned_free (a->r1_baseptr);
   _aligned_free (a);
@@ -466,6 +470,8 @@ void flush_iobuffs (int channel) {
 
   while (!WaitForSingleObject (a->Sem_BuffReady, 1));
 
+  InterlockedExchange (&ch[channel].pool_pending, 0);
+
   n = a->r2_havesamps / a->out_size;
   a->r2_unqueuedsamps = a->r2_havesamps - n * a->out_size;
   CloseHandle (a->Sem_OutReady);
@@ -474,11 +480,23 @@ void flush_iobuffs (int channel) {
 }
 
 
+//
+// Hand n input buffers over to the channel's own DSP thread, or to the shared DSP pool
+//
+static void queue_buffs (int channel, IOB a, int n) {
+  if (ch[channel].pooled) {
+    post_dsppool (channel, n);
+  } else {
+    ReleaseSemaphore(a->Sem_BuffReady, n, 0);
+  }
+}
+
 PORT  //double, interleaved I/Q
 void fexchange0 (int channel, double* in, double* out, int* error) {
   int n;
   int doit = 0;
   IOB a;
+  double t0 = dspload_run ? dspload_now () : 0.0;
   *error = 0;
 
   if (_InterlockedAnd (&ch[channel].exchange, 1)) {
@@ -494,7 +512,7 @@ void fexchange0 (int channel, double* in, double* out, int* error) {
     // add check with *error += -1; for case when r1 is full and an overwrite occurs
     if ((a->r1_unqueuedsamps += a->in_size) >= a->r1_outsize) {
       n = a->r1_unqueuedsamps / a->r1_outsize;
-      ReleaseSemaphore(a->Sem_BuffReady, n, 0);
+      queue_buffs(channel, a, n);
       a->r1_unqueuedsamps -= n * a->r1_outsize;
     }
 
@@ -535,6 +553,8 @@ void fexchange0 (int channel, double* in, double* out, int* error) {
 
     LeaveCriticalSection (&ch[channel].csEXCH);
   }
+
+  if (t0 > 0.0) { dspload_add (DSPLOAD_FEXCHANGE, channel, t0); }
 }
 
 PORT  //separate I/Q buffers
@@ -559,7 +579,7 @@ void fexchange2 (int channel, INREAL *Iin, INREAL *Qin, OUTREAL *Iout, OUTREAL *
     // add check with *error += -1; for case when r1 is full and an overwrite occurs
     if ((a->r1_unqueuedsamps += a->in_size) >= a->r1_outsize) {
       n = a->r1_unqueuedsamps / a->r1_outsize;
-      ReleaseSemaphore(a->Sem_BuffReady, n, 0);
+      queue_buffs(channel, a, n);
       a->r1_unqueuedsamps -= n * a->r1_outsize;
     }
 
@@ -606,11 +626,110 @@ void fexchange2 (int channel, INREAL *Iin, INREAL *Qin, OUTREAL *Iout, OUTREAL *
   }
 }
 
+//
+// Version of fexchange0 without the input copy, split into two calls:
+//
+// fexchange0_acquire() returns the slot of the input ring where the next
+// 'in_size' complex samples go, or NULL if the channel does not exchange data.
+// The caller writes the samples there, and then calls fexchange0_commit().
+// This queues the slot for the DSP thread and returns the 'out_size' processed
+// samples. They remain valid until the next call to fexchange0_commit().
+// The output is copied from the output ring while csEXCH is held, as in
+// fexchange0(): the DSP thread writes the output ring without any lock, and
+// a slot handed out to the caller could be overwritten while the caller
+// still reads it. If no output is available, an all-zero buffer is
+// returned and *error is set, as in fexchange0(). NULL is returned if the
+// channel has stopped exchanging data; fexchange0() would then not touch the
+// output buffer.
+//
+// The slots must only be used by the thread doing the exchanges, and not
+// while the channel is being re-built (sample rate or buffer size changes).
+//
+
+PORT
+double* fexchange0_acquire (int channel) {
+  IOB a = ch[channel].iob.pe;
+
+  if (!_InterlockedAnd (&ch[channel].exchange, 1)) { return 0; }
+
+  return a->r1_baseptr + 2 * a->r1_inidx;
+}
+
+PORT
+double* fexchange0_commit (int channel, int* error) {
+  int n;
+  int doit = 0;
+  double* out = 0;
+  IOB a;
+  double t0 = dspload_run ? dspload_now () : 0.0;
+  *error = 0;
+
+  if (_InterlockedAnd (&ch[channel].exchange, 1)) {
+    EnterCriticalSection (&ch[channel].csEXCH);
+    a = ch[channel].iob.pe;
+
+    // the slew-up is done in place
+    if (_InterlockedAnd (&a->slew.upflag, 1)) {
+      upslew0 (a, a->r1_baseptr + 2 * a->r1_inidx);
+    }
+
+    if ((a->r1_unqueuedsamps += a->in_size) >= a->r1_outsize) {
+      n = a->r1_unqueuedsamps / a->r1_outsize;
+      queue_buffs(channel, a, n);
+      a->r1_unqueuedsamps -= n * a->r1_outsize;
+    }
+
+    if ((a->r1_inidx += a->in_size) == a->r1_active_buffsize) {
+      a->r1_inidx = 0;
+    }
+
+    EnterCriticalSection (&a->r2_ControlSection);
+
+    if (a->r2_havesamps >= a->out_size) {
+      doit = 1;
+    }
+
+    if ((a->r2_havesamps -= a->out_size) < 0) { a->r2_havesamps = 0; }
+
+    LeaveCriticalSection (&a->r2_ControlSection);
+
+    if (a->bfo) { WaitForSingleObject (a->Sem_OutReady, INFINITE); }
+
+    if (a->bfo || doit) {
+      out = a->obuff;
+
+      if (_InterlockedAnd (&a->slew.downflag, 1)) {
+        downslew0 (a, out);
+
+        if (!_InterlockedAnd (&a->slew.downflag, 1)) {
+          InterlockedBitTestAndReset (&ch[channel].exchange, 0);
+          ReleaseSemaphore(a->Sem_Flush, 1, 0);
+        }
+      } else {
+        memcpy (out, a->r2_baseptr + 2 * a->r2_outidx, a->out_size * sizeof (complex));
+      }
+    } else {
+      out = a->zbuff;
+      *error += -2;
+    }
+
+    if ((a->r2_outidx += a->out_size) == a->r2_active_buffsize) {
+      a->r2_outidx = 0;
+    }
+
+    LeaveCriticalSection (&ch[channel].csEXCH);
+  }
+
+  if (t0 > 0.0) { dspload_add (DSPLOAD_FEXCHANGE, channel, t0); }
+
+  return out;
+}
+
 void dexchange (int channel, double* in, double* out) {
   int n;
   IOB a = ch[channel].iob.pd;
 
-  if (!_InterlockedAnd (&ch[channel].run, 1)) { _endthread(); }
+  if (!_InterlockedAnd (&ch[channel].run, 1) && !ch[channel].pooled) { _endthread(); }
 
   EnterCriticalSection (&a->r2_ControlSection);
   a->r2_havesamps += a->r2_insize;
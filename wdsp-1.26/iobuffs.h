@@ -49,6 +49,8 @@ typedef struct _iobf {
   int   r2_havesamps;             // number of processed samples in output pseudo-ring
   int   r2_unqueuedsamps;           // number of output samples not yet queued / released for output
   CRITICAL_SECTION r2_ControlSection;
+  double* zbuff;              // zero output, returned by fexchange0_commit() if no output is available
+  double* obuff;              // output returned by fexchange0_commit(), copied from the output ring
 
   int bfo;                  // block_for_output, wait until output is available before proceeding
   HANDLE Sem_OutReady;            // count = number of 'out_size' buffers processed and available for output
@@ -90,6 +92,12 @@ void fexchange0 (int channel, double* in, double* out, int* error);
 PORT  // separate I/Q buffers
 extern void fexchange2 (int channel, INREAL *Iin, INREAL *Qin, OUTREAL *Iout, OUTREAL *Qout, int* error);
 
+PORT  // version of fexchange0 without input copy, the caller fills the input ring slot
+double* fexchange0_acquire (int channel);
+
+PORT
+double* fexchange0_commit (int channel, int* error);
+
 extern void dexchange (int channel, double* in, double* out);
 
 #endif
\ No newline at end of file
@@ -26,6 +26,11 @@ warren@wpratt.com
 
 #include "comm.h"
 
+#if defined(__GNUC__) && defined(__x86_64__)
+  #include <immintrin.h>
+  #define IQC_AVX2
+#endif
+
 void size_iqc (IQC a) {
   int i;
   a->t =  (double *) malloc0 ((a->ints + 1) * sizeof(double));
@@ -38,6 +43,7 @@ void size_iqc (IQC a) {
     a->cm[i] = (double *) malloc0 (a->ints * 4 * sizeof(double));
     a->cc[i] = (double *) malloc0 (a->ints * 4 * sizeof(double));
     a->cs[i] = (double *) malloc0 (a->ints * 4 * sizeof(double));
+    a->coef[i] = (double *) malloc0 (a->ints * 12 * sizeof(double));
   }
 
   a->dog.cpi = (int *) malloc0 (a->ints * sizeof (int));
@@ -50,6 +56,7 @@ void desize_iqc (IQC a) {
   _aligned_free (a->dog.cpi);
 
   for (i = 0; i < 2; i++) {
+    _aligned_free (a->coef[i]);
     _aligned_free (a->cm[i]);
     _aligned_free (a->cc[i]);
     _aligned_free (a->cs[i]);
@@ -58,6 +65,32 @@ void desize_iqc (IQC a) {
   _aligned_free (a->t);
 }
 
+static void size_iqc_buffs (IQC a) {
+  a->kidx = (int *) malloc0 (a->size * sizeof (int));
+  a->dx = (double *) malloc0 (a->size * sizeof (double));
+  a->pre = (double *) malloc0 (a->size * sizeof (complex));
+  a->pro = (double *) malloc0 (a->size * sizeof (complex));
+}
+
+static void desize_iqc_buffs (IQC a) {
+  _aligned_free (a->pro);
+  _aligned_free (a->pre);
+  _aligned_free (a->dx);
+  _aligned_free (a->kidx);
+}
+
+static void pack_iqc (IQC a, int cset) {
+  // copy the coefficients of set 'cset' to the layout used by xiqc()
+  int i, j;
+
+  for (i = 0; i < a->ints; i++)
+    for (j = 0; j < 4; j++) {
+      a->coef[cset][12 * i + 0 + j] = a->cm[cset][4 * i + j];
+      a->coef[cset][12 * i + 4 + j] = a->cc[cset][4 * i + j];
+      a->coef[cset][12 * i + 8 + j] = a->cs[cset][4 * i + j];
+    }
+}
+
 void calc_iqc (IQC a) {
   int i;
   double delta, theta;
@@ -96,10 +129,12 @@ IQC create_iqc (int run, int size, double* in, double* out, double rate, int int
   a->tup = tup;
   a->dog.spi = spi;
   calc_iqc (a);
+  size_iqc_buffs (a);
   return a;
 }
 
 void destroy_iqc (IQC a) {
+  desize_iqc_buffs (a);
   decalc_iqc (a);
   _aligned_free (a);
 }
@@ -115,98 +150,234 @@ enum _iqcstate {
   DONE
 };
 
+//
+// xiqc() works in passes over the whole buffer, rather than running
+// the state machine for each sample:
+//  - iqc_index() finds the interval and offset of each sample,
+//  - iqc_correct() applies the pre-distortion; the coefficients of one
+//    interval are adjacent (see pack_iqc()), such that each sample needs
+//    one gather from a single cache line,
+//  - the cross-fades (BEGIN, SWAP, END) and the watchdog (RUN) are then
+//    done for runs of samples with the same state.
+//
+
+static inline void iqc_index_c (int size, const double* in, int ints, int* kidx, double* dx) {
+  int i, k;
+  double env;
+
+  for (i = 0; i < size; i++) {
+    env = sqrt (in[2 * i + 0] * in[2 * i + 0] + in[2 * i + 1] * in[2 * i + 1]);
+    k = (int)(env * ints);
+    k = k > ints - 1 ? ints - 1 : k;
+    kidx[i] = k;
+    dx[i] = env - (double)k / (double)ints;           // = env - t[k]
+  }
+}
+
+static void iqc_correct_c (int size, const double* in, double* out, const int* kidx, const double* dx,
+                           const double* coef) {
+  int i;
+  double I, Q, d, ym, yc, ys;
+  const double* c;
+
+  for (i = 0; i < size; i++) {
+    c = coef + 12 * kidx[i];
+    d = dx[i];
+    I = in[2 * i + 0];
+    Q = in[2 * i + 1];
+    ym = c[0] + d * (c[1] + d * (c[ 2] + d * c[ 3]));
+    yc = c[4] + d * (c[5] + d * (c[ 6] + d * c[ 7]));
+    ys = c[8] + d * (c[9] + d * (c[10] + d * c[11]));
+    out[2 * i + 0] = ym * (I * yc - Q * ys);
+    out[2 * i + 1] = ym * (I * ys + Q * yc);
+  }
+}
+
+#ifdef IQC_AVX2
+__attribute__((target("avx2")))
+static void iqc_index_avx2 (int size, const double* in, int ints, int* kidx, double* dx) {
+  // the same loop, vectorized by the compiler for AVX2
+  iqc_index_c (size, in, ints, kidx, dx);
+}
+
+__attribute__((target("avx2")))
+static inline __m256d iqc_poly (const double* c, __m128i base, __m256d d) {
+  __m256d c0 = _mm256_i32gather_pd (c + 0, base, 8);
+  __m256d c1 = _mm256_i32gather_pd (c + 1, base, 8);
+  __m256d c2 = _mm256_i32gather_pd (c + 2, base, 8);
+  __m256d c3 = _mm256_i32gather_pd (c + 3, base, 8);
+  // no FMA, to give the same results as iqc_correct_c()
+  return _mm256_add_pd (c0, _mm256_mul_pd (d, _mm256_add_pd (c1, _mm256_mul_pd (d,
+                        _mm256_add_pd (c2, _mm256_mul_pd (d, c3))))));
+}
+
+__attribute__((target("avx2")))
+static void iqc_correct_avx2 (int size, const double* in, double* out, const int* kidx, const double* dx,
+                              const double* coef) {
+  int i;
+  const __m128i twelve = _mm_set1_epi32 (12);
+
+  for (i = 0; i + 4 <= size; i += 4) {
+    // samples in the order 0, 2, 1, 3, which is what unpacklo/unpackhi give
+    __m256d v0 = _mm256_loadu_pd (in + 2 * i + 0);
+    __m256d v1 = _mm256_loadu_pd (in + 2 * i + 4);
+    __m256d I = _mm256_unpacklo_pd (v0, v1);
+    __m256d Q = _mm256_unpackhi_pd (v0, v1);
+    __m128i k = _mm_shuffle_epi32 (_mm_loadu_si128 ((const __m128i *)(kidx + i)), _MM_SHUFFLE(3, 1, 2, 0));
+    __m128i base = _mm_mullo_epi32 (k, twelve);
+    __m256d d = _mm256_permute4x64_pd (_mm256_loadu_pd (dx + i), _MM_SHUFFLE(3, 1, 2, 0));
+    __m256d ym = iqc_poly (coef + 0, base, d);
+    __m256d yc = iqc_poly (coef + 4, base, d);
+    __m256d ys = iqc_poly (coef + 8, base, d);
+    __m256d re = _mm256_mul_pd (ym, _mm256_sub_pd (_mm256_mul_pd (I, yc), _mm256_mul_pd (Q, ys)));
+    __m256d im = _mm256_mul_pd (ym, _mm256_add_pd (_mm256_mul_pd (I, ys), _mm256_mul_pd (Q, yc)));
+    _mm256_storeu_pd (out + 2 * i + 0, _mm256_unpacklo_pd (re, im));
+    _mm256_storeu_pd (out + 2 * i + 4, _mm256_unpackhi_pd (re, im));
+  }
+
+  iqc_correct_c (size - i, in + 2 * i, out + 2 * i, kidx + i, dx + i, coef);
+}
+
+static int iqc_have_avx2 (void) {
+  static volatile LONG have = -1;
+
+  if (have < 0) {
+    __builtin_cpu_init ();
+    have = __builtin_cpu_supports ("avx2");
+  }
+
+  return have;
+}
+#endif
+
+static void iqc_index (int size, const double* in, int ints, int* kidx, double* dx) {
+#ifdef IQC_AVX2
+
+  if (iqc_have_avx2 ()) {
+    iqc_index_avx2 (size, in, ints, kidx, dx);
+    return;
+  }
+
+#endif
+  iqc_index_c (size, in, ints, kidx, dx);
+}
+
+static void iqc_correct (int size, const double* in, double* out, const int* kidx, const double* dx,
+                         const double* coef) {
+#ifdef IQC_AVX2
+
+  if (iqc_have_avx2 ()) {
+    iqc_correct_avx2 (size, in, out, kidx, dx, coef);
+    return;
+  }
+
+#endif
+  iqc_correct_c (size, in, out, kidx, dx, coef);
+}
+
+static void iqc_dog (IQC a, int size) {
+  // count the samples per interval, in state RUN
+  int i, k;
+
+  for (i = 0; i < size; i++) {
+    k = a->kidx[i];
+
+    if (a->dog.cpi[k] != a->dog.spi && ++a->dog.cpi[k] == a->dog.spi && ++a->dog.full_ints == a->ints) {
+      EnterCriticalSection (&a->dog.cs);
+      ++a->dog.count;
+      LeaveCriticalSection (&a->dog.cs);
+      a->dog.full_ints = 0;
+      memset (a->dog.cpi, 0, a->ints * sizeof (int));
+    }
+  }
+}
+
+static int iqc_fade (IQC a, int n, const double* x, const double* y, double* out, int next) {
+  // out = (1 - cup) * x + cup * y over (at most) n samples, then on to state 'next'
+  int i;
+  double w;
+
+  if (n > a->ntup + 1 - a->count) { n = a->ntup + 1 - a->count; }
+
+  for (i = 0; i < n; i++) {
+    w = a->cup[a->count + i];
+    out[2 * i + 0] = (1.0 - w) * x[2 * i + 0] + w * y[2 * i + 0];
+    out[2 * i + 1] = (1.0 - w) * x[2 * i + 1] + w * y[2 * i + 1];
+  }
+
+  if ((a->count += n) > a->ntup) {
+    a->state = next;
+    a->count = 0;
+    InterlockedBitTestAndReset (&a->busy, 0);
+  }
+
+  return n;
+}
+
 void xiqc (IQC a) {
   if (_InterlockedAnd(&a->run, 1)) {
-    int i, k, cset, mset;
-    double I, Q, env, dx, ym, yc, ys, PRE0, PRE1;
-
-    for (i = 0; i < a->size; i++) {
-      I = a->in[2 * i + 0];
-      Q = a->in[2 * i + 1];
-      env = sqrt (I * I + Q * Q);
-
-      if ((k = (int)(env * a->ints)) > a->ints - 1) { k = a->ints - 1; }
-
-      dx = env - a->t[k];
-      cset = a->cset;
-      ym = a->cm[cset][4 * k + 0] + dx * (a->cm[cset][4 * k + 1] + dx * (a->cm[cset][4 * k + 2] + dx * a->cm[cset][4 * k +
-                                          3]));
-      yc = a->cc[cset][4 * k + 0] + dx * (a->cc[cset][4 * k + 1] + dx * (a->cc[cset][4 * k + 2] + dx * a->cc[cset][4 * k +
-                                          3]));
-      ys = a->cs[cset][4 * k + 0] + dx * (a->cs[cset][4 * k + 1] + dx * (a->cs[cset][4 * k + 2] + dx * a->cs[cset][4 * k +
-                                          3]));
-      PRE0 = ym * (I * yc - Q * ys);
-      PRE1 = ym * (I * ys + Q * yc);
+    int i, n;
 
-      switch (a->state) {
-      case RUN:
-        if (a->dog.cpi[k] != a->dog.spi)
-          if (++a->dog.cpi[k] == a->dog.spi) {
-            a->dog.full_ints++;
-          }
-
-        if (a->dog.full_ints == a->ints) {
-          EnterCriticalSection (&a->dog.cs);
-          ++a->dog.count;
-          LeaveCriticalSection (&a->dog.cs);
-          a->dog.full_ints = 0;
-          memset (a->dog.cpi, 0, a->ints * sizeof (int));
-        }
+    if (a->state == DONE) {
+      if (a->out != a->in) {
+        memcpy (a->out, a->in, a->size * sizeof (complex));
+      }
 
-        break;
+      return;
+    }
 
-      case BEGIN:
-        PRE0 = (1.0 - a->cup[a->count]) * I + a->cup[a->count] * PRE0;
-        PRE1 = (1.0 - a->cup[a->count]) * Q + a->cup[a->count] * PRE1;
+    iqc_index (a->size, a->in, a->ints, a->kidx, a->dx);
 
-        if (a->count++ == a->ntup) {
-          a->state = RUN;
-          a->count = 0;
-          InterlockedBitTestAndReset (&a->busy, 0);
-        }
+    if (a->state == RUN) {
+      iqc_correct (a->size, a->in, a->out, a->kidx, a->dx, a->coef[a->cset]);
+      iqc_dog (a, a->size);
+      return;
+    }
+
+    //
+    // BEGIN, SWAP or END: the buffer may end in a different state, and
+    // 'in' may be the same as 'out', hence correct into 'pre' first
+    //
+    iqc_correct (a->size, a->in, a->pre, a->kidx, a->dx, a->coef[a->cset]);
 
+    if (a->state == SWAP) {
+      iqc_correct (a->size, a->in, a->pro, a->kidx, a->dx, a->coef[1 - a->cset]);
+    }
+
+    for (i = 0; i < a->size; i += n) {
+      const double* in = a->in + 2 * i;
+      const double* pre = a->pre + 2 * i;
+      double* out = a->out + 2 * i;
+
+      switch (a->state) {
+      case BEGIN:
+        n = iqc_fade (a, a->size - i, in, pre, out, RUN);
         break;
 
       case SWAP:
-        mset = 1 - cset;
-        ym = a->cm[mset][4 * k + 0] + dx * (a->cm[mset][4 * k + 1] + dx * (a->cm[mset][4 * k + 2] + dx * a->cm[mset][4 * k +
-                                            3]));
-        yc = a->cc[mset][4 * k + 0] + dx * (a->cc[mset][4 * k + 1] + dx * (a->cc[mset][4 * k + 2] + dx * a->cc[mset][4 * k +
-                                            3]));
-        ys = a->cs[mset][4 * k + 0] + dx * (a->cs[mset][4 * k + 1] + dx * (a->cs[mset][4 * k + 2] + dx * a->cs[mset][4 * k +
-                                            3]));
-        PRE0 = (1.0 - a->cup[a->count]) * ym * (I * yc - Q * ys) + a->cup[a->count] * PRE0;
-        PRE1 = (1.0 - a->cup[a->count]) * ym * (I * ys + Q * yc) + a->cup[a->count] * PRE1;
-
-        if (a->count++ == a->ntup) {
-          a->state = RUN;
-          a->count = 0;
-          InterlockedBitTestAndReset (&a->busy, 0);
-        }
-
+        n = iqc_fade (a, a->size - i, a->pro + 2 * i, pre, out, RUN);
         break;
 
       case END:
-        PRE0 = (1.0 - a->cup[a->count]) * PRE0 + a->cup[a->count] * I;
-        PRE1 = (1.0 - a->cup[a->count]) * PRE1 + a->cup[a->count] * Q;
-
-        if (a->count++ == a->ntup) {
-          a->state = DONE;
-          a->count = 0;
-          InterlockedBitTestAndReset (&a->busy, 0);
-        }
+        n = iqc_fade (a, a->size - i, pre, in, out, DONE);
+        break;
 
+      case RUN:
+        n = a->size - i;
+        memcpy (out, pre, n * sizeof (complex));
+        memmove (a->kidx, a->kidx + i, n * sizeof (int));
+        iqc_dog (a, n);
         break;
 
-      case DONE:
-        PRE0 = I;
-        PRE1 = Q;
+      default:        // DONE
+        n = a->size - i;
+
+        if (out != in) {
+          memcpy (out, in, n * sizeof (complex));
+        }
+
         break;
       }
-
-      a->out[2 * i + 0] = PRE0;
-      a->out[2 * i + 1] = PRE1;
-      // print_iqc_values("iqc.txt", a->state, env, PRE0, PRE1, ym, yc, ys, 1.1);
     }
   } else if (a->out != a->in) {
     memcpy (a->out, a->in, a->size * sizeof (complex));
@@ -225,7 +396,9 @@ void setSamplerate_iqc (IQC a, int rate) {
 }
 
 void setSize_iqc (IQC a, int size) {
+  desize_iqc_buffs (a);
   a->size = size;
+  size_iqc_buffs (a);
 }
 
 /********************************************************************************************************
@@ -254,6 +427,7 @@ void SetTXAiqcValues (int channel, double* cm, double* cc, double* cs) {
   memcpy (a->cm[a->cset], cm, a->ints * 4 * sizeof (double));
   memcpy (a->cc[a->cset], cc, a->ints * 4 * sizeof (double));
   memcpy (a->cs[a->cset], cs, a->ints * 4 * sizeof (double));
+  pack_iqc (a, a->cset);
   a->state = RUN;
   LeaveCriticalSection (&ch[channel].csDSP);
 }
@@ -266,6 +440,7 @@ void SetTXAiqcSwap (int channel, double* cm, double* cc, double* cs) {
   memcpy (a->cm[a->cset], cm, a->ints * 4 * sizeof (double));
   memcpy (a->cc[a->cset], cc, a->ints * 4 * sizeof (double));
   memcpy (a->cs[a->cset], cs, a->ints * 4 * sizeof (double));
+  pack_iqc (a, a->cset);
   InterlockedBitTestAndSet (&a->busy, 0);
   a->state = SWAP;
   a->count = 0;
@@ -282,6 +457,7 @@ void SetTXAiqcStart (int channel, double* cm, double* cc, double* cs) {
   memcpy (a->cm[a->cset], cm, a->ints * 4 * sizeof (double));
   memcpy (a->cc[a->cset], cc, a->ints * 4 * sizeof (double));
   memcpy (a->cs[a->cset], cs, a->ints * 4 * sizeof (double));
+  pack_iqc (a, a->cset);
   InterlockedBitTestAndSet (&a->busy, 0);
   a->state = BEGIN;
   a->count = 0;
@@ -40,6 +40,11 @@ typedef struct _iqc {
   double* cm[2];
   double* cc[2];
   double* cs[2];
+  double* coef[2];      // cm, cc and cs of each interval side by side (12 values per interval)
+  int* kidx;            // interval of each sample
+  double* dx;           // offset of each sample within its interval
+  double* pre;          // corrected samples, while cross-fading
+  double* pro;          // corrected samples with the previous set, while swapping
   double tup;
   double* cup;
   int count;
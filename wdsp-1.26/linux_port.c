@@ -26,6 +26,7 @@ john.d.melton@googlemail.com
 */
 
 #include <errno.h>
+#include <time.h>
 
 #include "linux_port.h"
 #include "comm.h"
@@ -38,10 +39,158 @@ john.d.melton@googlemail.com
 
 #if defined(linux) || defined(__APPLE__)
 
-void QueueUserWorkItem(void *function, void *context, int flags) {
-  pthread_t t;
-  pthread_create(&t, NULL, function, context);
-  pthread_join(t, NULL);
+/********************************************************************************************************
+*                                                                                                       *
+*   Worker pool for QueueUserWorkItem                                                                   *
+*                                                                                                       *
+*   The work items are put into a bounded queue which is served by a fixed number of threads that are   *
+*   created upon the first call and then live as long as the program. QueueUserWorkItem returns FALSE   *
+*   (and the item is not executed) if the queue is full, the caller may then re-try later.              *
+*                                                                                                       *
+********************************************************************************************************/
+
+#define WORK_POOL_MAX_THREADS 4
+#define WORK_QUEUE_SIZE 64
+
+typedef struct _work_item {
+  void *(*function)(void *);
+  void *context;
+} WORK_ITEM;
+
+static struct _work_pool {
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+  WORK_ITEM queue[WORK_QUEUE_SIZE];
+  int head;                                 // next free slot
+  int tail;                                 // next item to execute
+  int depth;                                // number of queued items
+  int max_depth;                            // high-water mark of depth
+  int nthreads;
+  long executed;                            // number of items executed
+  long rejected;                            // number of items rejected because the queue was full
+  pthread_t threads[WORK_POOL_MAX_THREADS];
+} work_pool = { .mutex = PTHREAD_MUTEX_INITIALIZER, .cond = PTHREAD_COND_INITIALIZER };
+
+static pthread_once_t work_pool_once = PTHREAD_ONCE_INIT;
+
+static void *work_pool_thread(void *arg) {
+  WORK_ITEM item;
+  pthread_mutex_lock(&work_pool.mutex);
+
+  for (;;) {
+    while (work_pool.depth == 0) {
+      pthread_cond_wait(&work_pool.cond, &work_pool.mutex);
+    }
+
+    item = work_pool.queue[work_pool.tail];
+    work_pool.tail = (work_pool.tail + 1) % WORK_QUEUE_SIZE;
+    work_pool.depth--;
+    pthread_mutex_unlock(&work_pool.mutex);
+    item.function(item.context);
+    pthread_mutex_lock(&work_pool.mutex);
+    work_pool.executed++;
+  }
+
+  return NULL;
+}
+
+static void work_pool_init(void) {
+  //
+  // One thread less than the number of CPUs, since the thread
+  // feeding the queue (the analyzer's dispatcher) is also running
+  //
+  long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+  int n = (ncpu > 1) ? (int)ncpu - 1 : 1;
+
+  if (n > WORK_POOL_MAX_THREADS) { n = WORK_POOL_MAX_THREADS; }
+
+  for (int i = 0; i < n; i++) {
+    if (pthread_create(&work_pool.threads[work_pool.nthreads], NULL, work_pool_thread, NULL) == 0) {
+      pthread_detach(work_pool.threads[work_pool.nthreads]);
+      work_pool.nthreads++;
+    }
+  }
+}
+
+int QueueUserWorkItem(void *function, void *context, int flags) {
+  pthread_once(&work_pool_once, work_pool_init);
+
+  if (work_pool.nthreads == 0) {
+    //
+    // Could not create any threads: execute synchronously
+    //
+    ((void *(*)(void *))function)(context);
+    return TRUE;
+  }
+
+  pthread_mutex_lock(&work_pool.mutex);
+
+  if (work_pool.depth >= WORK_QUEUE_SIZE) {
+    work_pool.rejected++;
+    pthread_mutex_unlock(&work_pool.mutex);
+    return FALSE;
+  }
+
+  work_pool.queue[work_pool.head].function = (void *(*)(void *))function;
+  work_pool.queue[work_pool.head].context = context;
+  work_pool.head = (work_pool.head + 1) % WORK_QUEUE_SIZE;
+  work_pool.depth++;
+
+  if (work_pool.depth > work_pool.max_depth) { work_pool.max_depth = work_pool.depth; }
+
+  pthread_cond_signal(&work_pool.cond);
+  pthread_mutex_unlock(&work_pool.mutex);
+  return TRUE;
+}
+
+void GetWorkPoolStats(int *nthreads, int *depth, int *max_depth, long *executed, long *rejected) {
+  pthread_mutex_lock(&work_pool.mutex);
+  *nthreads = work_pool.nthreads;
+  *depth = work_pool.depth;
+  *max_depth = work_pool.max_depth;
+  *executed = work_pool.executed;
+  *rejected = work_pool.rejected;
+  pthread_mutex_unlock(&work_pool.mutex);
+}
+
+/********************************************************************************************************
+*                                                                                                       *
+*   Condition variables                                                                                 *
+*                                                                                                       *
+********************************************************************************************************/
+
+void InitializeConditionVariable(pthread_cond_t *cond) {
+  pthread_cond_init(cond, NULL);
+}
+
+//
+// The critical section must have been entered exactly once
+//
+int SleepConditionVariableCS(pthread_cond_t *cond, pthread_mutex_t *mutex, int ms) {
+  struct timespec ts;
+
+  if (ms == INFINITE) {
+    return pthread_cond_wait(cond, mutex) == 0;
+  }
+
+  clock_gettime(CLOCK_REALTIME, &ts);
+  ts.tv_sec += ms / 1000;
+  ts.tv_nsec += (ms % 1000) * 1000000;
+
+  if (ts.tv_nsec > 999999999) {
+    ts.tv_sec++;
+    ts.tv_nsec -= 1000000000;
+  }
+
+  return pthread_cond_timedwait(cond, mutex, &ts) == 0;
+}
+
+void WakeConditionVariable(pthread_cond_t *cond) {
+  pthread_cond_signal(cond);
+}
+
+void WakeAllConditionVariable(pthread_cond_t *cond) {
+  pthread_cond_broadcast(cond);
 }
 
 void InitializeCriticalSectionAndSpinCount(pthread_mutex_t *mutex, int count) {
@@ -35,6 +35,7 @@ john.d.melton@googlemail.com
   #include <unistd.h>
 
   #define CRITICAL_SECTION pthread_mutex_t
+  #define CONDITION_VARIABLE pthread_cond_t
   #define byte unsigned char
   #define String char *
   #define LONG long
@@ -56,6 +57,9 @@ john.d.melton@googlemail.com
   #define InterlockedExchange(target,value) __sync_lock_test_and_set(target,value)
   #define InterlockedAnd(base,mask) __sync_fetch_and_and(base,mask)
   #define _InterlockedAnd(base,mask) __sync_fetch_and_and(base,mask)
+  #define InterlockedExchangeAdd(base,value) __sync_fetch_and_add(base,value)
+  #define InterlockedCompareExchange(target,value,comparand) __sync_val_compare_and_swap(target,comparand,value)
+  #define MemoryBarrier() __sync_synchronize()
   #define __declspec(x)
   #define __cdecl
   #define __stdcall
@@ -85,7 +89,17 @@ john.d.melton@googlemail.com
 
   #define INFINITE -1
 
-  void QueueUserWorkItem(void *function, void *context, int flags);
+  int QueueUserWorkItem(void *function, void *context, int flags);
+
+  void GetWorkPoolStats(int *nthreads, int *depth, int *max_depth, long *executed, long *rejected);
+
+  void InitializeConditionVariable(pthread_cond_t *cond);
+
+  int SleepConditionVariableCS(pthread_cond_t *cond, pthread_mutex_t *mutex, int ms);
+
+  void WakeConditionVariable(pthread_cond_t *cond);
+
+  void WakeAllConditionVariable(pthread_cond_t *cond);
 
   void InitializeCriticalSectionAndSpinCount(pthread_mutex_t *mutex, int count);
 
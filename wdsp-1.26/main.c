@@ -26,6 +26,36 @@ warren@wpratt.com
 
 #include "comm.h"
 
+//
+// Process one buffer of a channel, csDSP must be held. Called by the
+// channel's own thread or by the shared DSP pool.
+//
+void xmain (int channel) {
+  double t0 = dspload_run ? dspload_now () : 0.0;
+
+  if (!_InterlockedAnd (&ch[channel].iob.pd->exec_bypass, 1)) {
+    switch (ch[channel].type) {
+    case 0:   // rxa
+      dexchange (channel, rxa[channel].pipeout, rxa[channel].pipein);
+      xrxa (channel);
+      break;
+
+    case 1:   // txa
+      dexchange (channel, txa[channel].pipeout, txa[channel].pipein);
+      xtxa (channel);
+      break;
+
+    case 31:  //
+      break;
+    }
+  }
+
+  // parameter changes queued while this buffer was processed
+  xcmdq (channel);
+
+  if (t0 > 0.0) { dspload_add (DSPLOAD_XMAIN, channel, t0); }
+}
+
 void wdspmain (void *pargs) {
 #if defined(_WIN32)
   DWORD taskIndex = 0;
@@ -40,24 +70,7 @@ void wdspmain (void *pargs) {
   while (_InterlockedAnd (&ch[channel].run, 1)) {
     WaitForSingleObject(ch[channel].iob.pd->Sem_BuffReady, INFINITE);
     EnterCriticalSection (&ch[channel].csDSP);
-
-    if (!_InterlockedAnd (&ch[channel].iob.pd->exec_bypass, 1)) {
-      switch (ch[channel].type) {
-      case 0:   // rxa
-        dexchange (channel, rxa[channel].outbuff, rxa[channel].inbuff);
-        xrxa (channel);
-        break;
-
-      case 1:   // txa
-        dexchange (channel, txa[channel].outbuff, txa[channel].inbuff);
-        xtxa (channel);
-        break;
-
-      case 31:  //
-        break;
-      }
-    }
-
+    xmain (channel);
     LeaveCriticalSection (&ch[channel].csDSP);
   }
 
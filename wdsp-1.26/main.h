@@ -27,6 +27,8 @@ warren@wpratt.com
 #ifndef _mainloop_h
 #define _mainloop_h
 
+extern void xmain (int channel);
+
 extern void wdspmain (void *pargs);
 
 extern void create_main (int channel);
@@ -500,6 +500,7 @@ void RXANBPSetRun (int channel, int run) {
   EnterCriticalSection (&ch[channel].csDSP);
   a = rxa[channel].nbp0.p;
   a->run = run;
+  RXAPipeCheck (channel);
   LeaveCriticalSection (&ch[channel].csDSP);
 }
 
@@ -133,6 +133,8 @@ void SetRXAPanelSelect (int channel, int select) {
 
 PORT
 void SetRXAPanelGain1 (int channel, double gain) {
+  if (queue_cmdD (channel, SetRXAPanelGain1, gain)) { return; }
+
   EnterCriticalSection (&ch[channel].csDSP);
   rxa[channel].panel.p->gain1 = gain;
   LeaveCriticalSection (&ch[channel].csDSP);
@@ -149,6 +151,9 @@ void SetRXAPanelGain2 (int channel, double gainI, double gainQ) {
 PORT
 void SetRXAPanelPan (int channel, double pan) {
   double gain1, gain2;
+
+  if (queue_cmdD (channel, SetRXAPanelPan, pan)) { return; }
+
   EnterCriticalSection (&ch[channel].csDSP);
 
   if (pan <= 0.5) {
@@ -193,6 +198,8 @@ void SetTXAPanelRun (int channel, int run) {
 
 PORT
 void SetTXAPanelGain1 (int channel, double gain) {
+  if (queue_cmdD (channel, SetTXAPanelGain1, gain)) { return; }
+
   EnterCriticalSection (&ch[channel].csDSP);
   txa[channel].panel.p->gain1 = gain;
   //print_message ("micgainset.txt", "Set MIC Gain to", (int)(100.0 * gain), 0, 0);
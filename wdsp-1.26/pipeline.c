@@ -0,0 +1,156 @@
+/*  pipeline.c
+
+This file is part of a program that implements a Software-Defined Radio.
+
+Copyright (C) 2025 Heiko Amft, DL1BZ
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+#include "comm.h"
+
+//
+// Changes of the stage list and the times are bracketed by pipe_begin() and
+// pipe_end(). All writers hold csDSP (or the channel is not running), so
+// there is only one at a time. Readers (get_pipeline_times) retry until they
+// have seen the same even sequence count before and after copying.
+//
+static void pipe_begin (PIPELINE a) {
+  a->seq++;
+  MemoryBarrier ();
+}
+
+static void pipe_end (PIPELINE a) {
+  MemoryBarrier ();
+  a->seq++;
+}
+
+PIPELINE create_pipeline (int channel, const pipestage* stage, int nstages) {
+  PIPELINE a = (PIPELINE) malloc0 (sizeof (pipeline));
+  a->channel = channel;
+  a->stage = stage;
+  a->nstages = min (nstages, PIPE_MAX_STAGES);
+  build_pipeline (a);
+  return a;
+}
+
+void destroy_pipeline (PIPELINE a) {
+  _aligned_free (a);
+}
+
+//
+// Collect the stages that are currently switched on, csDSP must be held
+// (or the channel must not be running)
+//
+void build_pipeline (PIPELINE a) {
+  int i, n = 0;
+  InterlockedBitTestAndReset (&a->dirty, 0);
+  pipe_begin (a);
+
+  for (i = 0; i < a->nstages; i++) {
+    if (!a->stage[i].active || a->stage[i].active (a->channel)) {
+      a->active[n++] = i;
+    }
+  }
+
+  a->nactive = n;
+  pipe_end (a);
+}
+
+void xpipeline (PIPELINE a) {
+  int i, k;
+
+  if (!a->timing) {
+    for (i = 0; i < a->nactive; i++) {
+      a->stage[a->active[i]].xstage (a->channel);
+    }
+  } else {
+    double t0, t1;
+    double dt[PIPE_MAX_STAGES];
+    t0 = dspload_now ();
+
+    for (i = 0; i < a->nactive; i++) {
+      a->stage[a->active[i]].xstage (a->channel);
+      t1 = dspload_now ();
+      dt[i] = t1 - t0;
+      t0 = t1;
+    }
+
+    // publish the times of this buffer in one go
+    pipe_begin (a);
+
+    for (i = 0; i < a->nactive; i++) {
+      k = a->active[i];
+      a->ns[k] += dt[i];
+
+      if (dt[i] > a->peak[k]) { a->peak[k] = dt[i]; }
+
+      a->calls[k]++;
+    }
+
+    a->buffers++;
+    pipe_end (a);
+  }
+}
+
+void reset_pipeline_times (PIPELINE a) {
+  pipe_begin (a);
+  a->buffers = 0;
+  memset (a->ns, 0, sizeof (a->ns));
+  memset (a->peak, 0, sizeof (a->peak));
+  memset (a->calls, 0, sizeof (a->calls));
+  pipe_end (a);
+}
+
+//
+// For each stage, the average and the worst case time per buffer (in
+// microseconds) since the last reset, and whether the stage is currently run.
+// csDSP need not be held.
+//
+void get_pipeline_times (PIPELINE a, double* us, double* peak_us, int* active) {
+  int i, nactive;
+  long seq, buffers;
+  int act[PIPE_MAX_STAGES];
+  double ns[PIPE_MAX_STAGES];
+  double peak[PIPE_MAX_STAGES];
+
+  for (;;) {
+    if ((seq = a->seq) & 1) {
+      Sleep (0);
+      continue;
+    }
+
+    MemoryBarrier ();
+    buffers = a->buffers;
+    nactive = a->nactive;
+    memcpy (act, a->active, sizeof (act));
+    memcpy (ns, a->ns, sizeof (ns));
+    memcpy (peak, a->peak, sizeof (peak));
+    MemoryBarrier ();
+
+    if (a->seq == seq) { break; }
+  }
+
+  for (i = 0; i < a->nstages; i++) {
+    us[i] = (buffers > 0) ? 1.0e-3 * ns[i] / buffers : 0.0;
+    peak_us[i] = 1.0e-3 * peak[i];
+    active[i] = 0;
+  }
+
+  for (i = 0; i < nactive; i++) {
+    active[act[i]] = 1;
+  }
+}
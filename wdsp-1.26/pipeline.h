@@ -0,0 +1,77 @@
+/*  pipeline.h
+
+This file is part of a program that implements a Software-Defined Radio.
+
+Copyright (C) 2025 Heiko Amft, DL1BZ
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+/********************************************************************************************************
+*                                                   *
+*                     Dynamically Composed Stage Pipelines                *
+*                                                   *
+********************************************************************************************************/
+
+//
+// xrxa() and xtxa() run a list of stages. The stages that are switched off
+// (by their run flag, or because they sit at the other position) are not put
+// into that list, so they cost nothing. The list is re-built before the next
+// buffer whenever a mode or run flag has changed (RXAPipeCheck, TXAPipeCheck).
+// Optionally, the time spent in each stage is measured. The stage list and the
+// times are published with a sequence count, such that they can be read without
+// csDSP, which the DSP thread holds for a whole buffer.
+//
+
+#ifndef _pipeline_h
+#define _pipeline_h
+
+#define PIPE_MAX_STAGES 48
+
+typedef struct _pipestage {
+  const char* name;
+  void (*xstage)(int channel);    // process one buffer
+  int (*active)(int channel);     // 0 if the stage always runs
+} pipestage;
+
+typedef struct _pipeline {
+  int channel;
+  int nstages;            // number of entries in stage[]
+  const pipestage* stage;     // all stages, in the order they are run
+  int nactive;            // number of stages actually run
+  int active[PIPE_MAX_STAGES];  // indices (into stage[]) of these stages
+  volatile long dirty;      // when 1, re-build before the next buffer
+  int timing;           // when 1, measure the time spent in each stage
+  long buffers;         // number of buffers timed since reset
+  double ns[PIPE_MAX_STAGES];   // accumulated time per stage
+  double peak[PIPE_MAX_STAGES]; // worst case per stage
+  long calls[PIPE_MAX_STAGES];  // number of buffers each stage has been run on
+  volatile long seq;        // odd while the above is being changed
+} pipeline, *PIPELINE;
+
+extern PIPELINE create_pipeline (int channel, const pipestage* stage, int nstages);
+
+extern void destroy_pipeline (PIPELINE a);
+
+extern void build_pipeline (PIPELINE a);
+
+extern void xpipeline (PIPELINE a);
+
+extern void reset_pipeline_times (PIPELINE a);
+
+extern void get_pipeline_times (PIPELINE a, double* us, double* peak_us, int* active);
+
+#endif
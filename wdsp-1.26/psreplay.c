@@ -0,0 +1,250 @@
+/*  psreplay.c
+
+This file is part of a program that implements a Software-Defined Radio.
+
+Copyright (C) 2025 Heiko Amft, DL1BZ
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+/********************************************************************************************************
+*                                                   *
+*                     PureSignal Replay                       *
+*                                                   *
+********************************************************************************************************/
+
+//
+// psreplay is a command-line program that runs the PureSignal calibration
+// (pscc/calc) and the pre-distortion (xiqc) on recorded samples, without
+// a radio. It is not part of the library, build it with "make psreplay".
+//
+//   psreplay [-r rate] [-p peak] [-i ints] [-s spi] [-n cals] [-f] [-o out] tx-file rx-file
+//
+// tx-file and rx-file hold the TX reference and the feedback samples, as
+// they are passed to pscc(), as interleaved I/Q pairs (64-bit doubles, or
+// 32-bit floats with -f). Both are replayed (repeatedly, if necessary)
+// until 'cals' calibrations have been attempted, the TX samples going
+// through xiqc() all the time. Then, one more pass of the TX samples is
+// run through xiqc() with the final correction and written to 'out'.
+//
+// Reported are the number of calibrations, the feedback level, the time
+// taken by each calc() and the time per sample of xiqc().
+//
+// return values of main()
+//
+//  0  all OK
+//  1  bad command line
+//  2  error reading the sample files
+//  3  no successful calibration
+//
+
+#include "comm.h"
+#include <unistd.h>
+
+#define BLOCK 1024
+
+static double* read_samples (const char* name, int is_float, int* n) {
+  FILE* f = fopen (name, "rb");
+  size_t width = is_float ? 2 * sizeof (float) : 2 * sizeof (double);
+  long len;
+  double* buf;
+  float* fbuf;
+  int i;
+
+  if (f == NULL) {
+    fprintf (stderr, "psreplay: cannot open %s\n", name);
+    return NULL;
+  }
+
+  fseek (f, 0, SEEK_END);
+  len = ftell (f);
+  fseek (f, 0, SEEK_SET);
+  *n = (int)(len / width);
+  buf = (double *) malloc0 ((*n + 1) * sizeof (complex));
+
+  if (is_float) {
+    fbuf = (float *) malloc0 ((*n + 1) * 2 * sizeof (float));
+
+    if (fread (fbuf, width, *n, f) != (size_t) * n) { *n = 0; }
+
+    for (i = 0; i < 2 * *n; i++) {
+      buf[i] = fbuf[i];
+    }
+
+    _aligned_free (fbuf);
+  } else if (fread (buf, width, *n, f) != (size_t) * n) {
+    *n = 0;
+  }
+
+  fclose (f);
+
+  if (*n == 0) {
+    fprintf (stderr, "psreplay: cannot read %s\n", name);
+    _aligned_free (buf);
+    return NULL;
+  }
+
+  return buf;
+}
+
+static void usage (void) {
+  fprintf (stderr, "usage: psreplay [-r rate] [-p peak] [-i ints] [-s spi] [-n cals] [-f] [-o out] tx-file rx-file\n");
+}
+
+int main (int argc, char** argv) {
+  int rate = 192000;
+  double peak = 0.4067;
+  int ints = 16;
+  int spi = 256;
+  int ncals = 10;
+  int is_float = 0;
+  const char* outname = NULL;
+  int opt, ntx, nrx, nsamps, i, pass;
+  int info[16];
+  double *tx, *rx, *buf;
+  double t0, tstart, tiqc, avg_us, peak_us;
+  long nblocks, count;
+  FILE* out = NULL;
+  IQC iqc;
+
+  while ((opt = getopt (argc, argv, "r:p:i:s:n:fo:")) != -1) {
+    switch (opt) {
+    case 'r':
+      rate = atoi (optarg);
+      break;
+
+    case 'p':
+      peak = atof (optarg);
+      break;
+
+    case 'i':
+      ints = atoi (optarg);
+      break;
+
+    case 's':
+      spi = atoi (optarg);
+      break;
+
+    case 'n':
+      ncals = atoi (optarg);
+      break;
+
+    case 'f':
+      is_float = 1;
+      break;
+
+    case 'o':
+      outname = optarg;
+      break;
+
+    default:
+      usage ();
+      return 1;
+    }
+  }
+
+  if (argc - optind != 2 || rate <= 0 || peak <= 0.0 || ints < 2 || spi < 1 || ncals < 1) {
+    usage ();
+    return 1;
+  }
+
+  if ((tx = read_samples (argv[optind], is_float, &ntx)) == NULL) { return 2; }
+
+  if ((rx = read_samples (argv[optind + 1], is_float, &nrx)) == NULL) { return 2; }
+
+  nsamps = (ntx < nrx ? ntx : nrx) / BLOCK * BLOCK;
+
+  if (nsamps == 0) {
+    fprintf (stderr, "psreplay: less than %d samples\n", BLOCK);
+    return 2;
+  }
+
+  //
+  // A TX channel that is never run, just as a home for calcc and iqc.
+  // The iqc is run here, on the replayed TX samples.
+  //
+  OpenChannel (0, BLOCK, BLOCK, rate, rate, rate, 1, 0, 0.0, 0.0, 0.0, 0.0, 1);
+  buf = (double *) malloc0 (BLOCK * sizeof (complex));
+  iqc = txa[0].iqc.p0;
+  setBuffers_iqc (iqc, buf, buf);
+  setSize_iqc (iqc, BLOCK);
+  SetPSFeedbackRate (0, rate);
+  SetPSHWPeak (0, peak);
+  SetPSIntsAndSpi (0, ints, spi);
+  SetPSRunCal (0, 1);
+  SetPSMox (0, 1);
+  SetPSControl (0, 0, 0, 1, 0);
+  SetDSPLoadRun (1);
+  ResetDSPLoad (0);
+  tstart = dspload_now ();
+  tiqc = 0.0;
+  nblocks = 0;
+  pass = 0;
+
+  do {
+    for (i = 0; i < nsamps; i += BLOCK) {
+      pscc (0, BLOCK, tx + 2 * i, rx + 2 * i);
+      memcpy (buf, tx + 2 * i, BLOCK * sizeof (complex));
+      t0 = dspload_now ();
+      EnterCriticalSection (&ch[0].csDSP);
+      xiqc (iqc);
+      LeaveCriticalSection (&ch[0].csDSP);
+      tiqc += dspload_now () - t0;
+      nblocks++;
+    }
+
+    GetPSInfo (0, info);
+    pass++;
+  } while (info[5] < ncals && pass < 1000);
+
+  printf ("%d passes of %d samples in %.3f s\n", pass, nsamps, 1.0e-9 * (dspload_now () - tstart));
+  printf ("calibrations: %d, correcting: %d, feedback level: %d\n", info[5], info[14], info[4]);
+  GetDSPLoad (DSPLOAD_CALCC, 0, &avg_us, &peak_us, &count);
+  printf ("calc: %ld runs, %.0f us average, %.0f us peak\n", count, avg_us, peak_us);
+  printf ("xiqc while calibrating: %.2f ns/sample\n", tiqc / (double)(nblocks * BLOCK));
+
+  if (outname != NULL && (out = fopen (outname, "wb")) == NULL) {
+    fprintf (stderr, "psreplay: cannot create %s\n", outname);
+  }
+
+  tiqc = 0.0;
+
+  for (i = 0; i < nsamps; i += BLOCK) {
+    memcpy (buf, tx + 2 * i, BLOCK * sizeof (complex));
+    t0 = dspload_now ();
+    EnterCriticalSection (&ch[0].csDSP);
+    xiqc (iqc);
+    LeaveCriticalSection (&ch[0].csDSP);
+    tiqc += dspload_now () - t0;
+
+    if (out != NULL) {
+      fwrite (buf, sizeof (complex), BLOCK, out);
+    }
+  }
+
+  printf ("xiqc with the final correction: %.2f ns/sample\n", tiqc / (double)nsamps);
+
+  if (out != NULL) {
+    fclose (out);
+  }
+
+  SetPSMox (0, 0);
+  CloseChannel (0);
+  _aligned_free (buf);
+  _aligned_free (rx);
+  _aligned_free (tx);
+  return info[14] ? 0 : 3;
+}
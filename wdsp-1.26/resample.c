@@ -32,9 +32,282 @@ warren@wpratt.com
 *                                               *
 ************************************************************************************************/
 
+/********************************************************************************************************
+*                                                   *
+*                     Half-Band Cascades                        *
+*                                                   *
+********************************************************************************************************/
+
+//
+// For rate ratios of 2^n with automatic filter selection, the resampler runs a
+// cascade of half-band filters instead of one long polyphase filter. Stage 0 sits
+// at the low rate end and has the sharp transition (passband 0.45 of the low rate,
+// as the polyphase filter), the stages towards the high rate only have to protect
+// that passband and are short. In a half-band filter every second tap is zero, so
+// each stage needs nt/2 complex MACs per sample at its high rate.
+//
+// The designs only depend on the stage number, they are computed once (Kaiser
+// window, HB_ATTEN dB) and shared by all resamplers and rate pairs. Since
+// channels may be created concurrently (e.g. by the DSP pool workers), the
+// design is run through pthread_once.
+//
+
+#define HB_ATTEN 150.0
+
+static double* hb_taps[RSMP_MAX_HB];
+static int hb_ntaps[RSMP_MAX_HB];
+static pthread_once_t hb_once = PTHREAD_ONCE_INIT;
+
+static double hb_bessI0 (double x) {
+  double sum = 1.0, term = 1.0;
+  int k;
+
+  for (k = 1; k < 100 && term > 1.0e-20 * sum; k++) {
+    term *= (0.5 * x / k) * (0.5 * x / k);
+    sum += term;
+  }
+
+  return sum;
+}
+
+static void design_halfband (void) {
+  int s, i, J, N;
+  double df, beta, d, q, sum;
+  beta = 0.1102 * (HB_ATTEN - 8.7);
+
+  for (s = 0; s < RSMP_MAX_HB; s++) {
+    // transition band, relative to the stage's high rate
+    df = 0.5 - 0.9 / (double)(2 << s);
+    N = (int)ceil ((HB_ATTEN - 7.95) / (14.36 * df)) + 1;
+    // N = 4 * J - 1, the centre tap is at 2 * J - 1
+    J = (N + 4) / 4;
+    q = (double)(2 * J - 1);
+    hb_ntaps[s] = 2 * J;
+    hb_taps[s] = (double *) malloc0 (2 * J * sizeof (double));
+    sum = 0.0;
+
+    for (i = 0; i < 2 * J; i++) {
+      d = (double)(2 * i) - q;
+      hb_taps[s][i] = sin (0.5 * PI * d) / (PI * d)
+                      * hb_bessI0 (beta * sqrt (1.0 - (d / q) * (d / q))) / hb_bessI0 (beta);
+      sum += hb_taps[s][i];
+    }
+
+    // exact unity gain at DC, the centre tap is 0.5
+    for (i = 0; i < 2 * J; i++) {
+      hb_taps[s][i] *= 0.5 / sum;
+    }
+  }
+}
+
+static void init_halfband (void) {
+  pthread_once (&hb_once, design_halfband);
+}
+
+static int xhb_decimate (hbstage* a, double* in, double* out, int n) {
+  int i, j, m = 0;
+  double I, Q;
+  double* r;
+  const int nt = a->nt;
+  const double* g = a->g;
+
+  for (i = 0; i < n; i++) {
+    if (a->phase) {
+      a->oring[2 * a->idx + 0] = a->oring[2 * (a->idx + a->size) + 0] = in[2 * i + 0];
+      a->oring[2 * a->idx + 1] = a->oring[2 * (a->idx + a->size) + 1] = in[2 * i + 1];
+      a->phase = 0;
+    } else {
+      if (--a->idx < 0) { a->idx = a->size - 1; }
+
+      a->ering[2 * a->idx + 0] = a->ering[2 * (a->idx + a->size) + 0] = in[2 * i + 0];
+      a->ering[2 * a->idx + 1] = a->ering[2 * (a->idx + a->size) + 1] = in[2 * i + 1];
+      r = a->ering + 2 * a->idx;
+      I = 0.0;
+      Q = 0.0;
+
+      for (j = 0; j < nt; j++) {
+        I += g[j] * r[2 * j + 0];
+        Q += g[j] * r[2 * j + 1];
+      }
+
+      r = a->oring + 2 * (a->idx + a->J);
+      out[2 * m + 0] = I + 0.5 * r[0];
+      out[2 * m + 1] = Q + 0.5 * r[1];
+      m++;
+      a->phase = 1;
+    }
+  }
+
+  return m;
+}
+
+static int xhb_interpolate (hbstage* a, double* in, double* out, int n) {
+  int i, j;
+  double I, Q;
+  double* r;
+  const int nt = a->nt;
+  const double* g = a->g;
+
+  for (i = 0; i < n; i++) {
+    if (--a->idx < 0) { a->idx = a->size - 1; }
+
+    a->ering[2 * a->idx + 0] = a->ering[2 * (a->idx + a->size) + 0] = in[2 * i + 0];
+    a->ering[2 * a->idx + 1] = a->ering[2 * (a->idx + a->size) + 1] = in[2 * i + 1];
+    r = a->ering + 2 * a->idx;
+    I = 0.0;
+    Q = 0.0;
+
+    for (j = 0; j < nt; j++) {
+      I += g[j] * r[2 * j + 0];
+      Q += g[j] * r[2 * j + 1];
+    }
+
+    out[4 * i + 0] = 2.0 * I;
+    out[4 * i + 1] = 2.0 * Q;
+    out[4 * i + 2] = r[2 * (a->J - 1) + 0];
+    out[4 * i + 3] = r[2 * (a->J - 1) + 1];
+  }
+
+  return 2 * n;
+}
+
+static void hb_buffers (RESAMPLE a) {
+  int need = a->decim ? a->size / 2 + 1 : a->size << (a->nhb - 1);
+
+  if (need > a->wsize) {
+    _aligned_free (a->wbuff[0]);
+    _aligned_free (a->wbuff[1]);
+    a->wsize = need;
+    a->wbuff[0] = (double *) malloc0 (a->wsize * sizeof (complex));
+    a->wbuff[1] = (double *) malloc0 (a->wsize * sizeof (complex));
+  }
+}
+
+static void calc_halfband (RESAMPLE a) {
+  int s, ratio;
+  hbstage* b;
+  a->nhb = 0;
+
+  if (!a->halfband || a->fcin != 0.0 || a->fc_low >= 0.0 || a->ncoefin != 0) { return; }
+
+  if (a->L == 1) {
+    ratio = a->M;
+    a->decim = 1;
+  } else if (a->M == 1) {
+    ratio = a->L;
+    a->decim = 0;
+  } else {
+    return;
+  }
+
+  if (ratio < 2 || ratio > (1 << RSMP_MAX_HB) || (ratio & (ratio - 1))) { return; }
+
+  init_halfband ();
+
+  while ((1 << a->nhb) < ratio) { a->nhb++; }
+
+  for (s = 0; s < a->nhb; s++) {
+    b = &a->hb[s];
+    b->nt = hb_ntaps[s];
+    b->J = hb_ntaps[s] / 2;
+    b->g = hb_taps[s];
+    b->size = b->nt;
+    b->ering = (double *) malloc0 (2 * b->size * sizeof (complex));
+    b->oring = (double *) malloc0 (2 * b->size * sizeof (complex));
+    b->idx = 0;
+    b->phase = 0;
+  }
+
+  hb_buffers (a);
+}
+
+static void decalc_halfband (RESAMPLE a) {
+  int s;
+
+  for (s = 0; s < a->nhb; s++) {
+    _aligned_free (a->hb[s].oring);
+    _aligned_free (a->hb[s].ering);
+  }
+
+  _aligned_free (a->wbuff[0]);
+  _aligned_free (a->wbuff[1]);
+  a->wbuff[0] = a->wbuff[1] = 0;
+  a->wsize = 0;
+  a->nhb = 0;
+}
+
+static void flush_halfband (RESAMPLE a) {
+  int s;
+
+  for (s = 0; s < a->nhb; s++) {
+    memset (a->hb[s].ering, 0, 2 * a->hb[s].size * sizeof (complex));
+    memset (a->hb[s].oring, 0, 2 * a->hb[s].size * sizeof (complex));
+    a->hb[s].idx = 0;
+    a->hb[s].phase = 0;
+  }
+}
+
+static int xhalfband (RESAMPLE a) {
+  int s, i, n = a->size;
+  double* src = a->in;
+  double* dst;
+  hb_buffers (a);
+
+  if (a->decim) {
+    // high rate end first, the stages after the first one work in place
+    for (s = a->nhb - 1; s >= 0; s--) {
+      dst = (s == 0) ? a->out : a->wbuff[0];
+      n = xhb_decimate (&a->hb[s], src, dst, n);
+      src = dst;
+    }
+  } else {
+    for (s = 0; s < a->nhb; s++) {
+      dst = (s == a->nhb - 1) ? a->out : a->wbuff[s & 1];
+      n = xhb_interpolate (&a->hb[s], src, dst, n);
+      src = dst;
+    }
+  }
+
+  if (a->gain != 1.0)
+    for (i = 0; i < 2 * n; i++) {
+      a->out[i] *= a->gain;
+    }
+
+  return n;
+}
+
+/********************************************************************************************************
+*                                                   *
+*                     Shared Polyphase Designs                    *
+*                                                   *
+********************************************************************************************************/
+
+//
+// 48000 <-> 44100 (L/M = 147/160) cannot use a half-band cascade. With automatic
+// filter selection, its polyphase filter has 22400 taps, which are designed once
+// per direction and then shared by all resamplers (and kept until the program
+// ends), such that a sample rate change or a second receiver neither designs nor
+// allocates them again, and all resamplers of this ratio use the same table in
+// the CPU caches. The design is the one calc_resample() would make.
+//
+
+static const int pp_rates[2][2] = { { 48000, 44100 }, { 44100, 48000 } };
+static double* volatile pp_taps[2];
+
+static int pp_slot (RESAMPLE a) {
+  int s;
+
+  if (a->fcin != 0.0 || a->fc_low >= 0.0 || a->ncoefin != 0 || a->gain != 1.0) { return -1; }
+
+  for (s = 0; s < 2; s++)
+    if (a->in_rate == pp_rates[s][0] && a->out_rate == pp_rates[s][1]) { return s; }
+
+  return -1;
+}
+
 void calc_resample (RESAMPLE a) {
   int x, y, z;
-  int i, j, k;
+  int i, j, k, s;
   int min_rate;
   double full_rate;
   double fc_norm_high, fc_norm_low;
@@ -73,25 +346,41 @@ void calc_resample (RESAMPLE a) {
 
   a->ncoef = (a->ncoef / a->L + 1) * a->L;
   a->cpp = a->ncoef / a->L;
-  a->h = (double *)malloc0(a->ncoef * sizeof(double));
-  impulse = fir_bandpass(a->ncoef, fc_norm_low, fc_norm_high, 1.0, 1, 0, a->gain * (double)a->L);
-  i = 0;
+  a->shared = 0;
 
-  for (j = 0; j < a->L; j++)
-    for (k = 0; k < a->ncoef; k += a->L) {
-      a->h[i++] = impulse[j + k];
-    }
+  if ((s = pp_slot (a)) >= 0 && pp_taps[s]) {
+    a->h = pp_taps[s];
+    a->shared = 1;
+  } else {
+    a->h = (double *)malloc0(a->ncoef * sizeof(double));
+    impulse = fir_bandpass(a->ncoef, fc_norm_low, fc_norm_high, 1.0, 1, 0, a->gain * (double)a->L);
+    i = 0;
+
+    for (j = 0; j < a->L; j++)
+      for (k = 0; k < a->ncoef; k += a->L) {
+        a->h[i++] = impulse[j + k];
+      }
 
+    _aligned_free(impulse);
+
+    // publish the design, unless another resampler has been faster
+    if (s >= 0 && InterlockedCompareExchange (&pp_taps[s], a->h, NULL) == NULL) { a->shared = 1; }
+  }
+
+  // mirrored ring, each sample is stored twice such that the taps of a phase
+  // see contiguous samples and the inner product needs no wrap-around
   a->ringsize = a->cpp;
-  a->ring = (double *)malloc0(a->ringsize * sizeof(complex));
+  a->ring = (double *)malloc0(2 * a->ringsize * sizeof(complex));
   a->idx_in = a->ringsize - 1;
   a->phnum = 0;
-  _aligned_free(impulse);
+  calc_halfband (a);
 }
 
 void decalc_resample (RESAMPLE a) {
+  decalc_halfband (a);
   _aligned_free(a->ring);
-  _aligned_free(a->h);
+
+  if (!a->shared) { _aligned_free(a->h); }
 }
 
 PORT
@@ -108,6 +397,7 @@ RESAMPLE create_resample ( int run, int size, double* in, double* out, int in_ra
   a->fc_low = -1.0;   // could add to create_resample() parameters
   a->ncoefin = ncoef;
   a->gain = gain;
+  a->halfband = 1;
   calc_resample (a);
   return a;
 }
@@ -120,19 +410,23 @@ void destroy_resample (RESAMPLE a) {
 
 PORT
 void flush_resample (RESAMPLE a) {
-  memset (a->ring, 0, a->ringsize * sizeof (complex));
+  memset (a->ring, 0, 2 * a->ringsize * sizeof (complex));
   a->idx_in = a->ringsize - 1;
   a->phnum = 0;
+  flush_halfband (a);
 }
 
 PORT
 int xresample (RESAMPLE a) {
   int outsamps = 0;
 
-  if (a->run) {
-    int i, j, n;
-    int idx_out;
+  if (a->run && a->nhb) {
+    outsamps = xhalfband (a);
+  } else if (a->run) {
+    int i, j;
     double I, Q;
+    double* hp;
+    double* rp;
     int cpp = a->cpp;
     int idx_in = a->idx_in;
     int ringsize = a->ringsize;
@@ -140,19 +434,18 @@ int xresample (RESAMPLE a) {
     double* ring = a->ring;
 
     for (i = 0; i < a->size; i++) {
-      ring[2 * idx_in + 0] = a->in[2 * i + 0];
-      ring[2 * idx_in + 1] = a->in[2 * i + 1];
+      ring[2 * idx_in + 0] = ring[2 * (idx_in + ringsize) + 0] = a->in[2 * i + 0];
+      ring[2 * idx_in + 1] = ring[2 * (idx_in + ringsize) + 1] = a->in[2 * i + 1];
+      rp = ring + 2 * idx_in;
 
       while (a->phnum < a->L) {
         I = 0.0;
         Q = 0.0;
-        n = cpp * a->phnum;
+        hp = h + cpp * a->phnum;
 
         for (j = 0; j < cpp; j++) {
-          if ((idx_out = idx_in + j) >= ringsize) { idx_out -= ringsize; }
-
-          I += h[n + j] * ring[2 * idx_out + 0];
-          Q += h[n + j] * ring[2 * idx_out + 1];
+          I += hp[j] * rp[2 * j + 0];
+          Q += hp[j] * rp[2 * j + 1];
         }
 
         a->out[2 * outsamps + 0] = I;
@@ -234,6 +527,60 @@ void destroy_resampleV (void* ptr) {
   destroy_resample ( (RESAMPLE)ptr );
 }
 
+//
+// CPU time per output sample (in nsec) for a rate pair, with the half-band
+// cascade enabled or disabled (i.e., always using the polyphase filter).
+// Returns -1.0 if the arguments are invalid.
+//
+
+PORT
+double ResampleBenchmark (int in_rate, int out_rate, int halfband) {
+  struct timespec ts, te;
+  int i, l, loops, outsamps = 0;
+  int size = 4096;
+  double* in;
+  double* out;
+  double ns;
+  RESAMPLE a;
+
+  if (in_rate <= 0 || out_rate <= 0) { return -1.0; }
+
+  in = (double *) malloc0 (size * sizeof (complex));
+  out = (double *) malloc0 ((size_t)size * out_rate / in_rate * sizeof (complex) + 4 * sizeof (complex));
+
+  for (i = 0; i < size; i++) {
+    in[2 * i + 0] = sin (0.001 * (i + 1));
+    in[2 * i + 1] = cos (0.002 * (i + 1));
+  }
+
+  a = create_resample (1, size, in, out, in_rate, out_rate, 0.0, 0, 1.0);
+
+  if (!halfband) {
+    decalc_resample (a);
+    a->halfband = 0;
+    calc_resample (a);
+  }
+
+  // about 2^22 input samples, but at least 10 buffers
+  loops = (1 << 22) / size;
+
+  if (loops < 10) { loops = 10; }
+
+  xresample (a);
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+
+  for (l = 0; l < loops; l++) {
+    outsamps += xresample (a);
+  }
+
+  clock_gettime (CLOCK_MONOTONIC, &te);
+  ns = ((te.tv_sec - ts.tv_sec) * 1.0e9 + (te.tv_nsec - ts.tv_nsec)) / (outsamps > 0 ? outsamps : 1);
+  destroy_resample (a);
+  _aligned_free (out);
+  _aligned_free (in);
+  return ns;
+}
+
 /************************************************************************************************
 *                                               *
 *               VERSION FOR NON-COMPLEX FLOATS                  *
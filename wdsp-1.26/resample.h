@@ -33,6 +33,19 @@ warren@wpratt.com
 #ifndef _resample_h
 #define _resample_h
 
+#define RSMP_MAX_HB 6       // half-band cascades are used for rate ratios up to 2^6
+
+typedef struct _hbstage {
+  int nt;       // number of taps besides the centre tap
+  int J;        // delay of the centre tap
+  double* g;      // taps (shared design, see resample.c)
+  int size;     // number of complex samples the rings hold
+  double* ering;    // mirrored ring for the taps
+  double* oring;    // mirrored ring for the centre tap (decimator)
+  int idx;      // ring index
+  int phase;      // decimator: next input sample goes to oring
+} hbstage;
+
 typedef struct _resample {
   int run;      // run
   int size;     // number of input samples per buffer
@@ -50,10 +63,17 @@ typedef struct _resample {
   int L;        // interpolation factor
   int M;        // decimation factor
   double* h;      // coefficients
+  int shared;     // h is a shared design (see resample.c), not to be freed
   int ringsize;   // number of complex pairs the ring buffer holds
   double* ring;   // ring buffer
   int cpp;      // coefficients of the phase
   int phnum;      // phase number
+  int halfband;     // use a half-band cascade if the rate ratio is 2^n
+  int nhb;      // number of half-band stages, 0: polyphase filter
+  int decim;      // cascade decimates (1) or interpolates (0)
+  hbstage hb[RSMP_MAX_HB];
+  int wsize;      // complex samples the work buffers hold
+  double* wbuff[2];   // work buffers between the stages
 } resample, *RESAMPLE;
 
 __declspec (dllexport)
@@ -81,6 +101,9 @@ extern void setFCLow_resample (RESAMPLE a, double fc_low);
 
 extern void setBandwidth_resample (RESAMPLE a, double fc_low, double fc_high);
 
+__declspec (dllexport)
+double ResampleBenchmark (int in_rate, int out_rate, int halfband);
+
 #endif
 
 /************************************************************************************************
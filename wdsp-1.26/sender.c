@@ -103,6 +103,7 @@ void SetRXASpectrum (int channel, int flag, int disp, int ss, int LO) {
   EnterCriticalSection (&ch[channel].csDSP);
   a = rxa[channel].sender.p;
   a->flag = flag;
+  RXAPipeCheck (channel);
   a->arg0 = disp;
   a->arg1 = ss;
   a->arg2 = LO;
@@ -104,13 +104,18 @@ void setSize_shift (SHIFT a, int size) {
 
 PORT
 void SetRXAShiftRun (int channel, int run) {
+  if (queue_cmdI (channel, SetRXAShiftRun, run)) { return; }
+
   EnterCriticalSection (&ch[channel].csDSP);
   rxa[channel].shift.p->run = run;
+  RXAPipeCheck (channel);
   LeaveCriticalSection (&ch[channel].csDSP);
 }
 
 PORT
 void SetRXAShiftFreq (int channel, double fshift) {
+  if (queue_cmdD (channel, SetRXAShiftFreq, fshift)) { return; }
+
   EnterCriticalSection (&ch[channel].csDSP);
   rxa[channel].shift.p->shift = fshift;
   calc_shift (rxa[channel].shift.p);
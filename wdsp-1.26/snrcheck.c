@@ -0,0 +1,303 @@
+/*  snrcheck.c
+
+This file is part of a program that implements a Software-Defined Radio.
+
+Copyright (C) 2025 Heiko Amft, DL1BZ
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+/********************************************************************************************************
+*                                                   *
+*                     Float/Double Output Comparison                  *
+*                                                   *
+********************************************************************************************************/
+
+//
+// snrcheck runs synthetic signals through the RXA chain in each receive
+// mode (and with NR2) and through the TXA chain in each transmit mode
+// (with the CFC compander), and either writes the outputs to a reference
+// file, or compares them with a reference file and reports the SNR of
+// each output relative to the reference. It is not part of the library.
+//
+// "make floatcheck" (and "make check") writes the reference with the
+// double build, then checks the FLOAT=ON build against it:
+//
+//   snrcheck -w ref-file            (double build)
+//   snrcheck [-t bound] ref-file    (float build)
+//
+// The DSP buffers are processed synchronously (xrxa/xtxa are called
+// directly, not through the channel's I/O buffers and DSP thread), and
+// the input signals are generated with a fixed seed, so the outputs do
+// not depend on thread timing. The double build reproduces its own
+// reference to within rounding (about 300 dB, FFTW may choose different
+// plans), the float build typically reaches 90 to 140 dB.
+//
+// return values of main()
+//
+//  0  all outputs within the bound (default 80 dB)
+//  1  bad command line
+//  2  error reading or writing the reference file
+//  3  at least one output below the bound
+//
+
+#include "comm.h"
+#include "checkutil.h"
+#include <unistd.h>
+
+//
+// API functions that are only declared in wdsp.h
+//
+extern void RXASetPassband (int channel, double f_low, double f_high);
+extern void SetRXAEMNRRun (int channel, int run);
+extern void SetTXABandpassFreqs (int channel, double f_low, double f_high);
+extern void SetTXACFCOMPRun (int channel, int run);
+extern void SetTXACFCOMPprofile (int channel, int nfreqs, double* F, double* G, double *E);
+
+#define DSP_SIZE     2048
+#define RX_IN_RATE   192000
+#define TX_OUT_RATE  192000
+#define NBUFFERS     64
+#define SKIP         16        // buffers skipped until AGC etc. have settled
+
+typedef struct _snrcase {
+  const char* name;
+  int tx;
+  int mode;
+  double f_low;
+  double f_high;
+  int nr2;
+} SNRCASE;
+
+static const SNRCASE cases[] = {
+  { "RX LSB",     0, RXA_LSB,  -2700.0,  -200.0, 0 },
+  { "RX USB",     0, RXA_USB,    200.0,  2700.0, 0 },
+  { "RX USB+NR2", 0, RXA_USB,    200.0,  2700.0, 1 },
+  { "RX DSB",     0, RXA_DSB,  -2700.0,  2700.0, 0 },
+  { "RX CWL",     0, RXA_CWL,   -850.0,  -350.0, 0 },
+  { "RX CWU",     0, RXA_CWU,    350.0,   850.0, 0 },
+  { "RX FM",      0, RXA_FM,   -8000.0,  8000.0, 0 },
+  { "RX AM",      0, RXA_AM,   -4000.0,  4000.0, 0 },
+  { "RX DIGU",    0, RXA_DIGU,   200.0,  2700.0, 0 },
+  { "RX DIGL",    0, RXA_DIGL, -2700.0,  -200.0, 0 },
+  { "RX SAM",     0, RXA_SAM,  -4000.0,  4000.0, 0 },
+  { "RX DRM",     0, RXA_DRM,  -5000.0,  5000.0, 0 },
+  { "TX LSB",     1, TXA_LSB,  -2850.0,  -150.0, 0 },
+  { "TX USB",     1, TXA_USB,    150.0,  2850.0, 0 },
+  { "TX DSB",     1, TXA_DSB,  -2850.0,  2850.0, 0 },
+  { "TX FM",      1, TXA_FM,   -3000.0,  3000.0, 0 },
+  { "TX AM",      1, TXA_AM,   -2850.0,  2850.0, 0 },
+  { "TX DIGU",    1, TXA_DIGU,   150.0,  2850.0, 0 },
+  { "TX DIGL",    1, TXA_DIGL, -2850.0,  -150.0, 0 },
+};
+
+#define NCASES ((int)(sizeof (cases) / sizeof (cases[0])))
+
+static double noise (void) {
+  return check_uniform () - 0.5;
+}
+
+//
+// Fill one input block: for RX a carrier 1 kHz (CW: 600 Hz) off the
+// "dial" frequency on the side of the passband, modulated according to
+// the mode, plus noise; for TX a two-tone (700/1900 Hz) microphone signal
+// with some noise, in the I channel only, as the mic samples are passed.
+//
+static void fill_block (const SNRCASE* c, double* in, int n, double* ph, double* ph2) {
+  int i;
+  double rate = c->tx ? 48000.0 : RX_IN_RATE;
+
+  for (i = 0; i < n; i++) {
+    if (c->tx) {
+      in[2 * i + 0] = 0.25 * sin (ph[0]) + 0.25 * sin (ph2[0]) + 1.0e-3 * noise ();
+      in[2 * i + 1] = 0.0;
+      ph[0] += TWOPI * 700.0 / rate;
+      ph2[0] += TWOPI * 1900.0 / rate;
+    } else {
+      double freq = (c->f_low + c->f_high) < 0.0 ? -1000.0 : 1000.0;
+      double amp = 0.01;
+
+      if (c->mode == RXA_CWL || c->mode == RXA_CWU) {
+        freq = c->mode == RXA_CWL ? -600.0 : 600.0;
+      }
+
+      if (c->mode == RXA_AM || c->mode == RXA_SAM || c->mode == RXA_DRM) {
+        freq = 0.0;
+        amp *= 1.0 + 0.5 * sin (ph2[0]);
+      }
+
+      if (c->mode == RXA_FM) {
+        freq = 2500.0 * sin (ph2[0]);
+      }
+
+      in[2 * i + 0] = amp * cos (ph[0]) + 1.0e-3 * noise ();
+      in[2 * i + 1] = amp * sin (ph[0]) + 1.0e-3 * noise ();
+      ph[0] += TWOPI * freq / rate;
+      ph2[0] += TWOPI * 400.0 / rate;
+    }
+
+    if (ph[0] > TWOPI) { ph[0] -= TWOPI; }
+
+    if (ph2[0] > TWOPI) { ph2[0] -= TWOPI; }
+  }
+}
+
+//
+// Run one case and return its output (after the settling time) in *out,
+// the number of doubles is returned
+//
+static int run_case (const SNRCASE* c, double** out) {
+  int in_size, out_size, nout, b;
+  double ph = 0.0, ph2 = 0.0;
+  check_seed (12345);
+
+  if (c->tx) {
+    double F[4] = { 0.0, 500.0, 1500.0, 3000.0 };
+    double G[4] = { 0.0, 5.0, 8.0, 5.0 };
+    double E[4] = { 0.0, 0.0, 0.0, 0.0 };
+    OpenChannel (0, 1024, DSP_SIZE, 48000, 96000, TX_OUT_RATE, 1, 0, 0.010, 0.025, 0.0, 0.010, 1);
+    SetTXAMode (0, c->mode);
+    SetTXABandpassFreqs (0, c->f_low, c->f_high);
+    SetTXACFCOMPprofile (0, 4, F, G, E);
+    SetTXACFCOMPRun (0, 1);
+  } else {
+    OpenChannel (0, 1024, DSP_SIZE, RX_IN_RATE, 48000, 48000, 0, 0, 0.010, 0.025, 0.0, 0.010, 1);
+    SetRXAMode (0, c->mode);
+    RXASetPassband (0, c->f_low, c->f_high);
+    SetRXAEMNRRun (0, c->nr2);
+  }
+
+  in_size = ch[0].dsp_insize;
+  out_size = ch[0].dsp_outsize;
+  nout = 2 * out_size * (NBUFFERS - SKIP);
+  *out = (double *) malloc0 (nout * sizeof (double));
+
+  for (b = 0; b < NBUFFERS; b++) {
+    EnterCriticalSection (&ch[0].csDSP);
+
+    if (c->tx) {
+      fill_block (c, txa[0].pipein, in_size, &ph, &ph2);
+      xtxa (0);
+    } else {
+      fill_block (c, rxa[0].pipein, in_size, &ph, &ph2);
+      xrxa (0);
+    }
+
+    if (b >= SKIP) {
+      memcpy (*out + 2 * out_size * (b - SKIP), c->tx ? txa[0].pipeout : rxa[0].pipeout,
+              out_size * sizeof (complex));
+    }
+
+    LeaveCriticalSection (&ch[0].csDSP);
+  }
+
+  CloseChannel (0);
+  return nout;
+}
+
+static void usage (void) {
+  fprintf (stderr, "usage: snrcheck -w ref-file\n"
+           "       snrcheck [-t bound] ref-file\n");
+}
+
+int main (int argc, char** argv) {
+  int writing = 0;
+  double bound = 80.0;
+  int opt, i, n, nref, failed = 0;
+  double *out, *ref;
+  FILE* f;
+
+  while ((opt = getopt (argc, argv, "wt:")) != -1) {
+    switch (opt) {
+    case 'w':
+      writing = 1;
+      break;
+
+    case 't':
+      bound = atof (optarg);
+      break;
+
+    default:
+      usage ();
+      return 1;
+    }
+  }
+
+  if (argc - optind != 1) {
+    usage ();
+    return 1;
+  }
+
+  if ((f = fopen (argv[optind], writing ? "wb" : "rb")) == NULL) {
+    fprintf (stderr, "snrcheck: cannot open %s\n", argv[optind]);
+    return 2;
+  }
+
+#ifdef WDSP_FLOAT
+  printf ("snrcheck: float build, %s %s\n", writing ? "writing" : "checking against", argv[optind]);
+#else
+  printf ("snrcheck: double build, %s %s\n", writing ? "writing" : "checking against", argv[optind]);
+#endif
+
+  for (i = 0; i < NCASES; i++) {
+    n = run_case (&cases[i], &out);
+
+    if (writing) {
+      if (fwrite (&n, sizeof (int), 1, f) != 1 || fwrite (out, sizeof (double), n, f) != (size_t) n) {
+        fprintf (stderr, "snrcheck: cannot write %s\n", argv[optind]);
+        return 2;
+      }
+
+      printf ("%-12s %d samples written\n", cases[i].name, n / 2);
+    } else {
+      double snr;
+
+      if (fread (&nref, sizeof (int), 1, f) != 1 || nref != n) {
+        fprintf (stderr, "snrcheck: %s does not match this program\n", argv[optind]);
+        return 2;
+      }
+
+      ref = (double *) malloc0 (n * sizeof (double));
+
+      if (fread (ref, sizeof (double), n, f) != (size_t) n) {
+        fprintf (stderr, "snrcheck: cannot read %s\n", argv[optind]);
+        return 2;
+      }
+
+      snr = check_snr (ref, out, n);
+
+      if (snr >= 1000.0) {
+        printf ("%-12s exact\n", cases[i].name);
+      } else {
+        printf ("%-12s SNR %6.1f dB%s\n", cases[i].name, snr, snr < bound ? "  BELOW BOUND" : "");
+
+        if (snr < bound) { failed++; }
+      }
+
+      _aligned_free (ref);
+    }
+
+    _aligned_free (out);
+  }
+
+  fclose (f);
+
+  if (!writing) {
+    printf ("%d of %d outputs below %.1f dB\n", failed, NCASES, bound);
+  }
+
+  return failed ? 3 : 0;
+}
@@ -333,11 +333,14 @@ PORT
 void SetRXASSQLRun (int channel, int run) {
   EnterCriticalSection (&ch[channel].csDSP);
   rxa[channel].ssql.p->run = run;
+  RXAPipeCheck (channel);
   LeaveCriticalSection (&ch[channel].csDSP);
 }
 
 PORT
 void SetRXASSQLThreshold (int channel, double threshold) {
+  if (queue_cmdD (channel, SetRXASSQLThreshold, threshold)) { return; }
+
   // 'threshold' should be between 0.0 and 1.0
   // WU2O testing:  0.16 is a good default for 'threshold'; => 0.08 for 'wthresh'
   EnterCriticalSection (&ch[channel].csDSP);
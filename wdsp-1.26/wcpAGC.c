@@ -540,6 +540,7 @@ PORT void
 SetTXAALCSt (int channel, int state) {
   EnterCriticalSection (&ch[channel].csDSP);
   txa[channel].alc.p->run = state;
+  TXAPipeCheck (channel);
   LeaveCriticalSection (&ch[channel].csDSP);
 }
 
@@ -578,6 +579,7 @@ PORT void
 SetTXALevelerSt (int channel, int state) {
   EnterCriticalSection (&ch[channel].csDSP);
   txa[channel].leveler.p->run = state;
+  TXAPipeCheck (channel);
   LeaveCriticalSection (&ch[channel].csDSP);
 }
 
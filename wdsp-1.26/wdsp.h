@@ -94,6 +94,11 @@ extern void SetRXAMode (int channel, int mode);
 extern void RXASetPassband (int channel, double f_low, double f_high);
 extern void RXASetNC (int channel, int nc);
 extern void RXASetMP (int channel, int mp);
+extern int GetRXAStageCount (void);
+extern const char* GetRXAStageName (int stage);
+extern void SetRXAStageTiming (int channel, int run);
+extern void GetRXAStageTimes (int channel, double* us, double* peak_us, int* active);
+extern void ResetRXAStageTimes (int channel);
 
 //
 // Interfaces from TXA.c
@@ -104,6 +109,11 @@ extern void SetTXABandpassFreqs (int channel, double f_low, double f_high);
 extern void TXASetNC (int channel, int nc);
 extern void TXASetMP (int channel, int mp);
 extern void SetTXAFMAFFilter (int channel, double low, double high);
+extern int GetTXAStageCount (void);
+extern const char* GetTXAStageName (int stage);
+extern void SetTXAStageTiming (int channel, int run);
+extern void GetTXAStageTimes (int channel, double* us, double* peak_us, int* active);
+extern void ResetTXAStageTimes (int channel);
 
 //
 // Interfaces from amd.c
@@ -198,6 +208,8 @@ extern void SetDisplayAvBackmult (int disp, int pixout, double mult);
 extern void SetDisplaySampleRate (int disp, int rate);
 extern void SetDisplayNormOneHz (int disp, int pixout, int norm);
 extern double GetDisplayENB (int disp);
+extern void GetDisplayStats (int disp, long *ffts, int *queue_depth, long *dropped);
+extern void GetWorkPoolStats(int *nthreads, int *depth, int *max_depth, long *executed, long *rejected);
 
 //
 // Interfaces from anf.c
@@ -210,6 +222,7 @@ extern  void SetRXAANFDelay (int channel, int delay);
 extern  void SetRXAANFGain (int channel, double gain);
 extern  void SetRXAANFLeakage (int channel, double leakage);
 extern  void SetRXAANFPosition (int channel, int position);
+extern  void SetRXAANFMethod (int channel, int method);
 
 //
 // Interfaces from anr.c
@@ -222,6 +235,7 @@ extern  void SetRXAANRDelay (int channel, int delay);
 extern  void SetRXAANRGain (int channel, double gain);
 extern  void SetRXAANRLeakage (int channel, double leakage);
 extern  void SetRXAANRPosition (int channel, int position);
+extern  void SetRXAANRMethod (int channel, int method);
 
 //
 // Interfaces from bandpass.c
@@ -320,6 +334,23 @@ extern void SetChannelTSlewUp (int channel, double time);
 extern void SetChannelTDelayDown (int channel, double time);
 extern void SetChannelTSlewDown (int channel, double time);
 
+//
+// Interfaces from cmac.c
+//
+
+extern int GetFirKernel (void);
+extern void SetFirKernel (int kernel);
+extern int GetFirKernelAvailable (int kernel);
+extern const char* GetFirKernelName (int kernel);
+extern double FirKernelBenchmark (int kernel, int size, int nparts);
+
+//
+// Interfaces from cmdq.c
+//
+
+extern void SetChannelCommandQueue (int channel, int run);
+extern void GetChannelCommandQueueStats (int channel, long* queued, long* direct);
+
 //
 // Interfaces from compress.c
 //
@@ -383,6 +414,32 @@ extern void SetEXTDIVOutput (int id, int output);
 extern void SetEXTDIVRotate (int id, int nr, double *Irotate, double *Qrotate);
 extern void xdivEXTF (int id, int size, float **input, float *Iout, float *Qout);
 
+//
+// Interfaces from dspload.c
+//
+
+enum _dspload_counter {
+  DSPLOAD_XMAIN = 0,
+  DSPLOAD_FEXCHANGE,
+  DSPLOAD_SPECTRUM,
+  DSPLOAD_CALCC,
+  DSPLOAD_NCOUNTERS
+};
+
+extern void SetDSPLoadRun (int run);
+extern void ResetDSPLoad (int index);
+extern void GetDSPLoad (int counter, int index, double* avg_us, double* peak_us, long* count);
+extern double GetDSPLoadPeriod (int channel);
+
+//
+// Interfaces from dsppool.c
+//
+
+extern int CreateDSPPool (int nthreads, int* cpus);
+extern void DestroyDSPPool (void);
+extern int GetDSPPoolThreads (void);
+extern void SetChannelDSPPool (int channel, int pooled);
+
 //
 // Interfaces from eer.c
 //
@@ -425,6 +482,7 @@ extern void SetRXAEMNRRun (int channel, int run);
 extern void SetRXAEMNRgainMethod (int channel, int method);
 extern void SetRXAEMNRnpeMethod (int channel, int method);
 extern void SetRXAEMNRaeRun (int channel, int run);
+extern void SetRXAEMNRfastGain (int channel, int run);
 extern void SetRXAEMNRPosition (int channel, int position);
 extern void SetRXAEMNRaeZetaThresh (int channel, double zetathresh);
 extern void SetRXAEMNRaePsi (int channel, double psi);
@@ -598,6 +656,7 @@ extern void SetTXAPHROTReverse (int channel, int reverse);
 extern int save_impulse_cache(const char* path);
 extern int read_impulse_cache(const char* path);
 extern void use_impulse_cache(int use);
+extern void GetImpulseCacheStats(long* hits, long* misses, int* entries);
 extern void init_impulse_cache(int use);
 extern void destroy_impulse_cache(void);
 
@@ -607,6 +666,8 @@ extern void destroy_impulse_cache(void);
 
 extern void fexchange0 (int channel, double* in, double* out, int* error);
 extern void fexchange2 (int channel, INREAL *Iin, INREAL *Qin, OUTREAL *Iout, OUTREAL *Qout, int* error);
+extern double* fexchange0_acquire (int channel);
+extern double* fexchange0_commit (int channel, int* error);
 
 //
 // Interfaces from iqc.c
@@ -789,6 +850,7 @@ extern void destroy_resampleV (void* ptr);
 extern void* create_resampleFV (int in_rate, int out_rate);
 extern void xresampleFV (float* input, float* output, int numsamps, int* outsamps, void* ptr);
 extern void destroy_resampleFV (void* ptr);
+extern double ResampleBenchmark (int in_rate, int out_rate, int halfband);
 
 //
 // Interfaces from rmatch.c
@@ -949,3 +1011,5 @@ extern  void SetTXALevelerTop (int channel, double maxgain);
 
 extern char* wisdom_get_status();
 extern int WDSPwisdom (char* directory);
+extern int WDSPwisdomQuick (char* directory);
+extern void WDSPwisdomStop (void);
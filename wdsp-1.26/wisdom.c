@@ -26,95 +26,618 @@ warren@wpratt.com
 
 #define _CRT_SECURE_NO_WARNINGS
 #include "comm.h"
+#if defined(linux) || defined(__APPLE__)
+  #include <sys/types.h>
+  #include <sys/wait.h>
+  #include <sys/resource.h>
+  #include <signal.h>
+  #define WISDOM_FORK
+#endif
+#if defined(__linux__)
+  #include <sys/prctl.h>
+  #include <sys/syscall.h>
+#endif
 
 static char status[128];
 
+//
+// Planner flags for all FFT plans. This is FFTW_PATIENT, unless the
+// wisdom is still being generated in the background (WDSPwisdomQuick).
+//
+int wisdom_rigor = FFTW_PATIENT;
+
 PORT
 char* wisdom_get_status() {
   return status;
 }
 
+/********************************************************************************************************
+*                                                   *
+*                   Parallel and Resumable Wisdom Generation                *
+*                                                   *
+********************************************************************************************************/
+
+//
+// The wisdom is generated as a list of jobs, one plan each, largest first.
+// Each job runs in a child process of its own, several of them in parallel,
+// and exports its wisdom to a job file (e.g. wdspWisdom00.f4096) which is
+// the checkpoint: an interrupted run resumes with the jobs whose files are
+// missing. When all jobs are done, their wisdom is merged into the wisdom
+// file and the job files are removed.
+//
+// Note FFTW_PATIENT measures run times, so plans made while other jobs are
+// running may be somewhat less than optimal. This is the price for a first
+// start that takes a fraction of the time on multi-core machines.
+//
+
+#define MAX_WISDOM_JOBS 128
+
+enum _wisdom_kind {
+  WISDOM_CFWD = 0,
+  WISDOM_CBWD,
+  WISDOM_R2C
+};
+
+typedef struct _wisdom_job {
+  int single;           // plan for the single precision (fftwf) library
+  int kind;
+  int size;
+} wisdom_job;
+
+static const char* wisdom_name[2] = { "wdspWisdom00", "wdspWisdomF00" };
+static const char  wisdom_kind_char[3] = { 'f', 'b', 'r' };
+static const char* wisdom_kind_text[3] = { "COMPLEX FORWARD ", "COMPLEX BACKWARD", "REAL    FORWARD " };
+
+#ifdef WISDOM_FORK
+//
+// background generation
+//
+static struct _wisdom_background {
+  volatile pid_t pid;
+  int njobs;
+  wisdom_job jobs[MAX_WISDOM_JOBS];
+  char directory[1024];
+  pthread_mutex_t lock;     // protects 'started'
+  pthread_cond_t cond;
+  int started;              // the monitor thread has tried to fork
+} bg = { 0, 0, {{0}}, "", PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, 0 };
+#endif
+
+static void add_wisdom_job (wisdom_job* jobs, int* njobs, int single, int kind, int size) {
+  if (*njobs >= MAX_WISDOM_JOBS) { return; }
+
+  jobs[*njobs].single = single;
+  jobs[*njobs].kind = kind;
+  jobs[*njobs].size = size;
+  (*njobs)++;
+}
+
+static int build_wisdom_jobs (wisdom_job* jobs, int single) {
+  int n = 0, psize;
+
+  if (!single) {
+    for (psize = 64; psize <= MAX_WISDOM_SIZE_FILTER; psize *= 2) {
+      add_wisdom_job (jobs, &n, 0, WISDOM_CFWD, psize);
+      add_wisdom_job (jobs, &n, 0, WISDOM_CBWD, psize);
+      add_wisdom_job (jobs, &n, 0, WISDOM_CBWD, psize + 1);
+    }
+
+    for (psize = 64; psize <= MAX_WISDOM_SIZE_DISPLAY; psize *= 2) {
+      if (psize > MAX_WISDOM_SIZE_FILTER) { add_wisdom_job (jobs, &n, 0, WISDOM_CFWD, psize); }
+
+      add_wisdom_job (jobs, &n, 0, WISDOM_R2C, psize);
+    }
+  } else {
+    //
+    // Single-precision plans used by the filter kernels and the analyzer,
+    // the double-precision plans are still used for filter design
+    //
+    for (psize = 64; psize <= MAX_WISDOM_SIZE_DISPLAY; psize *= 2) {
+      add_wisdom_job (jobs, &n, 1, WISDOM_CFWD, psize);
+
+      if (psize <= MAX_WISDOM_SIZE_FILTER) { add_wisdom_job (jobs, &n, 1, WISDOM_CBWD, psize); }
+
+      add_wisdom_job (jobs, &n, 1, WISDOM_R2C, psize);
+    }
+  }
+
+  return n;
+}
+
+static int cmp_wisdom_jobs (const void* a, const void* b) {
+  return ((const wisdom_job*)b)->size - ((const wisdom_job*)a)->size;
+}
+
+//
+// File names are built in buffers of WISDOM_PATH bytes, these functions
+// return 0 if the name does not fit (the directory is checked against
+// this in WDSPwisdom and WDSPwisdomQuick, so this should never happen).
+//
+#define WISDOM_PATH 1024
+
+static int wisdom_file (char* file, const char* directory, int single) {
+  int n = snprintf (file, WISDOM_PATH, "%s%s", directory, wisdom_name[single]);
+  return n >= 0 && n < WISDOM_PATH;
+}
+
+static int wisdom_job_file (char* file, const char* directory, wisdom_job* j) {
+  int n = snprintf (file, WISDOM_PATH, "%s%s.%c%d", directory, wisdom_name[j->single],
+                    wisdom_kind_char[j->kind], j->size);
+  return n >= 0 && n < WISDOM_PATH;
+}
+
+//
+// longest file name below the directory is wdspWisdomF00.b262145.tmp
+//
+static int wisdom_directory_ok (const char* directory) {
+  if (strlen (directory) + 32 < WISDOM_PATH) { return 1; }
+
+  fprintf (stderr, "WDSP wisdom: directory name too long: %s\n", directory);
+  sprintf (status, "FFTW planning impossible: directory name too long");
+  return 0;
+}
+
+static int wisdom_job_done (const char* directory, wisdom_job* j) {
+  char file[WISDOM_PATH];
+  FILE* fp;
+
+  if (!wisdom_job_file (file, directory, j)) { return 0; }
+
+  if ((fp = fopen (file, "r")) == NULL) { return 0; }
+
+  fclose (fp);
+  return 1;
+}
+
+static int wisdom_jobs_done (const char* directory, wisdom_job* jobs, int njobs) {
+  int i, n = 0;
+
+  for (i = 0; i < njobs; i++)
+    if (wisdom_job_done (directory, &jobs[i])) { n++; }
+
+  return n;
+}
+
+static void import_wisdom_file (int single, const char* file) {
+  if (single) {
+#ifdef WDSP_FLOAT
+    fftwf_import_wisdom_from_filename (file);
+#endif
+  } else {
+    fftw_import_wisdom_from_filename (file);
+  }
+}
+
+static void plan_wisdom_job (wisdom_job* j, int flags) {
+  if (j->single) {
+#ifdef WDSP_FLOAT
+    FFTREAL* in =  (FFTREAL *) malloc0 (j->size * sizeof (fftcomplex));
+    FFTREAL* out = (FFTREAL *) malloc0 (j->size * sizeof (fftcomplex));
+    fftwf_plan plan;
+
+    if (j->kind == WISDOM_R2C) {
+      plan = fftwf_plan_dft_r2c_1d (j->size, in, (fftwf_complex *)out, flags);
+    } else {
+      plan = fftwf_plan_dft_1d (j->size, (fftwf_complex *)in, (fftwf_complex *)out,
+                                j->kind == WISDOM_CFWD ? FFTW_FORWARD : FFTW_BACKWARD, flags);
+    }
+
+    fftwf_execute (plan);
+    fftwf_destroy_plan (plan);
+    _aligned_free (out);
+    _aligned_free (in);
+#endif
+  } else {
+    double* in =  (double *) malloc0 (j->size * sizeof (complex));
+    double* out = (double *) malloc0 (j->size * sizeof (complex));
+    fftw_plan plan;
+
+    if (j->kind == WISDOM_R2C) {
+      plan = fftw_plan_dft_r2c_1d (j->size, in, (fftw_complex *)out, flags);
+    } else {
+      plan = fftw_plan_dft_1d (j->size, (fftw_complex *)in, (fftw_complex *)out,
+                               j->kind == WISDOM_CFWD ? FFTW_FORWARD : FFTW_BACKWARD, flags);
+    }
+
+    fftw_execute (plan);
+    fftw_destroy_plan (plan);
+    _aligned_free (out);
+    _aligned_free (in);
+  }
+}
+
+//
+// Plan one job and write its wisdom to the job file. Writing to a
+// temporary file first guarantees that a job file is always complete.
+// Returns 0 on success.
+//
+static int run_wisdom_job (const char* directory, wisdom_job* j) {
+  char file[WISDOM_PATH], tmp[WISDOM_PATH + 4];
+  int ok = 0;
+
+  if (!wisdom_job_file (file, directory, j)) { return -1; }
+
+  snprintf (tmp, sizeof (tmp), "%s.tmp", file);
+  fprintf (stdout, "Planning %s%s FFT size %d\n", j->single ? "FLOAT " : "", wisdom_kind_text[j->kind], j->size);
+  fflush (stdout);
+
+  if (j->single) {
+#ifdef WDSP_FLOAT
+    fftwf_forget_wisdom ();
+    plan_wisdom_job (j, FFTW_PATIENT);
+    ok = fftwf_export_wisdom_to_filename (tmp);
+#endif
+  } else {
+    fftw_forget_wisdom ();
+    plan_wisdom_job (j, FFTW_PATIENT);
+    ok = fftw_export_wisdom_to_filename (tmp);
+  }
+
+  if (!ok || rename (tmp, file) != 0) {
+    fprintf (stderr, "WDSP wisdom: cannot write %s\n", file);
+    remove (tmp);
+    return -1;
+  }
+
+  return 0;
+}
+
+//
+// Run all missing jobs with up to 'nworkers' child processes, then merge
+// the job files into the wisdom file(s). Returns 0 on success, and -1 if
+// a job failed (its job file is then missing, the others are kept).
+//
+static int run_wisdom_jobs (const char* directory, wisdom_job* jobs, int njobs, int nworkers) {
+  int i, k, single, running = 0, failed = 0;
+  char file[WISDOM_PATH];
+#ifdef WISDOM_FORK
+  pid_t pid;
+  int st;
+#endif
+
+  for (i = 0; i < njobs; i++) {
+    if (wisdom_job_done (directory, &jobs[i])) { continue; }
+
+#ifdef WISDOM_FORK
+
+    while (running >= nworkers) {
+      if (wait (&st) > 0) {
+        running--;
+
+        if (!WIFEXITED (st) || WEXITSTATUS (st) != 0) { failed++; }
+      } else { running = 0; }
+    }
+
+    if ((pid = fork ()) == 0) {
+      _exit (run_wisdom_job (directory, &jobs[i]) == 0 ? 0 : 1);
+    }
+
+    if (pid > 0) {
+      running++;
+      continue;
+    }
+
+#endif
+
+    if (run_wisdom_job (directory, &jobs[i]) != 0) { failed++; }
+  }
+
+#ifdef WISDOM_FORK
+
+  while (running > 0 && wait (&st) > 0) {
+    running--;
+
+    if (!WIFEXITED (st) || WEXITSTATUS (st) != 0) { failed++; }
+  }
+
+#endif
+
+  if (failed || wisdom_jobs_done (directory, jobs, njobs) != njobs) { return -1; }
+
+  for (single = 0; single <= 1; single++) {
+    for (i = 0, k = 0; i < njobs; i++) {
+      if (jobs[i].single != single) { continue; }
+
+      if (k++ == 0) {
+        if (single) {
+#ifdef WDSP_FLOAT
+          fftwf_forget_wisdom ();
+#endif
+        } else {
+          fftw_forget_wisdom ();
+        }
+      }
+
+      if (wisdom_job_file (file, directory, &jobs[i])) { import_wisdom_file (single, file); }
+    }
+
+    if (k == 0) { continue; }
+
+    if (!wisdom_file (file, directory, single)) { return -1; }
+
+    if (single) {
+#ifdef WDSP_FLOAT
+      if (!fftwf_export_wisdom_to_filename (file)) { return -1; }
+#endif
+    } else {
+      if (!fftw_export_wisdom_to_filename (file)) { return -1; }
+    }
+  }
+
+  for (i = 0; i < njobs; i++) {
+    if (wisdom_job_file (file, directory, &jobs[i])) { remove (file); }
+  }
+
+  return 0;
+}
+
+static int wisdom_workers (int background);
+
+#ifdef WISDOM_FORK
+static void wisdom_sigterm (int sig) {
+  // take down the workers as well, they are in our process group
+  signal (SIGTERM, SIG_DFL);
+  kill (0, SIGTERM);
+}
+
+//
+// The job process is forked from a multi-threaded program and inherits
+// all its open files, e.g. the sockets of the radio connection and the
+// audio devices. Close them so they are released when the program ends,
+// even if the jobs are still running.
+//
+static void wisdom_close_files (void) {
+  long fd, maxfd;
+#if defined(__linux__) && defined(SYS_close_range)
+
+  if (syscall (SYS_close_range, 3, ~0U, 0) == 0) { return; }
+
+#endif
+  maxfd = sysconf (_SC_OPEN_MAX);
+
+  if (maxfd < 0 || maxfd > 65536) { maxfd = 65536; }
+
+  for (fd = 3; fd < maxfd; fd++) { close ((int) fd); }
+}
+
+//
+// Fork a process that runs the jobs. It has a process group of its own,
+// such that it can be stopped together with its workers.
+// On Linux, it is terminated if the calling thread ends, so this must
+// be called from a thread that waits for it.
+//
+static pid_t start_wisdom_jobs (const char* directory, wisdom_job* jobs, int njobs, int nworkers, int background) {
+  pid_t parent = getpid ();
+  pid_t pid = fork ();
+
+  if (pid != 0) {
+    if (pid > 0) { setpgid (pid, pid); }
+
+    return pid;
+  }
+
+  //
+  // Only the forking thread exists in the child: do not touch locks the
+  // other threads of the program may have held at the time of the fork.
+  //
+  setpgid (0, 0);
+  wisdom_close_files ();
+  signal (SIGTERM, wisdom_sigterm);
+#if defined(__linux__)
+
+  // if the program ends or crashes, do not continue
+  prctl (PR_SET_PDEATHSIG, SIGTERM);
+
+  if (getppid () != parent) { _exit (1); }
+
+#endif
+
+  if (background) { setpriority (PRIO_PROCESS, 0, 10); }
+
+  _exit (run_wisdom_jobs (directory, jobs, njobs, nworkers) == 0 ? 0 : 1);
+}
+
+//
+// The background job process is started from this thread, which lives
+// as long as the process (see start_wisdom_jobs).
+//
+static void* wisdom_monitor (void* arg) {
+  int st;
+  pid_t pid = start_wisdom_jobs (bg.directory, bg.jobs, bg.njobs, wisdom_workers (1), 1);
+  pthread_mutex_lock (&bg.lock);
+  bg.pid = pid > 0 ? pid : 0;
+  bg.started = 1;
+  pthread_cond_signal (&bg.cond);
+  pthread_mutex_unlock (&bg.lock);
+
+  if (pid <= 0) { return NULL; }
+
+  while (waitpid (bg.pid, &st, WNOHANG) == 0) {
+    sprintf (status, "Optimizing FFT sizes in background: %d of %d plans done",
+             wisdom_jobs_done (bg.directory, bg.jobs, bg.njobs), bg.njobs);
+    Sleep (1000);
+  }
+
+  if (WIFEXITED (st) && WEXITSTATUS (st) == 0) {
+    sprintf (status, "FFTW planning complete, wisdom is used upon next start.");
+  } else {
+    sprintf (status, "FFTW planning interrupted, will be resumed upon next start.");
+  }
+
+  fprintf (stdout, "%s\n", status);
+  fflush (stdout);
+  bg.pid = 0;
+  return NULL;
+}
+#endif
+
+static int wisdom_workers (int background) {
+  int n = 1;
+#ifdef WISDOM_FORK
+  n = (int) sysconf (_SC_NPROCESSORS_ONLN);
+
+  // leave some room for the radio
+  if (background) { n /= 2; }
+
+  if (n < 1) { n = 1; }
+
+#endif
+  return n;
+}
+
+//
+// Build the list of jobs for the wisdom files that cannot be imported
+//
+static int missing_wisdom_jobs (char* directory, wisdom_job* jobs) {
+  int n = 0;
+  char file[WISDOM_PATH];
+
+  if (!wisdom_file (file, directory, 0) || !fftw_import_wisdom_from_filename (file)) {
+    n += build_wisdom_jobs (jobs + n, 0);
+  }
+
+#ifdef WDSP_FLOAT
+
+  if (!wisdom_file (file, directory, 1) || !fftwf_import_wisdom_from_filename (file)) {
+    n += build_wisdom_jobs (jobs + n, 1);
+  }
+
+#endif
+  qsort (jobs, n, sizeof (wisdom_job), cmp_wisdom_jobs);
+  return n;
+}
+
+//
+// Returns 0 if the wisdom file has been loaded, 1 if it has been generated,
+// and -1 if generating it failed (the plans completed so far are kept).
+//
 PORT
 int WDSPwisdom (char* directory) {
-  int wisdom_return = 0; // 0 from existing, 1 rebuilt
-  fftw_plan tplan;
-  int psize;
+  wisdom_job jobs[MAX_WISDOM_JOBS];
+  int i, njobs, done, rc = -1, nworkers = wisdom_workers (0);
+  char file[WISDOM_PATH];
 #ifdef _WIN32
   FILE *stream;
 #endif
-  double* fftin;
-  double* fftout;
-  char wisdom_file[1024];
-  const int maxsize = max (MAX_WISDOM_SIZE_DISPLAY, MAX_WISDOM_SIZE_FILTER + 1);
-  strcpy (wisdom_file, directory);
-  strncat (wisdom_file, "wdspWisdom00", 16);
+#ifdef WISDOM_FORK
+  pid_t pid;
+  int st;
+#endif
+
+  if (!wisdom_directory_ok (directory)) { return -1; }
+
+  if ((njobs = missing_wisdom_jobs (directory, jobs)) == 0) { return 0; }
 
-  if (!fftw_import_wisdom_from_filename(wisdom_file)) {
-    fftin =  (double *) malloc0 (maxsize * sizeof (complex));
-    fftout = (double *) malloc0 (maxsize * sizeof (complex));
 #ifdef _WIN32
-    AllocConsole();               // create console
-    freopen_s(&stream, "conout$", "w", stdout); // redirect output to console
-#endif
-    fprintf(stdout, "Optimizing FFT sizes through %d\n\n", maxsize);
-    fprintf(stdout, "Please do not close this window until wisdom plans are completed.\n\n");
-    sprintf(status, "Optimizing FFT sizes through %d", maxsize);
-    psize = 64;
-
-    while (psize <= MAX_WISDOM_SIZE_FILTER) {
-      fprintf(stdout, "Planning COMPLEX FORWARD  FFT size %d\n", psize);
-      fflush(stdout);
-      sprintf(status, "Planning COMPLEX FORWARD  FFT size %d\n", psize);
-      tplan = fftw_plan_dft_1d(psize, (fftw_complex *)fftin, (fftw_complex *)fftout, FFTW_FORWARD, FFTW_PATIENT);
-      fftw_execute (tplan);
-      fftw_destroy_plan (tplan);
-      fprintf(stdout, "Planning COMPLEX BACKWARD FFT size %d\n", psize);
-      fflush(stdout);
-      sprintf(status, "Planning COMPLEX BACKWARD FFT size %d\n", psize);
-      tplan = fftw_plan_dft_1d(psize, (fftw_complex *)fftin, (fftw_complex *)fftout, FFTW_BACKWARD, FFTW_PATIENT);
-      fftw_execute (tplan);
-      fftw_destroy_plan (tplan);
-      fprintf(stdout, "Planning COMPLEX BACKWARD FFT size %d\n", psize + 1);
-      fflush(stdout);
-      sprintf(status, "Planning COMPLEX BACKWARD FFT size %d\n", psize + 1);
-      tplan = fftw_plan_dft_1d(psize + 1, (fftw_complex *)fftin, (fftw_complex *)fftout, FFTW_BACKWARD, FFTW_PATIENT);
-      fftw_execute (tplan);
-      fftw_destroy_plan (tplan);
-      psize *= 2;
+  AllocConsole();               // create console
+  freopen_s(&stream, "conout$", "w", stdout); // redirect output to console
+#endif
+  done = wisdom_jobs_done (directory, jobs, njobs);
+  fprintf(stdout, "Optimizing FFT sizes through %d, %d plans, %d done before, %d in parallel\n\n",
+          max (MAX_WISDOM_SIZE_DISPLAY, MAX_WISDOM_SIZE_FILTER + 1), njobs, done, nworkers);
+  fprintf(stdout, "Please do not close this window until wisdom plans are completed.\n\n");
+  sprintf(status, "Optimizing FFT sizes: %d of %d plans done", done, njobs);
+#ifdef WISDOM_FORK
+
+  if ((pid = start_wisdom_jobs (directory, jobs, njobs, nworkers, 0)) > 0) {
+    while (waitpid (pid, &st, WNOHANG) == 0) {
+      sprintf (status, "Optimizing FFT sizes: %d of %d plans done", wisdom_jobs_done (directory, jobs, njobs), njobs);
+      Sleep (250);
     }
 
-    psize = 64;
+    if (WIFEXITED (st) && WEXITSTATUS (st) == 0) { rc = 0; }
+  } else {
+    rc = run_wisdom_jobs (directory, jobs, njobs, 1);
+  }
 
-    while (psize <= MAX_WISDOM_SIZE_DISPLAY) {
-      if (psize > MAX_WISDOM_SIZE_FILTER) {
-        fprintf(stdout, "Planning COMPLEX FORWARD  FFT size %d\n", psize);
-        fflush(stdout);
-        sprintf(status, "Planning COMPLEX FORWARD  FFT size %d\n", psize);
-        tplan = fftw_plan_dft_1d(psize, (fftw_complex *)fftin, (fftw_complex *)fftout, FFTW_FORWARD, FFTW_PATIENT);
-        fftw_execute (tplan);
-        fftw_destroy_plan (tplan);
-      }
+#else
+  rc = run_wisdom_jobs (directory, jobs, njobs, 1);
+#endif
 
-      fprintf(stdout, "Planning REAL    FORWARD  FFT size %d\n", psize);
-      fflush(stdout);
-      sprintf(status, "Planning REAL    FORWARD  FFT size %d\n", psize);
-      tplan = fftw_plan_dft_r2c_1d(psize, fftin, (fftw_complex *)fftout, FFTW_PATIENT);
-      fftw_execute (tplan);
-      fftw_destroy_plan (tplan);
-      psize *= 2;
+  if (rc == 0) {
+    // the jobs ran in other processes, so load the result
+    for (i = 0; i <= 1; i++) {
+      if (wisdom_file (file, directory, i)) { import_wisdom_file (i, file); }
     }
 
     fprintf(stdout, "\nFFTW planning complete.\n");
-    fflush(stdout);
     sprintf(status, "\nFFTW planning complete.\n");
-    fftw_export_wisdom_to_filename(wisdom_file);
-    _aligned_free (fftout);
-    _aligned_free (fftin);
+  } else {
+    fprintf(stdout, "\nFFTW planning failed, %d of %d plans done.\n", wisdom_jobs_done (directory, jobs, njobs), njobs);
+    sprintf(status, "\nFFTW planning failed.\n");
+  }
+
+  fflush(stdout);
 #ifdef _WIN32
-    FreeConsole();              // dismiss console
+  FreeConsole();              // dismiss console
 #endif
-    wisdom_return = 1;
+  return rc == 0 ? 1 : -1;
+}
+
+//
+// Quick start: if there is no (complete) wisdom file, all plans are made
+// with FFTW_MEASURE in this session, which takes very little time, and the
+// FFTW_PATIENT wisdom is generated in the background for the next start.
+// Plans finished in an earlier, interrupted, run are used right away.
+//
+// Returns 0 if the wisdom file has been loaded, 1 if it has been generated,
+// 2 if it is being generated in the background, and -1 if generating it
+// failed.
+//
+PORT
+int WDSPwisdomQuick (char* directory) {
+#ifdef WISDOM_FORK
+  int i;
+  char file[WISDOM_PATH];
+  pthread_t tid;
+
+  if (bg.pid > 0) { return 2; }
+
+  if (!wisdom_directory_ok (directory)) { return -1; }
+
+  if ((bg.njobs = missing_wisdom_jobs (directory, bg.jobs)) == 0) { return 0; }
+
+  for (i = 0; i < bg.njobs; i++) {
+    if (wisdom_job_done (directory, &bg.jobs[i])) {
+      if (wisdom_job_file (file, directory, &bg.jobs[i])) { import_wisdom_file (bg.jobs[i].single, file); }
+    }
   }
 
-  return wisdom_return;
+  strncpy (bg.directory, directory, sizeof (bg.directory) - 1);
+  bg.started = 0;
+
+  if (pthread_create (&tid, NULL, wisdom_monitor, NULL) == 0) {
+    pthread_detach (tid);
+    pthread_mutex_lock (&bg.lock);
+
+    while (!bg.started) { pthread_cond_wait (&bg.cond, &bg.lock); }
+
+    pthread_mutex_unlock (&bg.lock);
+
+    if (bg.pid > 0) {
+      wisdom_rigor = FFTW_MEASURE;
+      fprintf (stdout, "FFTW wisdom incomplete, using FFTW_MEASURE and optimizing %d plans in background.\n", bg.njobs);
+      fflush (stdout);
+      sprintf (status, "Optimizing FFT sizes in background");
+      return 2;
+    }
+  }
+
+  bg.pid = 0;
+#endif
+  return WDSPwisdom (directory);
+}
+
+//
+// Stop a background wisdom generation, e.g. upon program exit.
+// The plans completed so far are kept and the next run resumes.
+//
+PORT
+void WDSPwisdomStop (void) {
+#ifdef WISDOM_FORK
+  pid_t pid = bg.pid;
+
+  if (pid > 0) { kill (-pid, SIGTERM); }
+
+#endif
 }